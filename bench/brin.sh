@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# Compare brin_locus_ops with gist_locus_ops on an append-only table in
+# genome order: build time, index size, and the time of region queries.
+#
+#   bench/brin.sh [dbname] [rows] [probes]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-20000000}
+PROBES=${3:-200}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_brin;
+  CREATE UNLOGGED TABLE bench_brin AS
+    SELECT ('chr' || c || ':' || s || '-' || (s + i % 300))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT 1 + (i - 1) * 22 / $ROWS AS c,
+                         ((i - 1) % ($ROWS / 22 + 1)) * 100 AS s) AS g
+    ORDER BY i;
+  VACUUM ANALYZE bench_brin;
+" || exit 1
+
+for method in brin gist; do
+  psql -X -q -d "$DB" -c "DROP INDEX IF EXISTS bench_brin_ix"
+  start=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "CREATE INDEX bench_brin_ix ON bench_brin USING $method (l)" || exit 1
+  end=$(date +%s.%N)
+  size=$(psql -X -A -t -d "$DB" -c "SELECT pg_size_pretty(pg_relation_size('bench_brin_ix'))")
+  echo "$start $end" | awk -v m="$method" -v size="$size" \
+    '{ printf "%-4s build: %.3f s, index size %s\n", m, $2 - $1, size }'
+
+  # Random 100 kb regions
+  psql -X -A -t -d "$DB" <<SQL | awk -v m="$method" -v n="$PROBES" \
+    '/Execution Time/ { ms += $3 } END { printf "%-4s && probes: %.3f ms per probe\n", m, ms / n }'
+SET enable_seqscan = off;
+SELECT format('EXPLAIN (ANALYZE, COSTS OFF) SELECT count(*) FROM bench_brin WHERE l && %L',
+              'chr' || (1 + i % 22) || ':' || s || '-' || (s + 100000))
+FROM generate_series(1, $PROBES) AS i,
+     LATERAL (SELECT (i * 104729) % ($ROWS / 22 * 100) AS s) AS g
+\\gexec
+SQL
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_brin"
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Measure text-input throughput of the locus type by loading N generated
+# loci with COPY.  Run it against a database where the extension is
+# installed, once per build to be compared:
+#
+#   bench/copy-in.sh [dbname] [rows] [runs]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-2000000}
+RUNS=${3:-5}
+DATA=$(mktemp /tmp/locus-copy-in.XXXXXX)
+
+trap 'rm -f "$DATA"' EXIT
+
+# A mix of the forms seen in practice: with and without "chr", points,
+# closed and half-open ranges, thousands separators and unplaced contigs.
+psql -X -q -d "$DB" -c "
+  COPY (
+    SELECT CASE i % 6
+      WHEN 0 THEN 'chr' || (1 + i % 22) || ':' || (i * 37 % 248956422)
+      WHEN 1 THEN (1 + i % 22) || ':' || (i * 37 % 248956422) || '-' || (i * 37 % 248956422 + 150)
+      WHEN 2 THEN 'chr' || (1 + i % 22) || ':' || to_char(i * 37 % 248956422, 'FM999,999,999')
+      WHEN 3 THEN 'chrX:' || (i * 13 % 156040895) || '-'
+      WHEN 4 THEN 'GL000' || (192 + i % 60) || '.1:-' || (i % 500000)
+      ELSE 'chr' || (1 + i % 22)
+    END
+    FROM generate_series(1, $ROWS) AS i
+  ) TO STDOUT
+" > "$DATA" || exit 1
+
+psql -X -q -d "$DB" -c "CREATE UNLOGGED TABLE IF NOT EXISTS bench_copy_in (l locus)" || exit 1
+
+run=1
+while [ $run -le "$RUNS" ]; do
+  psql -X -q -d "$DB" -c "TRUNCATE bench_copy_in"
+  start=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "\\copy bench_copy_in FROM '$DATA'" || exit 1
+  end=$(date +%s.%N)
+  echo "$start $end" | awk -v rows="$ROWS" -v run="$run" \
+    '{ t = $2 - $1; printf "run %d: %d rows in %.3f s, %.0f rows/s\n", run, rows, t, rows / t }'
+  run=$((run + 1))
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_copy_in"
@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# Measure text-output throughput of the locus type by exporting N loci with
+# COPY TO.  Run it against a database where the extension is installed, once
+# per build to be compared:
+#
+#   bench/copy-out.sh [dbname] [rows] [runs]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-2000000}
+RUNS=${3:-5}
+
+# Every output form: points, closed and half-open ranges, whole contigs.
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_copy_out;
+  CREATE UNLOGGED TABLE bench_copy_out AS
+    SELECT (CASE i % 5
+      WHEN 0 THEN 'chr' || (1 + i % 22) || ':' || (i * 37 % 248956422)
+      WHEN 1 THEN (1 + i % 22) || ':' || (i * 37 % 248956422) || '-' || (i * 37 % 248956422 + 150)
+      WHEN 2 THEN 'chrX:' || (i * 13 % 156040895) || '-'
+      WHEN 3 THEN 'GL000' || (192 + i % 60) || '.1:-' || (i % 500000)
+      ELSE 'chr' || (1 + i % 22)
+    END)::locus AS l
+    FROM generate_series(1, $ROWS) AS i;
+  VACUUM ANALYZE bench_copy_out;
+" || exit 1
+
+run=1
+while [ $run -le "$RUNS" ]; do
+  start=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "COPY bench_copy_out TO STDOUT" > /dev/null || exit 1
+  end=$(date +%s.%N)
+  echo "$start $end" | awk -v rows="$ROWS" -v run="$run" \
+    '{ t = $2 - $1; printf "run %d: %d rows in %.3f s, %.0f rows/s\n", run, rows, t, rows / t }'
+  run=$((run + 1))
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_copy_out"
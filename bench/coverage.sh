@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Time the depth of coverage of N generated 150-base reads on chr1, counted
+# base by base with generate_series and computed by locus_coverage, serially
+# and with parallel workers, and with 1 kb bins.
+#
+#   bench/coverage.sh [dbname] [rows]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_coverage;
+  CREATE UNLOGGED TABLE bench_coverage AS
+    SELECT ('chr1:' || s || '-' || (s + 149))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (random() * 248956272)::int AS s) AS g;
+  VACUUM ANALYZE bench_coverage;
+" || exit 1
+
+run() {
+  psql -X -A -t -d "$DB" <<SQL | awk -v name="$1" '/Execution Time/ { printf "%-18s %10.1f ms\n", name, $3 }'
+SET max_parallel_workers_per_gather = $2;
+EXPLAIN (ANALYZE, COSTS OFF) $3;
+SQL
+}
+
+run "generate_series" 0 "SELECT pos, count(*) FROM bench_coverage, generate_series(lower(l), upper(l)) AS pos GROUP BY pos"
+run "locus_coverage" 0 "SELECT locus_coverage(l) FROM bench_coverage"
+run "parallel" 4 "SELECT locus_coverage(l) FROM bench_coverage"
+run "1 kb bins" 4 "SELECT locus_coverage(l, 1000) FROM bench_coverage"
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_coverage"
@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+# Read regions of a BED file of N generated records, compressed with bgzip
+# and indexed with tabix, through a locus_fdw foreign table, and compare
+# with filtering all of it out of locus_read_bed().  Prints the rows the
+# planner expects against the rows read, and the time of each query.  Needs
+# bgzip and tabix (htslib) on this host; the server must be able to read
+# /tmp of this host, and the user needs the privileges of
+# pg_read_server_files:
+#
+#   bench/fdw.sh [dbname] [rows] [runs]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+RUNS=${3:-5}
+BED=$(mktemp /tmp/locus-fdw.XXXXXX)
+
+trap 'rm -f "$BED" "$BED.gz" "$BED.gz.tbi"' EXIT
+
+psql -X -q -d "$DB" -c "
+  COPY (
+    SELECT 'chr' || c, s, s + 1 + (i % 1000), 'feature' || i, i % 1000
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT 1 + i % 22 AS c, (i * 7919) % 248956422 AS s) AS g
+    ORDER BY c, s
+  ) TO STDOUT
+" > "$BED" || exit 1
+bgzip -f "$BED" && tabix -f -p bed "$BED.gz" || exit 1
+chmod 644 "$BED.gz" "$BED.gz.tbi"
+
+psql -X -q -d "$DB" <<SQL || exit 1
+CREATE SERVER IF NOT EXISTS bench_locus_files FOREIGN DATA WRAPPER locus_fdw;
+DROP FOREIGN TABLE IF EXISTS bench_fdw;
+CREATE FOREIGN TABLE bench_fdw (l locus, chrom text, chrom_start int, chrom_end int,
+                                name text, score int)
+  SERVER bench_locus_files OPTIONS (filename '$BED.gz');
+SQL
+
+run() {
+  psql -X -q -d "$DB" -c "EXPLAIN (ANALYZE, TIMING OFF, SUMMARY ON) $2" |
+    awk -v name="$1" '
+      /Foreign Scan|Function Scan/ && !scan { match($0, /rows=[0-9]+/); est = substr($0, RSTART + 5, RLENGTH - 5);
+                                              match($0, /actual rows=[0-9]+/); act = substr($0, RSTART + 12, RLENGTH - 12); scan = 1 }
+      /Execution Time/ { t = $3 }
+      END { printf "%-28s %10s est %10s rows %10.3f ms\n", name, est, act, t }'
+}
+
+run_all() {
+  run "fdw 10 kb" "SELECT * FROM bench_fdw WHERE l && 'chr7:50000000-50010000'"
+  run "fdw 1 Mb" "SELECT * FROM bench_fdw WHERE l && 'chr7:50000000-51000000'"
+  run "fdw 10 Mb, score > 900" "SELECT * FROM bench_fdw WHERE l && 'chr7:50000000-60000000'
+                                                          AND score > 900"
+  run "fdw <@ 1 Mb" "SELECT * FROM bench_fdw WHERE l <@ 'chr7:50000000-51000000'"
+  run "fdw <all> 100 kb" "SELECT * FROM bench_fdw WHERE '<all>:50000000-50100000' && l"
+  run "fdw whole file" "SELECT * FROM bench_fdw"
+  run "locus_read_bed 1 Mb" "SELECT * FROM locus_read_bed('$BED.gz')
+                             WHERE locus && 'chr7:50000000-51000000'"
+}
+
+i=1
+while [ $i -le "$RUNS" ]; do
+  echo "run $i:"
+  run_all
+  i=$((i + 1))
+done
+
+psql -X -q -d "$DB" -c "DROP FOREIGN TABLE bench_fdw; DROP SERVER bench_locus_files"
@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Time an indexed lookup of a batch of query loci in a GiST-indexed table of
+# N generated loci, as && ANY (one index scan per element) and as && on the
+# whole locus[] (one index scan).
+#
+#   bench/gist-batch.sh [dbname] [rows] [batch]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+BATCH=${3:-5000}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_gist_batch, bench_gist_batch_probe;
+  CREATE UNLOGGED TABLE bench_gist_batch AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  CREATE INDEX bench_gist_batch_ix ON bench_gist_batch USING gist (l);
+  CREATE UNLOGGED TABLE bench_gist_batch_probe AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + 100 + (i % 200)))::locus AS l
+    FROM generate_series(1, $BATCH) AS i,
+         LATERAL (SELECT (i * 104729) % 248956422 AS s) AS g;
+  VACUUM ANALYZE bench_gist_batch;
+" || exit 1
+
+for probe in any array; do
+  if [ $probe = any ]; then
+    query="SELECT count(*) FROM bench_gist_batch WHERE l && ANY (%L::locus[])"
+  else
+    query="SELECT count(*) FROM bench_gist_batch WHERE l && %L::locus[]"
+  fi
+  psql -X -A -t -d "$DB" <<SQL | awk -v p="$probe" '/Execution Time/ { printf "%-6s %10.1f ms\n", p, $3 }'
+SET max_parallel_workers_per_gather = 0;
+SET enable_seqscan = off;
+SELECT format('EXPLAIN (ANALYZE, COSTS OFF) $query', (SELECT array_agg(l)::text FROM bench_gist_batch_probe))
+\\gexec
+SQL
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_gist_batch, bench_gist_batch_probe"
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Compare GiST index builds on N generated loci: the sorted build that
+# gist_locus_ops uses by default against the insertion-based build forced
+# by buffering = on.  Prints build time and index size for each.
+#
+#   bench/gist-build.sh [dbname] [rows]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_gist_build;
+  CREATE UNLOGGED TABLE bench_gist_build AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  VACUUM ANALYZE bench_gist_build;
+" || exit 1
+
+for build in sorted inserted; do
+  if [ $build = sorted ]; then
+    options=""
+  else
+    options="WITH (buffering = on)"
+  fi
+  psql -X -q -d "$DB" -c "DROP INDEX IF EXISTS bench_gist_build_ix"
+  start=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "CREATE INDEX bench_gist_build_ix ON bench_gist_build USING gist (l) $options" || exit 1
+  end=$(date +%s.%N)
+  size=$(psql -X -A -t -d "$DB" -c "SELECT pg_size_pretty(pg_relation_size('bench_gist_build_ix'))")
+  echo "$start $end" | awk -v build="$build" -v size="$size" \
+    '{ printf "%-8s build: %.3f s, index size %s\n", build, $2 - $1, size }'
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_gist_build"
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Count the index pages that single-chromosome probes visit in a GiST index
+# on N generated loci, for both the sorted and the insertion-based build.
+# Run it against two builds of the extension to compare their index keys:
+# with keys that collapse to "<all>" above the leaves, a probe on one contig
+# also descends into the subtrees of the others.
+#
+#   bench/gist-probe.sh [dbname] [rows] [probes]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+PROBES=${3:-500}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_gist_probe;
+  CREATE UNLOGGED TABLE bench_gist_probe AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  VACUUM ANALYZE bench_gist_probe;
+" || exit 1
+
+for build in sorted inserted; do
+  if [ $build = sorted ]; then
+    options=""
+  else
+    options="WITH (buffering = on)"
+  fi
+  psql -X -q -d "$DB" -c "DROP INDEX IF EXISTS bench_gist_probe_ix"
+  psql -X -q -d "$DB" -c "CREATE INDEX bench_gist_probe_ix ON bench_gist_probe USING gist (l) $options" || exit 1
+
+  # Random 10 kb windows and one whole chromosome; buffers of the index
+  # scan only, summed over all probes.
+  for probe in window chromosome; do
+    if [ $probe = window ]; then
+      query="'chr' || (1 + i % 22) || ':' || s || '-' || (s + 10000)"
+      n=$PROBES
+    else
+      query="'chr21'"
+      n=1
+    fi
+    psql -X -A -t -d "$DB" <<SQL | awk -v b="$build" -v p="$probe" -v n="$n" \
+      '/Index Scan|Bitmap Index Scan/ { idx = 1 }
+       /Buffers: shared/ && idx { for (i = 1; i <= NF; i++) if ($i ~ /^(hit|read)=/) { split($i, kv, "="); buf += kv[2] }; idx = 0 }
+       END { printf "%-8s %-10s probes: %.1f index pages per probe\n", b, p, buf / n }'
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SELECT format('EXPLAIN (ANALYZE, BUFFERS, COSTS OFF) SELECT count(*) FROM bench_gist_probe WHERE l && %L', $query)
+FROM generate_series(1, $n) AS i,
+     LATERAL (SELECT (i * 104729) % 248946422 AS s) AS g
+\\gexec
+SQL
+  done
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_gist_probe"
@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Report the shape of an insertion-built GiST index on N loci spread over the
+# GRCh38 chromosomes and inserted in random order, the case where penalty and
+# picksplit decide the tree.  For the keys one level above the leaves it
+# prints how many span several contigs (or "<all>") and, for the rest, the
+# overlap factor: the summed key lengths over the length of their union on
+# each contig, 1.0 when sibling subtrees are disjoint.  Needs pageinspect.
+# Run it against two builds of the extension to compare their splits;
+# bench/gist-probe.sh measures what the difference costs a query.
+#
+#   bench/gist-quality.sh [dbname] [rows]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-2000000}
+
+psql -X -q -d "$DB" -c "
+  CREATE EXTENSION IF NOT EXISTS pageinspect;
+  DROP TABLE IF EXISTS bench_gist_quality;
+  CREATE UNLOGGED TABLE bench_gist_quality AS
+    WITH chr (name, len) AS (
+      VALUES ('chr1', 248956422), ('chr2', 242193529), ('chr3', 198295559),
+             ('chr4', 190214555), ('chr5', 181538259), ('chr6', 170805979),
+             ('chr7', 159345973), ('chr8', 145138636), ('chr9', 138394717),
+             ('chr10', 133797422), ('chr11', 135086622), ('chr12', 133275309),
+             ('chr13', 114364328), ('chr14', 107043718), ('chr15', 101991189),
+             ('chr16', 90338345), ('chr17', 83257441), ('chr18', 80373285),
+             ('chr19', 58617616), ('chr20', 64444167), ('chr21', 46709983),
+             ('chr22', 50818468), ('chrX', 156040895), ('chrY', 57227415)
+    ),
+    genome AS (
+      SELECT name, len, sum(len) OVER (ORDER BY name) - len AS start,
+             sum(len) OVER () AS total
+      FROM chr
+    ),
+    loci AS (
+      SELECT name, (random() * (len - 200000))::int AS s,
+             CASE WHEN r < 0.7 THEN 0
+                  WHEN r < 0.95 THEN exp(random() * 7)::int
+                  ELSE exp(7 + random() * 4.5)::int
+             END AS n
+      FROM (SELECT random() AS u, random() AS r FROM generate_series(1, $ROWS) OFFSET 0) AS g
+           JOIN genome ON g.u * genome.total >= genome.start
+                      AND g.u * genome.total < genome.start + genome.len
+    )
+    SELECT (name || ':' || s || '-' || (s + n))::locus AS l FROM loci ORDER BY random();
+  CREATE INDEX bench_gist_quality_ix ON bench_gist_quality USING gist (l) WITH (buffering = on);
+" || exit 1
+
+psql -X -d "$DB" <<'SQL'
+WITH pages AS (
+  SELECT blkno, (gist_page_opaque_info(get_raw_page('bench_gist_quality_ix', blkno::int))).flags
+  FROM generate_series(0, pg_relation_size('bench_gist_quality_ix') / current_setting('block_size')::int - 1) AS blkno
+),
+keys AS (
+  SELECT substring(i.keys FROM '^\(l\)=\((.*)\)$') AS k
+  FROM pages p,
+       LATERAL gist_page_items(get_raw_page('bench_gist_quality_ix', p.blkno::int), 'bench_gist_quality_ix') AS i
+       JOIN pages c ON c.blkno = (i.ctid::text::point)[0]::bigint
+  WHERE NOT 'leaf' = ANY (p.flags) AND NOT 'deleted' = ANY (p.flags)
+    AND 'leaf' = ANY (c.flags)
+),
+single AS (
+  SELECT k::locus AS l FROM keys WHERE k !~ '^(\{|<all>)'
+),
+contigs AS (
+  SELECT sum(upper(l) - lower(l) + 1) AS covered,
+         (SELECT sum(upper(r) - lower(r))
+          FROM unnest(range_agg(int8range(lower(l), upper(l), '[]'))) AS r) AS spanned
+  FROM single GROUP BY contig(l)
+)
+SELECT (SELECT count(*) FROM pages WHERE 'leaf' = ANY (flags)) AS leaf_pages,
+       (SELECT count(*) FROM keys) AS parent_keys,
+       (SELECT round(100.0 * count(*) FILTER (WHERE k ~ '^(\{|<all>)') / count(*), 1) FROM keys) AS multi_contig_pct,
+       (SELECT round(sum(covered) / sum(spanned), 2) FROM contigs) AS overlap_factor;
+SQL
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_gist_quality"
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Time a scan of N generated loci filtered by a panel of 20000 exon-sized
+# intervals, given as a locus[] to && ANY and as a locus_set to &&.
+#
+#   bench/locus-set.sh [dbname] [rows] [panel]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+PANEL=${3:-20000}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_locus_set, bench_locus_set_panel;
+  CREATE UNLOGGED TABLE bench_locus_set AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  CREATE UNLOGGED TABLE bench_locus_set_panel AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + 100 + (i % 200)))::locus AS l
+    FROM generate_series(1, $PANEL) AS i,
+         LATERAL (SELECT (i * 104729) % 248956422 AS s) AS g;
+  VACUUM ANALYZE bench_locus_set;
+" || exit 1
+
+for probe in any set; do
+  if [ $probe = any ]; then
+    query="SELECT count(*) FROM bench_locus_set WHERE l && ANY (%L::locus[])"
+    panel="SELECT array_agg(l)::text FROM bench_locus_set_panel"
+  else
+    query="SELECT count(*) FROM bench_locus_set WHERE l && %L::locus_set"
+    panel="SELECT locus_set_agg(l)::text FROM bench_locus_set_panel"
+  fi
+  psql -X -A -t -d "$DB" <<SQL | awk -v p="$probe" '/Execution Time/ { printf "%-4s %10.1f ms\n", p, $3 }'
+SET max_parallel_workers_per_gather = 0;
+SELECT format('EXPLAIN (ANALYZE, COSTS OFF) $query', ($panel))
+\\gexec
+SQL
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_locus_set, bench_locus_set_panel"
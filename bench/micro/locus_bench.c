@@ -0,0 +1,755 @@
+/*
+ * contrib/locus/bench/micro/locus_bench.c
+ *
+ * Microbenchmarks of the C code of the extension, without a server
+ *
+ * locus.c, locus_parse.c and strnatcmp.c are compiled unchanged against the
+ * headers in shim/ and linked with shim.c, and their functions are called
+ * as the executor calls them, through a function call frame.  The inputs
+ * are synthetic loci shaped like variant calls on GRCh38: contigs drawn in
+ * proportion to their lengths, mostly spelled with "chr", and mostly single
+ * bases, with some indels, longer events and structural variants.  Each
+ * benchmark runs a round that is not timed, then the given number of timed
+ * rounds, and reports the median and the fastest time per operation:
+ *
+ *   locus_in       parse the text of a locus
+ *   locus_out      format a locus
+ *   locus_cmp      compare two loci (B-tree order)
+ *   strnatcmp      compare two contig names in natural order
+ *   locus_overlap  the && operator
+ *   penalty        the GiST penalty of a locus for the key of a page
+ *   picksplit      the GiST split of a full leaf page
+ *
+ * Half of the pairs compared are drawn at random, mostly on different
+ * contigs; the other half are near neighbours in sorted order, as a sort or
+ * a merge meets them.  Results are written as tab-separated values, or as
+ * JSON with -f json; with -b, the median of each benchmark is compared with
+ * that of an earlier TSV run, and with -t the program exits with status 2
+ * when one of them got slower by more than the given percentage.
+ *
+ *   locus_bench [-n loci] [-r rounds] [-s seed] [-f tsv|json]
+ *               [-b baseline.tsv [-t percent]] [benchmark ...]
+ */
+#include "postgres.h"
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fmgr.h"
+#include "access/gist.h"
+
+#include "locus_data.h"
+#include "shim.h"
+
+extern Datum locus_in(PG_FUNCTION_ARGS);
+extern Datum gist_locus_union(PG_FUNCTION_ARGS);
+extern Datum gist_locus_penalty(PG_FUNCTION_ARGS);
+extern Datum gist_locus_picksplit(PG_FUNCTION_ARGS);
+
+/* entries of a leaf page that is split: 8 kB over 32-byte keys with tuple
+ * headers and line pointers */
+#define LEAF_PAGE_ENTRIES  180
+
+/* keys of an internal page that penalty chooses from */
+#define INTERNAL_PAGE_ENTRIES  100
+
+/*****************************************************************************
+ * Synthetic input
+ *****************************************************************************/
+
+typedef struct BenchContig
+{
+  const char *name;       /* without "chr" */
+  int32       length;
+} BenchContig;
+
+/* GRCh38, with two of its unplaced scaffolds */
+static const BenchContig contigs[] = {
+  {"1", 248956422}, {"2", 242193529}, {"3", 198295559}, {"4", 190214555},
+  {"5", 181538259}, {"6", 170805979}, {"7", 159345973}, {"8", 145138636},
+  {"9", 138394717}, {"10", 133797422}, {"11", 135086622}, {"12", 133275309},
+  {"13", 114364328}, {"14", 107043718}, {"15", 101991189}, {"16", 90338345},
+  {"17", 83257441}, {"18", 80373285}, {"19", 58617616}, {"20", 64444167},
+  {"21", 46709983}, {"22", 50818468}, {"X", 156040895}, {"Y", 57227415},
+  {"M", 16569}, {"GL000195.1", 182896}, {"KI270733.1", 179772}
+};
+
+static uint64 rng_state;
+
+/* splitmix64 */
+static uint64
+rng_next(void)
+{
+  uint64      z = (rng_state += UINT64CONST(0x9e3779b97f4a7c15));
+
+  z = (z ^ (z >> 30)) * UINT64CONST(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64CONST(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+/* uniform in [0, n) */
+static int64
+rng_below(int64 n)
+{
+  return (int64) (rng_next() % (uint64) n);
+}
+
+/* log-uniform in [lo, hi] */
+static int32
+rng_log_uniform(int32 lo, int32 hi)
+{
+  double      u = (double) (rng_next() >> 11) / (double) (UINT64CONST(1) << 53);
+
+  return (int32) floor(exp(log(lo) + u * (log(hi + 1.0) - log(lo))));
+}
+
+static const BenchContig *
+random_contig(void)
+{
+  static int64 total = 0;
+  int64       pick;
+  int         i;
+
+  if (total == 0)
+    for (i = 0; i < lengthof(contigs); i++)
+      total += contigs[i].length;
+
+  pick = rng_below(total);
+  for (i = 0; i < lengthof(contigs) - 1; i++)
+  {
+    if (pick < contigs[i].length)
+      break;
+    pick -= contigs[i].length;
+  }
+  return &contigs[i];
+}
+
+/*
+ * Write the text of a random locus into buf, in the form locus_out() gives
+ * it: 70% single bases, 20% indels of up to 50 bases, 8% events of up to
+ * 10 kb and 2% structural variants of up to 1 Mb.
+ */
+static void
+random_locus_text(char *buf, size_t size)
+{
+  const BenchContig *contig = random_contig();
+  const char *prefix = rng_below(10) < 8 ? "chr" : "";
+  int64       kind = rng_below(100);
+  int32       length;
+  int32       lower;
+
+  if (kind < 70)
+    length = 1;
+  else if (kind < 90)
+    length = 2 + (int32) rng_below(49);
+  else if (kind < 98)
+    length = rng_log_uniform(51, 10000);
+  else
+    length = rng_log_uniform(10001, 1000000);
+
+  length = Min(length, contig->length);
+  lower = 1 + (int32) rng_below(contig->length - length + 1);
+
+  if (length == 1)
+    snprintf(buf, size, "%s%s:%d", prefix, contig->name, lower);
+  else
+    snprintf(buf, size, "%s%s:%d-%d", prefix, contig->name, lower,
+             lower + length - 1);
+}
+
+/*****************************************************************************
+ * Calling the functions of the extension
+ *****************************************************************************/
+
+static Datum
+call1(PGFunction func, Datum arg1)
+{
+  LOCAL_FCINFO(fcinfo, 1);
+
+  InitFunctionCallInfoData(*fcinfo, NULL, 1, InvalidOid, NULL, NULL);
+  fcinfo->args[0].value = arg1;
+  fcinfo->args[0].isnull = false;
+
+  return (*func) (fcinfo);
+}
+
+static Datum
+call2(PGFunction func, Datum arg1, Datum arg2)
+{
+  LOCAL_FCINFO(fcinfo, 2);
+
+  InitFunctionCallInfoData(*fcinfo, NULL, 2, InvalidOid, NULL, NULL);
+  fcinfo->args[0].value = arg1;
+  fcinfo->args[0].isnull = false;
+  fcinfo->args[1].value = arg2;
+  fcinfo->args[1].isnull = false;
+
+  return (*func) (fcinfo);
+}
+
+static Datum
+call3(PGFunction func, Datum arg1, Datum arg2, Datum arg3)
+{
+  LOCAL_FCINFO(fcinfo, 3);
+
+  InitFunctionCallInfoData(*fcinfo, NULL, 3, InvalidOid, NULL, NULL);
+  fcinfo->args[0].value = arg1;
+  fcinfo->args[0].isnull = false;
+  fcinfo->args[1].value = arg2;
+  fcinfo->args[1].isnull = false;
+  fcinfo->args[2].value = arg3;
+  fcinfo->args[2].isnull = false;
+
+  return (*func) (fcinfo);
+}
+
+/*****************************************************************************
+ * The data the benchmarks share
+ *****************************************************************************/
+
+typedef struct BenchData
+{
+  int         n;
+  char      **texts;      /* the text of each locus */
+  LOCUS      *loci;       /* and the locus */
+  LOCUS      *sorted;     /* the loci in B-tree order */
+  int        *pairs;      /* two indexes into loci for each pair */
+  char      **names;      /* the contig of each locus, as spelled */
+  LOCUS      *keys;       /* union keys of runs of sorted loci */
+  int         nkeys;
+  GistEntryVector **pages;  /* full leaf pages */
+  int         npages;
+} BenchData;
+
+static int
+sorted_cmp(const void *a, const void *b)
+{
+  return locus_cmp_internal((LOCUS *) a, (LOCUS *) b);
+}
+
+/*
+ * The union key of count loci, as gist_locus_union() computes it for the
+ * downlink of a page holding them
+ */
+static void
+union_key(LOCUS *loci, int count, LOCUS *key)
+{
+  GistEntryVector *entryvec;
+  int         size;
+  int         i;
+
+  entryvec = palloc(GEVHDRSZ + count * sizeof(GISTENTRY));
+  entryvec->n = count;
+  for (i = 0; i < count; i++)
+    gistentryinit(entryvec->vector[i], PointerGetDatum(&loci[i]),
+                  NULL, NULL, i, false);
+
+  memcpy(key, DatumGetPointer(call2(gist_locus_union,
+                                    PointerGetDatum(entryvec),
+                                    PointerGetDatum(&size))),
+         sizeof(LOCUS));
+}
+
+static void
+check_parse(const char *text, const char *contig, int32 lower, int32 upper,
+            bool chr)
+{
+  LOCUS      *locus = DatumGetLocusP(call1(locus_in, CStringGetDatum(text)));
+
+  if (strcmp(locus->contig, contig) != 0 || locus->lower != lower ||
+      locus->upper != upper || locus->chr != chr)
+  {
+    fprintf(stderr, "locus_in(\"%s\") gave %s%s:%d-%d\n", text,
+            locus->chr ? "chr" : "", locus->contig, locus->lower, locus->upper);
+    exit(1);
+  }
+}
+
+static void
+bench_setup(BenchData *data, int n)
+{
+  char        buf[64];
+  int         i;
+
+  /* the parser and the shim agree on a few known values */
+  check_parse("chr8:10000-10005", "8", 10000, 10005, true);
+  check_parse("X:1500", "X", 1500, 1500, false);
+  check_parse("chrGL000195.1:1-182896", "GL000195.1", 1, 182896, true);
+  shim_reset();
+
+  data->n = n;
+  data->texts = malloc(n * sizeof(char *));
+  data->loci = malloc(n * sizeof(LOCUS));
+  data->sorted = malloc(n * sizeof(LOCUS));
+  data->pairs = malloc(2 * n * sizeof(int));
+  data->names = malloc(2 * n * sizeof(char *));
+
+  for (i = 0; i < n; i++)
+  {
+    char       *out;
+
+    random_locus_text(buf, sizeof(buf));
+    data->texts[i] = strdup(buf);
+    memcpy(&data->loci[i], DatumGetPointer(call1(locus_in, CStringGetDatum(buf))),
+           sizeof(LOCUS));
+
+    /* the text is canonical, so it comes back as it went in */
+    out = DatumGetCString(call1(locus_out, PointerGetDatum(&data->loci[i])));
+    if (strcmp(out, buf) != 0)
+    {
+      fprintf(stderr, "locus_out(locus_in(\"%s\")) gave \"%s\"\n", buf, out);
+      exit(1);
+    }
+    shim_reset();
+  }
+
+  memcpy(data->sorted, data->loci, n * sizeof(LOCUS));
+  qsort(data->sorted, n, sizeof(LOCUS), sorted_cmp);
+
+  /*
+   * Pairs: random ones at even positions, and neighbours in sorted order,
+   * up to 16 apart, at odd ones.  Indexes of sorted loci are marked by
+   * adding n.
+   */
+  for (i = 0; i < n; i++)
+  {
+    int        *pair = &data->pairs[2 * i];
+
+    if (i % 2 == 0)
+    {
+      pair[0] = (int) rng_below(n);
+      pair[1] = (int) rng_below(n);
+    }
+    else
+    {
+      int         step = 1 + (int) rng_below(16);
+
+      pair[0] = n + (int) rng_below(n);
+      pair[1] = Min(pair[0] + step, 2 * n - 1);
+    }
+  }
+
+  for (i = 0; i < 2 * n; i++)
+  {
+    int         k = data->pairs[i];
+    LOCUS      *locus = k < n ? &data->loci[k] : &data->sorted[k - n];
+
+    snprintf(buf, sizeof(buf), "%s%s", locus->chr ? "chr" : "", locus->contig);
+    data->names[i] = strdup(buf);
+  }
+
+  /* the downlinks of leaf pages filled in sorted order, as a build does */
+  data->nkeys = Max(n / LEAF_PAGE_ENTRIES, 1);
+  data->keys = malloc(data->nkeys * sizeof(LOCUS));
+  for (i = 0; i < data->nkeys; i++)
+  {
+    int         first = (int) ((int64) i * n / data->nkeys);
+    int         last = (int) ((int64) (i + 1) * n / data->nkeys);
+
+    union_key(&data->sorted[first], last - first, &data->keys[i]);
+  }
+  shim_reset();
+
+  /*
+   * Pages to split: runs of sorted loci one over a full page, some of which
+   * span two contigs, plus one locus from elsewhere.  Entries start at 1.
+   */
+  data->npages = Max(n / LEAF_PAGE_ENTRIES, 1);
+  data->pages = malloc(data->npages * sizeof(GistEntryVector *));
+  for (i = 0; i < data->npages; i++)
+  {
+    int         count = Min(LEAF_PAGE_ENTRIES + 1, n);
+    int         first = (int) rng_below(n - count + 1);
+    GistEntryVector *entryvec;
+    int         j;
+
+    entryvec = malloc(GEVHDRSZ + (count + 1) * sizeof(GISTENTRY));
+    entryvec->n = count + 1;
+    for (j = 1; j < count; j++)
+      gistentryinit(entryvec->vector[j], PointerGetDatum(&data->sorted[first + j - 1]),
+                    NULL, NULL, j, false);
+    gistentryinit(entryvec->vector[count], PointerGetDatum(&data->loci[rng_below(n)]),
+                  NULL, NULL, count, false);
+    data->pages[i] = entryvec;
+  }
+}
+
+static inline LOCUS *
+pair_locus(BenchData *data, int i)
+{
+  int         k = data->pairs[i];
+
+  return k < data->n ? &data->loci[k] : &data->sorted[k - data->n];
+}
+
+/*****************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+
+/* keeps the compiler from dropping the calls */
+static volatile uint64 sink;
+
+typedef int64 (*BenchFunc) (BenchData *data);
+
+static int64
+bench_locus_in(BenchData *data)
+{
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->n; i++)
+    acc += DatumGetLocusP(call1(locus_in, CStringGetDatum(data->texts[i])))->lower;
+
+  sink += acc;
+  return data->n;
+}
+
+static int64
+bench_locus_out(BenchData *data)
+{
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->n; i++)
+    acc += DatumGetCString(call1(locus_out, PointerGetDatum(&data->loci[i])))[0];
+
+  sink += acc;
+  return data->n;
+}
+
+static int64
+bench_locus_cmp(BenchData *data)
+{
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->n; i++)
+    acc += DatumGetInt32(call2(locus_cmp,
+                               PointerGetDatum(pair_locus(data, 2 * i)),
+                               PointerGetDatum(pair_locus(data, 2 * i + 1))));
+
+  sink += acc;
+  return data->n;
+}
+
+static int64
+bench_strnatcmp(BenchData *data)
+{
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->n; i++)
+    acc += strnatcmp(data->names[2 * i], data->names[2 * i + 1]);
+
+  sink += acc;
+  return data->n;
+}
+
+static int64
+bench_locus_overlap(BenchData *data)
+{
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->n; i++)
+    acc += DatumGetBool(call2(locus_overlap,
+                              PointerGetDatum(pair_locus(data, 2 * i)),
+                              PointerGetDatum(pair_locus(data, 2 * i + 1))));
+
+  sink += acc;
+  return data->n;
+}
+
+/*
+ * Choose a subtree for each locus, as an insertion does: the penalty of the
+ * locus for each key of an internal page
+ */
+static int64
+bench_penalty(BenchData *data)
+{
+  GISTENTRY   orig;
+  GISTENTRY   new;
+  float       penalty;
+  double      acc = 0;
+  int64       ops = 0;
+  int         per_locus = Min(INTERNAL_PAGE_ENTRIES, data->nkeys);
+  int         i,
+              j;
+
+  for (i = 0; i < data->n; i++)
+  {
+    int         first = i % (data->nkeys - per_locus + 1);
+
+    gistentryinit(new, PointerGetDatum(&data->loci[i]), NULL, NULL, 0, false);
+    for (j = first; j < first + per_locus; j++)
+    {
+      gistentryinit(orig, PointerGetDatum(&data->keys[j]), NULL, NULL, 0, false);
+      call3(gist_locus_penalty, PointerGetDatum(&orig), PointerGetDatum(&new),
+            PointerGetDatum(&penalty));
+      acc += penalty;
+    }
+    ops += per_locus;
+  }
+
+  sink += (uint64) acc;
+  return ops;
+}
+
+static int64
+bench_picksplit(BenchData *data)
+{
+  GIST_SPLITVEC v;
+  uint64      acc = 0;
+  int         i;
+
+  for (i = 0; i < data->npages; i++)
+  {
+    call2(gist_locus_picksplit, PointerGetDatum(data->pages[i]),
+          PointerGetDatum(&v));
+    acc += v.spl_nleft;
+  }
+
+  sink += acc;
+  return data->npages;
+}
+
+typedef struct Benchmark
+{
+  const char *name;
+  BenchFunc   func;
+  double      median;     /* ns per operation */
+  double      min;
+  int64       ops;        /* in a round */
+  bool        run;
+} Benchmark;
+
+static Benchmark benchmarks[] = {
+  {"locus_in", bench_locus_in},
+  {"locus_out", bench_locus_out},
+  {"locus_cmp", bench_locus_cmp},
+  {"strnatcmp", bench_strnatcmp},
+  {"locus_overlap", bench_locus_overlap},
+  {"penalty", bench_penalty},
+  {"picksplit", bench_picksplit},
+};
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int
+double_cmp(const void *a, const void *b)
+{
+  double      x = *(const double *) a;
+  double      y = *(const double *) b;
+
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+bench_run(Benchmark *bench, BenchData *data, int rounds)
+{
+  double     *times = malloc(rounds * sizeof(double));
+  int         r;
+
+  bench->func(data);
+  shim_reset();
+
+  for (r = 0; r < rounds; r++)
+  {
+    double      start = now_ns();
+
+    bench->ops = bench->func(data);
+    times[r] = (now_ns() - start) / bench->ops;
+    shim_reset();
+  }
+
+  qsort(times, rounds, sizeof(double), double_cmp);
+  bench->min = times[0];
+  bench->median = rounds % 2 ? times[rounds / 2] :
+    (times[rounds / 2 - 1] + times[rounds / 2]) / 2;
+  free(times);
+}
+
+/*****************************************************************************
+ * Output
+ *****************************************************************************/
+
+/* the medians of an earlier run, or -1 */
+static double
+baseline_median(const char *path, const char *name)
+{
+  FILE       *file = fopen(path, "r");
+  char        line[256];
+  double      result = -1;
+
+  if (file == NULL)
+  {
+    fprintf(stderr, "could not open \"%s\": %s\n", path, strerror(errno));
+    exit(1);
+  }
+
+  while (fgets(line, sizeof(line), file) != NULL)
+  {
+    char        found[64];
+    long long   ops;
+    double      median;
+
+    if (line[0] == '#')
+      continue;
+    if (sscanf(line, "%63s %lld %lf", found, &ops, &median) == 3 &&
+        strcmp(found, name) == 0)
+    {
+      result = median;
+      break;
+    }
+  }
+
+  fclose(file);
+  return result;
+}
+
+static void
+usage(const char *progname)
+{
+  int         i;
+
+  fprintf(stderr,
+          "usage: %s [-n loci] [-r rounds] [-s seed] [-f tsv|json]\n"
+          "       %*s [-b baseline.tsv [-t percent]] [benchmark ...]\n"
+          "benchmarks:",
+          progname, (int) strlen(progname), "");
+  for (i = 0; i < lengthof(benchmarks); i++)
+    fprintf(stderr, " %s", benchmarks[i].name);
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+  BenchData   data;
+  int         n = 100000;
+  int         rounds = 5;
+  uint64      seed = 42;
+  bool        json = false;
+  const char *baseline = NULL;
+  double      threshold = -1;
+  bool        regressed = false;
+  bool        first = true;
+  int         c;
+  int         i;
+
+  while ((c = getopt(argc, argv, "n:r:s:f:b:t:h")) != -1)
+  {
+    switch (c)
+    {
+      case 'n':
+        n = atoi(optarg);
+        break;
+      case 'r':
+        rounds = atoi(optarg);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'f':
+        if (strcmp(optarg, "json") == 0)
+          json = true;
+        else if (strcmp(optarg, "tsv") != 0)
+          usage(argv[0]);
+        break;
+      case 'b':
+        baseline = optarg;
+        break;
+      case 't':
+        threshold = atof(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (n < 2 || rounds < 1 || (threshold >= 0 && baseline == NULL))
+    usage(argv[0]);
+
+  for (i = 0; i < lengthof(benchmarks); i++)
+    benchmarks[i].run = (optind == argc);
+  for (; optind < argc; optind++)
+  {
+    for (i = 0; i < lengthof(benchmarks); i++)
+      if (strcmp(argv[optind], benchmarks[i].name) == 0)
+        break;
+    if (i == lengthof(benchmarks))
+      usage(argv[0]);
+    benchmarks[i].run = true;
+  }
+
+  rng_state = seed;
+  bench_setup(&data, n);
+
+  if (json)
+    printf("{\"loci\": %d, \"rounds\": %d, \"seed\": %llu, \"results\": [",
+           n, rounds, (unsigned long long) seed);
+  else
+    printf("# locus_bench loci=%d rounds=%d seed=%llu\n"
+           "benchmark\tops\tns_per_op\tmin_ns_per_op%s\n",
+           n, rounds, (unsigned long long) seed,
+           baseline ? "\tbaseline_ns_per_op\tchange_pct" : "");
+
+  for (i = 0; i < lengthof(benchmarks); i++)
+  {
+    Benchmark  *bench = &benchmarks[i];
+    double      base = -1;
+    double      change = 0;
+
+    if (!bench->run)
+      continue;
+
+    bench_run(bench, &data, rounds);
+
+    if (baseline != NULL)
+    {
+      base = baseline_median(baseline, bench->name);
+      if (base > 0)
+      {
+        change = 100.0 * (bench->median / base - 1.0);
+        if (threshold >= 0 && change > threshold)
+          regressed = true;
+      }
+    }
+
+    if (json)
+    {
+      printf("%s\n  {\"benchmark\": \"%s\", \"ops\": %lld, \"ns_per_op\": %.2f, "
+             "\"min_ns_per_op\": %.2f",
+             first ? "" : ",", bench->name, (long long) bench->ops,
+             bench->median, bench->min);
+      if (base > 0)
+        printf(", \"baseline_ns_per_op\": %.2f, \"change_pct\": %.1f", base, change);
+      printf("}");
+    }
+    else
+    {
+      printf("%s\t%lld\t%.2f\t%.2f", bench->name, (long long) bench->ops,
+             bench->median, bench->min);
+      if (base > 0)
+        printf("\t%.2f\t%+.1f", base, change);
+      else if (baseline != NULL)
+        printf("\t\t");
+      printf("\n");
+    }
+    fflush(stdout);
+    first = false;
+  }
+
+  if (json)
+    printf("\n]}\n");
+
+  return regressed ? 2 : 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * contrib/locus/bench/micro/shim.c
+ *
+ * The server functions that locus.c and locus_parse.c call, for the
+ * microbenchmark.  palloc() takes memory from an arena that shim_reset()
+ * rewinds, so that a round of a benchmark allocates as the server would,
+ * without the cost of malloc() per value or a leak across rounds.  An error
+ * prints its message and ends the program.  The functions that no benchmark
+ * reaches end it too, with the name of the function.
+ */
+#include "postgres.h"
+
+#include <stdarg.h>
+
+#include "fmgr.h"
+#include "funcapi.h"
+#include "common/hashfn.h"
+#include "lib/hyperloglog.h"
+#include "libpq/pqformat.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/rangetypes.h"
+#include "utils/sortsupport.h"
+
+#include "locus_data.h"
+#include "shim.h"
+
+MemoryContext CurrentMemoryContext = NULL;
+
+/*****************************************************************************
+ * Memory
+ *****************************************************************************/
+
+#define ARENA_BLOCK_SIZE  (1024 * 1024)
+
+/* a block of the arena; large requests get a block of their own */
+typedef struct ArenaBlock
+{
+  struct ArenaBlock *next;
+  Size        size;
+  Size        used;
+  char        data[FLEXIBLE_ARRAY_MEMBER];
+} ArenaBlock;
+
+static ArenaBlock *arena = NULL;
+
+void *
+palloc(Size size)
+{
+  ArenaBlock *block = arena;
+  void       *result;
+
+  size = MAXALIGN(size);
+  if (block == NULL || block->size - block->used < size)
+  {
+    Size    block_size = Max(size, ARENA_BLOCK_SIZE);
+
+    block = malloc(offsetof(ArenaBlock, data) + block_size);
+    if (block == NULL)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+    block->size = block_size;
+    block->used = 0;
+    block->next = arena;
+    arena = block;
+  }
+
+  result = block->data + block->used;
+  block->used += size;
+  return result;
+}
+
+void *
+palloc0(Size size)
+{
+  return memset(palloc(size), 0, size);
+}
+
+void
+pfree(void *pointer)
+{
+}
+
+char *
+psprintf(const char *fmt,...)
+{
+  va_list     args;
+  char       *result;
+  int         len;
+
+  va_start(args, fmt);
+  len = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+
+  result = palloc(len + 1);
+  va_start(args, fmt);
+  vsnprintf(result, len + 1, fmt, args);
+  va_end(args);
+
+  return result;
+}
+
+/*
+ * Free all that palloc() returned, keeping one block for the next round
+ */
+void
+shim_reset(void)
+{
+  while (arena != NULL && arena->next != NULL)
+  {
+    ArenaBlock *next = arena->next;
+
+    free(arena);
+    arena = next;
+  }
+  if (arena != NULL)
+  {
+    if (arena->size > ARENA_BLOCK_SIZE)
+    {
+      free(arena);
+      arena = NULL;
+    }
+    else
+      arena->used = 0;
+  }
+}
+
+/*****************************************************************************
+ * Errors
+ *****************************************************************************/
+
+static char shim_message[1024];
+
+void
+shim_errstart(int elevel)
+{
+  shim_message[0] = '\0';
+}
+
+void
+shim_errfinish(int elevel, const char *filename, int lineno)
+{
+  if (elevel < ERROR)
+    return;
+
+  fprintf(stderr, "ERROR:  %s (%s:%d)\n", shim_message, filename, lineno);
+  exit(1);
+}
+
+int
+errcode(int sqlerrcode)
+{
+  return 0;
+}
+
+#define SHIM_FORMAT(fmt) \
+  do { \
+    va_list args; \
+    va_start(args, fmt); \
+    vsnprintf(shim_message, sizeof(shim_message), fmt, args); \
+    va_end(args); \
+  } while (0)
+
+int
+errmsg(const char *fmt,...)
+{
+  SHIM_FORMAT(fmt);
+  return 0;
+}
+
+int
+errmsg_internal(const char *fmt,...)
+{
+  SHIM_FORMAT(fmt);
+  return 0;
+}
+
+int
+errdetail(const char *fmt,...)
+{
+  return 0;
+}
+
+int
+errhint(const char *fmt,...)
+{
+  return 0;
+}
+
+/*****************************************************************************
+ * Functions that the benchmarks use
+ *****************************************************************************/
+
+/* as in src/backend/utils/adt/numutils.c, without the two-digit table */
+int
+pg_ltoa(int32 value, char *a)
+{
+  uint32      uvalue = (uint32) value;
+  char        digits[10];
+  int         len = 0;
+  int         n = 0;
+
+  if (value < 0)
+  {
+    uvalue = (uint32) 0 - uvalue;
+    a[len++] = '-';
+  }
+
+  do
+  {
+    digits[n++] = '0' + uvalue % 10;
+    uvalue /= 10;
+  } while (uvalue != 0);
+
+  while (n > 0)
+    a[len++] = digits[--n];
+  a[len] = '\0';
+
+  return len;
+}
+
+Datum
+DirectFunctionCall2Coll(PGFunction func, Oid collation, Datum arg1, Datum arg2)
+{
+  LOCAL_FCINFO(fcinfo, 2);
+  Datum       result;
+
+  InitFunctionCallInfoData(*fcinfo, NULL, 2, collation, NULL, NULL);
+  fcinfo->args[0].value = arg1;
+  fcinfo->args[0].isnull = false;
+  fcinfo->args[1].value = arg2;
+  fcinfo->args[1].isnull = false;
+
+  result = (*func) (fcinfo);
+  if (fcinfo->isnull)
+    elog(ERROR, "function returned NULL");
+
+  return result;
+}
+
+/*****************************************************************************
+ * Functions that no benchmark reaches
+ *****************************************************************************/
+
+static void shim_unreachable(const char *name) pg_attribute_noreturn();
+
+static void
+shim_unreachable(const char *name)
+{
+  fprintf(stderr, "ERROR:  %s() is not available in the microbenchmark\n", name);
+  exit(1);
+}
+
+#define UNREACHABLE(name)  shim_unreachable(name); pg_unreachable()
+
+void locus_sweep_init(void) { UNREACHABLE("locus_sweep_init"); }
+void plocus_view(PLOCUS *value, LOCUS *locus) { UNREACHABLE("plocus_view"); }
+
+void MarkGUCPrefixReserved(const char *className) { UNREACHABLE("MarkGUCPrefixReserved"); }
+Oid get_fn_expr_rettype(FmgrInfo *flinfo) { UNREACHABLE("get_fn_expr_rettype"); }
+bool get_fn_expr_arg_stable(FmgrInfo *flinfo, int argnum) { UNREACHABLE("get_fn_expr_arg_stable"); }
+text *cstring_to_text(const char *s) { UNREACHABLE("cstring_to_text"); }
+
+FuncCallContext *init_MultiFuncCall(PG_FUNCTION_ARGS) { UNREACHABLE("init_MultiFuncCall"); }
+FuncCallContext *per_MultiFuncCall(PG_FUNCTION_ARGS) { UNREACHABLE("per_MultiFuncCall"); }
+void end_MultiFuncCall(PG_FUNCTION_ARGS, FuncCallContext *funcctx) { UNREACHABLE("end_MultiFuncCall"); }
+
+Datum hash_any(const unsigned char *k, int keylen) { UNREACHABLE("hash_any"); }
+Datum hash_any_extended(const unsigned char *k, int keylen, uint64 seed) { UNREACHABLE("hash_any_extended"); }
+Datum hash_uint32(uint32 k) { UNREACHABLE("hash_uint32"); }
+Datum hash_uint32_extended(uint32 k, uint64 seed) { UNREACHABLE("hash_uint32_extended"); }
+
+void initHyperLogLog(hyperLogLogState *cState, uint8 bwidth) { UNREACHABLE("initHyperLogLog"); }
+void addHyperLogLog(hyperLogLogState *cState, uint32 hash) { UNREACHABLE("addHyperLogLog"); }
+double estimateHyperLogLog(hyperLogLogState *cState) { UNREACHABLE("estimateHyperLogLog"); }
+
+void pq_begintypsend(StringInfo buf) { UNREACHABLE("pq_begintypsend"); }
+bytea *pq_endtypsend(StringInfo buf) { UNREACHABLE("pq_endtypsend"); }
+void pq_sendbyte(StringInfo buf, uint8 byt) { UNREACHABLE("pq_sendbyte"); }
+void pq_sendbytes(StringInfo buf, const void *data, int datalen) { UNREACHABLE("pq_sendbytes"); }
+void pq_sendint32(StringInfo buf, uint32 i) { UNREACHABLE("pq_sendint32"); }
+int pq_getmsgbyte(StringInfo msg) { UNREACHABLE("pq_getmsgbyte"); }
+unsigned int pq_getmsgint(StringInfo msg, int b) { UNREACHABLE("pq_getmsgint"); }
+const char *pq_getmsgbytes(StringInfo msg, int datalen) { UNREACHABLE("pq_getmsgbytes"); }
+
+int ArrayGetNItems(int ndim, const int *dims) { UNREACHABLE("ArrayGetNItems"); }
+ArrayIterator array_create_iterator(ArrayType *arr, int slice_ndim, void *mstate) { UNREACHABLE("array_create_iterator"); }
+bool array_iterate(ArrayIterator iterator, Datum *value, bool *isnull) { UNREACHABLE("array_iterate"); }
+void array_free_iterator(ArrayIterator iterator) { UNREACHABLE("array_free_iterator"); }
+
+int ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup) { UNREACHABLE("ssup_datum_unsigned_cmp"); }
+TypeCacheEntry *range_get_typcache(FunctionCallInfo fcinfo, Oid rngtypid) { UNREACHABLE("range_get_typcache"); }
+RangeType *range_serialize(TypeCacheEntry *typcache, RangeBound *lower, RangeBound *upper, bool empty, struct Node *escontext) { UNREACHABLE("range_serialize"); }
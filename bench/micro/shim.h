@@ -0,0 +1,9 @@
+/*
+ * contrib/locus/bench/micro/shim.h
+ */
+#ifndef LOCUS_BENCH_SHIM_H
+#define LOCUS_BENCH_SHIM_H
+
+extern void shim_reset(void);
+
+#endif              /* LOCUS_BENCH_SHIM_H */
@@ -0,0 +1,53 @@
+/*
+ * contrib/locus/bench/micro/shim/access/gist.h
+ *
+ * The structs that GiST support functions receive.
+ */
+#ifndef LOCUS_SHIM_GIST_H
+#define LOCUS_SHIM_GIST_H
+
+#include "access/stratnum.h"
+
+typedef struct RelationData *Relation;
+typedef char *Page;
+
+typedef struct GISTENTRY
+{
+  Datum       key;
+  Relation    rel;
+  Page        page;
+  OffsetNumber offset;
+  bool        leafkey;
+} GISTENTRY;
+
+typedef struct GistEntryVector
+{
+  int32       n;
+  GISTENTRY   vector[FLEXIBLE_ARRAY_MEMBER];
+} GistEntryVector;
+
+#define GEVHDRSZ  (offsetof(GistEntryVector, vector))
+
+typedef struct GIST_SPLITVEC
+{
+  OffsetNumber *spl_left;
+  int         spl_nleft;
+  Datum       spl_ldatum;
+  bool        spl_ldatum_exists;
+  OffsetNumber *spl_right;
+  int         spl_nright;
+  Datum       spl_rdatum;
+  bool        spl_rdatum_exists;
+} GIST_SPLITVEC;
+
+#define GIST_LEAF(entry)  ((entry)->leafkey)
+
+#define gistentryinit(e, k, r, pg, o, l) \
+  do { \
+    (e).key = (k); (e).rel = (r); (e).page = (pg); \
+    (e).offset = (o); (e).leafkey = (l); \
+  } while (0)
+
+#define FirstOffsetNumber  ((OffsetNumber) 1)
+
+#endif              /* LOCUS_SHIM_GIST_H */
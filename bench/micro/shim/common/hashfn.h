@@ -0,0 +1,26 @@
+/*
+ * contrib/locus/bench/micro/shim/common/hashfn.h
+ */
+#ifndef LOCUS_SHIM_HASHFN_H
+#define LOCUS_SHIM_HASHFN_H
+
+extern Datum hash_any(const unsigned char *k, int keylen);
+extern Datum hash_any_extended(const unsigned char *k, int keylen, uint64 seed);
+extern Datum hash_uint32(uint32 k);
+extern Datum hash_uint32_extended(uint32 k, uint64 seed);
+
+static inline uint32
+hash_combine(uint32 a, uint32 b)
+{
+  a ^= b + 0x9e3779b9 + (a << 6) + (a >> 2);
+  return a;
+}
+
+static inline uint64
+hash_combine64(uint64 a, uint64 b)
+{
+  a ^= b + UINT64CONST(0x49a0f4dd15e5a8e3) + (a << 54) + (a >> 7);
+  return a;
+}
+
+#endif              /* LOCUS_SHIM_HASHFN_H */
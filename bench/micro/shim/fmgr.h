@@ -0,0 +1,115 @@
+/*
+ * contrib/locus/bench/micro/shim/fmgr.h
+ *
+ * The version-1 calling convention, as in the server.  The harness calls
+ * the functions of the extension through LOCAL_FCINFO() frames.
+ */
+#ifndef LOCUS_SHIM_FMGR_H
+#define LOCUS_SHIM_FMGR_H
+
+#include "postgres.h"
+
+typedef struct Node Node;
+
+typedef struct FmgrInfo
+{
+  void       *fn_addr;
+  Oid         fn_oid;
+  short       fn_nargs;
+  bool        fn_strict;
+  void       *fn_extra;
+  MemoryContext fn_mcxt;
+  Node       *fn_expr;
+} FmgrInfo;
+
+typedef struct NullableDatum
+{
+  Datum       value;
+  bool        isnull;
+} NullableDatum;
+
+typedef struct FunctionCallInfoBaseData
+{
+  FmgrInfo   *flinfo;
+  Node       *context;
+  Node       *resultinfo;
+  Oid         fncollation;
+  bool        isnull;
+  short       nargs;
+  NullableDatum args[FLEXIBLE_ARRAY_MEMBER];
+} FunctionCallInfoBaseData;
+
+typedef FunctionCallInfoBaseData *FunctionCallInfo;
+typedef Datum (*PGFunction) (FunctionCallInfo fcinfo);
+
+#define SizeForFunctionCallInfo(nargs) \
+  (offsetof(FunctionCallInfoBaseData, args) + sizeof(NullableDatum) * (nargs))
+
+#define LOCAL_FCINFO(name, nargs) \
+  union \
+  { \
+    FunctionCallInfoBaseData fcinfo; \
+    char        fcinfo_data[SizeForFunctionCallInfo(nargs)]; \
+  } name##data; \
+  FunctionCallInfo name = &name##data.fcinfo
+
+#define InitFunctionCallInfoData(Fcinfo, Flinfo, Nargs, Collation, Context, Resultinfo) \
+  do { \
+    (Fcinfo).flinfo = (Flinfo); \
+    (Fcinfo).context = (Context); \
+    (Fcinfo).resultinfo = (Resultinfo); \
+    (Fcinfo).fncollation = (Collation); \
+    (Fcinfo).isnull = false; \
+    (Fcinfo).nargs = (Nargs); \
+  } while (0)
+
+#define PG_FUNCTION_ARGS  FunctionCallInfo fcinfo
+#define PG_MODULE_MAGIC  extern int no_such_variable
+#define PG_FUNCTION_INFO_V1(funcname)  extern Datum funcname(PG_FUNCTION_ARGS)
+
+extern void _PG_init(void);
+
+#define PG_NARGS()  (fcinfo->nargs)
+#define PG_ARGISNULL(n)  (fcinfo->args[n].isnull)
+#define PG_GET_COLLATION()  (fcinfo->fncollation)
+
+#define PG_GETARG_DATUM(n)    (fcinfo->args[n].value)
+#define PG_GETARG_POINTER(n)  DatumGetPointer(PG_GETARG_DATUM(n))
+#define PG_GETARG_CSTRING(n)  DatumGetCString(PG_GETARG_DATUM(n))
+#define PG_GETARG_BOOL(n)     DatumGetBool(PG_GETARG_DATUM(n))
+#define PG_GETARG_INT32(n)    DatumGetInt32(PG_GETARG_DATUM(n))
+#define PG_GETARG_UINT32(n)   DatumGetUInt32(PG_GETARG_DATUM(n))
+#define PG_GETARG_INT64(n)    DatumGetInt64(PG_GETARG_DATUM(n))
+#define PG_GETARG_UINT16(n)   ((uint16) PG_GETARG_DATUM(n))
+#define PG_GETARG_OID(n)      DatumGetObjectId(PG_GETARG_DATUM(n))
+#define PG_GETARG_FLOAT8(n)   DatumGetFloat8(PG_GETARG_DATUM(n))
+
+/* values are never toasted here */
+#define PG_DETOAST_DATUM(datum)         ((struct varlena *) DatumGetPointer(datum))
+#define PG_DETOAST_DATUM_PACKED(datum)  ((struct varlena *) DatumGetPointer(datum))
+#define PG_FREE_IF_COPY(ptr, n)  ((void) 0)
+
+#define PG_RETURN_DATUM(x)    return (x)
+#define PG_RETURN_POINTER(x)  return PointerGetDatum(x)
+#define PG_RETURN_CSTRING(x)  return CStringGetDatum(x)
+#define PG_RETURN_BOOL(x)     return BoolGetDatum(x)
+#define PG_RETURN_INT32(x)    return Int32GetDatum(x)
+#define PG_RETURN_UINT32(x)   return UInt32GetDatum(x)
+#define PG_RETURN_INT64(x)    return Int64GetDatum(x)
+#define PG_RETURN_UINT64(x)   return UInt64GetDatum(x)
+#define PG_RETURN_FLOAT8(x)   return Float8GetDatum(x)
+#define PG_RETURN_TEXT_P(x)   return PointerGetDatum(x)
+#define PG_RETURN_BYTEA_P(x)  return PointerGetDatum(x)
+#define PG_RETURN_VOID()      return (Datum) 0
+#define PG_RETURN_NULL() \
+  do { fcinfo->isnull = true; return (Datum) 0; } while (0)
+
+extern Datum DirectFunctionCall2Coll(PGFunction func, Oid collation,
+                                     Datum arg1, Datum arg2);
+#define DirectFunctionCall2(func, arg1, arg2) \
+  DirectFunctionCall2Coll(func, InvalidOid, arg1, arg2)
+
+extern Oid get_fn_expr_rettype(FmgrInfo *flinfo);
+extern bool get_fn_expr_arg_stable(FmgrInfo *flinfo, int argnum);
+
+#endif              /* LOCUS_SHIM_FMGR_H */
@@ -0,0 +1,33 @@
+/*
+ * contrib/locus/bench/micro/shim/funcapi.h
+ *
+ * The value-per-call SRF protocol, declared only.
+ */
+#ifndef LOCUS_SHIM_FUNCAPI_H
+#define LOCUS_SHIM_FUNCAPI_H
+
+#include "fmgr.h"
+
+typedef struct FuncCallContext
+{
+  uint64      call_cntr;
+  uint64      max_calls;
+  void       *user_fctx;
+  void       *attinmeta;
+  MemoryContext multi_call_memory_ctx;
+  void       *tuple_desc;
+} FuncCallContext;
+
+extern FuncCallContext *init_MultiFuncCall(PG_FUNCTION_ARGS);
+extern FuncCallContext *per_MultiFuncCall(PG_FUNCTION_ARGS);
+extern void end_MultiFuncCall(PG_FUNCTION_ARGS, FuncCallContext *funcctx);
+
+#define SRF_IS_FIRSTCALL()  (fcinfo->flinfo->fn_extra == NULL)
+#define SRF_FIRSTCALL_INIT()  init_MultiFuncCall(fcinfo)
+#define SRF_PERCALL_SETUP()  per_MultiFuncCall(fcinfo)
+#define SRF_RETURN_NEXT(_funcctx, _result) \
+  do { (_funcctx)->call_cntr++; PG_RETURN_DATUM(_result); } while (0)
+#define SRF_RETURN_DONE(_funcctx) \
+  do { end_MultiFuncCall(fcinfo, _funcctx); PG_RETURN_NULL(); } while (0)
+
+#endif              /* LOCUS_SHIM_FUNCAPI_H */
@@ -0,0 +1,20 @@
+/*
+ * contrib/locus/bench/micro/shim/lib/hyperloglog.h
+ */
+#ifndef LOCUS_SHIM_HYPERLOGLOG_H
+#define LOCUS_SHIM_HYPERLOGLOG_H
+
+typedef struct hyperLogLogState
+{
+  uint8       registerWidth;
+  Size        nRegisters;
+  double      alphaMM;
+  uint8      *hashesArr;
+  Size        arrSize;
+} hyperLogLogState;
+
+extern void initHyperLogLog(hyperLogLogState *cState, uint8 bwidth);
+extern void addHyperLogLog(hyperLogLogState *cState, uint32 hash);
+extern double estimateHyperLogLog(hyperLogLogState *cState);
+
+#endif              /* LOCUS_SHIM_HYPERLOGLOG_H */
@@ -0,0 +1,17 @@
+/*
+ * contrib/locus/bench/micro/shim/lib/stringinfo.h
+ */
+#ifndef LOCUS_SHIM_STRINGINFO_H
+#define LOCUS_SHIM_STRINGINFO_H
+
+typedef struct StringInfoData
+{
+  char       *data;
+  int         len;
+  int         maxlen;
+  int         cursor;
+} StringInfoData;
+
+typedef StringInfoData *StringInfo;
+
+#endif              /* LOCUS_SHIM_STRINGINFO_H */
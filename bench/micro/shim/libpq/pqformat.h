@@ -0,0 +1,18 @@
+/*
+ * contrib/locus/bench/micro/shim/libpq/pqformat.h
+ */
+#ifndef LOCUS_SHIM_PQFORMAT_H
+#define LOCUS_SHIM_PQFORMAT_H
+
+#include "lib/stringinfo.h"
+
+extern void pq_begintypsend(StringInfo buf);
+extern bytea *pq_endtypsend(StringInfo buf);
+extern void pq_sendbyte(StringInfo buf, uint8 byt);
+extern void pq_sendbytes(StringInfo buf, const void *data, int datalen);
+extern void pq_sendint32(StringInfo buf, uint32 i);
+extern int  pq_getmsgbyte(StringInfo msg);
+extern unsigned int pq_getmsgint(StringInfo msg, int b);
+extern const char *pq_getmsgbytes(StringInfo msg, int datalen);
+
+#endif              /* LOCUS_SHIM_PQFORMAT_H */
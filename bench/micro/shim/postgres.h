@@ -0,0 +1,180 @@
+/*
+ * contrib/locus/bench/micro/shim/postgres.h
+ *
+ * A Postgres-free stand-in for the server headers, just large enough to
+ * compile locus.c, locus_parse.c and strnatcmp.c into the microbenchmark.
+ * Types and macros keep the meaning they have in the server, so that the
+ * code under test is the code of the extension, unchanged.  Memory comes
+ * from an arena that the harness resets between rounds, and an error ends
+ * the program (see shim.c).  Everything that the benchmarks do not reach,
+ * such as arrays, sort support or the SRF protocol, is only declared.
+ */
+#ifndef LOCUS_SHIM_POSTGRES_H
+#define LOCUS_SHIM_POSTGRES_H
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef float float4;
+typedef double float8;
+typedef size_t Size;
+typedef unsigned int Oid;
+typedef char *Pointer;
+typedef uintptr_t Datum;
+typedef int16 AttrNumber;
+typedef uint16 OffsetNumber;
+typedef uint16 StrategyNumber;
+
+typedef struct MemoryContextData *MemoryContext;
+
+#define SIZEOF_DATUM  8
+#define InvalidOid    ((Oid) 0)
+
+#define Min(x, y)   ((x) < (y) ? (x) : (y))
+#define Max(x, y)   ((x) > (y) ? (x) : (y))
+#define lengthof(array)  (sizeof(array) / sizeof((array)[0]))
+#define PG_INT32_MAX  INT32_MAX
+#define PG_INT32_MIN  INT32_MIN
+#define PG_INT64_MAX  INT64_MAX
+#define INT64CONST(x)   (x##L)
+#define UINT64CONST(x)  (x##UL)
+
+#define likely(x)    __builtin_expect((x) != 0, 1)
+#define unlikely(x)  __builtin_expect((x) != 0, 0)
+#define pg_unreachable()  __builtin_unreachable()
+#define pg_attribute_unused()  __attribute__((unused))
+#define pg_attribute_noreturn()  __attribute__((noreturn))
+#define PGDLLEXPORT
+#define FLEXIBLE_ARRAY_MEMBER
+#define PG_USED_FOR_ASSERTS_ONLY  pg_attribute_unused()
+
+#define StaticAssertDecl(condition, message)  _Static_assert(condition, message)
+#define StaticAssertStmt(condition, message)  _Static_assert(condition, message)
+#define Assert(condition)  ((void) 0)
+
+#define MAXALIGN(len)  (((uintptr_t) (len) + 7) & ~(uintptr_t) 7)
+#define TYPALIGN_INT  'i'
+
+/* varlena values, with 4-byte headers only */
+struct varlena
+{
+  char    vl_len_[4];
+  char    vl_dat[FLEXIBLE_ARRAY_MEMBER];
+};
+typedef struct varlena text;
+typedef struct varlena bytea;
+
+#define VARHDRSZ  ((int32) sizeof(int32))
+#define VARSIZE(PTR)  ((*(const uint32 *) (PTR) >> 2) & 0x3FFFFFFF)
+#define VARDATA(PTR)  (((char *) (PTR)) + VARHDRSZ)
+#define VARSIZE_ANY(PTR)  VARSIZE(PTR)
+#define VARSIZE_ANY_EXHDR(PTR)  (VARSIZE(PTR) - VARHDRSZ)
+#define VARDATA_ANY(PTR)  VARDATA(PTR)
+#define SET_VARSIZE(PTR, len)  (*(uint32 *) (PTR) = (uint32) (len) << 2)
+
+/* Datum conversions */
+#define DatumGetPointer(X)  ((Pointer) (X))
+#define PointerGetDatum(X)  ((Datum) (X))
+#define DatumGetCString(X)  ((char *) DatumGetPointer(X))
+#define CStringGetDatum(X)  PointerGetDatum(X)
+#define DatumGetBool(X)     ((bool) ((X) != 0))
+#define BoolGetDatum(X)     ((Datum) ((X) ? 1 : 0))
+#define DatumGetInt32(X)    ((int32) (X))
+#define Int32GetDatum(X)    ((Datum) (int32) (X))
+#define DatumGetUInt32(X)   ((uint32) (X))
+#define UInt32GetDatum(X)   ((Datum) (X))
+#define DatumGetInt64(X)    ((int64) (X))
+#define Int64GetDatum(X)    ((Datum) (X))
+#define DatumGetUInt64(X)   ((uint64) (X))
+#define UInt64GetDatum(X)   ((Datum) (X))
+#define DatumGetObjectId(X) ((Oid) (X))
+#define ObjectIdGetDatum(X) ((Datum) (X))
+
+static inline Datum
+Float8GetDatum(float8 X)
+{
+  Datum   result;
+
+  memcpy(&result, &X, sizeof(result));
+  return result;
+}
+
+static inline float8
+DatumGetFloat8(Datum X)
+{
+  float8  result;
+
+  memcpy(&result, &X, sizeof(result));
+  return result;
+}
+
+/* memory, from the arena of shim.c; there is a single context */
+extern MemoryContext CurrentMemoryContext;
+
+static inline MemoryContext
+MemoryContextSwitchTo(MemoryContext context)
+{
+  MemoryContext old = CurrentMemoryContext;
+
+  CurrentMemoryContext = context;
+  return old;
+}
+
+extern void *palloc(Size size);
+extern void *palloc0(Size size);
+extern void pfree(void *pointer);
+extern char *psprintf(const char *fmt,...) __attribute__((format(printf, 1, 2)));
+
+/* error reporting: anything at ERROR or above ends the program */
+#define DEBUG1   14
+#define LOG      15
+#define NOTICE   18
+#define WARNING  19
+#define ERROR    21
+
+#define ERRCODE_INVALID_PARAMETER_VALUE         1
+#define ERRCODE_INVALID_TEXT_REPRESENTATION     2
+#define ERRCODE_INVALID_BINARY_REPRESENTATION   3
+#define ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE      4
+#define ERRCODE_PROGRAM_LIMIT_EXCEEDED          5
+#define ERRCODE_FEATURE_NOT_SUPPORTED           6
+#define ERRCODE_ARRAY_SUBSCRIPT_ERROR           7
+#define ERRCODE_DATATYPE_MISMATCH               8
+#define ERRCODE_INTERNAL_ERROR                  9
+#define ERRCODE_NULL_VALUE_NOT_ALLOWED         10
+#define ERRCODE_SYNTAX_ERROR                   11
+
+extern void shim_errstart(int elevel);
+extern void shim_errfinish(int elevel, const char *filename, int lineno);
+extern int  errcode(int sqlerrcode);
+extern int  errmsg(const char *fmt,...) __attribute__((format(printf, 1, 2)));
+extern int  errmsg_internal(const char *fmt,...) __attribute__((format(printf, 1, 2)));
+extern int  errdetail(const char *fmt,...) __attribute__((format(printf, 1, 2)));
+extern int  errhint(const char *fmt,...) __attribute__((format(printf, 1, 2)));
+
+#define ereport(elevel, ...) \
+  do { \
+    shim_errstart(elevel); \
+    __VA_ARGS__; \
+    shim_errfinish(elevel, __FILE__, __LINE__); \
+    if ((elevel) >= ERROR) \
+      pg_unreachable(); \
+  } while (0)
+
+#define elog(elevel, ...)  ereport(elevel, errmsg_internal(__VA_ARGS__))
+
+#endif              /* LOCUS_SHIM_POSTGRES_H */
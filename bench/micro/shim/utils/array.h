@@ -0,0 +1,30 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/array.h
+ */
+#ifndef LOCUS_SHIM_ARRAY_H
+#define LOCUS_SHIM_ARRAY_H
+
+typedef struct ArrayType
+{
+  int32       vl_len_;
+  int         ndim;
+  int32       dataoffset;
+  Oid         elemtype;
+} ArrayType;
+
+typedef struct ArrayIteratorData *ArrayIterator;
+
+#define ARR_NDIM(a)  ((a)->ndim)
+#define ARR_DIMS(a)  ((int *) (((char *) (a)) + sizeof(ArrayType)))
+#define ARR_ELEMTYPE(a)  ((a)->elemtype)
+
+#define DatumGetArrayTypeP(X)  ((ArrayType *) PG_DETOAST_DATUM(X))
+#define PG_GETARG_ARRAYTYPE_P(n)  DatumGetArrayTypeP(PG_GETARG_DATUM(n))
+
+extern int  ArrayGetNItems(int ndim, const int *dims);
+extern ArrayIterator array_create_iterator(ArrayType *arr, int slice_ndim,
+                                           void *mstate);
+extern bool array_iterate(ArrayIterator iterator, Datum *value, bool *isnull);
+extern void array_free_iterator(ArrayIterator iterator);
+
+#endif              /* LOCUS_SHIM_ARRAY_H */
@@ -0,0 +1,10 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/builtins.h
+ */
+#ifndef LOCUS_SHIM_BUILTINS_H
+#define LOCUS_SHIM_BUILTINS_H
+
+extern int  pg_ltoa(int32 value, char *a);
+extern text *cstring_to_text(const char *s);
+
+#endif              /* LOCUS_SHIM_BUILTINS_H */
@@ -0,0 +1,13 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/float.h
+ */
+#ifndef LOCUS_SHIM_FLOAT_H
+#define LOCUS_SHIM_FLOAT_H
+
+static inline float8
+get_float8_infinity(void)
+{
+  return (float8) INFINITY;
+}
+
+#endif              /* LOCUS_SHIM_FLOAT_H */
@@ -0,0 +1,9 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/guc.h
+ */
+#ifndef LOCUS_SHIM_GUC_H
+#define LOCUS_SHIM_GUC_H
+
+extern void MarkGUCPrefixReserved(const char *className);
+
+#endif              /* LOCUS_SHIM_GUC_H */
@@ -0,0 +1,30 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/rangetypes.h
+ */
+#ifndef LOCUS_SHIM_RANGETYPES_H
+#define LOCUS_SHIM_RANGETYPES_H
+
+#include "utils/typcache.h"
+
+typedef struct RangeType
+{
+  int32       vl_len_;
+  Oid         rangetypid;
+} RangeType;
+
+typedef struct RangeBound
+{
+  Datum       val;
+  bool        infinite;
+  bool        inclusive;
+  bool        lower;
+} RangeBound;
+
+#define PG_RETURN_RANGE_P(x)  return PointerGetDatum(x)
+
+extern TypeCacheEntry *range_get_typcache(FunctionCallInfo fcinfo, Oid rngtypid);
+extern RangeType *range_serialize(TypeCacheEntry *typcache, RangeBound *lower,
+                                  RangeBound *upper, bool empty,
+                                  struct Node *escontext);
+
+#endif              /* LOCUS_SHIM_RANGETYPES_H */
@@ -0,0 +1,26 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/sortsupport.h
+ */
+#ifndef LOCUS_SHIM_SORTSUPPORT_H
+#define LOCUS_SHIM_SORTSUPPORT_H
+
+typedef struct SortSupportData *SortSupport;
+
+typedef struct SortSupportData
+{
+  MemoryContext ssup_cxt;
+  Oid         ssup_collation;
+  bool        ssup_reverse;
+  bool        ssup_nulls_first;
+  AttrNumber  ssup_attno;
+  void       *ssup_extra;
+  int         (*comparator) (Datum x, Datum y, SortSupport ssup);
+  bool        abbreviate;
+  Datum       (*abbrev_converter) (Datum original, SortSupport ssup);
+  bool        (*abbrev_abort) (int memtupcount, SortSupport ssup);
+  int         (*abbrev_full_comparator) (Datum x, Datum y, SortSupport ssup);
+} SortSupportData;
+
+extern int  ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup);
+
+#endif              /* LOCUS_SHIM_SORTSUPPORT_H */
@@ -0,0 +1,15 @@
+/*
+ * contrib/locus/bench/micro/shim/utils/typcache.h
+ */
+#ifndef LOCUS_SHIM_TYPCACHE_H
+#define LOCUS_SHIM_TYPCACHE_H
+
+typedef struct TypeCacheEntry
+{
+  Oid         type_id;
+  int16       typlen;
+  bool        typbyval;
+  char        typalign;
+} TypeCacheEntry;
+
+#endif              /* LOCUS_SHIM_TYPCACHE_H */
@@ -0,0 +1,10 @@
+-- Join the loci of bench_suite_b in a random region to the loci of
+-- bench_suite_a they overlap, as a nested loop over its GiST index
+-- (see bench/suite.sh)
+\set c random(1, 22)
+\set s random(1, 46000000 - :width)
+\set e :s + :width - 1
+SELECT count(*)
+FROM bench_suite_b AS b
+JOIN bench_suite_a AS a ON a.l && b.l
+WHERE b.l && ('chr' || :c || ':' || :s || '-' || :e)::locus;
@@ -0,0 +1,6 @@
+-- Count the loci of bench_suite_a in a region of :width bases at a random
+-- place on chr1 to chr22, through its GiST index (see bench/suite.sh)
+\set c random(1, 22)
+\set s random(1, 46000000 - :width)
+\set e :s + :width - 1
+SELECT count(*) FROM bench_suite_a WHERE l && ('chr' || :c || ':' || :s || '-' || :e)::locus;
@@ -0,0 +1,13 @@
+-- The join of gist-join.sql as an equijoin on the tiles of :tile bases
+-- that the loci touch, counting each pair in the first tile they share
+-- (see bench/suite.sh)
+\set c random(1, 22)
+\set s random(1, 46000000 - :width)
+\set e :s + :width - 1
+SELECT count(*)
+FROM bench_suite_b AS b
+CROSS JOIN LATERAL locus_tiles(b.l, :tile) AS t (tile)
+JOIN bench_suite_a_tiles AS a ON a.tile = t.tile
+WHERE b.l && ('chr' || :c || ':' || :s || '-' || :e)::locus
+  AND a.tile = greatest(locus_tile_key(a.l, :tile), locus_tile_key(b.l, :tile))
+  AND a.l && b.l;
@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# Compare plocus with locus on the same N generated loci: table, B-tree and
+# GiST index size, GiST index build, a sequential and an indexed && scan, and
+# a sort.
+#
+#   bench/plocus.sh [dbname] [rows]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+
+# contig names must be registered, and committed, before plocus values use them
+psql -X -q -d "$DB" -c "
+  SELECT locus_contig_register('chr' || i) FROM generate_series(1, 22) AS i;
+" > /dev/null || exit 1
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_locus, bench_plocus;
+  CREATE UNLOGGED TABLE bench_locus AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  CREATE UNLOGGED TABLE bench_plocus AS SELECT l::plocus AS l FROM bench_locus;
+  VACUUM ANALYZE bench_locus;
+  VACUUM ANALYZE bench_plocus;
+" || exit 1
+
+run() {
+  psql -X -A -t -d "$DB" <<SQL | awk -v name="$1" '/Execution Time/ { printf "%-18s %10.1f ms\n", name, $3 }'
+SET max_parallel_workers_per_gather = 0;
+SET enable_seqscan = $2;
+EXPLAIN (ANALYZE, COSTS OFF) $3;
+SQL
+}
+
+for type in locus plocus; do
+  start=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "CREATE INDEX bench_${type}_ix ON bench_$type USING gist (l)" || exit 1
+  end=$(date +%s.%N)
+  psql -X -q -d "$DB" -c "CREATE INDEX bench_${type}_btree_ix ON bench_$type (l)" || exit 1
+  sizes=$(psql -X -A -t -F ', ' -d "$DB" -c "
+    SELECT 'table ' || pg_size_pretty(pg_table_size('bench_$type')),
+           'btree ' || pg_size_pretty(pg_relation_size('bench_${type}_btree_ix')),
+           'gist ' || pg_size_pretty(pg_relation_size('bench_${type}_ix'))")
+  echo "$start $end" | awk -v type="$type" -v sizes="$sizes" \
+    '{ printf "%-6s build: %.3f s, %s\n", type, $2 - $1, sizes }'
+
+  run "$type seq scan" on "SELECT count(*) FROM bench_$type WHERE l && 'chr7:55000000-56000000'"
+  run "$type index scan" off "SELECT count(*) FROM bench_$type WHERE l && 'chr7:55000000-56000000'"
+  run "$type sort" on "SELECT l FROM bench_$type ORDER BY l OFFSET $ROWS"
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_locus, bench_plocus"
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Compare ways of loading a BED file of N generated records into a locus
+# table: rewriting it into locus text with awk and loading that with COPY,
+# and INSERT ... SELECT from locus_read_bed(), on the plain and the
+# gzip-compressed file.  The server must be able to read /tmp of this host,
+# and the user needs the privileges of pg_read_server_files:
+#
+#   bench/read-bed.sh [dbname] [rows] [runs]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-2000000}
+RUNS=${3:-5}
+BED=$(mktemp /tmp/locus-read-bed.XXXXXX)
+TEXT=$(mktemp /tmp/locus-read-bed-text.XXXXXX)
+
+trap 'rm -f "$BED" "$BED.gz" "$TEXT"' EXIT
+chmod 644 "$BED"
+
+psql -X -q -d "$DB" -c "
+  COPY (
+    SELECT 'chr' || (1 + i % 22), s, s + 1 + (i % 1000), 'feature' || i, i % 1000,
+           CASE WHEN i % 2 = 0 THEN '+' ELSE '-' END
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g
+  ) TO STDOUT
+" > "$BED" || exit 1
+gzip -c "$BED" > "$BED.gz"
+chmod 644 "$BED.gz"
+
+psql -X -q -d "$DB" -c "CREATE UNLOGGED TABLE IF NOT EXISTS bench_read_bed (l locus, name text)" || exit 1
+
+timed() {
+  psql -X -q -d "$DB" -c "TRUNCATE bench_read_bed"
+  start=$(date +%s.%N)
+  sh -c "$2" || exit 1
+  end=$(date +%s.%N)
+  echo "$start $end" | awk -v rows="$ROWS" -v name="$1" \
+    '{ t = $2 - $1; printf "%-22s %.3f s, %.0f rows/s\n", name, t, rows / t }'
+}
+
+run=1
+while [ $run -le "$RUNS" ]; do
+  echo "run $run:"
+  timed "awk + COPY" "awk -F '\t' -v OFS='\t' '{ print \$1 \":\" \$2 + 1 \"-\" \$3, \$4 }' '$BED' > '$TEXT' &&
+                      psql -X -q -d '$DB' -c \"\\\\copy bench_read_bed FROM '$TEXT'\""
+  timed "locus_read_bed" "psql -X -q -d '$DB' -c \"INSERT INTO bench_read_bed
+                            SELECT locus, fields[1] FROM locus_read_bed('$BED')\""
+  timed "locus_read_bed (gzip)" "psql -X -q -d '$DB' -c \"INSERT INTO bench_read_bed
+                                   SELECT locus, fields[1] FROM locus_read_bed('$BED.gz')\""
+  run=$((run + 1))
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_read_bed"
@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# Compare gist_locus_ops with spgist_locus_ops: build time, index size and
+# the cost of && probes (execution time and buffers touched).  Runs on the
+# regression data (data/test_locus.data) and on N generated loci that mix
+# point SNVs with a few long structural variants.
+#
+#   bench/spgist.sh [dbname] [rows] [probes]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-5000000}
+PROBES=${3:-1000}
+DIR=$(dirname "$0")/..
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_spgist_regress, bench_spgist_generated;
+  CREATE UNLOGGED TABLE bench_spgist_regress (l locus);
+" || exit 1
+psql -X -q -d "$DB" -c "\\copy bench_spgist_regress from '$DIR/data/test_locus.data'" || exit 1
+
+psql -X -q -d "$DB" -c "
+  CREATE UNLOGGED TABLE bench_spgist_generated AS
+    SELECT (CASE WHEN i % 1000 = 0
+      THEN 'chr' || (1 + i % 22) || ':' || s || '-' || (s + 100000 + (i * 31) % 5000000)
+      ELSE 'chr' || (1 + i % 22) || ':' || s
+    END)::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  VACUUM ANALYZE bench_spgist_regress, bench_spgist_generated;
+" || exit 1
+
+for table in bench_spgist_regress bench_spgist_generated; do
+  for method in gist spgist; do
+    psql -X -q -d "$DB" -c "DROP INDEX IF EXISTS ${table}_ix"
+    start=$(date +%s.%N)
+    psql -X -q -d "$DB" -c "CREATE INDEX ${table}_ix ON $table USING $method (l ${method}_locus_ops)" || exit 1
+    end=$(date +%s.%N)
+    size=$(psql -X -A -t -d "$DB" -c "SELECT pg_size_pretty(pg_relation_size('${table}_ix'))")
+    echo "$start $end" | awk -v t="$table" -v m="$method" -v size="$size" \
+      '{ printf "%s, %-6s build: %.3f s, index size %s\n", t, m, $2 - $1, size }'
+
+    # Random 10 kb windows; the sum of buffers and time over all probes.
+    psql -X -A -t -d "$DB" <<SQL | awk -v t="$table" -v m="$method" -v n="$PROBES" \
+      '/Buffers: shared/ { for (i = 1; i <= NF; i++) if ($i ~ /^(hit|read)=/) { split($i, kv, "="); buf += kv[2] } }
+       /Execution Time/ { ms += $3 }
+       END { printf "%s, %-6s && probes: %.3f ms and %.1f buffers per probe\n", t, m, ms / n, buf / n }'
+SET enable_seqscan = off;
+SELECT format('EXPLAIN (ANALYZE, BUFFERS, COSTS OFF) SELECT count(*) FROM $table WHERE l && %L', 'chr' || (1 + i % 22) || ':' || s || '-' || (s + 10000))
+FROM generate_series(1, $PROBES) AS i,
+     LATERAL (SELECT (i * 104729) % 248000000 AS s) AS g
+\\gexec
+SQL
+  done
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_spgist_regress, bench_spgist_generated"
@@ -0,0 +1,123 @@
+#!/bin/sh
+#
+# The SQL benchmark suite.  For each size, load a table bench_suite_a of
+# that many loci and a table bench_suite_b of a tenth as many from
+# locus_generate(), time the load, a full sort and the index builds once,
+# then run the pgbench scripts in bench/pgbench for a while each: a region
+# count on the GiST index, and the loci of B in a region joined to those of A
+# as a nested loop over the GiST index and as an equijoin on tiles.  The
+# results go into the table bench_suite_results and are printed with a
+# column per size at the end.
+#
+#   bench/suite.sh [dbname] [sizes] [seed] [seconds]
+#
+# sizes is a list of row counts, "1000000 10000000 100000000" by default.
+# The loci are those of the assembly profile $PROFILE (grch38 by default),
+# with seed and seed + 1, and pgbench draws its regions with the same seed,
+# so two runs with the same arguments do the same work.  Regions are $WIDTH
+# bases (1000000 by default) and tiles $TILE bases (100000 by default).
+#
+
+DB=${1:-contrib_regression}
+SIZES=${2:-"1000000 10000000 100000000"}
+SEED=${3:-0}
+SECS=${4:-30}
+PROFILE=${PROFILE:-grch38}
+WIDTH=${WIDTH:-1000000}
+TILE=${TILE:-100000}
+SCRIPTS=$(dirname "$0")/pgbench
+
+# single-process plans, so that the numbers do not depend on the workers
+OPTIONS="-c max_parallel_workers_per_gather=0"
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_suite_results;
+  CREATE TABLE bench_suite_results (
+    id serial,
+    rows int8,
+    benchmark text,
+    value float8,
+    unit text
+  );
+" || exit 1
+
+record() {
+  psql -X -q -d "$DB" -c "INSERT INTO bench_suite_results (rows, benchmark, value, unit)
+                          VALUES ($ROWS, '$1', $2, '$3')"
+  echo "$ROWS rows, $1: $2 $3"
+}
+
+# the time of a statement, run once
+timed() {
+  ms=$(PGOPTIONS="$OPTIONS" psql -X -q -d "$DB" -o /dev/null -c '\timing on' -c "$2" |
+       awk '/^Time:/ { ms = $2 } END { print ms }')
+  [ -n "$ms" ] || exit 1
+  record "$1" "$ms" ms
+}
+
+# the average latency of a pgbench script, run for SECS seconds
+bench() {
+  ms=$(PGOPTIONS="$OPTIONS $3" pgbench -n -T "$SECS" --random-seed="$SEED" \
+         -D width="$WIDTH" -D tile="$TILE" -f "$SCRIPTS/$2.sql" "$DB" |
+       awk '/^latency average/ { print $4 }')
+  [ -n "$ms" ] || exit 1
+  record "$1" "$ms" ms
+}
+
+for ROWS in $SIZES; do
+  psql -X -q -d "$DB" -c "
+    DROP TABLE IF EXISTS bench_suite_a, bench_suite_b, bench_suite_a_tiles;
+    CREATE UNLOGGED TABLE bench_suite_a (l locus);
+    CREATE UNLOGGED TABLE bench_suite_b (l locus);
+  " || exit 1
+
+  timed "load" "INSERT INTO bench_suite_a
+                SELECT * FROM locus_generate($ROWS, '$PROFILE', 'germline', $SEED)"
+  psql -X -q -d "$DB" -c "
+    INSERT INTO bench_suite_b
+      SELECT * FROM locus_generate($ROWS / 10, '$PROFILE', 'germline', $SEED + 1);
+    VACUUM ANALYZE bench_suite_a;
+  " || exit 1
+
+  timed "sort" "SELECT l FROM bench_suite_a ORDER BY l OFFSET $ROWS"
+  timed "btree build" "CREATE INDEX bench_suite_a_btree ON bench_suite_a (l)"
+  timed "gist build" "CREATE INDEX bench_suite_a_gist ON bench_suite_a USING gist (l)"
+  timed "tile table build" "
+    CREATE UNLOGGED TABLE bench_suite_a_tiles AS
+      SELECT t AS tile, l FROM bench_suite_a, locus_tiles(l, $TILE) AS t;
+    CREATE INDEX bench_suite_a_tiles_tile ON bench_suite_a_tiles (tile)"
+
+  psql -X -q -d "$DB" -c "
+    DROP INDEX bench_suite_a_btree;
+    CREATE INDEX bench_suite_b_gist ON bench_suite_b USING gist (l);
+    VACUUM ANALYZE bench_suite_a;
+    VACUUM ANALYZE bench_suite_b;
+    VACUUM ANALYZE bench_suite_a_tiles;
+  " || exit 1
+
+  # both joins must find the same pairs
+  psql -X -A -t -d "$DB" -c "
+    SELECT (SELECT count(*)
+            FROM bench_suite_b AS b
+            JOIN bench_suite_a AS a ON a.l && b.l
+            WHERE b.l && 'chr1:1-$WIDTH')
+         = (SELECT count(*)
+            FROM bench_suite_b AS b
+            CROSS JOIN LATERAL locus_tiles(b.l, $TILE) AS t (tile)
+            JOIN bench_suite_a_tiles AS a ON a.tile = t.tile
+            WHERE b.l && 'chr1:1-$WIDTH'
+              AND a.tile = greatest(locus_tile_key(a.l, $TILE), locus_tile_key(b.l, $TILE))
+              AND a.l && b.l)
+  " | grep -q '^t$' || { echo "the GiST and tile joins disagree" >&2; exit 1; }
+
+  bench "region count" region-count
+  bench "gist join" gist-join "-c locus.enable_sweep_join=off"
+  bench "tile join" tile-join
+done
+
+psql -X -d "$DB" <<SQL
+SELECT benchmark || ' (' || unit || ')' AS benchmark, rows, round(value::numeric, 1) AS value
+FROM bench_suite_results
+ORDER BY id
+\crosstabview benchmark rows value
+SQL
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Time an overlap join of two sets of generated loci, N and N/10 rows, as a
+# nested loop over a GiST index and as a sweep-line join.  The sweep sorts
+# both sides and holds only the loci that overlap the current position, so
+# its cost grows with the input sizes rather than with their product; the
+# peak size of the active set is printed along with the time.
+#
+#   bench/sweep-join.sh [dbname] [rows]
+#
+
+DB=${1:-contrib_regression}
+ROWS=${2:-2000000}
+
+psql -X -q -d "$DB" -c "
+  DROP TABLE IF EXISTS bench_sweep_a, bench_sweep_b;
+  CREATE UNLOGGED TABLE bench_sweep_a AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 1000)))::locus AS l
+    FROM generate_series(1, $ROWS) AS i,
+         LATERAL (SELECT (i * 7919) % 248956422 AS s) AS g;
+  CREATE UNLOGGED TABLE bench_sweep_b AS
+    SELECT ('chr' || (1 + i % 22) || ':' || s || '-' || (s + (i % 10000)))::locus AS l
+    FROM generate_series(1, $ROWS / 10) AS i,
+         LATERAL (SELECT (i * 104729) % 248956422 AS s) AS g;
+  CREATE INDEX bench_sweep_a_ix ON bench_sweep_a USING gist (l);
+  VACUUM ANALYZE bench_sweep_a;
+  VACUUM ANALYZE bench_sweep_b;
+" || exit 1
+
+for join in gist sweep; do
+  if [ $join = gist ]; then
+    settings="SET locus.enable_sweep_join = off; SET enable_hashjoin = off; SET enable_mergejoin = off;"
+  else
+    settings="SET enable_nestloop = off;"
+  fi
+  psql -X -A -t -d "$DB" <<SQL | awk -v j="$join" \
+    '/Peak Active Rows/ { peak = $NF }
+     /Execution Time/ { ms = $3 }
+     END { printf "%-6s %10.1f ms", j, ms; if (peak != "") printf ", peak active rows %s", peak; printf "\n" }'
+SET max_parallel_workers_per_gather = 0;
+$settings
+EXPLAIN (ANALYZE, COSTS OFF) SELECT count(*) FROM bench_sweep_b b JOIN bench_sweep_a a ON b.l && a.l;
+SQL
+done
+
+psql -X -q -d "$DB" -c "DROP TABLE bench_sweep_a, bench_sweep_b"
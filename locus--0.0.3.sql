@@ -0,0 +1,1577 @@
+/* contrib/locus/locus--0.0.3.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION locus" to load this file. \quit
+
+-- Create the user-defined type for 1-D floating point intervals (locus)
+
+CREATE FUNCTION locus_in(cstring)
+RETURNS locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_out(locus)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_recv(internal)
+RETURNS locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_send(locus)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_typanalyze(internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+CREATE TYPE locus (
+  INTERNALLENGTH = 32,
+  INPUT = locus_in,
+  OUTPUT = locus_out,
+  RECEIVE = locus_recv,
+  SEND = locus_send,
+  ANALYZE = locus_typanalyze
+);
+
+COMMENT ON TYPE locus IS
+'genomic locus ''contig:begin-end'', ''contig:pos'', or just ''contig''';
+
+--
+-- External C-functions for R-tree methods
+--
+
+-- Left/Right methods
+
+CREATE FUNCTION locus_over_left(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_over_left(locus, locus) IS
+'none of (a) is above the upper bound of (b)';
+
+CREATE FUNCTION locus_over_right(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_over_right(locus, locus) IS
+'none of (a) is below the lower bound of (b)';
+
+CREATE FUNCTION locus_left(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_left(locus, locus) IS
+'strictly left';
+
+CREATE FUNCTION locus_right(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_right(locus, locus) IS
+'strictly right';
+
+
+-- Scalar comparison methods
+
+CREATE FUNCTION locus_lt(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_lt(locus, locus) IS
+'less than';
+
+CREATE FUNCTION locus_le(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_le(locus, locus) IS
+'less than or equal';
+
+CREATE FUNCTION locus_gt(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_gt(locus, locus) IS
+'greater than';
+
+CREATE FUNCTION locus_ge(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_ge(locus, locus) IS
+'greater than or equal';
+
+CREATE FUNCTION locus_contains(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_contains(locus, locus) IS
+'contains';
+
+CREATE FUNCTION locus_contained(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_contained(locus, locus) IS
+'contained in';
+
+CREATE FUNCTION locus_overlap(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_overlap(locus, locus) IS
+'overlaps';
+
+CREATE FUNCTION locus_same(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_same(locus, locus) IS
+'same as';
+
+CREATE FUNCTION locus_different(locus, locus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_different(locus, locus) IS
+'different';
+
+CREATE FUNCTION locus_distance(locus, locus)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_distance(locus, locus) IS
+'distance in bases';
+
+-- support routines for indexing
+
+CREATE FUNCTION locus_cmp(locus, locus)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_cmp(locus, locus) IS 'btree comparison function';
+
+CREATE FUNCTION locus_hash(locus)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_hash(locus) IS 'hash function';
+
+CREATE FUNCTION locus_hash_extended(locus, int8)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_hash_extended(locus, int8) IS 'extended hash function';
+
+CREATE FUNCTION locus_union(locus, locus)
+RETURNS locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_inter(locus, locus)
+RETURNS locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION length(locus)
+RETURNS int
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- selectivity estimation
+
+CREATE FUNCTION locus_overlap_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_contains_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_contained_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_left_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_right_sel(internal, oid, internal, integer)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_overlap_joinsel(internal, oid, internal, smallint, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_contains_joinsel(internal, oid, internal, smallint, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_contained_joinsel(internal, oid, internal, smallint, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_left_joinsel(internal, oid, internal, smallint, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_right_joinsel(internal, oid, internal, smallint, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+-- miscellaneous
+
+CREATE FUNCTION contig(locus)
+RETURNS text
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION range(locus)
+RETURNS int8range
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION center(locus)
+RETURNS int
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION upper(locus)
+RETURNS int
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION lower(locus)
+RETURNS int
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+
+--
+-- OPERATORS
+--
+
+CREATE OPERATOR < (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_lt,
+  COMMUTATOR = '>',
+  NEGATOR = '>=',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_le,
+  COMMUTATOR = '>=',
+  NEGATOR = '>',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR > (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_gt,
+  COMMUTATOR = '<',
+  NEGATOR = '<=',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_ge,
+  COMMUTATOR = '<=',
+  NEGATOR = '<',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR << (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_left,
+  COMMUTATOR = '>>',
+  RESTRICT = locus_left_sel,
+  JOIN = locus_left_joinsel
+);
+
+CREATE OPERATOR <& (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_over_left,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR && (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_overlap,
+  COMMUTATOR = '&&',
+  RESTRICT = locus_overlap_sel,
+  JOIN = locus_overlap_joinsel
+);
+
+CREATE OPERATOR &> (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_over_right,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR >> (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_right,
+  COMMUTATOR = '<<',
+  RESTRICT = locus_right_sel,
+  JOIN = locus_right_joinsel
+);
+
+CREATE OPERATOR = (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_same,
+  COMMUTATOR = '=',
+  NEGATOR = '<>',
+  RESTRICT = eqsel,
+  JOIN = eqjoinsel,
+  MERGES,
+  HASHES
+);
+
+CREATE OPERATOR <> (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_different,
+  COMMUTATOR = '<>',
+  NEGATOR = '=',
+  RESTRICT = neqsel,
+  JOIN = neqjoinsel
+);
+
+CREATE OPERATOR @> (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_contains,
+  COMMUTATOR = '<@',
+  RESTRICT = locus_contains_sel,
+  JOIN = locus_contains_joinsel
+);
+
+CREATE OPERATOR <@ (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_contained,
+  COMMUTATOR = '@>',
+  RESTRICT = locus_contained_sel,
+  JOIN = locus_contained_joinsel
+);
+
+CREATE OPERATOR <-> (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_distance,
+  COMMUTATOR = '<->'
+);
+
+-- obsolete (but linked to GiST strategies):
+CREATE OPERATOR @ (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_contains,
+  COMMUTATOR = '~',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR ~ (
+  LEFTARG = locus,
+  RIGHTARG = locus,
+  PROCEDURE = locus_contained,
+  COMMUTATOR = '@',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+-- define GiST support methods
+CREATE FUNCTION gist_locus_consistent(internal,locus,smallint,oid,internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_compress(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_decompress(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_penalty(internal,internal,internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_picksplit(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_union(internal, internal)
+RETURNS locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_same(locus, locus, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_locus_distance(internal, locus, smallint, oid, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+
+-- define B-tree and GiST sort support methods
+CREATE FUNCTION locus_sortsupport(internal)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_equalimage(oid)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+
+-- Create a function to compute a tile ID for a locus
+CREATE FUNCTION locus_tile_id(locus, int8 DEFAULT 1000000)
+RETURNS text
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Integer tile and bin keys for binned overlap joins
+CREATE FUNCTION locus_tile_key(locus, int8 DEFAULT 1000000)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_tiles(locus, int8 DEFAULT 1000000)
+RETURNS SETOF int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE
+ROWS 2;
+
+CREATE FUNCTION locus_bin(locus)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_bins(locus)
+RETURNS SETOF int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE
+ROWS 11;
+
+-- Coalescing overlapping loci
+CREATE FUNCTION locus_merge_transfn(internal, locus)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_transfn(internal, locus, int4)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_combinefn(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_serialfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_deserialfn(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_finalfn(internal, locus)
+RETURNS locus[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_merge_finalfn(internal, locus, int4)
+RETURNS locus[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE AGGREGATE locus_merge(locus) (
+  SFUNC = locus_merge_transfn,
+  STYPE = internal,
+  FINALFUNC = locus_merge_finalfn,
+  FINALFUNC_EXTRA,
+  COMBINEFUNC = locus_merge_combinefn,
+  SERIALFUNC = locus_merge_serialfn,
+  DESERIALFUNC = locus_merge_deserialfn,
+  PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE locus_merge(locus) IS
+'sorted array of the loci left after merging overlapping ones';
+
+CREATE AGGREGATE locus_merge(locus, int4) (
+  SFUNC = locus_merge_transfn,
+  STYPE = internal,
+  FINALFUNC = locus_merge_finalfn,
+  FINALFUNC_EXTRA,
+  COMBINEFUNC = locus_merge_combinefn,
+  SERIALFUNC = locus_merge_serialfn,
+  DESERIALFUNC = locus_merge_deserialfn,
+  PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE locus_merge(locus, int4) IS
+'sorted array of the loci left after merging those at most gap bases apart';
+
+-- Depth of coverage
+CREATE TYPE locus_depth AS (
+  locus locus,
+  depth int4
+);
+
+CREATE FUNCTION locus_coverage_transfn(internal, locus)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_coverage_transfn(internal, locus, int8)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_coverage_combinefn(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_coverage_serialfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_coverage_deserialfn(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION locus_coverage_finalfn(internal)
+RETURNS locus_depth[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE AGGREGATE locus_coverage(locus) (
+  SFUNC = locus_coverage_transfn,
+  STYPE = internal,
+  FINALFUNC = locus_coverage_finalfn,
+  COMBINEFUNC = locus_coverage_combinefn,
+  SERIALFUNC = locus_coverage_serialfn,
+  DESERIALFUNC = locus_coverage_deserialfn,
+  PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE locus_coverage(locus) IS
+'runs of equal depth of coverage by the loci, as (locus, depth) records';
+
+CREATE AGGREGATE locus_coverage(locus, int8) (
+  SFUNC = locus_coverage_transfn,
+  STYPE = internal,
+  FINALFUNC = locus_coverage_finalfn,
+  COMBINEFUNC = locus_coverage_combinefn,
+  SERIALFUNC = locus_coverage_serialfn,
+  DESERIALFUNC = locus_coverage_deserialfn,
+  PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE locus_coverage(locus, int8) IS
+'runs of equal depth of coverage by the loci in bins of the given width';
+
+-- Interval sets
+CREATE FUNCTION locus_set_in(cstring)
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_set_out(locus_set)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE TYPE locus_set (
+  INTERNALLENGTH = VARIABLE,
+  INPUT = locus_set_in,
+  OUTPUT = locus_set_out,
+  ALIGNMENT = int4,
+  STORAGE = extended
+);
+
+COMMENT ON TYPE locus_set IS
+'sorted set of disjoint genomic intervals ''{contig:begin-end, ...}''';
+
+CREATE FUNCTION locus_set(locus[])
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_set_to_array(locus_set)
+RETURNS locus[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE CAST (locus[] AS locus_set) WITH FUNCTION locus_set(locus[]);
+CREATE CAST (locus_set AS locus[]) WITH FUNCTION locus_set_to_array(locus_set);
+
+CREATE FUNCTION locus_set_agg_finalfn(internal)
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE AGGREGATE locus_set_agg(locus) (
+  SFUNC = locus_merge_transfn,
+  STYPE = internal,
+  FINALFUNC = locus_set_agg_finalfn,
+  COMBINEFUNC = locus_merge_combinefn,
+  SERIALFUNC = locus_merge_serialfn,
+  DESERIALFUNC = locus_merge_deserialfn,
+  PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE locus_set_agg(locus) IS
+'set of the positions covered by the loci';
+
+CREATE FUNCTION locus_overlap_set(locus, locus_set)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_overlap_set(locus, locus_set) IS
+'(a) overlaps an interval of the set';
+
+CREATE FUNCTION locus_contained_set(locus, locus_set)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_contained_set(locus, locus_set) IS
+'(a) is contained in an interval of the set';
+
+CREATE FUNCTION locus_set_union(locus_set, locus_set)
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_set_intersect(locus_set, locus_set)
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus_set_minus(locus_set, locus_set)
+RETURNS locus_set
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OPERATOR && (
+  LEFTARG = locus,
+  RIGHTARG = locus_set,
+  PROCEDURE = locus_overlap_set,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR <@ (
+  LEFTARG = locus,
+  RIGHTARG = locus_set,
+  PROCEDURE = locus_contained_set,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR + (
+  LEFTARG = locus_set,
+  RIGHTARG = locus_set,
+  PROCEDURE = locus_set_union,
+  COMMUTATOR = '+'
+);
+
+CREATE OPERATOR * (
+  LEFTARG = locus_set,
+  RIGHTARG = locus_set,
+  PROCEDURE = locus_set_intersect,
+  COMMUTATOR = '*'
+);
+
+CREATE OPERATOR - (
+  LEFTARG = locus_set,
+  RIGHTARG = locus_set,
+  PROCEDURE = locus_set_minus
+);
+
+-- Probing an array of loci in one index scan
+CREATE FUNCTION locus_overlap_array(locus, locus[])
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_overlap_array(locus, locus[]) IS
+'(a) overlaps an element of the array';
+
+CREATE FUNCTION locus_contained_array(locus, locus[])
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION locus_contained_array(locus, locus[]) IS
+'(a) is contained in an element of the array';
+
+CREATE OPERATOR && (
+  LEFTARG = locus,
+  RIGHTARG = locus[],
+  PROCEDURE = locus_overlap_array,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR <@ (
+  LEFTARG = locus,
+  RIGHTARG = locus[],
+  PROCEDURE = locus_contained_array,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+-- Loci with contig names of any length
+CREATE FUNCTION vlocus_in(cstring)
+RETURNS vlocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_out(vlocus)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_recv(internal)
+RETURNS vlocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_send(vlocus)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE TYPE vlocus (
+  INTERNALLENGTH = VARIABLE,
+  INPUT = vlocus_in,
+  OUTPUT = vlocus_out,
+  RECEIVE = vlocus_recv,
+  SEND = vlocus_send,
+  ALIGNMENT = char,
+  STORAGE = main
+);
+
+COMMENT ON TYPE vlocus IS
+'genomic locus with a contig name of any length, ''contig:begin-end''';
+
+CREATE FUNCTION vlocus(locus)
+RETURNS vlocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus(vlocus)
+RETURNS locus
+AS 'MODULE_PATHNAME', 'vlocus_to_locus'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE CAST (locus AS vlocus) WITH FUNCTION vlocus(locus) AS ASSIGNMENT;
+CREATE CAST (vlocus AS locus) WITH FUNCTION locus(vlocus) AS ASSIGNMENT;
+
+CREATE FUNCTION contig(vlocus)
+RETURNS text
+AS 'MODULE_PATHNAME', 'vlocus_contig'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION lower(vlocus)
+RETURNS int
+AS 'MODULE_PATHNAME', 'vlocus_lower'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION upper(vlocus)
+RETURNS int
+AS 'MODULE_PATHNAME', 'vlocus_upper'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_cmp(vlocus, vlocus)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_lt(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_le(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_gt(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_ge(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_same(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_different(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_left(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_right(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_over_left(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_over_right(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_overlap(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_contains(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION vlocus_contained(vlocus, vlocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OPERATOR < (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_lt,
+  COMMUTATOR = '>',
+  NEGATOR = '>=',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_le,
+  COMMUTATOR = '>=',
+  NEGATOR = '>',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR > (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_gt,
+  COMMUTATOR = '<',
+  NEGATOR = '<=',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_ge,
+  COMMUTATOR = '<=',
+  NEGATOR = '<',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR = (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_same,
+  COMMUTATOR = '=',
+  NEGATOR = '<>',
+  RESTRICT = eqsel,
+  JOIN = eqjoinsel,
+  MERGES
+);
+
+CREATE OPERATOR <> (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_different,
+  COMMUTATOR = '<>',
+  NEGATOR = '=',
+  RESTRICT = neqsel,
+  JOIN = neqjoinsel
+);
+
+CREATE OPERATOR << (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_left,
+  COMMUTATOR = '>>',
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR <& (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_over_left,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR && (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_overlap,
+  COMMUTATOR = '&&',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR &> (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_over_right,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR >> (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_right,
+  COMMUTATOR = '<<',
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR @> (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_contains,
+  COMMUTATOR = '<@',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR <@ (
+  LEFTARG = vlocus,
+  RIGHTARG = vlocus,
+  PROCEDURE = vlocus_contained,
+  COMMUTATOR = '@>',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR CLASS vlocus_ops
+    DEFAULT FOR TYPE vlocus USING btree AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       vlocus_cmp(vlocus, vlocus);
+
+-- gist_vlocus_ops keeps the keys of gist_locus_ops and shares its methods
+CREATE FUNCTION gist_vlocus_consistent(internal, vlocus, smallint, oid, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_vlocus_compress(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS gist_vlocus_ops
+DEFAULT FOR TYPE vlocus USING gist
+AS
+  OPERATOR   1 << ,
+  OPERATOR   2 <& ,
+  OPERATOR   3 && ,
+  OPERATOR   4 &> ,
+  OPERATOR   5 >> ,
+  OPERATOR   6  = ,
+  OPERATOR   7 @> ,
+  OPERATOR   8 <@ ,
+  FUNCTION  1 gist_vlocus_consistent (internal, vlocus, smallint, oid, internal),
+  FUNCTION  2 gist_locus_union (internal, internal),
+  FUNCTION  3 gist_vlocus_compress (internal),
+  FUNCTION  4 gist_locus_decompress (internal),
+  FUNCTION  5 gist_locus_penalty (internal, internal, internal),
+  FUNCTION  6 gist_locus_picksplit (internal, internal),
+  FUNCTION  7 gist_locus_same (locus, locus, internal),
+  STORAGE locus;
+
+-- Loci with interned contig names
+
+-- The contig dictionary of plocus: names are entered by
+-- locus_contig_register() and never change or go away.  The C collation
+-- lets the functions of plocus scan the name index directly.
+CREATE TABLE locus_contigs (
+  id serial PRIMARY KEY,
+  name text COLLATE "C" NOT NULL UNIQUE CHECK (length(name) BETWEEN 1 AND 255)
+);
+
+GRANT SELECT ON locus_contigs TO PUBLIC;
+
+SELECT pg_catalog.pg_extension_config_dump('locus_contigs', '');
+SELECT pg_catalog.pg_extension_config_dump('locus_contigs_id_seq', '');
+
+CREATE FUNCTION locus_contig_register(text)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE PARALLEL UNSAFE;
+
+COMMENT ON FUNCTION locus_contig_register(text) IS
+'enter a contig name into the dictionary of plocus and return its ID';
+
+CREATE FUNCTION plocus_in(cstring)
+RETURNS plocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_out(plocus)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_recv(internal)
+RETURNS plocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_send(plocus)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE TYPE plocus (
+  INTERNALLENGTH = 16,
+  INPUT = plocus_in,
+  OUTPUT = plocus_out,
+  RECEIVE = plocus_recv,
+  SEND = plocus_send,
+  ALIGNMENT = int4
+);
+
+COMMENT ON TYPE plocus IS
+'genomic locus with an interned contig name, ''contig:begin-end''';
+
+CREATE FUNCTION plocus(locus)
+RETURNS plocus
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION locus(plocus)
+RETURNS locus
+AS 'MODULE_PATHNAME', 'plocus_to_locus'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE CAST (locus AS plocus) WITH FUNCTION plocus(locus) AS ASSIGNMENT;
+CREATE CAST (plocus AS locus) WITH FUNCTION locus(plocus) AS ASSIGNMENT;
+
+CREATE FUNCTION contig(plocus)
+RETURNS text
+AS 'MODULE_PATHNAME', 'plocus_contig'
+LANGUAGE C STRICT STABLE PARALLEL SAFE;
+
+CREATE FUNCTION lower(plocus)
+RETURNS int
+AS 'MODULE_PATHNAME', 'plocus_lower'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION upper(plocus)
+RETURNS int
+AS 'MODULE_PATHNAME', 'plocus_upper'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_cmp(plocus, plocus)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_lt(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_le(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_gt(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_ge(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_same(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_different(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_left(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_right(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_over_left(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_over_right(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_overlap(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_contains(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION plocus_contained(plocus, plocus)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OPERATOR < (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_lt,
+  COMMUTATOR = '>',
+  NEGATOR = '>=',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_le,
+  COMMUTATOR = '>=',
+  NEGATOR = '>',
+  RESTRICT = scalarltsel,
+  JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR > (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_gt,
+  COMMUTATOR = '<',
+  NEGATOR = '<=',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_ge,
+  COMMUTATOR = '<=',
+  NEGATOR = '<',
+  RESTRICT = scalargtsel,
+  JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR = (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_same,
+  COMMUTATOR = '=',
+  NEGATOR = '<>',
+  RESTRICT = eqsel,
+  JOIN = eqjoinsel,
+  MERGES
+);
+
+CREATE OPERATOR <> (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_different,
+  COMMUTATOR = '<>',
+  NEGATOR = '=',
+  RESTRICT = neqsel,
+  JOIN = neqjoinsel
+);
+
+CREATE OPERATOR << (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_left,
+  COMMUTATOR = '>>',
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR <& (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_over_left,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR && (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_overlap,
+  COMMUTATOR = '&&',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR &> (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_over_right,
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR >> (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_right,
+  COMMUTATOR = '<<',
+  RESTRICT = positionsel,
+  JOIN = positionjoinsel
+);
+
+CREATE OPERATOR @> (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_contains,
+  COMMUTATOR = '<@',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR <@ (
+  LEFTARG = plocus,
+  RIGHTARG = plocus,
+  PROCEDURE = plocus_contained,
+  COMMUTATOR = '@>',
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE OPERATOR CLASS plocus_ops
+    DEFAULT FOR TYPE plocus USING btree AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       plocus_cmp(plocus, plocus);
+
+-- gist_plocus_ops keeps the keys of gist_locus_ops and shares its methods
+CREATE FUNCTION gist_plocus_consistent(internal, plocus, smallint, oid, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gist_plocus_compress(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS gist_plocus_ops
+DEFAULT FOR TYPE plocus USING gist
+AS
+  OPERATOR   1 << ,
+  OPERATOR   2 <& ,
+  OPERATOR   3 && ,
+  OPERATOR   4 &> ,
+  OPERATOR   5 >> ,
+  OPERATOR   6  = ,
+  OPERATOR   7 @> ,
+  OPERATOR   8 <@ ,
+  FUNCTION  1 gist_plocus_consistent (internal, plocus, smallint, oid, internal),
+  FUNCTION  2 gist_locus_union (internal, internal),
+  FUNCTION  3 gist_plocus_compress (internal),
+  FUNCTION  4 gist_locus_decompress (internal),
+  FUNCTION  5 gist_locus_penalty (internal, internal, internal),
+  FUNCTION  6 gist_locus_picksplit (internal, internal),
+  FUNCTION  7 gist_locus_same (locus, locus, internal),
+  STORAGE locus;
+
+-- Reading BED and VCF files on the server
+CREATE FUNCTION locus_read_bed(path text)
+RETURNS TABLE (locus locus, fields text[])
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE PARALLEL UNSAFE
+ROWS 100000;
+
+COMMENT ON FUNCTION locus_read_bed(text) IS
+'records of a BED file, plain or gzip-compressed, as 1-based loci and the columns after chromEnd';
+
+CREATE FUNCTION locus_read_vcf(path text)
+RETURNS TABLE (locus locus, id text, ref text, alt text, qual text, filter text,
+               info text, fields text[])
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE PARALLEL UNSAFE
+ROWS 100000;
+
+COMMENT ON FUNCTION locus_read_vcf(text) IS
+'records of a VCF file, plain or gzip-compressed, with FORMAT and the samples in fields';
+
+-- Foreign tables over bgzip-compressed, tabix-indexed files
+CREATE FUNCTION locus_fdw_handler()
+RETURNS fdw_handler
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+CREATE FUNCTION locus_fdw_validator(text[], oid)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+CREATE FOREIGN DATA WRAPPER locus_fdw
+  HANDLER locus_fdw_handler
+  VALIDATOR locus_fdw_validator;
+
+COMMENT ON FOREIGN DATA WRAPPER locus_fdw IS
+'records of bgzip files through their tabix index, reading only the blocks of a region for locus && const, <@ and @>';
+
+-- Synthetic loci for benchmarks
+CREATE FUNCTION locus_generate(n int8, assembly_profile text DEFAULT 'grch38',
+                               length_distribution text DEFAULT 'germline',
+                               seed int8 DEFAULT 0)
+RETURNS SETOF locus
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE
+ROWS 1000000;
+
+COMMENT ON FUNCTION locus_generate(int8, text, text, int8) IS
+'n SNV, indel and SV loci on the chromosomes of an assembly, the same for the same seed';
+
+-- Create operator classes for indexing
+
+CREATE OPERATOR CLASS locus_ops
+    DEFAULT FOR TYPE locus USING btree AS
+        OPERATOR        1       < ,
+        OPERATOR        2       <= ,
+        OPERATOR        3       = ,
+        OPERATOR        4       >= ,
+        OPERATOR        5       > ,
+        FUNCTION        1       locus_cmp(locus, locus),
+        FUNCTION        2       locus_sortsupport(internal),
+        FUNCTION        4       locus_equalimage(oid);
+
+CREATE OPERATOR CLASS hash_locus_ops
+    DEFAULT FOR TYPE locus USING hash AS
+        OPERATOR        1       = ,
+        FUNCTION        1       locus_hash(locus),
+        FUNCTION        2       locus_hash_extended(locus, int8);
+
+CREATE OPERATOR CLASS gist_locus_ops
+DEFAULT FOR TYPE locus USING gist
+AS
+  OPERATOR   1 << ,
+  OPERATOR   2 <& ,
+  OPERATOR   3 && ,
+  OPERATOR   4 &> ,
+  OPERATOR   5 >> ,
+  OPERATOR   6  = ,
+  OPERATOR   7 @> ,
+  OPERATOR   8 <@ ,
+  OPERATOR  13  @ ,
+  OPERATOR  14  ~ ,
+  OPERATOR  15 <-> (locus, locus) FOR ORDER BY float_ops,
+  OPERATOR  31 && (locus, locus[]),
+  OPERATOR  32 <@ (locus, locus[]),
+  FUNCTION  1 gist_locus_consistent (internal, locus, smallint, oid, internal),
+  FUNCTION  2 gist_locus_union (internal, internal),
+  FUNCTION  3 gist_locus_compress (internal),
+  FUNCTION  4 gist_locus_decompress (internal),
+  FUNCTION  5 gist_locus_penalty (internal, internal, internal),
+  FUNCTION  6 gist_locus_picksplit (internal, internal),
+  FUNCTION  7 gist_locus_same (locus, locus, internal),
+  FUNCTION  8 gist_locus_distance (internal, locus, smallint, oid, internal),
+  FUNCTION 11 locus_sortsupport (internal);
+
+-- define SP-GiST support methods
+CREATE FUNCTION spg_locus_quad_config(internal, internal)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION spg_locus_quad_choose(internal, internal)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION spg_locus_quad_picksplit(internal, internal)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION spg_locus_quad_inner_consistent(internal, internal)
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION spg_locus_quad_leaf_consistent(internal, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS spgist_locus_ops
+FOR TYPE locus USING spgist
+AS
+  OPERATOR   1 << ,
+  OPERATOR   3 && ,
+  OPERATOR   5 >> ,
+  OPERATOR   7 @> ,
+  OPERATOR   8 <@ ,
+  FUNCTION  1 spg_locus_quad_config (internal, internal),
+  FUNCTION  2 spg_locus_quad_choose (internal, internal),
+  FUNCTION  3 spg_locus_quad_picksplit (internal, internal),
+  FUNCTION  4 spg_locus_quad_inner_consistent (internal, internal),
+  FUNCTION  5 spg_locus_quad_leaf_consistent (internal, internal);
+
+-- define BRIN support methods
+CREATE FUNCTION brin_locus_opcinfo(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION brin_locus_add_value(internal, internal, internal, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION brin_locus_consistent(internal, internal, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION brin_locus_union(internal, internal, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS brin_locus_ops
+DEFAULT FOR TYPE locus USING brin
+AS
+  OPERATOR   1 << ,
+  OPERATOR   3 && ,
+  OPERATOR   5 >> ,
+  OPERATOR   6  = ,
+  OPERATOR   7 @> ,
+  OPERATOR   8 <@ ,
+  FUNCTION  1 brin_locus_opcinfo (internal),
+  FUNCTION  2 brin_locus_add_value (internal, internal, internal, internal),
+  FUNCTION  3 brin_locus_consistent (internal, internal, internal),
+  FUNCTION  4 brin_locus_union (internal, internal, internal),
+  STORAGE locus;
@@ -8,23 +8,29 @@
  ******************************************************************************/
 
 
+#include <ctype.h>
 #include <float.h>
 #include <limits.h>  /* for INT_MAX */
+#include <math.h>
 
 #include "postgres.h"
 #include "access/gist.h"
 #include "access/stratnum.h"
+#include "common/hashfn.h"
+#include "funcapi.h"
+#include "lib/hyperloglog.h"
+#include "libpq/pqformat.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/float.h"
+#include "utils/guc.h"
+#include "utils/sortsupport.h"
 #include "utils/typcache.h"
 #include "utils/rangetypes.h"
 
 #include "locus_data.h"
-#include "strnatcmp.h"
 
 
-#define DatumGetLocusP(X) ((LOCUS *) DatumGetPointer(X))
-#define PG_GETARG_LOCUS_P(n) ((LOCUS *) PG_GETARG_POINTER(n))
-
 
 /*
 #define GIST_DEBUG
@@ -34,20 +40,47 @@
 PG_MODULE_MAGIC;
 
 /*
- * Auxiliary data structure for the picksplit method.
+ * Auxiliary data structures for the picksplit method.
  */
 typedef struct
 {
-  float   center;
   OffsetNumber index;
   LOCUS      *data;
+  LOCUS_RANGE_KEY contigs;  /* data as a range key, for its contigs */
 } gist_locus_picksplit_item;
 
+/* An entry that fits in either group of a split */
+typedef struct
+{
+  gist_locus_picksplit_item *item;
+  int64   delta;
+} gist_locus_common_entry;
+
+/* The best split of a group of entries found so far */
+typedef struct
+{
+  int     entries_count;
+  bool    first;      /* no split considered yet */
+  int32   left_upper;
+  int32   right_lower;
+  float4  ratio;
+  int64   overlap;
+} gist_locus_split_context;
+
+/* Minimum share of the entries that either side of a split must get */
+#define LIMIT_RATIO  0.3
+
+/* Penalty for taking in another contig: more than any change in area */
+#define GIST_LOCUS_CONTIG_PENALTY  ((float) 4294967296.0)
+
 /*
 ** Input/Output routines
 */
 PG_FUNCTION_INFO_V1(locus_in);
 PG_FUNCTION_INFO_V1(locus_out);
+PG_FUNCTION_INFO_V1(locus_recv);
+PG_FUNCTION_INFO_V1(locus_send);
+PG_FUNCTION_INFO_V1(locus_rekey);
 PG_FUNCTION_INFO_V1(contig);
 PG_FUNCTION_INFO_V1(range);
 PG_FUNCTION_INFO_V1(length);
@@ -65,10 +98,34 @@ PG_FUNCTION_INFO_V1(gist_locus_picksplit);
 PG_FUNCTION_INFO_V1(gist_locus_penalty);
 PG_FUNCTION_INFO_V1(gist_locus_union);
 PG_FUNCTION_INFO_V1(gist_locus_same);
+PG_FUNCTION_INFO_V1(gist_locus_distance);
+PG_FUNCTION_INFO_V1(gist_vlocus_consistent);
+PG_FUNCTION_INFO_V1(gist_vlocus_compress);
+PG_FUNCTION_INFO_V1(gist_plocus_consistent);
+PG_FUNCTION_INFO_V1(gist_plocus_compress);
 
 static Datum gist_locus_leaf_consistent(Datum key, Datum query, StrategyNumber strategy);
 static Datum gist_locus_internal_consistent(Datum key, Datum query, StrategyNumber strategy);
-static Datum gist_locus_binary_union(Datum r1, Datum r2, int *sizep);
+static bool gist_locus_range_consistent(LOCUS_RANGE_KEY *key, LOCUS *query, StrategyNumber strategy);
+static bool gist_locus_range_matches_contig(LOCUS_RANGE_KEY *key, LOCUS *query);
+static void gist_locus_range_key(LOCUS *key, LOCUS_RANGE_KEY *range);
+static void gist_locus_key_union(LOCUS *a, LOCUS *b, LOCUS *result);
+static bool gist_locus_covers_contigs(LOCUS *key, LOCUS *locus);
+static int64 gist_locus_growth(LOCUS *key, LOCUS *locus);
+
+/*
+ * Strategies of locus && locus[] and locus <@ locus[], numbered past those
+ * in stratnum.h
+ */
+#define LOCUS_BATCH_OVERLAP_STRATEGY    31
+#define LOCUS_BATCH_CONTAINED_STRATEGY  32
+
+typedef struct LocusBatch LocusBatch;
+
+static LocusBatch *locus_batch_get(FmgrInfo *flinfo, Datum query);
+static bool locus_batch_overlaps(LocusBatch *batch, LOCUS *locus);
+static bool locus_batch_contained(LocusBatch *batch, LOCUS *locus);
+static bool gist_locus_batch_consistent(LOCUS *key, LocusBatch *batch, StrategyNumber strategy);
 
 /*
 ** R-tree support functions
@@ -79,6 +136,8 @@ static Datum gist_locus_binary_union(Datum r1, Datum r2, int *sizep);
 PG_FUNCTION_INFO_V1(locus_same);
 PG_FUNCTION_INFO_V1(locus_contains);
 PG_FUNCTION_INFO_V1(locus_contained);
+PG_FUNCTION_INFO_V1(locus_overlap_array);
+PG_FUNCTION_INFO_V1(locus_contained_array);
 PG_FUNCTION_INFO_V1(locus_overlap);
 PG_FUNCTION_INFO_V1(locus_left);
 PG_FUNCTION_INFO_V1(locus_over_left);
@@ -86,7 +145,9 @@ PG_FUNCTION_INFO_V1(locus_right);
 PG_FUNCTION_INFO_V1(locus_over_right);
 PG_FUNCTION_INFO_V1(locus_union);
 PG_FUNCTION_INFO_V1(locus_inter);
-static void rt_locus_size(LOCUS *a, float *size);
+PG_FUNCTION_INFO_V1(locus_distance);
+static float8 locus_distance_internal(LOCUS *a, LOCUS *b);
+static float8 locus_position_distance(LOCUS *a, LOCUS *b);
 /*
 ** Various operators
 */
@@ -97,11 +158,222 @@ PG_FUNCTION_INFO_V1(locus_gt);
 PG_FUNCTION_INFO_V1(locus_ge);
 PG_FUNCTION_INFO_V1(locus_different);
 
+/*
+** B-tree sort support
+*/
+PG_FUNCTION_INFO_V1(locus_sortsupport);
+PG_FUNCTION_INFO_V1(locus_equalimage);
+
+/*
+** Hash support
+*/
+PG_FUNCTION_INFO_V1(locus_hash);
+PG_FUNCTION_INFO_V1(locus_hash_extended);
+
 /*
 ** Experimental tiling function to support performance benchmarks
 */
 PG_FUNCTION_INFO_V1(locus_tile_id);
 
+/*
+** Integer tile and bin keys for binned joins
+*/
+PG_FUNCTION_INFO_V1(locus_tile_key);
+PG_FUNCTION_INFO_V1(locus_tiles);
+PG_FUNCTION_INFO_V1(locus_bin);
+PG_FUNCTION_INFO_V1(locus_bins);
+
+
+/*****************************************************************************
+ * Module initialization
+ *****************************************************************************/
+
+void
+_PG_init(void)
+{
+  locus_sweep_init();
+
+  MarkGUCPrefixReserved("locus");
+}
+
+/*****************************************************************************
+ * Contig keys
+ *****************************************************************************/
+
+/*
+ * Natural-order contig keys
+ *
+ * locus_contig_natkey() encodes a contig name into a byte string whose
+ * unsigned (memcmp) order agrees with strnatcmp().  Characters other than
+ * digits are copied with their sign bit flipped when char is signed, because
+ * strnatcmp() compares plain chars.  A run of digits is written as a marker
+ * byte in the digit range followed by the digits themselves:
+ *
+ *   - a run without a leading zero gets the marker '0' + length (runs of nine
+ *     or more digits use '9' followed by a length byte), so that longer
+ *     numbers sort after shorter ones as in compare_right();
+ *   - a run with a leading zero gets the marker '0' and is closed by a byte
+ *     below any digit, reproducing the left-aligned compare_left().
+ *
+ * Whitespace is skipped, as strnatcmp() does.  The key is padded with the
+ * code of the terminating NUL.  The return value is the length of the full
+ * encoding; if it exceeds keylen, the key is only a prefix, and two equal
+ * prefixes have to be resolved with strnatcmp().
+ *
+ * Every LOCUS carries the first LOCUS_NATKEY_LEN bytes of its key, set by
+ * locus_set_natkey() when the value is built.
+ */
+#define NATKEY_BYTE(c)   ((uint8) ((c) ^ (CHAR_MIN < 0 ? 0x80 : 0)))
+#define NATKEY_END       NATKEY_BYTE('\0')
+#define NATKEY_RUN_END   0x01
+
+/*
+ * Upper bound on the length of a full key.  The worst case is a contig of
+ * single zeros between other characters, at four bytes per two characters.
+ */
+#define NATKEY_MAXLEN    (2 * sizeof(((LOCUS *) 0)->contig))
+
+#define natkey_put(b) \
+  do { if (n < keylen) key[n] = (b); n++; } while (0)
+
+static int
+locus_contig_natkey(const char *contig, uint8 *key, int keylen)
+{
+  const unsigned char *p = (const unsigned char *) contig;
+  int     n = 0;
+
+  while (*p)
+  {
+    if (isspace(*p))
+    {
+      p++;
+      continue;
+    }
+
+    if (isdigit(*p))
+    {
+      const unsigned char *run = p;
+      int     len;
+
+      while (isdigit(*p))
+        p++;
+      len = p - run;
+
+      if (*run == '0')
+      {
+        natkey_put(NATKEY_BYTE('0'));
+        for (; run < p; run++)
+          natkey_put(NATKEY_BYTE(*run));
+        natkey_put(NATKEY_RUN_END);
+      }
+      else
+      {
+        if (len < 9)
+          natkey_put(NATKEY_BYTE('0' + len));
+        else
+        {
+          natkey_put(NATKEY_BYTE('9'));
+          natkey_put((uint8) Min(len, 255));
+        }
+        for (; run < p; run++)
+          natkey_put(NATKEY_BYTE(*run));
+      }
+      continue;
+    }
+
+    natkey_put(NATKEY_BYTE(*p));
+    p++;
+  }
+
+  if (n < keylen)
+    memset(key + n, NATKEY_END, keylen - n);
+
+  return n;
+}
+
+/*
+ * Write the contig name that a key prefix starts with into buf, which needs
+ * keylen + 1 bytes.  Whitespace that the key skipped does not come back.
+ */
+static void
+locus_natkey_text(const uint8 *key, int keylen, char *buf)
+{
+  int     i = 0;
+
+  while (i < keylen && key[i] != NATKEY_END)
+  {
+    char    c = (char) NATKEY_BYTE(key[i++]);
+    int     len;
+
+    if (!isdigit((unsigned char) c))
+    {
+      *buf++ = c;
+      continue;
+    }
+
+    /* c is the marker of a run of digits */
+    if (c == '0')
+    {
+      while (i < keylen && key[i] != NATKEY_RUN_END)
+        *buf++ = (char) NATKEY_BYTE(key[i++]);
+      i++;
+      continue;
+    }
+    if (c == '9')
+    {
+      if (i >= keylen)
+        break;
+      len = key[i++];
+    }
+    else
+      len = c - '0';
+    for (; len > 0 && i < keylen; len--)
+      *buf++ = (char) NATKEY_BYTE(key[i++]);
+  }
+
+  *buf = '\0';
+}
+
+/*
+ * Compute the natural-order key of a contig into natkey and return the
+ * flags that go with it
+ */
+uint8
+locus_contig_flags(const char *contig, uint8 *natkey)
+{
+  uint8     flags = 0;
+
+  if (strcmp(contig, "<all>") == 0)
+    flags |= LOCUS_WILDCARD;
+  if (locus_contig_natkey(contig, natkey, LOCUS_NATKEY_LEN) <= LOCUS_NATKEY_LEN)
+    flags |= LOCUS_NATKEY_EXACT;
+
+  return flags;
+}
+
+/*
+ * Fill in the natural-order key and flags of a locus whose contig is set.
+ * The unused tail of the contig buffer is cleared so that equal values have
+ * equal images.
+ */
+void
+locus_set_natkey(LOCUS *locus)
+{
+  size_t    len = strnlen(locus->contig, sizeof(locus->contig) - 1);
+
+  memset(locus->contig + len, 0, sizeof(locus->contig) - len);
+
+  locus->flags = locus_contig_flags(locus->contig, locus->natkey);
+}
+
+void
+locus_set_wildcard(LOCUS *locus)
+{
+  strcpy(locus->contig, "<all>");
+  locus->chr = false;
+  locus_set_natkey(locus);
+}
+
 
 /*****************************************************************************
  * Input/Output functions
@@ -111,51 +383,235 @@ Datum
 locus_in(PG_FUNCTION_ARGS)
 {
   char     *str = PG_GETARG_CSTRING(0);
-  LOCUS    *result = palloc(sizeof(LOCUS));
-
-  locus_scanner_init(str);
+  LOCUS    *result = palloc0(sizeof(LOCUS));
 
-  if (locus_yyparse(result) != 0)
-    locus_yyerror(result, "bogus input");
-
-  locus_scanner_finish();
+  locus_parse(str, result);
+  locus_set_natkey(result);
 
   PG_RETURN_POINTER(result);
 }
 
 // ------------------------- locus_out ---------------------------
-Datum
-locus_out(PG_FUNCTION_ARGS)
+/*
+ * Number of characters pg_ltoa() produces for value
+ */
+static inline int
+locus_int32_len(int32 value)
 {
-  LOCUS    *locus = PG_GETARG_LOCUS_P(0);
-  char     *result;
+  uint32    u = value < 0 ? -(uint32) value : (uint32) value;
+  int       len = value < 0 ? 2 : 1;
+
+  while (u >= 10)
+  {
+    u /= 10;
+    len++;
+  }
+  return len;
+}
+
+/*
+ * Display a GiST range key, which only tools looking into index pages get to
+ * see, as {first..last}:lower-upper.  A contig that is cut short ends in '*',
+ * and ",<all>" marks wildcard loci.
+ */
+static char *
+locus_range_key_out(LOCUS_RANGE_KEY *key)
+{
+  char      first[LOCUS_RANGE_NATKEY_LEN + 1];
+  char      last[LOCUS_RANGE_NATKEY_LEN + 1];
 
-  result = (char *) palloc(40);   // max 14 chars of contig + two delimiters + max 20 digits
+  locus_natkey_text(key->first, LOCUS_RANGE_NATKEY_LEN, first);
+  locus_natkey_text(key->last, LOCUS_RANGE_NATKEY_LEN, last);
 
+  return psprintf("{%s%s..%s%s%s}:%d-%d",
+                  first, (key->flags & LOCUS_RANGE_FIRST_EXACT) ? "" : "*",
+                  last, (key->flags & LOCUS_RANGE_LAST_EXACT) ? "" : "*",
+                  (key->flags & LOCUS_WILDCARD) ? ",<all>" : "",
+                  key->lower, key->upper);
+}
 
-  if (locus == (LOCUS *) NULL) {
-    sprintf(result, "NULL");
-  }
-  else if (locus->lower == locus->upper) {
+/*
+ * The text of a locus with the given contig, which need not end in a NUL
+ */
+char *
+locus_format(bool chr, const char *contig, int contig_len, int32 lower, int32 upper)
+{
+  bool      show_lower;
+  bool      show_dash;
+  bool      show_upper;
+  int       len;
+  char     *result;
+  char     *p;
+
+  if (lower == upper) {
   /*
    * indicates that this interval was built by locus_in() off a single point
    */
-    sprintf(result, locus->chr ? "chr%s:%d" : "%s:%d", locus->contig, locus->lower);
+    show_lower = true;
+    show_dash = show_upper = false;
   }
-  else if (locus->lower > 0 && locus->upper == INT_MAX) {
-    sprintf(result, locus->chr ? "chr%s:%d-" : "%s:%d-", locus->contig, locus->lower);
+  else if (lower > 0 && upper == INT_MAX) {
+    show_lower = show_dash = true;
+    show_upper = false;
   }
-  else if (locus->lower == 0 && locus->upper < INT_MAX) {
-    sprintf(result, locus->chr ? "chr%s:-%d" : "%s:-%d", locus->contig, locus->upper);
+  else if (lower == 0 && upper < INT_MAX) {
+    show_lower = false;
+    show_dash = show_upper = true;
   }
-  else if (locus->lower == 0 && locus->upper == INT_MAX) {
-    sprintf(result, locus->chr ? "chr%s" : "%s", locus->contig);
+  else if (lower == 0 && upper == INT_MAX) {
+    show_lower = show_dash = show_upper = false;
   }
-  else{
-    sprintf(result, locus->chr ? "chr%s:%d-%d" : "%s:%d-%d", locus->contig, locus->lower, locus->upper);
+  else {
+    show_lower = show_dash = show_upper = true;
   }
 
-  PG_RETURN_CSTRING(result);
+  len = (chr ? 3 : 0) + contig_len;
+  if (show_lower || show_dash)
+    len++;  /* colon */
+  if (show_lower)
+    len += locus_int32_len(lower);
+  if (show_dash)
+    len++;
+  if (show_upper)
+    len += locus_int32_len(upper);
+
+  result = p = (char *) palloc(len + 1);
+
+  if (chr) {
+    memcpy(p, "chr", 3);
+    p += 3;
+  }
+  memcpy(p, contig, contig_len);
+  p += contig_len;
+
+  if (show_lower || show_dash)
+    *p++ = ':';
+  if (show_lower)
+    p += pg_ltoa(lower, p);
+  if (show_dash)
+    *p++ = '-';
+  if (show_upper)
+    p += pg_ltoa(upper, p);
+  *p = '\0';
+
+  Assert(p - result == len);
+
+  return result;
+}
+
+Datum
+locus_out(PG_FUNCTION_ARGS)
+{
+  LOCUS    *locus = PG_GETARG_LOCUS_P(0);
+
+  if (LOCUS_IS_RANGE(locus))
+    PG_RETURN_CSTRING(locus_range_key_out((LOCUS_RANGE_KEY *) locus));
+
+  PG_RETURN_CSTRING(locus_format(locus->chr, locus->contig, strlen(locus->contig),
+                                 locus->lower, locus->upper));
+}
+
+/*
+ * Binary representation
+ *
+ *   uint8   format version (LOCUS_BINARY_VERSION)
+ *   uint8   flags (LOCUS_BINARY_CHR: the contig is spelled with 'chr')
+ *   int32   lower
+ *   int32   upper
+ *   uint8   contig length, followed by the contig bytes without 'chr'
+ *
+ * The natural-order key is not sent: the receiver recomputes it.
+ */
+#define LOCUS_BINARY_VERSION  1
+#define LOCUS_BINARY_CHR      0x01
+
+// ------------------------- locus_recv ---------------------------
+Datum
+locus_recv(PG_FUNCTION_ARGS)
+{
+  StringInfo  buf = (StringInfo) PG_GETARG_POINTER(0);
+  LOCUS      *result = palloc0(sizeof(LOCUS));
+  int         version;
+  int         flags;
+  int         len;
+
+  version = pq_getmsgbyte(buf);
+  if (version != LOCUS_BINARY_VERSION)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("unsupported locus binary format version %d", version)));
+
+  flags = pq_getmsgbyte(buf);
+  result->lower = pq_getmsgint(buf, 4);
+  result->upper = pq_getmsgint(buf, 4);
+  len = pq_getmsgbyte(buf);
+
+  /* as locus_in would */
+  if (result->lower > result->upper)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("swapped boundaries in external locus value: %d is greater than %d",
+                result->lower, result->upper)));
+
+  if (len < 1 || len > (flags & LOCUS_BINARY_CHR ? 11 : 14))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig length %d in external locus value", len)));
+
+  result->chr = (flags & LOCUS_BINARY_CHR) != 0;
+  memcpy(result->contig, pq_getmsgbytes(buf, len), len);
+
+  /* as locus_in would produce, so that the value prints back as itself */
+  if (!locus_contig_valid(result->chr, result->contig, len,
+                          sizeof(result->contig) - 1))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig in external locus value")));
+
+  locus_set_natkey(result);
+
+  PG_RETURN_POINTER(result);
+}
+
+// ------------------------- locus_send ---------------------------
+Datum
+locus_send(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  int         len = strlen(locus->contig);
+  StringInfoData buf;
+
+  pq_begintypsend(&buf);
+  pq_sendbyte(&buf, LOCUS_BINARY_VERSION);
+  pq_sendbyte(&buf, locus->chr ? LOCUS_BINARY_CHR : 0);
+  pq_sendint32(&buf, locus->lower);
+  pq_sendint32(&buf, locus->upper);
+  pq_sendbyte(&buf, len);
+  pq_sendbytes(&buf, locus->contig, len);
+
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+// ------------------------- locus_rekey ---------------------------
+/*
+ * Rebuild a stored value with its natural-order key.  Versions before 0.0.3
+ * left the bytes after the contig uninitialized; the upgrade script runs
+ * every stored locus through this function.
+ */
+Datum
+locus_rekey(PG_FUNCTION_ARGS)
+{
+  LOCUS    *locus = PG_GETARG_LOCUS_P(0);
+  LOCUS    *result = palloc0(sizeof(LOCUS));
+
+  result->lower = locus->lower;
+  result->upper = locus->upper;
+  memcpy(result->contig, locus->contig, sizeof(result->contig) - 1);
+  result->chr = locus->chr;
+
+  locus_set_natkey(result);
+
+  PG_RETURN_POINTER(result);
 }
 
 // ------------------------- contig ---------------------------
@@ -229,6 +685,15 @@ upper(PG_FUNCTION_ARGS)
  *               GiST functions
  *****************************************************************************/
 
+/*
+ * Keys on the internal pages of a GiST index are loci while everything below
+ * them lies on one contig.  Above that they are LOCUS_RANGE_KEYs (see
+ * locus_data.h), which keep the least and the greatest contig instead of
+ * collapsing to "<all>", so that a search on one contig skips the subtrees
+ * of the others.  Range keys hold prefixes of the natural-order contig keys;
+ * where a prefix cannot settle a comparison, the subtree is searched.
+ */
+
 /*
 ** The GiST Consistent method for genomic loci
 ** Should return false if for all data items x below entry,
@@ -248,6 +713,18 @@ gist_locus_consistent(PG_FUNCTION_ARGS)
   /* All cases served by this function are exact */
   *recheck = false;
 
+  if (strategy == LOCUS_BATCH_OVERLAP_STRATEGY || strategy == LOCUS_BATCH_CONTAINED_STRATEGY)
+  {
+    LocusBatch *batch = locus_batch_get(fcinfo->flinfo, query);
+    LOCUS      *key = DatumGetLocusP(entry->key);
+
+    if (!GIST_LEAF(entry))
+      PG_RETURN_BOOL(gist_locus_batch_consistent(key, batch, strategy));
+    if (strategy == LOCUS_BATCH_OVERLAP_STRATEGY)
+      PG_RETURN_BOOL(locus_batch_overlaps(batch, key));
+    PG_RETURN_BOOL(locus_batch_contained(batch, key));
+  }
+
   /*
    * if entry is not leaf, use gist_locus_internal_consistent, else use
    * gist_locus_leaf_consistent
@@ -258,6 +735,155 @@ gist_locus_consistent(PG_FUNCTION_ARGS)
     return gist_locus_internal_consistent(entry->key, query, strategy);
 }
 
+/*
+** GiST methods of vlocus and plocus
+**
+** gist_vlocus_ops and gist_plocus_ops share the keys and all but two methods
+** of gist_locus_ops.  A value whose contig fits in a locus is stored as that
+** locus; any other as a range key over its contig, a leaf that only tells
+** which subtrees it belongs to, so the rows found through it are rechecked.
+*/
+static Datum
+gist_locus_view_compress(GISTENTRY *entry, LOCUS *view)
+{
+  GISTENTRY  *retval;
+  LOCUS      *key;
+
+  key = (LOCUS *) palloc0(sizeof(LOCUS));
+  if (view->flags & LOCUS_CONTIG_OUT)
+    gist_locus_range_key(view, (LOCUS_RANGE_KEY *) key);
+  else
+  {
+    key->lower = view->lower;
+    key->upper = view->upper;
+    strcpy(key->contig, view->contig);
+    key->chr = view->chr;
+    key->flags = view->flags;
+    memcpy(key->natkey, view->natkey, LOCUS_NATKEY_LEN);
+  }
+
+  retval = (GISTENTRY *) palloc(sizeof(GISTENTRY));
+  gistentryinit(*retval, PointerGetDatum(key), entry->rel, entry->page,
+                entry->offset, false);
+
+  PG_RETURN_POINTER(retval);
+}
+
+static Datum
+gist_locus_view_consistent(GISTENTRY *entry, LOCUS *view, StrategyNumber strategy,
+                           bool *recheck)
+{
+  LOCUS      *key = DatumGetLocusP(entry->key);
+
+  *recheck = false;
+
+  if (!GIST_LEAF(entry))
+    return gist_locus_internal_consistent(entry->key, PointerGetDatum(view), strategy);
+
+  if (LOCUS_IS_RANGE(key))
+  {
+    *recheck = true;
+    PG_RETURN_BOOL(gist_locus_range_consistent((LOCUS_RANGE_KEY *) key, view, strategy));
+  }
+
+  return gist_locus_leaf_consistent(entry->key, PointerGetDatum(view), strategy);
+}
+
+Datum
+gist_vlocus_compress(PG_FUNCTION_ARGS)
+{
+  GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+  LOCUS       view;
+
+  if (!entry->leafkey)
+    PG_RETURN_POINTER(entry);
+
+  vlocus_view(DatumGetVLocusP(entry->key), &view);
+
+  return gist_locus_view_compress(entry, &view);
+}
+
+Datum
+gist_vlocus_consistent(PG_FUNCTION_ARGS)
+{
+  GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+  VLOCUS     *query = PG_GETARG_VLOCUS_P(1);
+  StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+
+  /* Oid    subtype = PG_GETARG_OID(3); */
+  bool     *recheck = (bool *) PG_GETARG_POINTER(4);
+  LOCUS       view;
+
+  vlocus_view(query, &view);
+
+  return gist_locus_view_consistent(entry, &view, strategy, recheck);
+}
+
+Datum
+gist_plocus_compress(PG_FUNCTION_ARGS)
+{
+  GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+  LOCUS       view;
+
+  if (!entry->leafkey)
+    PG_RETURN_POINTER(entry);
+
+  plocus_view(DatumGetPLocusP(entry->key), &view);
+
+  return gist_locus_view_compress(entry, &view);
+}
+
+Datum
+gist_plocus_consistent(PG_FUNCTION_ARGS)
+{
+  GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+  PLOCUS     *query = PG_GETARG_PLOCUS_P(1);
+  StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+
+  /* Oid    subtype = PG_GETARG_OID(3); */
+  bool     *recheck = (bool *) PG_GETARG_POINTER(4);
+  LOCUS       view;
+
+  plocus_view(query, &view);
+
+  return gist_locus_view_consistent(entry, &view, strategy, recheck);
+}
+
+/*
+** The GiST Distance method for genomic loci
+**
+** An internal key encloses the positions of everything below it and either
+** shares their contig or bounds their contigs, so its distance to the query
+** never exceeds that of any leaf below it.  Leaf distances are exact.
+*/
+Datum
+gist_locus_distance(PG_FUNCTION_ARGS)
+{
+  GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+  LOCUS      *query = PG_GETARG_LOCUS_P(1);
+  StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+  LOCUS      *key = DatumGetLocusP(entry->key);
+
+  /* Oid    subtype = PG_GETARG_OID(3); */
+  bool     *recheck = (bool *) PG_GETARG_POINTER(4);
+
+  if (strategy != RTKNNSearchStrategyNumber)
+    elog(ERROR, "unrecognized strategy number: %d", strategy);
+
+  *recheck = false;
+
+  if (LOCUS_IS_RANGE(key))
+  {
+    /* a wildcard query is at a finite distance from anything */
+    if (!LOCUS_IS_WILDCARD(query) &&
+        !gist_locus_range_matches_contig((LOCUS_RANGE_KEY *) key, query))
+      PG_RETURN_FLOAT8(get_float8_infinity());
+    PG_RETURN_FLOAT8(locus_position_distance(key, query));
+  }
+
+  PG_RETURN_FLOAT8(locus_distance_internal(key, query));
+}
+
 /*
 ** The GiST Union method for genomic loci
 ** returns the minimal bounding locus that encloses all the entries in entryvec
@@ -269,29 +895,27 @@ gist_locus_union(PG_FUNCTION_ARGS)
   int      *sizep = (int *) PG_GETARG_POINTER(1);
   int     numranges,
         i;
-  Datum   out = 0;
-  Datum   tmp;
+  LOCUS      *out;
 
 #ifdef GIST_DEBUG
   fprintf(stderr, "union\n");
 #endif
 
   numranges = entryvec->n;
-  tmp = entryvec->vector[0].key;
+  out = (LOCUS *) palloc(sizeof(LOCUS));
+  memcpy(out, DatumGetLocusP(entryvec->vector[0].key), sizeof(LOCUS));
   *sizep = sizeof(LOCUS);
 
   for (i = 1; i < numranges; i++)
-  {
-    out = gist_locus_binary_union(tmp, entryvec->vector[i].key, sizep);
-    tmp = out;
-  }
+    gist_locus_key_union(out, DatumGetLocusP(entryvec->vector[i].key), out);
 
-  PG_RETURN_DATUM(out);
+  PG_RETURN_POINTER(out);
 }
 
 /*
 ** GiST Compress and Decompress methods for genomic loci
-** do not do anything.
+** do not do anything: leaf keys are the loci themselves, and range keys
+** are made by union and picksplit in the form they are stored in.
 */
 Datum
 gist_locus_compress(PG_FUNCTION_ARGS)
@@ -307,7 +931,8 @@ gist_locus_decompress(PG_FUNCTION_ARGS)
 
 /*
 ** The GiST Penalty method for genomic loci
-** As in the R-tree paper, we use change in area as our penalty metric
+** As in the R-tree paper, we use change in area as our penalty metric.
+** Taking in another contig costs more than any change in area.
 */
 Datum
 gist_locus_penalty(PG_FUNCTION_ARGS)
@@ -315,16 +940,12 @@ gist_locus_penalty(PG_FUNCTION_ARGS)
   GISTENTRY  *origentry = (GISTENTRY *) PG_GETARG_POINTER(0);
   GISTENTRY  *newentry = (GISTENTRY *) PG_GETARG_POINTER(1);
   float    *result = (float *) PG_GETARG_POINTER(2);
-  LOCUS      *ud;
-  float   tmp1,
-        tmp2;
+  LOCUS      *orig = DatumGetLocusP(origentry->key);
+  LOCUS      *new = DatumGetLocusP(newentry->key);
 
-  ud = DatumGetLocusP(DirectFunctionCall2(locus_union,
-                      origentry->key,
-                      newentry->key));
-  rt_locus_size(ud, &tmp1);
-  rt_locus_size(DatumGetLocusP(origentry->key), &tmp2);
-  *result = tmp1 - tmp2;
+  *result = (float) gist_locus_growth(orig, new);
+  if (!gist_locus_covers_contigs(orig, new))
+    *result += GIST_LOCUS_CONTIG_PENALTY;
 
 #ifdef GIST_DEBUG
   fprintf(stderr, "penalty\n");
@@ -335,43 +956,322 @@ gist_locus_penalty(PG_FUNCTION_ARGS)
 }
 
 /*
- * Compare function for gist_locus_picksplit_item: sort by center.
+ * Compare function for gist_locus_picksplit_item: sort by the least, then
+ * the greatest contig.  "<all>" loci, which have no contig, come last.
  */
 static int
 gist_locus_picksplit_item_cmp(const void *a, const void *b)
 {
   const gist_locus_picksplit_item *i1 = (const gist_locus_picksplit_item *) a;
   const gist_locus_picksplit_item *i2 = (const gist_locus_picksplit_item *) b;
+  int     cmp;
+
+  cmp = memcmp(i1->contigs.first, i2->contigs.first, LOCUS_RANGE_NATKEY_LEN);
+  if (cmp != 0)
+    return cmp;
+  return memcmp(i1->contigs.last, i2->contigs.last, LOCUS_RANGE_NATKEY_LEN);
+}
+
+/*
+ * Compare functions for pointers to gist_locus_picksplit_item: sort by
+ * lower, or by upper bound.
+ */
+static int
+gist_locus_lower_cmp(const void *a, const void *b)
+{
+  LOCUS      *l1 = (*(gist_locus_picksplit_item *const *) a)->data;
+  LOCUS      *l2 = (*(gist_locus_picksplit_item *const *) b)->data;
+
+  if (l1->lower != l2->lower)
+    return l1->lower < l2->lower ? -1 : 1;
+  if (l1->upper != l2->upper)
+    return l1->upper < l2->upper ? -1 : 1;
+  return 0;
+}
+
+static int
+gist_locus_upper_cmp(const void *a, const void *b)
+{
+  LOCUS      *l1 = (*(gist_locus_picksplit_item *const *) a)->data;
+  LOCUS      *l2 = (*(gist_locus_picksplit_item *const *) b)->data;
+
+  if (l1->upper != l2->upper)
+    return l1->upper < l2->upper ? -1 : 1;
+  if (l1->lower != l2->lower)
+    return l1->lower < l2->lower ? -1 : 1;
+  return 0;
+}
 
-  if (i1->center < i2->center)
+static int
+gist_locus_common_entry_cmp(const void *a, const void *b)
+{
+  int64   d1 = ((const gist_locus_common_entry *) a)->delta;
+  int64   d2 = ((const gist_locus_common_entry *) b)->delta;
+
+  if (d1 < d2)
     return -1;
-  else if (i1->center == i2->center)
-    return 0;
+  return d1 > d2 ? 1 : 0;
+}
+
+/*
+ * Put an item on one side of the split and widen the key of that side.
+ */
+static void
+gist_locus_place(gist_locus_picksplit_item *item, OffsetNumber *list, int *count,
+                 LOCUS **key)
+{
+  if (*key == NULL)
+  {
+    *key = (LOCUS *) palloc(sizeof(LOCUS));
+    memcpy(*key, item->data, sizeof(LOCUS));
+  }
   else
-    return 1;
+    gist_locus_key_union(*key, item->data, *key);
+
+  list[(*count)++] = item->index;
+}
+
+#define PLACE_LEFT(item) \
+  gist_locus_place(item, v->spl_left, &v->spl_nleft, left)
+#define PLACE_RIGHT(item) \
+  gist_locus_place(item, v->spl_right, &v->spl_nright, right)
+
+/*
+ * Consider a split of the positions, with the left group ending at
+ * left_upper and the right group starting at right_lower, into which
+ * between min_left_count and max_left_count entries can go to the left.
+ */
+static void
+gist_locus_consider_split(gist_locus_split_context *context,
+                          int32 right_lower, int min_left_count,
+                          int32 left_upper, int max_left_count)
+{
+  int     left_count,
+          right_count;
+  float4  ratio;
+  int64   overlap;
+
+  /* the most even count that the common entries allow */
+  if (min_left_count >= (context->entries_count + 1) / 2)
+    left_count = min_left_count;
+  else if (max_left_count <= context->entries_count / 2)
+    left_count = max_left_count;
+  else
+    left_count = context->entries_count / 2;
+  right_count = context->entries_count - left_count;
+
+  ratio = (float4) Min(left_count, right_count) / (float4) context->entries_count;
+  if (ratio <= LIMIT_RATIO)
+    return;
+
+  /* negative when there is a gap between the groups */
+  overlap = (int64) left_upper - right_lower;
+
+  if (context->first || overlap < context->overlap ||
+      (overlap == context->overlap && ratio > context->ratio))
+  {
+    context->left_upper = left_upper;
+    context->right_lower = right_lower;
+    context->ratio = ratio;
+    context->overlap = overlap;
+    context->first = false;
+  }
+}
+
+/*
+ * Split n items on positions by the double sorting split of Korotkov and
+ * Bartunov, as the range type opclass does: of the splits where each group
+ * gets enough of the entries, take the one whose groups overlap least.
+ * Bounds are compared as the integers they are.
+ */
+static void
+gist_locus_double_sorting_split(gist_locus_picksplit_item *items, int n,
+                                GIST_SPLITVEC *v, LOCUS **left, LOCUS **right)
+{
+  gist_locus_split_context context;
+  gist_locus_picksplit_item **by_lower;
+  gist_locus_picksplit_item **by_upper;
+  gist_locus_common_entry *common_entries;
+  int     common_entries_count;
+  int     nleft = 0;
+  int     nright = 0;
+  int     i1,
+          i2,
+          i,
+          m;
+  int32   right_lower,
+          left_upper;
+
+  by_lower = palloc(n * sizeof(gist_locus_picksplit_item *));
+  by_upper = palloc(n * sizeof(gist_locus_picksplit_item *));
+  for (i = 0; i < n; i++)
+    by_lower[i] = by_upper[i] = &items[i];
+  qsort(by_lower, n, sizeof(gist_locus_picksplit_item *), gist_locus_lower_cmp);
+  qsort(by_upper, n, sizeof(gist_locus_picksplit_item *), gist_locus_upper_cmp);
+
+  context.entries_count = n;
+  context.first = true;
+
+  /*
+   * Iterate over the lower bound of the right group, finding the smallest
+   * possible upper bound of the left group.
+   */
+  i1 = 0;
+  i2 = 0;
+  right_lower = by_lower[i1]->data->lower;
+  left_upper = by_upper[i2]->data->lower;
+  while (true)
+  {
+    while (i1 < n && by_lower[i1]->data->lower == right_lower)
+    {
+      left_upper = Max(left_upper, by_lower[i1]->data->upper);
+      i1++;
+    }
+    if (i1 >= n)
+      break;
+    right_lower = by_lower[i1]->data->lower;
+
+    /* entries that have to go to the left group */
+    while (i2 < n && by_upper[i2]->data->upper <= left_upper)
+      i2++;
+
+    gist_locus_consider_split(&context, right_lower, i1, left_upper, i2);
+  }
+
+  /*
+   * Iterate over the upper bound of the left group, finding the greatest
+   * possible lower bound of the right group.
+   */
+  i1 = n - 1;
+  i2 = n - 1;
+  right_lower = by_lower[i1]->data->upper;
+  left_upper = by_upper[i2]->data->upper;
+  while (true)
+  {
+    while (i2 >= 0 && by_upper[i2]->data->upper == left_upper)
+    {
+      right_lower = Min(right_lower, by_upper[i2]->data->lower);
+      i2--;
+    }
+    if (i2 < 0)
+      break;
+    left_upper = by_upper[i2]->data->upper;
+
+    /* entries that have to go to the right group */
+    while (i1 >= 0 && by_lower[i1]->data->lower >= right_lower)
+      i1--;
+
+    gist_locus_consider_split(&context, right_lower, i1 + 1, left_upper, i2 + 1);
+  }
+
+  if (context.first)
+  {
+    /* no split is even enough, e.g. with all the entries alike */
+    for (i = 0; i < n; i++)
+    {
+      if (i < n / 2)
+        PLACE_LEFT(by_lower[i]);
+      else
+        PLACE_RIGHT(by_lower[i]);
+    }
+    return;
+  }
+
+  /*
+   * Place the entries that fit in one group only, and collect those that fit
+   * in both.
+   */
+  common_entries = palloc(n * sizeof(gist_locus_common_entry));
+  common_entries_count = 0;
+  for (i = 0; i < n; i++)
+  {
+    LOCUS      *data = items[i].data;
+
+    if (data->lower >= context.right_lower)
+    {
+      if (data->upper <= context.left_upper)
+      {
+        common_entries[common_entries_count].item = &items[i];
+        common_entries[common_entries_count].delta =
+          ((int64) data->lower - context.right_lower) -
+          ((int64) context.left_upper - data->upper);
+        common_entries_count++;
+      }
+      else
+      {
+        PLACE_RIGHT(&items[i]);
+        nright++;
+      }
+    }
+    else
+    {
+      Assert(data->upper <= context.left_upper);
+      PLACE_LEFT(&items[i]);
+      nleft++;
+    }
+  }
+
+  /*
+   * In order of how much more they would widen the right group than the
+   * left, give the common entries to a group that still needs them to reach
+   * LIMIT_RATIO, or else to the group they widen less.
+   */
+  m = (int) ceil(LIMIT_RATIO * n);
+  qsort(common_entries, common_entries_count, sizeof(gist_locus_common_entry),
+        gist_locus_common_entry_cmp);
+  for (i = 0; i < common_entries_count; i++)
+  {
+    gist_locus_picksplit_item *item = common_entries[i].item;
+
+    if (nleft + (common_entries_count - i) <= m)
+    {
+      PLACE_LEFT(item);
+      nleft++;
+    }
+    else if (nright + (common_entries_count - i) <= m)
+    {
+      PLACE_RIGHT(item);
+      nright++;
+    }
+    else if (gist_locus_growth(*left, item->data) < gist_locus_growth(*right, item->data))
+    {
+      PLACE_LEFT(item);
+      nleft++;
+    }
+    else
+    {
+      PLACE_RIGHT(item);
+      nright++;
+    }
+  }
 }
 
 /*
  * The GiST PickSplit method for genomic loci
  *
- * We used to use Guttman's split algorithm here, but since the data is 1-D
- * it's easier and more robust to just sort the genomic loci by center-point and
- * split at the middle.
+ * Entries on different contigs never need to share a page, so the split
+ * goes between contigs where it can: at the contig boundary closest to the
+ * middle, if that leaves either side at least LIMIT_RATIO of the entries.
+ * Otherwise one contig (or one group of range keys whose contigs overlap)
+ * holds too many entries for that.  It is split on positions by the double
+ * sorting split, with the contigs before it going to the left and those
+ * after it to the right.
  */
 Datum
 gist_locus_picksplit(PG_FUNCTION_ARGS)
 {
   GistEntryVector *entryvec = (GistEntryVector *) PG_GETARG_POINTER(0);
   GIST_SPLITVEC *v = (GIST_SPLITVEC *) PG_GETARG_POINTER(1);
-  int     i;
-  LOCUS      *locus,
-         *locus_l,
-         *locus_r;
-  gist_locus_picksplit_item *sort_items;
-  OffsetNumber *left,
-         *right;
+  gist_locus_picksplit_item *items;
+  LOCUS      *locus_l = NULL;
+  LOCUS      *locus_r = NULL;
+  LOCUS     **left = &locus_l;
+  LOCUS     **right = &locus_r;
+  bool       *boundary;
+  uint8      *last;
   OffsetNumber maxoff;
-  OffsetNumber firstright;
+  int     best = -1;
+  int     i;
 
 #ifdef GIST_DEBUG
   fprintf(stderr, "picksplit\n");
@@ -380,66 +1280,66 @@ gist_locus_picksplit(PG_FUNCTION_ARGS)
   /* Valid items in entryvec->vector[] are indexed 1..maxoff */
   maxoff = entryvec->n - 1;
 
-  /*
-   * Prepare the auxiliary array and sort it.
-   */
-  sort_items = (gist_locus_picksplit_item *)
+  items = (gist_locus_picksplit_item *)
     palloc(maxoff * sizeof(gist_locus_picksplit_item));
   for (i = 1; i <= maxoff; i++)
   {
-    locus = DatumGetLocusP(entryvec->vector[i].key);
-    /* center calculation is done this way to avoid possible overflow */
-    sort_items[i - 1].center = locus->lower * 0.5f + locus->upper * 0.5f;
-    sort_items[i - 1].index = i;
-    sort_items[i - 1].data = locus;
+    items[i - 1].index = i;
+    items[i - 1].data = DatumGetLocusP(entryvec->vector[i].key);
+    gist_locus_range_key(items[i - 1].data, &items[i - 1].contigs);
   }
-  qsort(sort_items, maxoff, sizeof(gist_locus_picksplit_item),
-      gist_locus_picksplit_item_cmp);
-
-  /* sort items below "firstright" will go into the left side */
-  firstright = maxoff / 2;
+  qsort(items, maxoff, sizeof(gist_locus_picksplit_item),
+        gist_locus_picksplit_item_cmp);
 
   v->spl_left = (OffsetNumber *) palloc(maxoff * sizeof(OffsetNumber));
   v->spl_right = (OffsetNumber *) palloc(maxoff * sizeof(OffsetNumber));
-  left = v->spl_left;
   v->spl_nleft = 0;
-  right = v->spl_right;
   v->spl_nright = 0;
 
   /*
-   * Emit genomic loci to the left output page, and compute its bounding box.
+   * boundary[i] is set if every contig of the items before i sorts before
+   * every contig of the items from i on.
    */
-  locus_l = (LOCUS *) palloc(sizeof(LOCUS));
-  memcpy(locus_l, sort_items[0].data, sizeof(LOCUS));
-  *left++ = sort_items[0].index;
-  v->spl_nleft++;
-  for (i = 1; i < firstright; i++)
+  boundary = (bool *) palloc0(maxoff * sizeof(bool));
+  last = items[0].contigs.last;
+  for (i = 1; i < maxoff; i++)
   {
-    Datum   sortitem = PointerGetDatum(sort_items[i].data);
-
-    locus_l = DatumGetLocusP(DirectFunctionCall2(locus_union,
-                         PointerGetDatum(locus_l),
-                         sortitem));
-    *left++ = sort_items[i].index;
-    v->spl_nleft++;
+    if (memcmp(last, items[i].contigs.first, LOCUS_RANGE_NATKEY_LEN) < 0)
+    {
+      boundary[i] = true;
+      if (best < 0 || abs(2 * i - maxoff) < abs(2 * best - maxoff))
+        best = i;
+    }
+    if (memcmp(items[i].contigs.last, last, LOCUS_RANGE_NATKEY_LEN) > 0)
+      last = items[i].contigs.last;
   }
 
-  /*
-   * Likewise for the right page.
-   */
-  locus_r = (LOCUS *) palloc(sizeof(LOCUS));
-  memcpy(locus_r, sort_items[firstright].data, sizeof(LOCUS));
-  *right++ = sort_items[firstright].index;
-  v->spl_nright++;
-  for (i = firstright + 1; i < maxoff; i++)
+  if (best > 0 && Min(best, maxoff - best) >= LIMIT_RATIO * maxoff)
   {
-    Datum   sortitem = PointerGetDatum(sort_items[i].data);
-
-    locus_r = DatumGetLocusP(DirectFunctionCall2(locus_union,
-                         PointerGetDatum(locus_r),
-                         sortitem));
-    *right++ = sort_items[i].index;
-    v->spl_nright++;
+    for (i = 0; i < maxoff; i++)
+    {
+      if (i < best)
+        PLACE_LEFT(&items[i]);
+      else
+        PLACE_RIGHT(&items[i]);
+    }
+  }
+  else
+  {
+    int     start = maxoff / 2;
+    int     end = maxoff / 2 + 1;
+
+    /* the group of items around the middle */
+    while (start > 0 && !boundary[start])
+      start--;
+    while (end < maxoff && !boundary[end])
+      end++;
+
+    for (i = 0; i < start; i++)
+      PLACE_LEFT(&items[i]);
+    gist_locus_double_sorting_split(items + start, end - start, v, left, right);
+    for (i = end; i < maxoff; i++)
+      PLACE_RIGHT(&items[i]);
   }
 
   v->spl_ldatum = PointerGetDatum(locus_l);
@@ -454,9 +1354,13 @@ gist_locus_picksplit(PG_FUNCTION_ARGS)
 Datum
 gist_locus_same(PG_FUNCTION_ARGS)
 {
+  LOCUS      *a = PG_GETARG_LOCUS_P(0);
+  LOCUS      *b = PG_GETARG_LOCUS_P(1);
   bool     *result = (bool *) PG_GETARG_POINTER(2);
 
-  if (DirectFunctionCall2(locus_same, PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)))
+  if (LOCUS_IS_RANGE(a) || LOCUS_IS_RANGE(b))
+    *result = memcmp(a, b, sizeof(LOCUS)) == 0;
+  else if (DirectFunctionCall2(locus_same, PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)))
     *result = true;
   else
     *result = false;
@@ -524,6 +1428,10 @@ gist_locus_internal_consistent(Datum key, Datum query, StrategyNumber strategy)
   fprintf(stderr, "internal_consistent, %d\n", strategy);
 #endif
 
+  if (LOCUS_IS_RANGE(DatumGetLocusP(key)))
+    PG_RETURN_BOOL(gist_locus_range_consistent((LOCUS_RANGE_KEY *) DatumGetPointer(key),
+                                               DatumGetLocusP(query), strategy));
+
   switch (strategy)
   {
     case RTLeftStrategyNumber:
@@ -554,25 +1462,552 @@ gist_locus_internal_consistent(Datum key, Datum query, StrategyNumber strategy)
       break;
     case RTContainedByStrategyNumber:
     case RTOldContainedByStrategyNumber:
+      /* a wildcard query contains loci of any contig */
       retval =
-        DatumGetBool(DirectFunctionCall2(locus_overlap, key, query));
+        DatumGetBool(DirectFunctionCall2(locus_overlap, query, key));
       break;
     default:
       retval = false;
   }
 
-  PG_RETURN_BOOL(retval);
+  PG_RETURN_BOOL(retval);
+}
+
+/*
+ * Prefix of the natural-order key of the contig of a locus, as range keys
+ * hold them.  Returns whether it is the whole key.
+ */
+static bool
+gist_locus_range_natkey(LOCUS *locus, uint8 *key)
+{
+  return locus_contig_natkey(locus_contig_name(locus), key, LOCUS_RANGE_NATKEY_LEN) <=
+    LOCUS_RANGE_NATKEY_LEN;
+}
+
+/*
+ * A GiST key as a range key.  A locus covers just its own contig, except
+ * that "<all>" is no contig at all: it gets an empty range, with first above
+ * last, and the wildcard flag.
+ */
+static void
+gist_locus_range_key(LOCUS *key, LOCUS_RANGE_KEY *range)
+{
+  if (LOCUS_IS_RANGE(key))
+  {
+    memcpy(range, key, sizeof(LOCUS_RANGE_KEY));
+    return;
+  }
+
+  memset(range, 0, sizeof(LOCUS_RANGE_KEY));
+  range->lower = key->lower;
+  range->upper = key->upper;
+  range->flags = LOCUS_GIST_RANGE;
+
+  if (LOCUS_IS_WILDCARD(key))
+  {
+    memset(range->first, 0xFF, LOCUS_RANGE_NATKEY_LEN);
+    range->flags |= LOCUS_WILDCARD;
+    return;
+  }
+
+  if (gist_locus_range_natkey(key, range->first))
+    range->flags |= LOCUS_RANGE_FIRST_EXACT | LOCUS_RANGE_LAST_EXACT;
+  memcpy(range->last, range->first, LOCUS_RANGE_NATKEY_LEN);
+}
+
+/*
+ * Union of two GiST keys into result, which may be one of them.  The union
+ * of keys on the same contig is a locus; anything else makes a range key.
+ */
+static void
+gist_locus_key_union(LOCUS *a, LOCUS *b, LOCUS *result)
+{
+  LOCUS_RANGE_KEY ra;
+  LOCUS_RANGE_KEY rb;
+  int       cmp;
+
+  if (!LOCUS_IS_RANGE(a) && !LOCUS_IS_RANGE(b) && locus_contig_cmp(a, b) == 0)
+  {
+    int32     lower = Min(a->lower, b->lower);
+    int32     upper = Max(a->upper, b->upper);
+
+    if (result != a)
+      memcpy(result, a, sizeof(LOCUS));
+    result->lower = lower;
+    result->upper = upper;
+    return;
+  }
+
+  gist_locus_range_key(a, &ra);
+  gist_locus_range_key(b, &rb);
+
+  ra.lower = Min(ra.lower, rb.lower);
+  ra.upper = Max(ra.upper, rb.upper);
+  ra.flags |= rb.flags & LOCUS_WILDCARD;
+
+  /* of two keys with equal prefixes, a whole one is the lesser */
+  cmp = memcmp(rb.first, ra.first, LOCUS_RANGE_NATKEY_LEN);
+  if (cmp < 0)
+  {
+    memcpy(ra.first, rb.first, LOCUS_RANGE_NATKEY_LEN);
+    ra.flags = (ra.flags & ~LOCUS_RANGE_FIRST_EXACT) | (rb.flags & LOCUS_RANGE_FIRST_EXACT);
+  }
+  else if (cmp == 0)
+    ra.flags |= rb.flags & LOCUS_RANGE_FIRST_EXACT;
+
+  cmp = memcmp(rb.last, ra.last, LOCUS_RANGE_NATKEY_LEN);
+  if (cmp > 0)
+  {
+    memcpy(ra.last, rb.last, LOCUS_RANGE_NATKEY_LEN);
+    ra.flags = (ra.flags & ~LOCUS_RANGE_LAST_EXACT) | (rb.flags & LOCUS_RANGE_LAST_EXACT);
+  }
+  else if (cmp == 0)
+    ra.flags &= rb.flags | ~LOCUS_RANGE_LAST_EXACT;
+
+  memcpy(result, &ra, sizeof(LOCUS));
+}
+
+/*
+ * Whether the contigs of key take in those of locus, which may be a key too
+ */
+static bool
+gist_locus_covers_contigs(LOCUS *key, LOCUS *locus)
+{
+  LOCUS_RANGE_KEY *range = (LOCUS_RANGE_KEY *) key;
+  LOCUS_RANGE_KEY other;
+
+  if (!LOCUS_IS_RANGE(key))
+    return !LOCUS_IS_RANGE(locus) && locus_contig_cmp(key, locus) == 0;
+
+  gist_locus_range_key(locus, &other);
+  if ((other.flags & LOCUS_WILDCARD) && !(range->flags & LOCUS_WILDCARD))
+    return false;
+
+  /* only "<all>" loci, first above last */
+  if (memcmp(other.first, other.last, LOCUS_RANGE_NATKEY_LEN) > 0)
+    return true;
+
+  return memcmp(range->first, other.first, LOCUS_RANGE_NATKEY_LEN) <= 0 &&
+    memcmp(range->last, other.last, LOCUS_RANGE_NATKEY_LEN) >= 0;
+}
+
+/*
+ * How much the positions of key would have to widen to take in locus.  No
+ * key, as for an empty group, takes in anything.
+ */
+static int64
+gist_locus_growth(LOCUS *key, LOCUS *locus)
+{
+  if (key == NULL)
+    return 0;
+
+  return ((int64) Max(key->upper, locus->upper) - Min(key->lower, locus->lower)) -
+    ((int64) key->upper - key->lower);
+}
+
+/*
+ * Whether loci below a range key may lie on the contig of query, or are
+ * "<all>" loci, which match it anyway
+ */
+static bool
+gist_locus_range_matches_contig(LOCUS_RANGE_KEY *key, LOCUS *query)
+{
+  uint8     qkey[LOCUS_RANGE_NATKEY_LEN];
+
+  if (key->flags & LOCUS_WILDCARD)
+    return true;
+
+  gist_locus_range_natkey(query, qkey);
+
+  return memcmp(key->first, qkey, LOCUS_RANGE_NATKEY_LEN) <= 0 &&
+    memcmp(key->last, qkey, LOCUS_RANGE_NATKEY_LEN) >= 0;
+}
+
+/*
+ * Consistent method for range keys: whether any locus x below key may
+ * satisfy x op query.  When the prefix of the first (last) contig equals
+ * that of the query, the positions only decide if both are whole keys.
+ */
+static bool
+gist_locus_range_consistent(LOCUS_RANGE_KEY *key, LOCUS *query, StrategyNumber strategy)
+{
+  uint8     qkey[LOCUS_RANGE_NATKEY_LEN];
+  bool      qexact = gist_locus_range_natkey(query, qkey);
+  int       first_cmp = memcmp(key->first, qkey, LOCUS_RANGE_NATKEY_LEN);
+  int       last_cmp = memcmp(key->last, qkey, LOCUS_RANGE_NATKEY_LEN);
+  bool      wildcard = (key->flags & LOCUS_WILDCARD) != 0;
+  bool      on_contig = wildcard || (first_cmp <= 0 && last_cmp >= 0);
+
+  switch (strategy)
+  {
+    case RTLeftStrategyNumber:
+      /* wildcards are never to the left or right of anything */
+      if (LOCUS_IS_WILDCARD(query) || first_cmp > 0)
+        return false;
+      if (first_cmp == 0 && qexact && (key->flags & LOCUS_RANGE_FIRST_EXACT))
+        return key->lower < query->lower;
+      return true;
+
+    case RTOverLeftStrategyNumber:
+      return (wildcard || first_cmp <= 0) && key->lower <= query->upper;
+
+    case RTOverlapStrategyNumber:
+      return on_contig && key->lower <= query->upper && key->upper >= query->lower;
+
+    case RTOverRightStrategyNumber:
+      return (wildcard || last_cmp >= 0) && key->upper >= query->lower;
+
+    case RTRightStrategyNumber:
+      if (LOCUS_IS_WILDCARD(query) || last_cmp < 0)
+        return false;
+      if (last_cmp == 0 && qexact && (key->flags & LOCUS_RANGE_LAST_EXACT))
+        return key->upper > query->upper;
+      return true;
+
+    case RTSameStrategyNumber:
+    case RTContainsStrategyNumber:
+    case RTOldContainsStrategyNumber:
+      return on_contig && key->lower <= query->lower && key->upper >= query->upper;
+
+    case RTContainedByStrategyNumber:
+    case RTOldContainedByStrategyNumber:
+      /* a wildcard query contains loci of any contig */
+      return (on_contig || LOCUS_IS_WILDCARD(query)) &&
+        key->lower <= query->upper && key->upper >= query->lower;
+
+    default:
+      return false;
+  }
+}
+
+/*****************************************************************************
+ * Batch probes: locus && locus[] and locus <@ locus[]
+ *****************************************************************************/
+
+/*
+ * The loci of an array, sorted for probes.  They are grouped by contig in
+ * natural order and sorted by lower boundary within each group, and
+ * maxupper[i] is the greatest upper boundary among the loci of the group up
+ * to i.  The loci of a group that start at or before a position are a prefix
+ * of it, found by binary search, and maxupper says whether any of them
+ * reaches another position: whether some locus overlaps an interval, or
+ * contains one.  The same test prunes GiST subtrees, so one index scan
+ * serves the whole array.
+ */
+typedef struct
+{
+  LOCUS       contig;     /* a locus on the contig */
+  uint8       natkey[LOCUS_RANGE_NATKEY_LEN];  /* as range keys hold it */
+  int         first;
+  int         count;
+} LocusBatchGroup;
+
+struct LocusBatch
+{
+  int         ngroups;
+  int         wildcard;   /* group of "<all>" loci, or -1 */
+  LocusBatchGroup *groups;
+  int32      *lower;
+  int32      *maxupper;
+};
+
+/* A batch built for one value of the array argument */
+typedef struct
+{
+  ArrayType  *query;        /* a copy of the array */
+  LocusBatch  batch;
+} LocusBatchCache;
+
+static int
+locus_batch_item_cmp(const void *a, const void *b)
+{
+  return locus_cmp_internal((LOCUS *) a, (LOCUS *) b);
+}
+
+static void
+locus_batch_build(ArrayType *array, LocusBatch *batch)
+{
+  ArrayIterator iterator = array_create_iterator(array, 0, NULL);
+  int         maxitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+  LOCUS      *items = (LOCUS *) palloc((maxitems + 1) * sizeof(LOCUS));
+  int         nitems = 0;
+  LocusBatchGroup *group = NULL;
+  Datum       value;
+  bool        isnull;
+  int         i;
+
+  while (array_iterate(iterator, &value, &isnull))
+  {
+    if (!isnull)
+      items[nitems++] = *DatumGetLocusP(value);
+  }
+  array_free_iterator(iterator);
+
+  qsort(items, nitems, sizeof(LOCUS), locus_batch_item_cmp);
+
+  batch->ngroups = 0;
+  batch->wildcard = -1;
+  batch->groups = (LocusBatchGroup *) palloc((nitems + 1) * sizeof(LocusBatchGroup));
+  batch->lower = (int32 *) palloc((nitems + 1) * sizeof(int32));
+  batch->maxupper = (int32 *) palloc((nitems + 1) * sizeof(int32));
+
+  for (i = 0; i < nitems; i++)
+  {
+    if (group == NULL || locus_contig_cmp(&group->contig, &items[i]) != 0)
+    {
+      group = &batch->groups[batch->ngroups];
+      group->contig = items[i];
+      gist_locus_range_natkey(&items[i], group->natkey);
+      group->first = i;
+      group->count = 0;
+      if (LOCUS_IS_WILDCARD(&items[i]))
+        batch->wildcard = batch->ngroups;
+      batch->ngroups++;
+    }
+    batch->lower[i] = items[i].lower;
+    batch->maxupper[i] = group->count == 0 ? items[i].upper :
+      Max(batch->maxupper[i - 1], items[i].upper);
+    group->count++;
+  }
+
+  pfree(items);
+}
+
+/*
+ * The batch for an array argument, built once per value and kept in
+ * fn_extra with a copy of the array.  The argument may change under the
+ * same FmgrInfo: gistrescan keeps fn_extra, and the inner side of a nested
+ * loop is rescanned with each outer array, which may even be at the address
+ * of the last one.  So, as gtrgm_consistent does, the batch is reused only
+ * when the array is the same, byte for byte.
+ */
+static LocusBatch *
+locus_batch_get(FmgrInfo *flinfo, Datum query)
+{
+  LocusBatchCache *cache = (LocusBatchCache *) flinfo->fn_extra;
+  ArrayType  *array = DatumGetArrayTypeP(query);
+
+  if (cache == NULL ||
+      VARSIZE(cache->query) != VARSIZE(array) ||
+      memcmp(cache->query, array, VARSIZE(array)) != 0)
+  {
+    MemoryContext oldcontext = MemoryContextSwitchTo(flinfo->fn_mcxt);
+
+    if (cache == NULL)
+      flinfo->fn_extra = cache = (LocusBatchCache *) palloc(sizeof(LocusBatchCache));
+    else
+    {
+      pfree(cache->query);
+      pfree(cache->batch.groups);
+      pfree(cache->batch.lower);
+      pfree(cache->batch.maxupper);
+    }
+    cache->query = (ArrayType *) palloc(VARSIZE(array));
+    memcpy(cache->query, array, VARSIZE(array));
+    locus_batch_build(array, &cache->batch);
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+
+  if ((Pointer) array != DatumGetPointer(query))
+    pfree(array);
+
+  return &cache->batch;
+}
+
+/* The last locus of a group that starts at or before pos, or -1 */
+static int
+locus_batch_last_start(LocusBatch *batch, LocusBatchGroup *group, int32 pos)
+{
+  int         lo = group->first,
+              hi = group->first + group->count;
+
+  while (lo < hi)
+  {
+    int         mid = lo + (hi - lo) / 2;
+
+    if (batch->lower[mid] <= pos)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo - 1 >= group->first ? lo - 1 : -1;
+}
+
+/* Whether a locus of the group overlaps [lower, upper] */
+static bool
+locus_batch_group_overlaps(LocusBatch *batch, LocusBatchGroup *group, int32 lower, int32 upper)
+{
+  int         i = locus_batch_last_start(batch, group, upper);
+
+  return i >= 0 && batch->maxupper[i] >= lower;
+}
+
+/* Whether a locus of the group contains [lower, upper] */
+static bool
+locus_batch_group_contains(LocusBatch *batch, LocusBatchGroup *group, int32 lower, int32 upper)
+{
+  int         i = locus_batch_last_start(batch, group, lower);
+
+  return i >= 0 && batch->maxupper[i] >= upper;
+}
+
+static bool
+locus_batch_any_overlaps(LocusBatch *batch, int32 lower, int32 upper)
+{
+  int         g;
+
+  for (g = 0; g < batch->ngroups; g++)
+  {
+    if (locus_batch_group_overlaps(batch, &batch->groups[g], lower, upper))
+      return true;
+  }
+  return false;
+}
+
+/* The group of the contig of a locus, or NULL */
+static LocusBatchGroup *
+locus_batch_find(LocusBatch *batch, LOCUS *locus)
+{
+  int         lo = 0,
+              hi = batch->ngroups;
+
+  while (lo < hi)
+  {
+    int         mid = lo + (hi - lo) / 2;
+    int         cmp = locus_contig_cmp(&batch->groups[mid].contig, locus);
+
+    if (cmp == 0)
+      return &batch->groups[mid];
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return NULL;
+}
+
+/* locus && ANY (array), as locus_overlap() decides it for each element */
+static bool
+locus_batch_overlaps(LocusBatch *batch, LOCUS *locus)
+{
+  LocusBatchGroup *group;
+
+  if (LOCUS_IS_WILDCARD(locus))
+    return locus_batch_any_overlaps(batch, locus->lower, locus->upper);
+
+  group = locus_batch_find(batch, locus);
+  return group != NULL && locus_batch_group_overlaps(batch, group, locus->lower, locus->upper);
+}
+
+/* locus <@ ANY (array): "<all>" elements contain loci of any contig */
+static bool
+locus_batch_contained(LocusBatch *batch, LOCUS *locus)
+{
+  LocusBatchGroup *group = locus_batch_find(batch, locus);
+
+  if (group != NULL && locus_batch_group_contains(batch, group, locus->lower, locus->upper))
+    return true;
+
+  return !LOCUS_IS_WILDCARD(locus) && batch->wildcard >= 0 &&
+    locus_batch_group_contains(batch, &batch->groups[batch->wildcard],
+                               locus->lower, locus->upper);
+}
+
+/*
+ * Consistent method of the batch strategies for internal keys: whether a
+ * locus below key may overlap, or lie in, an element.  Either way such an
+ * element overlaps the key on one of its contigs, or is an "<all>" element
+ * that may hold the loci of any contig.
+ */
+static bool
+gist_locus_batch_consistent(LOCUS *key, LocusBatch *batch, StrategyNumber strategy)
+{
+  LOCUS_RANGE_KEY *range = (LOCUS_RANGE_KEY *) key;
+  int         lo,
+              hi;
+
+  if (strategy == LOCUS_BATCH_CONTAINED_STRATEGY && batch->wildcard >= 0 &&
+      locus_batch_group_overlaps(batch, &batch->groups[batch->wildcard],
+                                 key->lower, key->upper))
+    return true;
+
+  /* "<all>" loci overlap elements on any contig */
+  if ((key->flags & LOCUS_WILDCARD) != 0)
+    return locus_batch_any_overlaps(batch, key->lower, key->upper);
+
+  if (!LOCUS_IS_RANGE(key))
+  {
+    LocusBatchGroup *group = locus_batch_find(batch, key);
+
+    return group != NULL && locus_batch_group_overlaps(batch, group, key->lower, key->upper);
+  }
+
+  /* the groups whose contigs the range key may hold */
+  lo = 0;
+  hi = batch->ngroups;
+  while (lo < hi)
+  {
+    int         mid = lo + (hi - lo) / 2;
+
+    if (memcmp(batch->groups[mid].natkey, range->first, LOCUS_RANGE_NATKEY_LEN) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (; lo < batch->ngroups &&
+       memcmp(batch->groups[lo].natkey, range->last, LOCUS_RANGE_NATKEY_LEN) <= 0; lo++)
+  {
+    if (locus_batch_group_overlaps(batch, &batch->groups[lo], key->lower, key->upper))
+      return true;
+  }
+  return false;
 }
 
-static Datum
-gist_locus_binary_union(Datum r1, Datum r2, int *sizep)
+/*
+ * locus && locus[] and locus <@ locus[]: the same as && ANY and <@ ANY, but
+ * GiST-indexable.  A constant array is sorted once per query.
+ */
+static bool
+locus_array_any(LOCUS *locus, ArrayType *array, PGFunction op)
 {
-  Datum   retval;
+  ArrayIterator iterator = array_create_iterator(array, 0, NULL);
+  Datum       value;
+  bool        isnull;
+  bool        result = false;
 
-  retval = DirectFunctionCall2(locus_union, r1, r2);
-  *sizep = sizeof(LOCUS);
+  while (!result && array_iterate(iterator, &value, &isnull))
+  {
+    if (!isnull)
+      result = DatumGetBool(DirectFunctionCall2(op, PointerGetDatum(locus), value));
+  }
+  array_free_iterator(iterator);
+
+  return result;
+}
+
+Datum
+locus_overlap_array(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+
+  if (get_fn_expr_arg_stable(fcinfo->flinfo, 1))
+    PG_RETURN_BOOL(locus_batch_overlaps(locus_batch_get(fcinfo->flinfo, PG_GETARG_DATUM(1)),
+                                        locus));
+
+  PG_RETURN_BOOL(locus_array_any(locus, PG_GETARG_ARRAYTYPE_P(1), locus_overlap));
+}
 
-  return (retval);
+Datum
+locus_contained_array(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+
+  if (get_fn_expr_arg_stable(fcinfo->flinfo, 1))
+    PG_RETURN_BOOL(locus_batch_contained(locus_batch_get(fcinfo->flinfo, PG_GETARG_DATUM(1)),
+                                         locus));
+
+  PG_RETURN_BOOL(locus_array_any(locus, PG_GETARG_ARRAYTYPE_P(1), locus_contained));
 }
 
 
@@ -582,7 +2017,7 @@ locus_contains(PG_FUNCTION_ARGS)
   LOCUS      *a = PG_GETARG_LOCUS_P(0);
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
   PG_RETURN_BOOL(
-    (strcmp(a->contig, "<all>") == 0 || strnatcmp(a->contig, b->contig) == 0) &&
+    (LOCUS_IS_WILDCARD(a) || locus_contig_cmp(a, b) == 0) &&
     (a->lower <= b->lower) && (a->upper >= b->upper)
   );
 }
@@ -619,7 +2054,7 @@ locus_overlap(PG_FUNCTION_ARGS)
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
 
   PG_RETURN_BOOL(
-    (strcmp(a->contig, "<all>") == 0 || strcmp(a->contig, "<all>") == 0 || strnatcmp(a->contig, b->contig) == 0)
+    (LOCUS_IS_WILDCARD(a) || locus_contig_cmp(a, b) == 0)
     &&
     (
       ((a->upper >= b->upper) && (a->lower <= b->upper)) ||
@@ -637,7 +2072,7 @@ locus_over_left(PG_FUNCTION_ARGS)
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
 
   PG_RETURN_BOOL(
-    (strcmp(a->contig, "<all>") == 0 || strnatcmp(a->contig, b->contig) <= 0)
+    (LOCUS_IS_WILDCARD(a) || locus_contig_cmp(a, b) <= 0)
     &&
     a->upper <= b->upper
   );
@@ -651,9 +2086,12 @@ locus_left(PG_FUNCTION_ARGS)
   LOCUS      *a = PG_GETARG_LOCUS_P(0);
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
 
-  if (strcmp(a->contig, "<all>") == 0 || strcmp(b->contig, "<all>") == 0) PG_RETURN_BOOL(false);
-  if (strnatcmp(a->contig, b->contig) > 0) PG_RETURN_BOOL(false);
-  if (strnatcmp(a->contig, b->contig) < 0) PG_RETURN_BOOL(true);
+  int     cmp;
+
+  if (LOCUS_IS_WILDCARD(a) || LOCUS_IS_WILDCARD(b)) PG_RETURN_BOOL(false);
+  cmp = locus_contig_cmp(a, b);
+  if (cmp > 0) PG_RETURN_BOOL(false);
+  if (cmp < 0) PG_RETURN_BOOL(true);
 
   PG_RETURN_BOOL(a->upper < b->lower);
 }
@@ -666,9 +2104,12 @@ locus_right(PG_FUNCTION_ARGS)
   LOCUS      *a = PG_GETARG_LOCUS_P(0);
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
 
-  if (strcmp(a->contig, "<all>") == 0 || strcmp(b->contig, "<all>") == 0) PG_RETURN_BOOL(false);
-  if (strnatcmp(a->contig, b->contig) < 0) PG_RETURN_BOOL(false);
-  if (strnatcmp(a->contig, b->contig) > 0) PG_RETURN_BOOL(true);
+  int     cmp;
+
+  if (LOCUS_IS_WILDCARD(a) || LOCUS_IS_WILDCARD(b)) PG_RETURN_BOOL(false);
+  cmp = locus_contig_cmp(a, b);
+  if (cmp < 0) PG_RETURN_BOOL(false);
+  if (cmp > 0) PG_RETURN_BOOL(true);
   PG_RETURN_BOOL(a->lower > b->upper);
 }
 
@@ -681,12 +2122,47 @@ locus_over_right(PG_FUNCTION_ARGS)
   LOCUS      *b = PG_GETARG_LOCUS_P(1);
 
   PG_RETURN_BOOL(
-    (strcmp(a->contig, "<all>") == 0 || strnatcmp(a->contig, b->contig) >= 0)
+    (LOCUS_IS_WILDCARD(a) || locus_contig_cmp(a, b) >= 0)
     &&
     a->lower >= b->lower
   );
 }
 
+/*  locus_distance -- number of bases between (a) and (b)
+ *
+ *  Zero if they overlap; infinity if they lie on different contigs.  A
+ *  wildcard contig on either side matches any contig.
+ */
+static float8
+locus_distance_internal(LOCUS *a, LOCUS *b)
+{
+  if (!LOCUS_IS_WILDCARD(a) && !LOCUS_IS_WILDCARD(b) && locus_contig_cmp(a, b) != 0)
+    return get_float8_infinity();
+
+  return locus_position_distance(a, b);
+}
+
+/* the same, whatever the contigs */
+static float8
+locus_position_distance(LOCUS *a, LOCUS *b)
+{
+  if (a->upper < b->lower)
+    return (float8) ((int64) b->lower - a->upper);
+  if (b->upper < a->lower)
+    return (float8) ((int64) a->lower - b->upper);
+
+  return 0.0;
+}
+
+Datum
+locus_distance(PG_FUNCTION_ARGS)
+{
+  LOCUS      *a = PG_GETARG_LOCUS_P(0);
+  LOCUS      *b = PG_GETARG_LOCUS_P(1);
+
+  PG_RETURN_FLOAT8(locus_distance_internal(a, b));
+}
+
 Datum
 locus_union(PG_FUNCTION_ARGS)
 {
@@ -696,13 +2172,11 @@ locus_union(PG_FUNCTION_ARGS)
 
   n = (LOCUS *) palloc(sizeof(*n));
 
-  if (strcmp(a->contig, b->contig) == 0) {
-    strcpy(n->contig, a->contig);
-    n->chr = a->chr;
+  if (locus_contig_cmp(a, b) == 0) {
+    memcpy(n, a, sizeof(*n));
   }
   else {
-    sprintf(n->contig, "<all>");
-    n->chr = false;
+    locus_set_wildcard(n);
   }
 
   /* take max of upper endpoints */
@@ -733,13 +2207,11 @@ locus_inter(PG_FUNCTION_ARGS)
 
   n = (LOCUS *) palloc(sizeof(*n));
 
-  if (strnatcmp(a->contig, b->contig) == 0) {
-    strcpy(n->contig, a->contig);
-    n->chr = a->chr;
+  if (locus_contig_cmp(a, b) == 0) {
+    memcpy(n, a, sizeof(*n));
   }
   else {
-    sprintf(n->contig, "<all>");
-    n->chr = false;
+    locus_set_wildcard(n);
   }
 
   /* take min of upper endpoints */
@@ -765,17 +2237,6 @@ locus_inter(PG_FUNCTION_ARGS)
   PG_RETURN_POINTER(n);
 }
 
-static void
-rt_locus_size(LOCUS *a, float *size)
-{
-  if (a == (LOCUS *) NULL)
-    *size = 0.0;
-  else
-    *size = (float) a->upper - a->lower;
-
-  return;
-}
-
 Datum
 length(PG_FUNCTION_ARGS)
 {
@@ -788,41 +2249,47 @@ length(PG_FUNCTION_ARGS)
 /*****************************************************************************
  *           Miscellaneous operators
  *****************************************************************************/
-Datum
-locus_cmp(PG_FUNCTION_ARGS)
+int32
+locus_cmp_internal(LOCUS *a, LOCUS *b)
 {
-  LOCUS      *a = PG_GETARG_LOCUS_P(0);
-  LOCUS      *b = PG_GETARG_LOCUS_P(1);
-
   /*
    * First compare on contig
    */
-  int32 contig_comparison = strnatcmp(a->contig, b->contig);
+  int32 contig_comparison = locus_contig_cmp(a, b);
   if (contig_comparison != 0) {
-    PG_RETURN_INT32(contig_comparison);
+    return contig_comparison;
   }
 
   /*
    * First compare on lower boundary position
    */
   if (a->lower < b->lower)
-    PG_RETURN_INT32(-1);
+    return -1;
   if (a->lower > b->lower)
-    PG_RETURN_INT32(1);
+    return 1;
 
 
   /*
    * a->lower == b->lower, so compare the upper boundaries
    */
   if (a->upper < b->upper)
-    PG_RETURN_INT32(-1);
+    return -1;
   if (a->upper > b->upper)
-    PG_RETURN_INT32(1);
+    return 1;
 
   /*
    * a->upper == b->upper
    */
-  PG_RETURN_INT32(0);
+  return 0;
+}
+
+Datum
+locus_cmp(PG_FUNCTION_ARGS)
+{
+  LOCUS      *a = PG_GETARG_LOCUS_P(0);
+  LOCUS      *b = PG_GETARG_LOCUS_P(1);
+
+  PG_RETURN_INT32(locus_cmp_internal(a, b));
 }
 
 Datum
@@ -872,6 +2339,227 @@ locus_different(PG_FUNCTION_ARGS)
 }
 
 
+/*****************************************************************************
+ *           Sort support
+ *****************************************************************************/
+
+/*
+ * Abbreviated keys
+ *
+ * On platforms with 8-byte Datums, the abbreviated key holds the first four
+ * bytes of the contig's natural-order key in the upper half and the lower
+ * boundary in the lower half.  The lower boundary can only be used when the
+ * whole contig key fits into four bytes: otherwise two different contigs
+ * could share the same prefix, so the position part is left at zero and ties
+ * go to the authoritative comparator.  Common contig names (1-22, X, Y, MT,
+ * with or without 'chr') all fit.
+ */
+typedef struct
+{
+  int64   input_count;  /* number of non-null values seen */
+  bool    estimating;   /* true if estimating cardinality */
+
+  hyperLogLogState abbr_card; /* cardinality estimator */
+} locus_sortsupport_state;
+
+static int
+locus_fastcmp(Datum x, Datum y, SortSupport ssup)
+{
+  return locus_cmp_internal(DatumGetLocusP(x), DatumGetLocusP(y));
+}
+
+static Datum
+locus_abbrev_convert(Datum original, SortSupport ssup)
+{
+  locus_sortsupport_state *lss = ssup->ssup_extra;
+  LOCUS      *locus = DatumGetLocusP(original);
+  uint8      *key = locus->natkey;
+  uint64      res;
+
+  /* the whole contig key is shorter than four bytes */
+  if ((locus->flags & LOCUS_NATKEY_EXACT) && key[3] == NATKEY_END)
+    res = (uint32) locus->lower ^ 0x80000000;
+  else
+    res = 0;
+
+  res |= (uint64) ((uint32) key[0] << 24 | (uint32) key[1] << 16 |
+                   (uint32) key[2] << 8 | (uint32) key[3]) << 32;
+
+  lss->input_count += 1;
+
+  if (lss->estimating)
+  {
+    uint32    tmp;
+
+    tmp = (uint32) res ^ (uint32) (res >> 32);
+    addHyperLogLog(&lss->abbr_card, DatumGetUInt32(hash_uint32(tmp)));
+  }
+
+  return UInt64GetDatum(res);
+}
+
+/*
+ * Callback for estimating effectiveness of abbreviated key optimization,
+ * modeled after the one for uuid.
+ */
+static bool
+locus_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+  locus_sortsupport_state *lss = ssup->ssup_extra;
+  double    abbr_card;
+
+  if (memtupcount < 10000 || lss->input_count < 10000 || !lss->estimating)
+    return false;
+
+  abbr_card = estimateHyperLogLog(&lss->abbr_card);
+
+  /*
+   * If we have >100k distinct values, then even if we were sorting many
+   * billion rows we'd likely still break even, and the penalty of undoing
+   * that many rows of abbrevs would probably not be worth it.  Stop even
+   * counting at that point.
+   */
+  if (abbr_card > 100000.0)
+  {
+    lss->estimating = false;
+    return false;
+  }
+
+  /*
+   * Target minimum cardinality is 1 per ~2k of non-null inputs.  0.5 row
+   * fudge factor allows us to abort earlier on genuinely pathological data
+   * where we've had exactly one abbreviated value in the first 2k
+   * (non-null) rows.
+   */
+  if (abbr_card < lss->input_count / 2000.0 + 0.5)
+    return true;
+
+  return false;
+}
+
+/*
+** SortSupport function
+**
+** Serves both locus_ops and gist_locus_ops.  For GiST it enables sorted
+** index builds: leaf tuples are written in contig, then position order, so
+** neighboring pages cover adjacent stretches of one contig.
+*/
+Datum
+locus_sortsupport(PG_FUNCTION_ARGS)
+{
+  SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+  ssup->comparator = locus_fastcmp;
+  ssup->ssup_extra = NULL;
+
+#if SIZEOF_DATUM == 8
+  if (ssup->abbreviate)
+  {
+    locus_sortsupport_state *lss;
+    MemoryContext oldcontext;
+
+    oldcontext = MemoryContextSwitchTo(ssup->ssup_cxt);
+
+    lss = palloc(sizeof(locus_sortsupport_state));
+    lss->input_count = 0;
+    lss->estimating = true;
+    initHyperLogLog(&lss->abbr_card, 10);
+
+    ssup->ssup_extra = lss;
+    ssup->comparator = ssup_datum_unsigned_cmp;
+    ssup->abbrev_converter = locus_abbrev_convert;
+    ssup->abbrev_abort = locus_abbrev_abort;
+    ssup->abbrev_full_comparator = locus_fastcmp;
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+#endif
+
+  PG_RETURN_VOID();
+}
+
+/*
+** B-tree equalimage function
+**
+** Deduplication requires that any two values that compare equal are also
+** bitwise identical.  That does not hold for locus: '1:100' = 'chr1:100',
+** but the two values differ in the chr flag, and a deduplicated posting list
+** would hand the spelling of one of them back to an index-only scan of the
+** other.  So deduplication stays off, but explicitly.
+*/
+Datum
+locus_equalimage(PG_FUNCTION_ARGS)
+{
+  /* Oid    opcintype = PG_GETARG_OID(0); */
+
+  PG_RETURN_BOOL(false);
+}
+
+
+/*****************************************************************************
+ *           Hash support
+ *****************************************************************************/
+
+/*
+ * Hash functions have to agree with locus_cmp: equal loci must hash alike
+ * even when they are spelled differently, as in '1:100' and 'chr1:100' or
+ * contig names that strnatcmp() considers equal.  So the contig part of the
+ * hash is taken from its natural-order key, which is equal for exactly those
+ * contigs, and the chr flag is left out.  The stored prefix is the whole key
+ * when it is exact; otherwise the key is computed in full.
+ */
+static const uint8 *
+locus_hash_natkey(LOCUS *locus, uint8 *buf, int *len)
+{
+  if (locus->flags & LOCUS_NATKEY_EXACT)
+  {
+    *len = LOCUS_NATKEY_LEN;
+    return locus->natkey;
+  }
+
+  *len = locus_contig_natkey(locus->contig, buf, NATKEY_MAXLEN);
+  Assert(*len <= NATKEY_MAXLEN);
+  return buf;
+}
+
+Datum
+locus_hash(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  uint8       buf[NATKEY_MAXLEN];
+  const uint8 *key;
+  int         len;
+  uint32      hash;
+
+  key = locus_hash_natkey(locus, buf, &len);
+  hash = DatumGetUInt32(hash_any(key, len));
+  hash = hash_combine(hash, DatumGetUInt32(hash_uint32((uint32) locus->lower)));
+  hash = hash_combine(hash, DatumGetUInt32(hash_uint32((uint32) locus->upper)));
+
+  PG_RETURN_UINT32(hash);
+}
+
+Datum
+locus_hash_extended(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  uint64      seed = PG_GETARG_INT64(1);
+  uint8       buf[NATKEY_MAXLEN];
+  const uint8 *key;
+  int         len;
+  uint64      hash;
+
+  key = locus_hash_natkey(locus, buf, &len);
+  hash = DatumGetUInt64(hash_any_extended(key, len, seed));
+  hash = hash_combine64(hash,
+    DatumGetUInt64(hash_uint32_extended((uint32) locus->lower, seed)));
+  hash = hash_combine64(hash,
+    DatumGetUInt64(hash_uint32_extended((uint32) locus->upper, seed)));
+
+  PG_RETURN_UINT64(hash);
+}
+
+
 // This function was suggested by ChatGPT as a benchmarking tool to evaluate
 // GIST performance with JOINs over large genomic datasets. The region tiling approach
 // is used by bedtools and other tools, so it can be a relatable benchmark.
@@ -902,3 +2590,223 @@ locus_tile_id(PG_FUNCTION_ARGS)
     PG_RETURN_TEXT_P(result);
 }
 
+
+/*****************************************************************************
+ * Tile and bin keys
+ *
+ * Binned overlap joins equate integer keys instead of comparing loci.  A key
+ * holds a code of the contig in its upper 32 bits and the number of a tile or
+ * a bin on that contig in the lower 32, so the keys of one contig order as
+ * their numbers do.  The code is a hash of the natural-order contig key, so
+ * that spellings that compare equal, such as '1' and 'chr1', get the same
+ * keys.  Contigs whose codes collide only bring the join pairs that its
+ * overlap test drops.
+ *****************************************************************************/
+
+static int64
+locus_contig_code(LOCUS *locus)
+{
+  uint8       buf[NATKEY_MAXLEN];
+  const uint8 *key;
+  int         len;
+
+  if (LOCUS_IS_WILDCARD(locus))
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("a locus on all contigs has no tiles or bins")));
+
+  key = locus_hash_natkey(locus, buf, &len);
+  return (int64) ((uint64) DatumGetUInt32(hash_any(key, len)) << 32);
+}
+
+static int64
+locus_tile_width(int64 width)
+{
+  if (width <= 0)
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("tile width must be positive")));
+  return width;
+}
+
+/*
+ * The key of the tile that holds the start of a locus
+ */
+Datum
+locus_tile_key(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  int64       width = locus_tile_width(PG_GETARG_INT64(1));
+
+  PG_RETURN_INT64(locus_contig_code(locus) | (uint32) (locus->lower / width));
+}
+
+/*
+ * The keys of all the tiles that a locus touches.  Two loci overlap only if
+ * they share a tile, and the greater of their locus_tile_key() values is the
+ * first tile they share, which is how a join counts each pair once.
+ */
+Datum
+locus_tiles(PG_FUNCTION_ARGS)
+{
+  FuncCallContext *funcctx;
+  int64      *first;
+
+  if (SRF_IS_FIRSTCALL())
+  {
+    LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+    int64       width = locus_tile_width(PG_GETARG_INT64(1));
+    MemoryContext oldcontext;
+
+    funcctx = SRF_FIRSTCALL_INIT();
+    oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    first = (int64 *) palloc(sizeof(int64));
+    *first = locus_contig_code(locus) | (uint32) (locus->lower / width);
+    funcctx->user_fctx = first;
+    funcctx->max_calls = locus->upper / width - locus->lower / width + 1;
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+
+  funcctx = SRF_PERCALL_SETUP();
+  first = (int64 *) funcctx->user_fctx;
+
+  if (funcctx->call_cntr < funcctx->max_calls)
+    SRF_RETURN_NEXT(funcctx, Int64GetDatum(*first + (int64) funcctx->call_cntr));
+
+  SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * UCSC genome browser bins (Kent et al., 2002).  A locus goes to the smallest
+ * bin of 128 kb, 1 Mb, 8 Mb, 64 Mb or 512 Mb that holds it whole.  Loci that
+ * reach past 512 Mb go to the six levels of the extended scheme, up to 16 Gb,
+ * numbered from 4681.  Positions are taken as 1-based, as in browser
+ * positions, so that the numbers agree with the bin columns of UCSC tables.
+ */
+#define LOCUS_BIN_FIRST_SHIFT  17
+#define LOCUS_BIN_NEXT_SHIFT   3
+#define LOCUS_BIN_MAXEND_512M  (INT64CONST(512) * 1024 * 1024)
+#define LOCUS_BIN_OLD_TO_EXTENDED  4681
+
+static const int32 locus_bin_offsets[] = {
+  512 + 64 + 8 + 1, 64 + 8 + 1, 8 + 1, 1, 0
+};
+
+static const int32 locus_bin_offsets_extended[] = {
+  4096 + 512 + 64 + 8 + 1, 512 + 64 + 8 + 1, 64 + 8 + 1, 8 + 1, 1, 0
+};
+
+/* The 0-based first and last positions of a locus */
+static void
+locus_bin_bounds(LOCUS *locus, int64 *start, int64 *last)
+{
+  *start = Max((int64) locus->lower - 1, 0);
+  *last = Max((int64) locus->upper - 1, *start);
+}
+
+Datum
+locus_bin(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  int64       code = locus_contig_code(locus);
+  const int32 *offsets = locus_bin_offsets;
+  int         levels = lengthof(locus_bin_offsets);
+  int32       base = 0;
+  int64       start,
+              last;
+  int         i;
+
+  locus_bin_bounds(locus, &start, &last);
+  if (last >= LOCUS_BIN_MAXEND_512M)
+  {
+    offsets = locus_bin_offsets_extended;
+    levels = lengthof(locus_bin_offsets_extended);
+    base = LOCUS_BIN_OLD_TO_EXTENDED;
+  }
+
+  start >>= LOCUS_BIN_FIRST_SHIFT;
+  last >>= LOCUS_BIN_FIRST_SHIFT;
+  for (i = 0; i < levels - 1 && start != last; i++)
+  {
+    start >>= LOCUS_BIN_NEXT_SHIFT;
+    last >>= LOCUS_BIN_NEXT_SHIFT;
+  }
+
+  PG_RETURN_INT64(code | (uint32) (base + offsets[i] + start));
+}
+
+/*
+ * Append the keys of the bins of one scheme that hold positions start to
+ * last on some level.
+ */
+static void
+locus_bins_add(int64 code, int32 base, const int32 *offsets, int levels,
+               int64 start, int64 last, int64 *keys, int *nkeys)
+{
+  int     i;
+  int64   bin;
+
+  start >>= LOCUS_BIN_FIRST_SHIFT;
+  last >>= LOCUS_BIN_FIRST_SHIFT;
+  for (i = 0; i < levels; i++)
+  {
+    for (bin = start; bin <= last; bin++)
+      keys[(*nkeys)++] = code | (uint32) (base + offsets[i] + bin);
+    start >>= LOCUS_BIN_NEXT_SHIFT;
+    last >>= LOCUS_BIN_NEXT_SHIFT;
+  }
+}
+
+/*
+ * The keys of all the bins that can hold a locus overlapping this one.  Each
+ * overlapping locus has its locus_bin() among them exactly once.
+ */
+Datum
+locus_bins(PG_FUNCTION_ARGS)
+{
+  FuncCallContext *funcctx;
+  int64      *keys;
+
+  if (SRF_IS_FIRSTCALL())
+  {
+    LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+    int64       code = locus_contig_code(locus);
+    MemoryContext oldcontext;
+    int64       start,
+                last;
+    int         nkeys = 0;
+
+    funcctx = SRF_FIRSTCALL_INIT();
+    oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    /* at most one more bin per level than the finest level has */
+    locus_bin_bounds(locus, &start, &last);
+    keys = (int64 *) palloc(((last >> LOCUS_BIN_FIRST_SHIFT) -
+                             (start >> LOCUS_BIN_FIRST_SHIFT) + 2) *
+                            (lengthof(locus_bin_offsets) +
+                             lengthof(locus_bin_offsets_extended)) *
+                            sizeof(int64));
+
+    /* loci in the standard scheme end before 512 Mb */
+    if (start < LOCUS_BIN_MAXEND_512M)
+      locus_bins_add(code, 0, locus_bin_offsets, lengthof(locus_bin_offsets),
+                     start, Min(last, LOCUS_BIN_MAXEND_512M - 1), keys, &nkeys);
+    locus_bins_add(code, LOCUS_BIN_OLD_TO_EXTENDED, locus_bin_offsets_extended,
+                   lengthof(locus_bin_offsets_extended), start, last, keys, &nkeys);
+
+    funcctx->user_fctx = keys;
+    funcctx->max_calls = nkeys;
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+
+  funcctx = SRF_PERCALL_SETUP();
+  keys = (int64 *) funcctx->user_fctx;
+
+  if (funcctx->call_cntr < funcctx->max_calls)
+    SRF_RETURN_NEXT(funcctx, Int64GetDatum(keys[funcctx->call_cntr]));
+
+  SRF_RETURN_DONE(funcctx);
+}
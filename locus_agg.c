@@ -0,0 +1,668 @@
+/*
+ * contrib/locus/locus_agg.c
+ *
+ * Aggregates over genomic loci
+ *
+ * locus_merge(locus [, gap]) coalesces overlapping loci, as bedtools merge
+ * does: loci on the same contig whose distance is at most gap (zero when
+ * they overlap) are replaced by their locus_union().  The result is the
+ * sorted array of the merged loci.  "<all>" loci are merged among
+ * themselves, like the loci of one more contig.
+ *
+ * The transition state is a flat array of LOCUS values.  When it fills up it
+ * is sorted and coalesced in place, and it only grows if that leaves it more
+ * than half full, so on data that merges well it stays about the size of the
+ * result.  The state is serialized as the raw array, and two states combine
+ * by appending one to the other and coalescing again.
+ *
+ * locus_coverage(locus [, bin_width]) computes the depth of coverage: the
+ * state is a list of events, +1 where a locus starts and -1 past its end,
+ * coalesced the same way by summing the events at each position of a
+ * contig.  It grows with the number of distinct boundaries, not of loci, and
+ * with a bin width the boundaries are rounded out to multiples of it, which
+ * bounds the state by the number of bins.  The final function walks the
+ * events in genome order and returns the runs of equal, nonzero depth.
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "libpq/pqformat.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(locus_merge_transfn);
+PG_FUNCTION_INFO_V1(locus_merge_combinefn);
+PG_FUNCTION_INFO_V1(locus_merge_serialfn);
+PG_FUNCTION_INFO_V1(locus_merge_deserialfn);
+PG_FUNCTION_INFO_V1(locus_merge_finalfn);
+PG_FUNCTION_INFO_V1(locus_set_agg_finalfn);
+PG_FUNCTION_INFO_V1(locus_coverage_transfn);
+PG_FUNCTION_INFO_V1(locus_coverage_combinefn);
+PG_FUNCTION_INFO_V1(locus_coverage_serialfn);
+PG_FUNCTION_INFO_V1(locus_coverage_deserialfn);
+PG_FUNCTION_INFO_V1(locus_coverage_finalfn);
+
+#define LOCUS_MERGE_INITIAL_ITEMS  64
+#define LOCUS_COVERAGE_INITIAL_EVENTS  256
+#define LOCUS_COVERAGE_INITIAL_CONTIGS  32
+
+typedef struct LocusMergeState
+{
+  int64       gap;        /* largest distance between merged loci */
+  int         nitems;     /* loci in items */
+  int         maxitems;   /* allocated length of items */
+  LOCUS      *items;
+} LocusMergeState;
+
+static MemoryContext
+locus_agg_context(FunctionCallInfo fcinfo, const char *name)
+{
+  MemoryContext aggcontext;
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext))
+    elog(ERROR, "%s called in non-aggregate context", name);
+  return aggcontext;
+}
+
+static LocusMergeState *
+locus_merge_create(MemoryContext aggcontext, int64 gap, int maxitems)
+{
+  LocusMergeState *state;
+
+  state = (LocusMergeState *) MemoryContextAlloc(aggcontext, sizeof(LocusMergeState));
+  state->gap = gap;
+  state->nitems = 0;
+  state->maxitems = Max(maxitems, LOCUS_MERGE_INITIAL_ITEMS);
+  state->items = (LOCUS *) MemoryContextAllocHuge(aggcontext,
+                                                  state->maxitems * sizeof(LOCUS));
+  return state;
+}
+
+static int
+locus_merge_item_cmp(const void *a, const void *b)
+{
+  return locus_cmp_internal((LOCUS *) a, (LOCUS *) b);
+}
+
+/*
+ * Sort the loci of a state and merge in place those that are no more than
+ * gap apart.  The merged locus keeps the contig spelling of the first one.
+ */
+static void
+locus_merge_compact(LocusMergeState *state)
+{
+  LOCUS      *items = state->items;
+  int         n = 0;
+  int         i;
+
+  if (state->nitems < 2)
+    return;
+
+  qsort(items, state->nitems, sizeof(LOCUS), locus_merge_item_cmp);
+
+  for (i = 0; i < state->nitems; i++)
+  {
+    if (n > 0 &&
+        locus_contig_cmp(&items[n - 1], &items[i]) == 0 &&
+        (int64) items[i].lower - items[n - 1].upper <= state->gap)
+    {
+      if (items[i].upper > items[n - 1].upper)
+        items[n - 1].upper = items[i].upper;
+      continue;
+    }
+    if (n != i)
+      items[n] = items[i];
+    n++;
+  }
+  state->nitems = n;
+}
+
+/*
+ * Make room for count more loci, coalescing first and growing the array
+ * only if that does not free at least half of it.
+ */
+static void
+locus_merge_reserve(LocusMergeState *state, int count)
+{
+  if (state->nitems + count <= state->maxitems)
+    return;
+
+  locus_merge_compact(state);
+
+  if (state->nitems + count > state->maxitems / 2)
+  {
+    int         maxitems = state->maxitems;
+
+    while (state->nitems + count > maxitems / 2)
+      maxitems *= 2;
+    state->items = (LOCUS *) repalloc_huge(state->items, maxitems * sizeof(LOCUS));
+    state->maxitems = maxitems;
+  }
+}
+
+/*
+ * locus_merge(locus [, gap]) transition function.  NULL loci are skipped;
+ * the gap is taken from the first row and must not be negative.
+ */
+Datum
+locus_merge_transfn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_merge_transfn");
+  LocusMergeState *state = PG_ARGISNULL(0) ? NULL : (LocusMergeState *) PG_GETARG_POINTER(0);
+
+  if (PG_ARGISNULL(1))
+    PG_RETURN_POINTER(state);
+
+  if (state == NULL)
+  {
+    int64       gap = 0;
+
+    if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+      gap = PG_GETARG_INT32(2);
+    if (gap < 0)
+      ereport(ERROR,
+              (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+               errmsg("gap must not be negative")));
+    state = locus_merge_create(aggcontext, gap, 0);
+  }
+
+  locus_merge_reserve(state, 1);
+  state->items[state->nitems++] = *PG_GETARG_LOCUS_P(1);
+
+  PG_RETURN_POINTER(state);
+}
+
+Datum
+locus_merge_combinefn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_merge_combinefn");
+  LocusMergeState *state1 = PG_ARGISNULL(0) ? NULL : (LocusMergeState *) PG_GETARG_POINTER(0);
+  LocusMergeState *state2 = PG_ARGISNULL(1) ? NULL : (LocusMergeState *) PG_GETARG_POINTER(1);
+
+  if (state2 == NULL)
+    PG_RETURN_POINTER(state1);
+
+  if (state1 == NULL)
+    state1 = locus_merge_create(aggcontext, state2->gap, state2->nitems);
+
+  locus_merge_reserve(state1, state2->nitems);
+  memcpy(state1->items + state1->nitems, state2->items, state2->nitems * sizeof(LOCUS));
+  state1->nitems += state2->nitems;
+  locus_merge_compact(state1);
+
+  PG_RETURN_POINTER(state1);
+}
+
+/*
+ * The serialized state is the gap, the number of loci and the loci as they
+ * are in memory; it only travels between processes of one server.
+ */
+Datum
+locus_merge_serialfn(PG_FUNCTION_ARGS)
+{
+  LocusMergeState *state = (LocusMergeState *) PG_GETARG_POINTER(0);
+  StringInfoData buf;
+
+  locus_merge_compact(state);
+
+  pq_begintypsend(&buf);
+  pq_sendint64(&buf, state->gap);
+  pq_sendint32(&buf, state->nitems);
+  pq_sendbytes(&buf, (char *) state->items, state->nitems * sizeof(LOCUS));
+
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+Datum
+locus_merge_deserialfn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_merge_deserialfn");
+  bytea      *sstate = PG_GETARG_BYTEA_PP(0);
+  LocusMergeState *state;
+  StringInfoData buf;
+  int64       gap;
+  int         nitems;
+
+  initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+  gap = pq_getmsgint64(&buf);
+  nitems = pq_getmsgint(&buf, 4);
+  state = locus_merge_create(aggcontext, gap, nitems);
+  pq_copymsgbytes(&buf, (char *) state->items, nitems * sizeof(LOCUS));
+  state->nitems = nitems;
+  pq_getmsgend(&buf);
+
+  PG_RETURN_POINTER(state);
+}
+
+/*
+ * The merged loci as an array in locus_ops order.  The element type comes
+ * from the dummy argument of FINALFUNC_EXTRA.
+ */
+Datum
+locus_merge_finalfn(PG_FUNCTION_ARGS)
+{
+  LocusMergeState *state;
+  Oid         elemtype;
+  int16       typlen;
+  bool        typbyval;
+  char        typalign;
+  Datum      *elems;
+  int         i;
+
+  (void) locus_agg_context(fcinfo, "locus_merge_finalfn");
+
+  if (PG_ARGISNULL(0))
+    PG_RETURN_NULL();
+  state = (LocusMergeState *) PG_GETARG_POINTER(0);
+
+  locus_merge_compact(state);
+
+  elemtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+  get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+
+  elems = (Datum *) palloc(state->nitems * sizeof(Datum));
+  for (i = 0; i < state->nitems; i++)
+    elems[i] = PointerGetDatum(&state->items[i]);
+
+  PG_RETURN_ARRAYTYPE_P(construct_array(elems, state->nitems, elemtype,
+                                        typlen, typbyval, typalign));
+}
+
+/*
+ * locus_set_agg(locus) shares the state of locus_merge(locus) and builds a
+ * locus_set from the merged loci.
+ */
+Datum
+locus_set_agg_finalfn(PG_FUNCTION_ARGS)
+{
+  LocusMergeState *state;
+  LOCUS      *items;
+
+  (void) locus_agg_context(fcinfo, "locus_set_agg_finalfn");
+
+  if (PG_ARGISNULL(0))
+    PG_RETURN_NULL();
+  state = (LocusMergeState *) PG_GETARG_POINTER(0);
+
+  /* locus_set_build() works in place; the state may be finalized again */
+  locus_merge_compact(state);
+  items = (LOCUS *) palloc(state->nitems * sizeof(LOCUS));
+  memcpy(items, state->items, state->nitems * sizeof(LOCUS));
+
+  PG_RETURN_POINTER(locus_set_build(items, state->nitems));
+}
+
+/* A change of depth at a position of one of the contigs of a state */
+typedef struct LocusCoverageEvent
+{
+  int32       contig;     /* index into contigs */
+  int32       pos;
+  int32       delta;
+} LocusCoverageEvent;
+
+typedef struct LocusCoverageState
+{
+  int64       width;      /* bin width, 1 for single bases */
+  int         ncontigs;
+  int         maxcontigs;
+  int         last;       /* contig of the latest locus */
+  LOCUS      *contigs;    /* one locus on each contig seen */
+  int         nevents;
+  int         maxevents;
+  LocusCoverageEvent *events;
+} LocusCoverageState;
+
+static LocusCoverageState *
+locus_coverage_create(MemoryContext aggcontext, int64 width, int maxcontigs, int maxevents)
+{
+  LocusCoverageState *state;
+
+  state = (LocusCoverageState *) MemoryContextAlloc(aggcontext, sizeof(LocusCoverageState));
+  state->width = width;
+  state->ncontigs = 0;
+  state->maxcontigs = Max(maxcontigs, LOCUS_COVERAGE_INITIAL_CONTIGS);
+  state->last = -1;
+  state->contigs = (LOCUS *) MemoryContextAlloc(aggcontext,
+                                                state->maxcontigs * sizeof(LOCUS));
+  state->nevents = 0;
+  state->maxevents = Max(maxevents, LOCUS_COVERAGE_INITIAL_EVENTS);
+  state->events = (LocusCoverageEvent *)
+    MemoryContextAllocHuge(aggcontext, state->maxevents * sizeof(LocusCoverageEvent));
+  return state;
+}
+
+/*
+ * The index of the contig of a locus in a state, added if it is new.  Input
+ * usually comes grouped by contig, so the latest one is tried first.
+ */
+static int
+locus_coverage_contig(LocusCoverageState *state, LOCUS *locus)
+{
+  int         i;
+
+  if (state->last >= 0 && locus_contig_cmp(&state->contigs[state->last], locus) == 0)
+    return state->last;
+
+  for (i = 0; i < state->ncontigs; i++)
+  {
+    if (locus_contig_cmp(&state->contigs[i], locus) == 0)
+      return state->last = i;
+  }
+
+  if (state->ncontigs == state->maxcontigs)
+  {
+    state->maxcontigs *= 2;
+    state->contigs = (LOCUS *) repalloc(state->contigs, state->maxcontigs * sizeof(LOCUS));
+  }
+  state->contigs[state->ncontigs] = *locus;
+  return state->last = state->ncontigs++;
+}
+
+static int
+locus_coverage_event_cmp(const void *a, const void *b)
+{
+  const LocusCoverageEvent *ea = (const LocusCoverageEvent *) a;
+  const LocusCoverageEvent *eb = (const LocusCoverageEvent *) b;
+
+  if (ea->contig != eb->contig)
+    return ea->contig < eb->contig ? -1 : 1;
+  if (ea->pos != eb->pos)
+    return ea->pos < eb->pos ? -1 : 1;
+  return 0;
+}
+
+/*
+ * Sort the events of a state and replace those at the same position with
+ * their sum, dropping the ones that cancel out.
+ */
+static void
+locus_coverage_compact(LocusCoverageState *state)
+{
+  LocusCoverageEvent *events = state->events;
+  int         n = 0;
+  int         i;
+
+  qsort(events, state->nevents, sizeof(LocusCoverageEvent), locus_coverage_event_cmp);
+
+  for (i = 0; i < state->nevents; i++)
+  {
+    if (n > 0 &&
+        events[n - 1].contig == events[i].contig &&
+        events[n - 1].pos == events[i].pos)
+    {
+      events[n - 1].delta += events[i].delta;
+      continue;
+    }
+    if (n > 0 && events[n - 1].delta == 0)
+      n--;
+    events[n++] = events[i];
+  }
+  if (n > 0 && events[n - 1].delta == 0)
+    n--;
+  state->nevents = n;
+}
+
+/* As locus_merge_reserve(), for events */
+static void
+locus_coverage_reserve(LocusCoverageState *state, int count)
+{
+  if (state->nevents + count <= state->maxevents)
+    return;
+
+  locus_coverage_compact(state);
+
+  if (state->nevents + count > state->maxevents / 2)
+  {
+    int         maxevents = state->maxevents;
+
+    while (state->nevents + count > maxevents / 2)
+      maxevents *= 2;
+    state->events = (LocusCoverageEvent *)
+      repalloc_huge(state->events, maxevents * sizeof(LocusCoverageEvent));
+    state->maxevents = maxevents;
+  }
+}
+
+/*
+ * Renumber the contigs of a state in natural order, so that sorted events
+ * follow the genome.
+ */
+static void
+locus_coverage_sort_contigs(LocusCoverageState *state)
+{
+  int        *order = (int *) palloc(state->ncontigs * sizeof(int));
+  int        *rank = (int *) palloc(state->ncontigs * sizeof(int));
+  LOCUS      *contigs = (LOCUS *) palloc(state->ncontigs * sizeof(LOCUS));
+  int         i,
+              j;
+
+  /* insertion sort: there are few contigs */
+  for (i = 0; i < state->ncontigs; i++)
+  {
+    for (j = i; j > 0 && locus_contig_cmp(&state->contigs[order[j - 1]], &state->contigs[i]) > 0; j--)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+  for (i = 0; i < state->ncontigs; i++)
+  {
+    rank[order[i]] = i;
+    contigs[i] = state->contigs[order[i]];
+  }
+
+  memcpy(state->contigs, contigs, state->ncontigs * sizeof(LOCUS));
+  for (i = 0; i < state->nevents; i++)
+    state->events[i].contig = rank[state->events[i].contig];
+  state->last = -1;
+
+  pfree(order);
+  pfree(rank);
+  pfree(contigs);
+}
+
+/*
+ * locus_coverage(locus [, bin_width]) transition function.  A locus adds
+ * one to the depth from its lower boundary to its upper one, both included;
+ * with bins, from the start of its first bin to the end of its last.  Loci
+ * that reach the end of the contig have no end event.
+ */
+Datum
+locus_coverage_transfn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_coverage_transfn");
+  LocusCoverageState *state = PG_ARGISNULL(0) ? NULL : (LocusCoverageState *) PG_GETARG_POINTER(0);
+  LOCUS      *locus;
+  MemoryContext oldcontext;
+  int         contig;
+  int64       start;
+  int64       end;
+
+  if (PG_ARGISNULL(1))
+    PG_RETURN_POINTER(state);
+
+  if (state == NULL)
+  {
+    int64       width = 1;
+
+    if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+      width = PG_GETARG_INT64(2);
+    if (width <= 0)
+      ereport(ERROR,
+              (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+               errmsg("bin width must be positive")));
+    state = locus_coverage_create(aggcontext, width, 0, 0);
+  }
+
+  locus = PG_GETARG_LOCUS_P(1);
+  start = locus->lower - locus->lower % state->width;
+  end = ((int64) locus->upper / state->width + 1) * state->width;
+
+  oldcontext = MemoryContextSwitchTo(aggcontext);
+  contig = locus_coverage_contig(state, locus);
+  locus_coverage_reserve(state, 2);
+  MemoryContextSwitchTo(oldcontext);
+
+  state->events[state->nevents].contig = contig;
+  state->events[state->nevents].pos = (int32) start;
+  state->events[state->nevents++].delta = 1;
+  if (end <= PG_INT32_MAX)
+  {
+    state->events[state->nevents].contig = contig;
+    state->events[state->nevents].pos = (int32) end;
+    state->events[state->nevents++].delta = -1;
+  }
+
+  PG_RETURN_POINTER(state);
+}
+
+Datum
+locus_coverage_combinefn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_coverage_combinefn");
+  LocusCoverageState *state1 = PG_ARGISNULL(0) ? NULL : (LocusCoverageState *) PG_GETARG_POINTER(0);
+  LocusCoverageState *state2 = PG_ARGISNULL(1) ? NULL : (LocusCoverageState *) PG_GETARG_POINTER(1);
+  MemoryContext oldcontext;
+  int        *map;
+  int         i;
+
+  if (state2 == NULL)
+    PG_RETURN_POINTER(state1);
+
+  if (state1 == NULL)
+    state1 = locus_coverage_create(aggcontext, state2->width,
+                                   state2->ncontigs, state2->nevents);
+
+  oldcontext = MemoryContextSwitchTo(aggcontext);
+  map = (int *) palloc(Max(state2->ncontigs, 1) * sizeof(int));
+  for (i = 0; i < state2->ncontigs; i++)
+    map[i] = locus_coverage_contig(state1, &state2->contigs[i]);
+  locus_coverage_reserve(state1, state2->nevents);
+  MemoryContextSwitchTo(oldcontext);
+
+  for (i = 0; i < state2->nevents; i++)
+  {
+    state1->events[state1->nevents] = state2->events[i];
+    state1->events[state1->nevents++].contig = map[state2->events[i].contig];
+  }
+  pfree(map);
+  locus_coverage_compact(state1);
+
+  PG_RETURN_POINTER(state1);
+}
+
+/*
+ * The serialized state is the bin width, the contigs and the events, the
+ * last two as they are in memory.
+ */
+Datum
+locus_coverage_serialfn(PG_FUNCTION_ARGS)
+{
+  LocusCoverageState *state = (LocusCoverageState *) PG_GETARG_POINTER(0);
+  StringInfoData buf;
+
+  locus_coverage_compact(state);
+
+  pq_begintypsend(&buf);
+  pq_sendint64(&buf, state->width);
+  pq_sendint32(&buf, state->ncontigs);
+  pq_sendbytes(&buf, (char *) state->contigs, state->ncontigs * sizeof(LOCUS));
+  pq_sendint32(&buf, state->nevents);
+  pq_sendbytes(&buf, (char *) state->events, state->nevents * sizeof(LocusCoverageEvent));
+
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+Datum
+locus_coverage_deserialfn(PG_FUNCTION_ARGS)
+{
+  MemoryContext aggcontext = locus_agg_context(fcinfo, "locus_coverage_deserialfn");
+  bytea      *sstate = PG_GETARG_BYTEA_PP(0);
+  LocusCoverageState *state;
+  StringInfoData buf;
+  int64       width;
+  int         ncontigs;
+  int         nevents;
+  const char *contigs;
+
+  initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate), VARSIZE_ANY_EXHDR(sstate));
+
+  width = pq_getmsgint64(&buf);
+  ncontigs = pq_getmsgint(&buf, 4);
+  contigs = pq_getmsgbytes(&buf, ncontigs * sizeof(LOCUS));
+  nevents = pq_getmsgint(&buf, 4);
+
+  state = locus_coverage_create(aggcontext, width, ncontigs, nevents);
+  memcpy(state->contigs, contigs, ncontigs * sizeof(LOCUS));
+  state->ncontigs = ncontigs;
+  pq_copymsgbytes(&buf, (char *) state->events, nevents * sizeof(LocusCoverageEvent));
+  state->nevents = nevents;
+  pq_getmsgend(&buf);
+
+  PG_RETURN_POINTER(state);
+}
+
+/*
+ * The runs of equal, nonzero depth as an array of locus_depth records in
+ * locus_ops order.
+ */
+Datum
+locus_coverage_finalfn(PG_FUNCTION_ARGS)
+{
+  LocusCoverageState *state;
+  Oid         rectype;
+  TupleDesc   tupdesc;
+  Datum      *elems;
+  int         nelems = 0;
+  int         depth = 0;
+  int         i;
+
+  (void) locus_agg_context(fcinfo, "locus_coverage_finalfn");
+
+  if (PG_ARGISNULL(0))
+    PG_RETURN_NULL();
+  state = (LocusCoverageState *) PG_GETARG_POINTER(0);
+
+  locus_coverage_sort_contigs(state);
+  locus_coverage_compact(state);
+
+  rectype = get_element_type(get_fn_expr_rettype(fcinfo->flinfo));
+  tupdesc = lookup_rowtype_tupdesc_copy(rectype, -1);
+  tupdesc = BlessTupleDesc(tupdesc);
+
+  /* each event but the last of a contig starts a run */
+  elems = (Datum *) palloc(state->nevents * sizeof(Datum));
+  for (i = 0; i < state->nevents; i++)
+  {
+    LocusCoverageEvent *event = &state->events[i];
+    bool        last = i + 1 == state->nevents || state->events[i + 1].contig != event->contig;
+    LOCUS      *run;
+    Datum       values[2];
+    bool        nulls[2] = {false, false};
+
+    depth += event->delta;
+    if (depth == 0)
+      continue;
+
+    run = (LOCUS *) palloc(sizeof(LOCUS));
+    *run = state->contigs[event->contig];
+    run->lower = event->pos;
+    run->upper = last ? PG_INT32_MAX : state->events[i + 1].pos - 1;
+
+    values[0] = PointerGetDatum(run);
+    values[1] = Int32GetDatum(depth);
+    elems[nelems++] = HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+
+    if (last)
+      depth = 0;
+  }
+
+  PG_RETURN_ARRAYTYPE_P(construct_array(elems, nelems, rectype, -1, false, TYPALIGN_DOUBLE));
+}
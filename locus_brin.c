@@ -0,0 +1,249 @@
+/*
+ * contrib/locus/locus_brin.c
+ *
+ * BRIN operator class for genomic loci
+ *
+ * Each block range is summarized by the smallest start and the largest end
+ * of the loci it holds, as bounds in the (contig, position) order that
+ * locus_cmp uses:
+ *
+ *   lo        contig and lower of the locus with the least (contig, lower)
+ *   hi        contig and upper of the locus with the greatest (contig, upper)
+ *   wildcard  whether the range holds any "<all>" loci
+ *
+ * On a table written in genome order a block range covers a short stretch
+ * of one contig, or the end of one contig and the start of the next, and the
+ * summary is about as tight as the data.  Wildcard loci match queries on any
+ * contig, so they stay out of lo and hi and are tracked by the flag; until
+ * the range holds a locus with a real contig, lo and hi are wildcards.
+ */
+
+#include "postgres.h"
+
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "utils/typcache.h"
+
+#include "locus_data.h"
+
+
+PG_FUNCTION_INFO_V1(brin_locus_opcinfo);
+PG_FUNCTION_INFO_V1(brin_locus_add_value);
+PG_FUNCTION_INFO_V1(brin_locus_consistent);
+PG_FUNCTION_INFO_V1(brin_locus_union);
+
+#define LOCUS_BRIN_LO        0
+#define LOCUS_BRIN_HI        1
+#define LOCUS_BRIN_WILDCARD  2
+#define LOCUS_BRIN_NSTORED   3
+
+
+/*
+ * Compare bound (a, apos) with bound (b, bpos)
+ */
+static inline int
+locus_brin_bound_cmp(LOCUS *a, int32 apos, LOCUS *b, int32 bpos)
+{
+  int       cmp = locus_contig_cmp(a, b);
+
+  if (cmp != 0)
+    return cmp;
+  if (apos < bpos)
+    return -1;
+  return apos > bpos ? 1 : 0;
+}
+
+/*
+ * A copy of locus whose lower and upper are both pos
+ */
+static Datum
+locus_brin_bound(LOCUS *locus, int32 pos)
+{
+  LOCUS    *bound = (LOCUS *) palloc(sizeof(LOCUS));
+
+  memcpy(bound, locus, sizeof(LOCUS));
+  bound->lower = bound->upper = pos;
+
+  return PointerGetDatum(bound);
+}
+
+static inline void
+locus_brin_replace(BrinValues *column, int n, Datum value)
+{
+  pfree(DatumGetPointer(column->bv_values[n]));
+  column->bv_values[n] = value;
+}
+
+/*
+ * Widen the summary in column to take in locus.  Returns whether it changed.
+ */
+static bool
+locus_brin_widen(BrinValues *column, LOCUS *locus)
+{
+  LOCUS    *lo = DatumGetLocusP(column->bv_values[LOCUS_BRIN_LO]);
+  LOCUS    *hi = DatumGetLocusP(column->bv_values[LOCUS_BRIN_HI]);
+  bool      updated = false;
+
+  if (LOCUS_IS_WILDCARD(locus))
+  {
+    if (!DatumGetBool(column->bv_values[LOCUS_BRIN_WILDCARD]))
+    {
+      column->bv_values[LOCUS_BRIN_WILDCARD] = BoolGetDatum(true);
+      updated = true;
+    }
+    return updated;
+  }
+
+  if (LOCUS_IS_WILDCARD(lo) ||
+      locus_brin_bound_cmp(locus, locus->lower, lo, lo->lower) < 0)
+  {
+    locus_brin_replace(column, LOCUS_BRIN_LO, locus_brin_bound(locus, locus->lower));
+    updated = true;
+  }
+
+  if (LOCUS_IS_WILDCARD(hi) ||
+      locus_brin_bound_cmp(locus, locus->upper, hi, hi->upper) > 0)
+  {
+    locus_brin_replace(column, LOCUS_BRIN_HI, locus_brin_bound(locus, locus->upper));
+    updated = true;
+  }
+
+  return updated;
+}
+
+/*
+ * BRIN opcinfo function
+ */
+Datum
+brin_locus_opcinfo(PG_FUNCTION_ARGS)
+{
+  Oid       typoid = PG_GETARG_OID(0);
+  BrinOpcInfo *result;
+
+  result = palloc0(SizeofBrinOpcInfo(LOCUS_BRIN_NSTORED));
+  result->oi_nstored = LOCUS_BRIN_NSTORED;
+  result->oi_regular_nulls = true;
+  result->oi_opaque = NULL;
+  result->oi_typcache[LOCUS_BRIN_LO] =
+    result->oi_typcache[LOCUS_BRIN_HI] = lookup_type_cache(typoid, 0);
+  result->oi_typcache[LOCUS_BRIN_WILDCARD] = lookup_type_cache(BOOLOID, 0);
+
+  PG_RETURN_POINTER(result);
+}
+
+/*
+ * BRIN add_value function
+ */
+Datum
+brin_locus_add_value(PG_FUNCTION_ARGS)
+{
+  /* BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0); */
+  BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+  LOCUS      *locus = PG_GETARG_LOCUS_P(2);
+
+  /* nulls are handled by the BRIN core */
+  Assert(!PG_GETARG_BOOL(3));
+
+  if (column->bv_allnulls)
+  {
+    column->bv_values[LOCUS_BRIN_LO] = locus_brin_bound(locus, locus->lower);
+    column->bv_values[LOCUS_BRIN_HI] = locus_brin_bound(locus, locus->upper);
+    column->bv_values[LOCUS_BRIN_WILDCARD] = BoolGetDatum(LOCUS_IS_WILDCARD(locus));
+    column->bv_allnulls = false;
+    PG_RETURN_BOOL(true);
+  }
+
+  PG_RETURN_BOOL(locus_brin_widen(column, locus));
+}
+
+/*
+ * BRIN consistent function
+ *
+ * Whether the block range may hold a locus satisfying the key.  Any locus
+ * that does lies between lo and hi, which is all these tests look at.
+ */
+Datum
+brin_locus_consistent(PG_FUNCTION_ARGS)
+{
+  /* BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0); */
+  BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+  ScanKey     key = (ScanKey) PG_GETARG_POINTER(2);
+  LOCUS      *query = DatumGetLocusP(key->sk_argument);
+  LOCUS      *lo = DatumGetLocusP(column->bv_values[LOCUS_BRIN_LO]);
+  LOCUS      *hi = DatumGetLocusP(column->bv_values[LOCUS_BRIN_HI]);
+  bool        wildcard = DatumGetBool(column->bv_values[LOCUS_BRIN_WILDCARD]);
+  bool        loci = !LOCUS_IS_WILDCARD(lo);
+
+  Assert(!column->bv_allnulls);
+
+  switch (key->sk_strategy)
+  {
+    case RTLeftStrategyNumber:
+      /* wildcards are never to the left or right of anything */
+      if (LOCUS_IS_WILDCARD(query))
+        PG_RETURN_BOOL(false);
+      PG_RETURN_BOOL(loci &&
+        locus_brin_bound_cmp(lo, lo->lower, query, query->lower) < 0);
+
+    case RTRightStrategyNumber:
+      if (LOCUS_IS_WILDCARD(query))
+        PG_RETURN_BOOL(false);
+      PG_RETURN_BOOL(loci &&
+        locus_brin_bound_cmp(hi, hi->upper, query, query->upper) > 0);
+
+    case RTOverlapStrategyNumber:
+      if (wildcard)
+        PG_RETURN_BOOL(true);
+      PG_RETURN_BOOL(loci &&
+        locus_brin_bound_cmp(lo, lo->lower, query, query->upper) <= 0 &&
+        locus_brin_bound_cmp(hi, hi->upper, query, query->lower) >= 0);
+
+    case RTSameStrategyNumber:
+    case RTContainsStrategyNumber:
+      if (wildcard)
+        PG_RETURN_BOOL(true);
+      PG_RETURN_BOOL(loci &&
+        locus_brin_bound_cmp(lo, lo->lower, query, query->lower) <= 0 &&
+        locus_brin_bound_cmp(hi, hi->upper, query, query->upper) >= 0);
+
+    case RTContainedByStrategyNumber:
+      /* a wildcard query contains loci of any contig */
+      if (wildcard || LOCUS_IS_WILDCARD(query))
+        PG_RETURN_BOOL(true);
+      PG_RETURN_BOOL(loci &&
+        locus_brin_bound_cmp(lo, lo->lower, query, query->upper) <= 0 &&
+        locus_brin_bound_cmp(hi, hi->upper, query, query->lower) >= 0);
+
+    default:
+      elog(ERROR, "unrecognized strategy number: %d", key->sk_strategy);
+      PG_RETURN_BOOL(false);  /* keep compiler quiet */
+  }
+}
+
+/*
+ * BRIN union function
+ */
+Datum
+brin_locus_union(PG_FUNCTION_ARGS)
+{
+  /* BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0); */
+  BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+  BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+  LOCUS      *lo = DatumGetLocusP(col_b->bv_values[LOCUS_BRIN_LO]);
+  LOCUS      *hi = DatumGetLocusP(col_b->bv_values[LOCUS_BRIN_HI]);
+
+  Assert(!col_a->bv_allnulls && !col_b->bv_allnulls);
+
+  if (DatumGetBool(col_b->bv_values[LOCUS_BRIN_WILDCARD]))
+    col_a->bv_values[LOCUS_BRIN_WILDCARD] = BoolGetDatum(true);
+
+  /* lo and hi of b are loci with lower = upper */
+  locus_brin_widen(col_a, lo);
+  locus_brin_widen(col_a, hi);
+
+  PG_RETURN_VOID();
+}
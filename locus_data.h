@@ -2,21 +2,244 @@
  * contrib/locus/locus_data.h
  */
 
+#include "strnatcmp.h"
+
+/*
+ * The natural-order contig key (see locus_contig_natkey() in locus.c) lives
+ * in the bytes that INTERNALLENGTH = 32 leaves after the contig name.  It is
+ * computed once, when a value is built, so that comparisons can use memcmp()
+ * instead of strnatcmp().
+ */
+#define LOCUS_NATKEY_LEN  7
+
 typedef struct LOCUS
 {
   int    lower;
   int    upper;
   char   contig[15];
   bool   chr;
+  uint8  flags;
+  uint8  natkey[LOCUS_NATKEY_LEN];
 } LOCUS;
 
-/* in locus_scan.l */
-extern int locus_yylex(void);
-// extern void locus_yyerror(LOCUS *result, const char *message) pg_attribute_noreturn();
-extern void locus_yyerror(LOCUS *result, const char *message);
-extern void locus_scanner_init(const char *str);
-extern void locus_scanner_finish(void);
+/* flags */
+#define LOCUS_WILDCARD      0x01  /* contig is "<all>" */
+#define LOCUS_NATKEY_EXACT  0x02  /* natkey holds the whole contig key */
+#define LOCUS_GIST_RANGE    0x04  /* a LOCUS_RANGE_KEY, not a LOCUS */
+#define LOCUS_CONTIG_OUT    0x20  /* contig holds a pointer to the name */
+
+#define LOCUS_IS_WILDCARD(l)  (((l)->flags & LOCUS_WILDCARD) != 0)
+#define LOCUS_IS_RANGE(l)     (((l)->flags & LOCUS_GIST_RANGE) != 0)
+
+/*
+ * The key of a GiST index entry whose subtree holds loci on more than one
+ * contig.  It has the size of a LOCUS and keeps its flags byte in the same
+ * place, where LOCUS_GIST_RANGE tells the two apart.  first and last are
+ * prefixes of the natural-order keys of the least and the greatest contig
+ * below; the flags say whether they are whole keys.  lower and upper bound
+ * the positions on all of them, and LOCUS_WILDCARD means that there are
+ * "<all>" loci below as well.
+ */
+#define LOCUS_RANGE_NATKEY_LEN  8
+
+#define LOCUS_RANGE_FIRST_EXACT  0x08
+#define LOCUS_RANGE_LAST_EXACT   0x10
+
+typedef struct LOCUS_RANGE_KEY
+{
+  int    lower;
+  int    upper;
+  uint8  first[LOCUS_RANGE_NATKEY_LEN];
+  uint8  last[LOCUS_RANGE_NATKEY_LEN];
+  uint8  flags;
+  uint8  unused[7];
+} LOCUS_RANGE_KEY;
+
+StaticAssertDecl(sizeof(LOCUS_RANGE_KEY) == sizeof(LOCUS) &&
+                 offsetof(LOCUS_RANGE_KEY, flags) == offsetof(LOCUS, flags),
+                 "LOCUS_RANGE_KEY must overlay LOCUS");
+
+#define DatumGetLocusP(X) ((LOCUS *) DatumGetPointer(X))
+#define PG_GETARG_LOCUS_P(n) ((LOCUS *) PG_GETARG_POINTER(n))
+
+/*
+ * A vlocus is a locus with a contig name of any length (up to
+ * VLOCUS_MAX_CONTIG), stored as a varlena.  The fields of a LOCUS come
+ * first, but for the contig, which ends the value with its terminating NUL.
+ * Short values get a one-byte header on disk, so they are not aligned;
+ * vlocus_view() reads one in place into a LOCUS.
+ */
+#define VLOCUS_MAX_CONTIG  255
+
+typedef struct VLOCUS
+{
+  int32  vl_len_;    /* varlena header (do not touch directly!) */
+  int32  lower;
+  int32  upper;
+  uint8  flags;
+  bool   chr;
+  uint8  natkey[LOCUS_NATKEY_LEN];
+  char   contig[FLEXIBLE_ARRAY_MEMBER];
+} VLOCUS;
+
+#define VLOCUS_HDRSZ  offsetof(VLOCUS, contig)
+
+#define DatumGetVLocusP(X) ((VLOCUS *) PG_DETOAST_DATUM_PACKED(X))
+#define PG_GETARG_VLOCUS_P(n) DatumGetVLocusP(PG_GETARG_DATUM(n))
+
+/*
+ * A plocus is a locus whose contig is interned: it holds the ID of the contig
+ * in the dictionary table locus_contigs instead of its name, in 16 bytes.
+ * plocus_view() looks the name up in a cache of the table, which is kept by
+ * each backend and filled as IDs are met.
+ */
+typedef struct PLOCUS
+{
+  int32  contig_id;
+  int32  lower;
+  int32  upper;
+  bool   chr;
+  uint8  unused[3];
+} PLOCUS;
+
+StaticAssertDecl(sizeof(PLOCUS) == 16, "PLOCUS must take 16 bytes");
+
+#define DatumGetPLocusP(X) ((PLOCUS *) DatumGetPointer(X))
+#define PG_GETARG_PLOCUS_P(n) ((PLOCUS *) PG_GETARG_POINTER(n))
+
+/*
+ * A locus_set is a sorted set of disjoint, non-adjacent intervals, grouped
+ * by contig.  The contigs come first, in natural order; each one is a LOCUS
+ * spanning its intervals, with the index of the first one and their count.
+ * The intervals follow as pairs of boundaries, sorted within each contig, so
+ * that both their lower and their upper boundaries ascend and a probe is a
+ * binary search.
+ */
+typedef struct LocusSetContig
+{
+  LOCUS       extent;
+  int32       first;
+  int32       count;
+} LocusSetContig;
+
+typedef struct LocusSetInterval
+{
+  int32       lower;
+  int32       upper;
+} LocusSetInterval;
+
+typedef struct LOCUS_SET
+{
+  int32       vl_len_;    /* varlena header (do not touch directly!) */
+  int32       ncontigs;
+  int32       nintervals;
+  LocusSetContig contigs[FLEXIBLE_ARRAY_MEMBER];
+} LOCUS_SET;
+
+#define LOCUS_SET_INTERVALS(s) ((LocusSetInterval *) &(s)->contigs[(s)->ncontigs])
+#define LOCUS_SET_SIZE(ncontigs, nintervals) \
+  (offsetof(LOCUS_SET, contigs) + (ncontigs) * sizeof(LocusSetContig) + \
+   (nintervals) * sizeof(LocusSetInterval))
+
+#define DatumGetLocusSetP(X) ((LOCUS_SET *) PG_DETOAST_DATUM(X))
+#define PG_GETARG_LOCUS_SET_P(n) DatumGetLocusSetP(PG_GETARG_DATUM(n))
+
+/* in locus.c */
+extern uint8 locus_contig_flags(const char *contig, uint8 *natkey);
+extern void locus_set_natkey(LOCUS *locus);
+extern void locus_set_wildcard(LOCUS *locus);
+extern int32 locus_cmp_internal(LOCUS *a, LOCUS *b);
+extern char *locus_format(bool chr, const char *contig, int contig_len,
+                          int32 lower, int32 upper);
+extern Datum locus_out(PG_FUNCTION_ARGS);
+extern Datum locus_contains(PG_FUNCTION_ARGS);
+extern Datum locus_contained(PG_FUNCTION_ARGS);
+extern Datum locus_overlap(PG_FUNCTION_ARGS);
+extern Datum locus_left(PG_FUNCTION_ARGS);
+extern Datum locus_right(PG_FUNCTION_ARGS);
+extern Datum locus_over_left(PG_FUNCTION_ARGS);
+extern Datum locus_over_right(PG_FUNCTION_ARGS);
+extern Datum locus_same(PG_FUNCTION_ARGS);
+extern Datum locus_different(PG_FUNCTION_ARGS);
+extern Datum locus_cmp(PG_FUNCTION_ARGS);
+extern Datum locus_lt(PG_FUNCTION_ARGS);
+extern Datum locus_le(PG_FUNCTION_ARGS);
+extern Datum locus_gt(PG_FUNCTION_ARGS);
+extern Datum locus_ge(PG_FUNCTION_ARGS);
+
+/*
+ * The contig name of a locus.  A LOCUS read from a vlocus whose name does
+ * not fit (see vlocus_view()) points to it instead of holding it.
+ */
+static inline const char *
+locus_contig_name(LOCUS *locus)
+{
+  const char *name;
+
+  if ((locus->flags & LOCUS_CONTIG_OUT) == 0)
+    return locus->contig;
+
+  memcpy(&name, locus->contig, sizeof(name));
+  return name;
+}
+
+/*
+ * Compare contigs in natural order: the stored keys decide unless both are
+ * equal prefixes of longer keys.
+ */
+static inline int
+locus_contig_cmp(LOCUS *a, LOCUS *b)
+{
+  int     cmp = memcmp(a->natkey, b->natkey, LOCUS_NATKEY_LEN);
+
+  if (cmp != 0)
+    return cmp < 0 ? -1 : 1;
+  if (a->flags & b->flags & LOCUS_NATKEY_EXACT)
+    return 0;
+
+  return strnatcmp(locus_contig_name(a), locus_contig_name(b));
+}
+
+/*
+ * Read a vlocus into a LOCUS in place: the contig is copied when it fits,
+ * and pointed to otherwise.  The result is only good while the vlocus is.
+ */
+static inline void
+vlocus_view(VLOCUS *value, LOCUS *locus)
+{
+  const char *data = VARDATA_ANY(value);
+  const char *contig = data + (VLOCUS_HDRSZ - VARHDRSZ);
+  size_t      len = VARSIZE_ANY_EXHDR(value) - (VLOCUS_HDRSZ - VARHDRSZ) - 1;
+
+  memcpy(&locus->lower, data + offsetof(VLOCUS, lower) - VARHDRSZ, sizeof(int32));
+  memcpy(&locus->upper, data + offsetof(VLOCUS, upper) - VARHDRSZ, sizeof(int32));
+  locus->flags = data[offsetof(VLOCUS, flags) - VARHDRSZ];
+  locus->chr = data[offsetof(VLOCUS, chr) - VARHDRSZ];
+  memcpy(locus->natkey, data + offsetof(VLOCUS, natkey) - VARHDRSZ, LOCUS_NATKEY_LEN);
+
+  if (len < sizeof(locus->contig))
+    memcpy(locus->contig, contig, len + 1);
+  else
+  {
+    memcpy(locus->contig, &contig, sizeof(contig));
+    locus->flags |= LOCUS_CONTIG_OUT;
+  }
+}
+
+/* in locus_packed.c */
+extern void plocus_view(PLOCUS *value, LOCUS *locus);
+
+/* in locus_set.c */
+extern LOCUS_SET *locus_set_build(LOCUS *items, int nitems);
+
+/* in locus_sweep.c */
+extern void locus_sweep_init(void);
 
-/* in locus_parse.y */
-extern int locus_yyparse(LOCUS *result);
+/* in locus_parse.c */
+extern void locus_parse(const char *str, LOCUS *result);
+extern void locus_parse_contig(const char *str, LOCUS *result, int maxlen,
+                               const char **contig, int *len);
+extern bool locus_contig_valid(bool chr, const char *name, int len, int maxlen);
+extern void locus_parse_name(const char *name, int len, LOCUS *result);
+extern bool locus_name_valid(const char *name, int len);
 
@@ -0,0 +1,1555 @@
+/*
+ * contrib/locus/locus_fdw.c
+ *
+ * Foreign tables over bgzip-compressed, tabix-indexed files
+ *
+ * bgzip writes a file as a series of gzip members, or blocks, of at most
+ * 64 kB each, so that a reader can start at any block; a position in the
+ * file is a virtual offset, the offset of a block in the file shifted left
+ * by 16 bits, plus an offset in the data of the block.  The tabix index of
+ * such a file (the .tbi file next to it) maps the records of each contig to
+ * runs of virtual offsets (chunks) in the bins of the UCSC binning scheme,
+ * and keeps a linear index of the first record in every 16 kb window.  To
+ * read a region, a scan seeks to the chunks of the bins that the region
+ * touches and inflates only their blocks.
+ *
+ * A foreign table has a row for each record of its file.  A column of type
+ * locus gets the region of the record, in the 1-based, closed coordinates of
+ * locus; the other columns get the fields of the record, in order, through
+ * the input functions of their types, and a column option "field" maps a
+ * column to another one.  A qual comparing a locus column with a constant by
+ * &&, <@ or @> is pushed down: the scan reads only the blocks of the region
+ * of the constant, and the qual is still checked on the rows it returns.
+ * Rows are estimated from the compressed bytes the index says the scan will
+ * read, at the density of records of the whole file.
+ *
+ * Table options:
+ *   filename  the bgzip file (required); setting it requires the privileges
+ *             of pg_read_server_files
+ *   index     its tabix index (default: filename with ".tbi" appended)
+ */
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <limits.h>  /* for INT_MAX */
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "access/reloptions.h"
+#include "catalog/pg_attribute.h"
+#include "catalog/pg_authid.h"
+#include "catalog/pg_foreign_table.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
+#include "commands/explain.h"
+#include "commands/extension.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "foreign/fdwapi.h"
+#include "foreign/foreign.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/cost.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/planmain.h"
+#include "optimizer/restrictinfo.h"
+#include "storage/fd.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(locus_fdw_handler);
+PG_FUNCTION_INFO_V1(locus_fdw_validator);
+
+
+/*****************************************************************************
+ * BGZF reader
+ *****************************************************************************/
+
+#define BGZF_BLOCK_SIZE    65536
+#define BGZF_HEADER_SIZE   18
+#define BGZF_FOOTER_SIZE   8
+
+#define BGZF_COFFSET(v)    ((v) >> 16)
+#define BGZF_UOFFSET(v)    ((int) ((v) & 0xffff))
+
+typedef struct BgzfFile
+{
+  const char *path;
+  int         fd;
+  z_stream    zs;
+  uint8      *cdata;        /* the compressed block */
+  char       *udata;        /* its data */
+  off_t       block;        /* offset of the block in the file, or -1 */
+  off_t       next;         /* offset of the block after it */
+  int         ulen;         /* bytes of data in the block */
+  int         upos;         /* the data not yet read */
+  int64       nblocks;      /* blocks inflated, for EXPLAIN ANALYZE */
+} BgzfFile;
+
+static void *
+bgzf_zalloc(void *opaque, unsigned int items, unsigned int size)
+{
+  return MemoryContextAlloc((MemoryContext) opaque, (Size) items * size);
+}
+
+static void
+bgzf_zfree(void *opaque, void *address)
+{
+  pfree(address);
+}
+
+static void
+bgzf_corrupt(BgzfFile *file)
+{
+  ereport(ERROR,
+      (errcode(ERRCODE_DATA_CORRUPTED),
+       errmsg("invalid bgzip block at offset %lld of file \"%s\"",
+              (long long) file->block, file->path)));
+}
+
+/*
+ * Open a file for reading in the current memory context, which must last
+ * until it is closed.  The descriptor is closed at the end of the
+ * transaction if an error comes first.
+ */
+static BgzfFile *
+bgzf_open(const char *path)
+{
+  BgzfFile   *file = (BgzfFile *) palloc0(sizeof(BgzfFile));
+
+  file->path = pstrdup(path);
+  file->fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+  if (file->fd < 0)
+    ereport(ERROR,
+        (errcode_for_file_access(),
+         errmsg("could not open file \"%s\" for reading: %m", path)));
+
+  file->cdata = palloc(BGZF_BLOCK_SIZE);
+  file->udata = palloc(BGZF_BLOCK_SIZE);
+  file->block = -1;
+
+  file->zs.zalloc = bgzf_zalloc;
+  file->zs.zfree = bgzf_zfree;
+  file->zs.opaque = CurrentMemoryContext;
+  /* raw deflate data: the reader checks the gzip header itself */
+  if (inflateInit2(&file->zs, -MAX_WBITS) != Z_OK)
+    ereport(ERROR,
+        (errcode(ERRCODE_OUT_OF_MEMORY),
+         errmsg("could not initialize decompression of file \"%s\"", path)));
+
+  return file;
+}
+
+static void
+bgzf_close(BgzfFile *file)
+{
+  inflateEnd(&file->zs);
+  CloseTransientFile(file->fd);
+}
+
+static int
+bgzf_pread(BgzfFile *file, void *buf, int len, off_t offset)
+{
+  int         n = pread(file->fd, buf, len, offset);
+
+  if (n < 0)
+    ereport(ERROR,
+        (errcode_for_file_access(),
+         errmsg("could not read file \"%s\": %m", file->path)));
+
+  return n;
+}
+
+/*
+ * Read and inflate the block at offset; return false at the end of the file
+ */
+static bool
+bgzf_load(BgzfFile *file, off_t offset)
+{
+  uint8      *h = file->cdata;
+  int         bsize;
+  int         n;
+  uint32      crc;
+  uint32      isize;
+
+  file->block = offset;
+  file->ulen = file->upos = 0;
+
+  n = bgzf_pread(file, h, BGZF_HEADER_SIZE, offset);
+  if (n == 0)
+  {
+    file->next = offset;
+    return false;
+  }
+
+  /* a gzip member with one extra subfield, BC, holding the block size - 1 */
+  if (n < BGZF_HEADER_SIZE || h[0] != 31 || h[1] != 139 || h[2] != 8 ||
+      (h[3] & 4) == 0 || (h[10] | h[11] << 8) != 6 ||
+      h[12] != 'B' || h[13] != 'C' || (h[14] | h[15] << 8) != 2)
+    bgzf_corrupt(file);
+
+  bsize = (h[16] | h[17] << 8) + 1;
+  if (bsize < BGZF_HEADER_SIZE + BGZF_FOOTER_SIZE ||
+      bgzf_pread(file, h + BGZF_HEADER_SIZE, bsize - BGZF_HEADER_SIZE,
+                 offset + BGZF_HEADER_SIZE) != bsize - BGZF_HEADER_SIZE)
+    bgzf_corrupt(file);
+
+  if (inflateReset(&file->zs) != Z_OK)
+    bgzf_corrupt(file);
+  file->zs.next_in = h + BGZF_HEADER_SIZE;
+  file->zs.avail_in = bsize - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+  file->zs.next_out = (Bytef *) file->udata;
+  file->zs.avail_out = BGZF_BLOCK_SIZE;
+  if (inflate(&file->zs, Z_FINISH) != Z_STREAM_END)
+    bgzf_corrupt(file);
+
+  file->ulen = BGZF_BLOCK_SIZE - file->zs.avail_out;
+
+  h += bsize - BGZF_FOOTER_SIZE;
+  crc = h[0] | h[1] << 8 | h[2] << 16 | (uint32) h[3] << 24;
+  isize = h[4] | h[5] << 8 | h[6] << 16 | (uint32) h[7] << 24;
+  if (isize != file->ulen || crc != crc32(0, (Bytef *) file->udata, file->ulen))
+    bgzf_corrupt(file);
+
+  file->next = offset + bsize;
+  file->nblocks++;
+
+  return true;
+}
+
+/*
+ * Move to a virtual offset
+ */
+static void
+bgzf_seek(BgzfFile *file, uint64 voffset)
+{
+  off_t       offset = BGZF_COFFSET(voffset);
+
+  if (offset != file->block)
+    bgzf_load(file, offset);
+  if (BGZF_UOFFSET(voffset) > file->ulen)
+    bgzf_corrupt(file);
+  file->upos = BGZF_UOFFSET(voffset);
+}
+
+static uint64
+bgzf_tell(BgzfFile *file)
+{
+  return (uint64) file->block << 16 | file->upos;
+}
+
+/*
+ * Skip to data not yet read, past the end of the block and any empty blocks;
+ * return false at the end of the file
+ */
+static bool
+bgzf_fill(BgzfFile *file)
+{
+  while (file->upos == file->ulen)
+  {
+    if (!bgzf_load(file, file->block < 0 ? 0 : file->next))
+      return false;
+  }
+
+  return true;
+}
+
+/*
+ * Read the next line into line, without its line ending, and set voffset to
+ * its start; return false at the end of the file
+ */
+static bool
+bgzf_readline(BgzfFile *file, StringInfo line, uint64 *voffset)
+{
+  resetStringInfo(line);
+
+  if (!bgzf_fill(file))
+    return false;
+  *voffset = bgzf_tell(file);
+
+  for (;;)
+  {
+    char       *data = file->udata + file->upos;
+    int         len = file->ulen - file->upos;
+    char       *nl = memchr(data, '\n', len);
+
+    if (nl != NULL)
+    {
+      appendBinaryStringInfo(line, data, nl - data);
+      file->upos += nl - data + 1;
+      break;
+    }
+
+    appendBinaryStringInfo(line, data, len);
+    file->upos = file->ulen;
+    if (!bgzf_fill(file))
+      break;
+  }
+
+  if (line->len > 0 && line->data[line->len - 1] == '\r')
+    line->data[--line->len] = '\0';
+
+  return true;
+}
+
+
+/*****************************************************************************
+ * Tabix index
+ *****************************************************************************/
+
+/* format */
+#define TABIX_GENERIC  0
+#define TABIX_SAM      1
+#define TABIX_VCF      2
+#define TABIX_UCSC     0x10000  /* 0-based, half-open coordinates */
+
+/* the binning scheme: 6 levels of bins, from 512 Mb down to 16 kb */
+#define TABIX_MIN_SHIFT  14
+#define TABIX_LEVELS     5
+#define TABIX_MAX_BIN    37448
+#define TABIX_META_BIN   37450  /* pseudo-bin counting the records */
+#define TABIX_MAX_POS    (1 << 29)
+
+typedef struct TabixChunk
+{
+  uint64      beg;          /* virtual offsets */
+  uint64      end;
+} TabixChunk;
+
+typedef struct TabixBin
+{
+  uint32      bin;
+  int32       nchunks;
+  TabixChunk *chunks;
+} TabixBin;
+
+typedef struct TabixRef
+{
+  const char *name;         /* as in the file */
+  const char *contig;       /* without "chr", as a locus has it */
+  int32       nbins;
+  TabixBin   *bins;
+  int32       nintervals;
+  uint64     *intervals;    /* linear index: first record in each window */
+  int64       nrecords;     /* from the pseudo-bin, or -1 */
+} TabixRef;
+
+typedef struct TabixIndex
+{
+  MemoryContext cxt;
+  char       *path;
+  time_t      mtime;
+  off_t       size;
+  int32       format;
+  int32       col_seq;      /* 1-based columns */
+  int32       col_beg;
+  int32       col_end;      /* 0 for none */
+  char        meta;         /* header lines start with this */
+  int32       skip;         /* header lines at the start of the file */
+  int32       nrefs;
+  TabixRef   *refs;
+  int64       nrecords;     /* in all contigs, or -1 */
+  double      block_bytes;  /* the mean size of a compressed block */
+  struct TabixIndex *next;  /* in the cache */
+} TabixIndex;
+
+/* the indexes read by this backend */
+static TabixIndex *tabix_cache = NULL;
+
+typedef struct TabixReader
+{
+  const char *path;
+  const uint8 *p;
+  const uint8 *end;
+} TabixReader;
+
+static void
+tabix_corrupt(TabixReader *r)
+{
+  ereport(ERROR,
+      (errcode(ERRCODE_DATA_CORRUPTED),
+       errmsg("invalid tabix index \"%s\"", r->path)));
+}
+
+static const uint8 *
+tabix_bytes(TabixReader *r, int64 len)
+{
+  const uint8 *p = r->p;
+
+  if (len < 0 || len > r->end - r->p)
+    tabix_corrupt(r);
+  r->p += len;
+
+  return p;
+}
+
+static int32
+tabix_int32(TabixReader *r)
+{
+  const uint8 *p = tabix_bytes(r, 4);
+
+  return (int32) (p[0] | p[1] << 8 | p[2] << 16 | (uint32) p[3] << 24);
+}
+
+static uint64
+tabix_uint64(TabixReader *r)
+{
+  const uint8 *p = tabix_bytes(r, 8);
+  uint64      v = 0;
+  int         i;
+
+  for (i = 7; i >= 0; i--)
+    v = v << 8 | p[i];
+
+  return v;
+}
+
+static int
+tabix_bin_cmp(const void *a, const void *b)
+{
+  uint32      x = ((const TabixBin *) a)->bin;
+  uint32      y = ((const TabixBin *) b)->bin;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+ * Read an index into the current memory context
+ */
+static void
+tabix_read(TabixIndex *index)
+{
+  BgzfFile   *file = bgzf_open(index->path);
+  StringInfoData data;
+  TabixReader r;
+  int32       len;
+  const char *names;
+  uint64      first = 0;
+  uint64      last = 0;
+  int64       nblocks = 0;
+  int         i;
+
+  initStringInfo(&data);
+  while (bgzf_fill(file))
+  {
+    appendBinaryStringInfo(&data, file->udata, file->ulen);
+    file->upos = file->ulen;
+  }
+  bgzf_close(file);
+
+  r.path = index->path;
+  r.p = (const uint8 *) data.data;
+  r.end = r.p + data.len;
+
+  if (memcmp(tabix_bytes(&r, 4), "TBI\1", 4) != 0)
+    tabix_corrupt(&r);
+
+  index->nrefs = tabix_int32(&r);
+  index->format = tabix_int32(&r);
+  index->col_seq = tabix_int32(&r);
+  index->col_beg = tabix_int32(&r);
+  index->col_end = tabix_int32(&r);
+  index->meta = (char) tabix_int32(&r);
+  index->skip = tabix_int32(&r);
+  len = tabix_int32(&r);
+  names = (const char *) tabix_bytes(&r, len);
+
+  if (index->nrefs < 0 || index->col_seq < 1 || index->col_beg < 1 || index->col_end < 0 ||
+      (len > 0 && names[len - 1] != '\0'))
+    tabix_corrupt(&r);
+  if ((index->format & 0xffff) == TABIX_SAM)
+    ereport(ERROR,
+        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+         errmsg("tabix index \"%s\" is for a SAM file, which locus_fdw does not read",
+                index->path)));
+
+  index->refs = (TabixRef *) palloc0(Max(index->nrefs, 1) * sizeof(TabixRef));
+  index->nrecords = 0;
+
+  for (i = 0; i < index->nrefs; i++)
+  {
+    TabixRef   *ref = &index->refs[i];
+    int32       nbins;
+    int         j;
+
+    if (names >= (const char *) r.p)
+      tabix_corrupt(&r);
+    ref->name = names;
+    names += strlen(names) + 1;
+    ref->contig = ref->name;
+    if (strlen(ref->name) > 3 && strncmp(ref->name, "chr", 3) == 0)
+      ref->contig += 3;
+
+    nbins = tabix_int32(&r);
+    if (nbins < 0 || (int64) nbins * 8 > r.end - r.p)
+      tabix_corrupt(&r);
+    ref->bins = (TabixBin *) palloc(Max(nbins, 1) * sizeof(TabixBin));
+    ref->nrecords = -1;
+
+    for (j = 0; j < nbins; j++)
+    {
+      uint32      bin = (uint32) tabix_int32(&r);
+      int32       nchunks = tabix_int32(&r);
+      int         k;
+
+      if (nchunks < 0 || (int64) nchunks * 16 > r.end - r.p)
+        tabix_corrupt(&r);
+
+      if (bin == TABIX_META_BIN)
+      {
+        /* (first, last offset), (mapped, unmapped records) */
+        if (nchunks == 2)
+        {
+          tabix_uint64(&r);
+          tabix_uint64(&r);
+          ref->nrecords = (int64) tabix_uint64(&r) + (int64) tabix_uint64(&r);
+        }
+        else
+          r.p += (int64) nchunks * 16;
+        continue;
+      }
+
+      ref->bins[ref->nbins].bin = bin;
+      ref->bins[ref->nbins].nchunks = nchunks;
+      ref->bins[ref->nbins].chunks = (TabixChunk *) palloc(Max(nchunks, 1) * sizeof(TabixChunk));
+      for (k = 0; k < nchunks; k++)
+      {
+        ref->bins[ref->nbins].chunks[k].beg = tabix_uint64(&r);
+        ref->bins[ref->nbins].chunks[k].end = tabix_uint64(&r);
+      }
+      ref->nbins++;
+    }
+    qsort(ref->bins, ref->nbins, sizeof(TabixBin), tabix_bin_cmp);
+
+    ref->nintervals = tabix_int32(&r);
+    if (ref->nintervals < 0 || (int64) ref->nintervals * 8 > r.end - r.p)
+      tabix_corrupt(&r);
+    ref->intervals = (uint64 *) palloc(Max(ref->nintervals, 1) * sizeof(uint64));
+    for (j = 0; j < ref->nintervals; j++)
+    {
+      ref->intervals[j] = tabix_uint64(&r);
+
+      /* count the blocks where windows start */
+      if (nblocks == 0 || BGZF_COFFSET(ref->intervals[j]) != last)
+      {
+        if (nblocks++ == 0)
+          first = BGZF_COFFSET(ref->intervals[j]);
+        last = BGZF_COFFSET(ref->intervals[j]);
+      }
+    }
+
+    if (ref->nrecords < 0 || index->nrecords < 0)
+      index->nrecords = -1;
+    else
+      index->nrecords += ref->nrecords;
+  }
+
+  /* windows start in most blocks of a file with records all along */
+  index->block_bytes = nblocks > 1
+    ? Min((double) (last - first) / (nblocks - 1), BGZF_BLOCK_SIZE)
+    : BGZF_BLOCK_SIZE / 4;
+}
+
+/*
+ * The index at path, from the cache if it has not changed since it was read
+ */
+static TabixIndex *
+tabix_index(const char *path)
+{
+  struct stat st;
+  MemoryContext cxt;
+  MemoryContext oldcontext;
+  TabixIndex *index;
+  TabixIndex **prev;
+
+  if (stat(path, &st) < 0)
+    ereport(ERROR,
+        (errcode_for_file_access(),
+         errmsg("could not stat file \"%s\": %m", path)));
+
+  for (prev = &tabix_cache; *prev != NULL; prev = &(*prev)->next)
+  {
+    index = *prev;
+    if (strcmp(index->path, path) != 0)
+      continue;
+    if (index->mtime == st.st_mtime && index->size == st.st_size)
+      return index;
+
+    /*
+     * The file has changed.  A scan of this transaction may still read the
+     * old index, so it goes away with the transaction.
+     */
+    *prev = index->next;
+    MemoryContextSetParent(index->cxt, TopTransactionContext);
+    break;
+  }
+
+  /* read it in a context of its own, which is kept once it is complete */
+  cxt = AllocSetContextCreate(CurrentMemoryContext, "locus_fdw index",
+                              ALLOCSET_DEFAULT_SIZES);
+  oldcontext = MemoryContextSwitchTo(cxt);
+
+  index = (TabixIndex *) palloc0(sizeof(TabixIndex));
+  index->cxt = cxt;
+  index->path = pstrdup(path);
+  index->mtime = st.st_mtime;
+  index->size = st.st_size;
+  tabix_read(index);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  MemoryContextSetParent(cxt, CacheMemoryContext);
+  index->next = tabix_cache;
+  tabix_cache = index;
+
+  return index;
+}
+
+static int
+tabix_chunk_cmp(const void *a, const void *b)
+{
+  uint64      x = ((const TabixChunk *) a)->beg;
+  uint64      y = ((const TabixChunk *) b)->beg;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+ * The chunks of ref that may hold records overlapping [beg, end), 0-based,
+ * in the order of the file and merged where they share a block; return their
+ * number
+ */
+static int
+tabix_chunks(TabixRef *ref, int32 beg, int32 end, TabixChunk **result)
+{
+  static const int shifts[TABIX_LEVELS + 1] = {29, 26, 23, 20, 17, 14};
+  TabixChunk *chunks;
+  int         nchunks = 0;
+  uint64      min_offset = 0;
+  int         total = 0;
+  int         i;
+  int         j;
+
+  end = Min(end, TABIX_MAX_POS);
+  beg = Max(beg, 0);
+  if (beg >= end)
+  {
+    *result = NULL;
+    return 0;
+  }
+
+  /* records starting before this one end before the region */
+  if (ref->nintervals > 0)
+    min_offset = ref->intervals[Min(beg >> TABIX_MIN_SHIFT, ref->nintervals - 1)];
+
+  for (i = 0; i < ref->nbins; i++)
+    total += ref->bins[i].nchunks;
+  chunks = (TabixChunk *) palloc(Max(total, 1) * sizeof(TabixChunk));
+
+  for (i = 0; i < ref->nbins; i++)
+  {
+    TabixBin   *bin = &ref->bins[i];
+    int         level;
+    int         first = 0;
+    int64       lower;
+    int64       upper;
+
+    if (bin->bin > TABIX_MAX_BIN)
+      continue;
+
+    /* bins on level l are numbered from (8^l - 1) / 7 */
+    for (level = 0; level < TABIX_LEVELS; level++)
+    {
+      int         next = first + (1 << (3 * level));
+
+      if (bin->bin < next)
+        break;
+      first = next;
+    }
+
+    lower = (int64) (bin->bin - first) << shifts[level];
+    upper = lower + ((int64) 1 << shifts[level]);
+    if (upper <= beg || lower >= end)
+      continue;
+
+    for (j = 0; j < bin->nchunks; j++)
+      if (bin->chunks[j].end > min_offset)
+        chunks[nchunks++] = bin->chunks[j];
+  }
+
+  if (nchunks > 1)
+  {
+    qsort(chunks, nchunks, sizeof(TabixChunk), tabix_chunk_cmp);
+
+    /* chunks in the same block take no seek of their own */
+    for (i = 0, j = 1; j < nchunks; j++)
+    {
+      if (BGZF_COFFSET(chunks[j].beg) <= BGZF_COFFSET(chunks[i].end))
+        chunks[i].end = Max(chunks[i].end, chunks[j].end);
+      else
+        chunks[++i] = chunks[j];
+    }
+    nchunks = i + 1;
+  }
+
+  *result = chunks;
+  return nchunks;
+}
+
+/*
+ * Does ref hold the contig of region?
+ */
+static bool
+tabix_ref_matches(TabixRef *ref, LOCUS *region, bool any_contig)
+{
+  return any_contig || strnatcmp(ref->contig, locus_contig_name(region)) == 0;
+}
+
+
+/*****************************************************************************
+ * Options
+ *****************************************************************************/
+
+typedef struct LocusFdwOption
+{
+  const char *name;
+  Oid         context;
+} LocusFdwOption;
+
+static const LocusFdwOption locus_fdw_options[] = {
+  {"filename", ForeignTableRelationId},
+  {"index", ForeignTableRelationId},
+  {"field", AttributeRelationId},
+  {NULL, InvalidOid}
+};
+
+/* a column that gets the region of the record, not a field */
+#define LOCUS_FDW_REGION  (-1)
+/* a dropped column */
+#define LOCUS_FDW_NONE    (-2)
+
+Datum
+locus_fdw_validator(PG_FUNCTION_ARGS)
+{
+  List       *options = untransformRelOptions(PG_GETARG_DATUM(0));
+  Oid         catalog = PG_GETARG_OID(1);
+  char       *filename = NULL;
+  char       *indexname = NULL;
+  ListCell   *cell;
+
+  foreach(cell, options)
+  {
+    DefElem    *def = (DefElem *) lfirst(cell);
+    const LocusFdwOption *opt;
+
+    for (opt = locus_fdw_options; opt->name; opt++)
+      if (opt->context == catalog && strcmp(opt->name, def->defname) == 0)
+        break;
+
+    if (opt->name == NULL)
+    {
+      StringInfoData buf;
+
+      initStringInfo(&buf);
+      for (opt = locus_fdw_options; opt->name; opt++)
+        if (opt->context == catalog)
+          appendStringInfo(&buf, "%s%s", buf.len > 0 ? ", " : "", opt->name);
+
+      ereport(ERROR,
+          (errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+           errmsg("invalid option \"%s\"", def->defname),
+           buf.len > 0
+           ? errhint("Valid options in this context are: %s", buf.data)
+           : errhint("There are no valid options in this context.")));
+    }
+
+    if (strcmp(def->defname, "filename") == 0 || strcmp(def->defname, "index") == 0)
+    {
+      char      **value = strcmp(def->defname, "filename") == 0 ? &filename : &indexname;
+
+      /* the files are read as the server, whoever queries the table */
+      if (!has_privs_of_role(GetUserId(), ROLE_PG_READ_SERVER_FILES))
+        ereport(ERROR,
+            (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+             errmsg("permission denied to set the \"%s\" option of a locus_fdw foreign table",
+                    def->defname),
+             errdetail("Only roles with privileges of the \"%s\" role may set this option.",
+                       "pg_read_server_files")));
+
+      if (*value != NULL)
+        ereport(ERROR,
+            (errcode(ERRCODE_SYNTAX_ERROR),
+             errmsg("conflicting or redundant options")));
+      *value = defGetString(def);
+    }
+    else if (strcmp(def->defname, "field") == 0)
+    {
+      char       *value = defGetString(def);
+      char       *end;
+      long        field = strtol(value, &end, 10);
+
+      if (*value == '\0' || *end != '\0' || field < 1 || field > INT_MAX)
+        ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("invalid value for option \"field\": \"%s\"", value),
+             errhint("Fields are numbered from 1.")));
+    }
+  }
+
+  if (catalog == ForeignTableRelationId && filename == NULL)
+    ereport(ERROR,
+        (errcode(ERRCODE_FDW_OPTION_NAME_NOT_FOUND),
+         errmsg("filename is required for locus_fdw foreign tables")));
+
+  PG_RETURN_VOID();
+}
+
+/*
+ * The files of a foreign table
+ */
+static void
+locus_fdw_files(Oid relid, char **filename, char **indexname)
+{
+  ForeignTable *table = GetForeignTable(relid);
+  ListCell   *cell;
+
+  *filename = NULL;
+  *indexname = NULL;
+
+  foreach(cell, table->options)
+  {
+    DefElem    *def = (DefElem *) lfirst(cell);
+
+    if (strcmp(def->defname, "filename") == 0)
+      *filename = defGetString(def);
+    else if (strcmp(def->defname, "index") == 0)
+      *indexname = defGetString(def);
+  }
+
+  if (*filename == NULL)
+    elog(ERROR, "filename is required for locus_fdw foreign tables");
+  if (*indexname == NULL)
+    *indexname = psprintf("%s.tbi", *filename);
+}
+
+/*
+ * The field option of a column, 0-based, or -1
+ */
+static int
+locus_fdw_column_field(Oid relid, AttrNumber attnum)
+{
+  ListCell   *cell;
+
+  foreach(cell, GetForeignColumnOptions(relid, attnum))
+  {
+    DefElem    *def = (DefElem *) lfirst(cell);
+
+    if (strcmp(def->defname, "field") == 0)
+      return atoi(defGetString(def)) - 1;
+  }
+
+  return -1;
+}
+
+static Oid
+locus_fdw_locus_type(void)
+{
+  Oid         nspid = get_extension_schema(get_extension_oid("locus", false));
+
+  return GetSysCacheOid2(TYPENAMENSP, Anum_pg_type_oid,
+                         CStringGetDatum("locus"), ObjectIdGetDatum(nspid));
+}
+
+
+/*****************************************************************************
+ * Planning
+ *****************************************************************************/
+
+/*
+ * The default density of records, when the index does not count them: a
+ * line of BED or VCF deflates to a few dozen bytes
+ */
+#define LOCUS_FDW_BYTES_PER_RECORD  16.0
+
+typedef struct LocusFdwPlanState
+{
+  char       *filename;
+  char       *indexname;
+  double      filesize;
+  double      records_per_byte;
+  Const      *region;       /* the constant of the pushed qual, or NULL */
+  bool        any_contig;   /* does its wildcard count? */
+  RestrictInfo *pushed;
+  double      bytes;        /* compressed bytes to read */
+  double      nchunks;      /* seeks */
+} LocusFdwPlanState;
+
+/*
+ * The compressed bytes and the chunks a scan of region reads
+ */
+static void
+locus_fdw_region_size(TabixIndex *index, LOCUS *region, bool any_contig,
+                      double *bytes, double *nchunks)
+{
+  int         i;
+
+  *bytes = 0;
+  *nchunks = 0;
+
+  for (i = 0; i < index->nrefs; i++)
+  {
+    TabixChunk *chunks;
+    int         n;
+    int         j;
+
+    if (!tabix_ref_matches(&index->refs[i], region, any_contig))
+      continue;
+
+    n = tabix_chunks(&index->refs[i], region->lower - 1, region->upper, &chunks);
+    for (j = 0; j < n; j++)
+      /* the last block of a chunk is read to its end */
+      *bytes += BGZF_COFFSET(chunks[j].end) - BGZF_COFFSET(chunks[j].beg) + index->block_bytes;
+    *nchunks += n;
+    if (chunks != NULL)
+      pfree(chunks);
+  }
+}
+
+/*
+ * If clause is locus_column OP constant, or the other way around, with OP
+ * one of &&, <@ and @>, set region to the constant and any_contig to whether
+ * the clause would match rows on any contig for a wildcard constant
+ */
+static bool
+locus_fdw_pushable(Oid relid, Index varno, Oid locus_type, Expr *clause,
+                   Const **region, bool *any_contig)
+{
+  OpExpr     *op = (OpExpr *) clause;
+  Node       *left;
+  Node       *right;
+  Var        *var;
+  Const      *value;
+  bool        var_left;
+  char       *opname;
+  Oid         lefttype;
+  Oid         righttype;
+
+  if (!IsA(clause, OpExpr) || list_length(op->args) != 2)
+    return false;
+
+  op_input_types(op->opno, &lefttype, &righttype);
+  if (lefttype != locus_type || righttype != locus_type)
+    return false;
+
+  left = (Node *) linitial(op->args);
+  right = (Node *) lsecond(op->args);
+  var_left = IsA(left, Var);
+  var = (Var *) (var_left ? left : right);
+  value = (Const *) (var_left ? right : left);
+
+  if (!IsA(var, Var) || !IsA(value, Const) || value->constisnull ||
+      var->varno != varno || var->varlevelsup != 0 || var->varattno <= 0 ||
+      locus_fdw_column_field(relid, var->varattno) >= 0)
+    return false;
+
+  opname = get_opname(op->opno);
+  if (opname == NULL)
+    return false;
+
+  /*
+   * A record overlaps the constant in every case.  The wildcard of a locus
+   * counts when it is the left operand of &&, or the one that contains.
+   */
+  if (strcmp(opname, "&&") == 0)
+    *any_contig = !var_left;
+  else if (strcmp(opname, "<@") == 0)
+    *any_contig = var_left;
+  else if (strcmp(opname, "@>") == 0)
+    *any_contig = !var_left;
+  else
+    return false;
+
+  *any_contig = *any_contig && LOCUS_IS_WILDCARD(DatumGetLocusP(value->constvalue));
+  *region = value;
+
+  return true;
+}
+
+static void
+locus_fdw_get_rel_size(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+  LocusFdwPlanState *state = (LocusFdwPlanState *) palloc0(sizeof(LocusFdwPlanState));
+  TabixIndex *index;
+  struct stat st;
+  Oid         locus_type = locus_fdw_locus_type();
+  List       *other = NIL;
+  double      nrecords;
+  ListCell   *lc;
+
+  baserel->fdw_private = state;
+  locus_fdw_files(foreigntableid, &state->filename, &state->indexname);
+  index = tabix_index(state->indexname);
+
+  /* as file_fdw does, assume 10 pages if the file is not there yet */
+  state->filesize = stat(state->filename, &st) < 0 ? 10 * BLCKSZ : Max(st.st_size, 1);
+  state->records_per_byte = index->nrecords >= 0
+    ? index->nrecords / state->filesize
+    : 1.0 / LOCUS_FDW_BYTES_PER_RECORD;
+
+  state->bytes = state->filesize;
+  state->nchunks = 1;
+
+  /* push down the qual that reads the least */
+  foreach(lc, baserel->baserestrictinfo)
+  {
+    RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+    Const      *region;
+    bool        any_contig;
+    double      bytes;
+    double      nchunks;
+
+    if (!locus_fdw_pushable(foreigntableid, baserel->relid, locus_type,
+                            rinfo->clause, &region, &any_contig))
+      continue;
+
+    locus_fdw_region_size(index, DatumGetLocusP(region->constvalue), any_contig,
+                          &bytes, &nchunks);
+    bytes = Min(bytes, state->filesize);
+    if (state->pushed == NULL || bytes < state->bytes)
+    {
+      state->pushed = rinfo;
+      state->region = region;
+      state->any_contig = any_contig;
+      state->bytes = bytes;
+      state->nchunks = nchunks;
+    }
+  }
+
+  foreach(lc, baserel->baserestrictinfo)
+    if (lfirst(lc) != state->pushed)
+      other = lappend(other, lfirst(lc));
+
+  baserel->tuples = clamp_row_est(state->filesize * state->records_per_byte);
+  nrecords = state->bytes * state->records_per_byte;
+  baserel->rows = clamp_row_est(nrecords * clauselist_selectivity(root, other, baserel->relid,
+                                                                  JOIN_INNER, NULL));
+}
+
+static void
+locus_fdw_get_paths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+  LocusFdwPlanState *state = (LocusFdwPlanState *) baserel->fdw_private;
+  Cost        startup_cost;
+  Cost        run_cost;
+  Cost        cpu_per_tuple;
+
+  /* inflating and splitting lines costs about what COPY does */
+  startup_cost = baserel->baserestrictcost.startup;
+  run_cost = seq_page_cost * ceil(state->bytes / BLCKSZ);
+  if (state->pushed != NULL)
+    run_cost += random_page_cost * state->nchunks;
+  cpu_per_tuple = cpu_tuple_cost * 10 + baserel->baserestrictcost.per_tuple;
+  run_cost += cpu_per_tuple * state->bytes * state->records_per_byte;
+
+  add_path(baserel, (Path *)
+           create_foreignscan_path(root, baserel, NULL, baserel->rows,
+                                   startup_cost, startup_cost + run_cost,
+                                   NIL, baserel->lateral_relids, NULL, NIL, NIL));
+}
+
+static ForeignScan *
+locus_fdw_get_plan(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid,
+                   ForeignPath *best_path, List *tlist, List *scan_clauses, Plan *outer_plan)
+{
+  LocusFdwPlanState *state = (LocusFdwPlanState *) baserel->fdw_private;
+  List       *fdw_private = NIL;
+
+  /* every qual is checked again on the rows of the region */
+  scan_clauses = extract_actual_clauses(scan_clauses, false);
+
+  if (state->pushed != NULL)
+    fdw_private = list_make2(copyObject(state->region), makeBoolean(state->any_contig));
+
+  return make_foreignscan(tlist, scan_clauses, baserel->relid, NIL, fdw_private,
+                          NIL, NIL, outer_plan);
+}
+
+
+/*****************************************************************************
+ * Execution
+ *****************************************************************************/
+
+typedef struct LocusFdwScanState
+{
+  char       *filename;
+  MemoryContext cxt;        /* lasts as long as the scan */
+  TabixIndex *index;
+  BgzfFile   *file;
+  StringInfoData line;
+  char      **fields;
+  int         maxfields;
+
+  /* the region of the pushed qual; a scan of the whole file without one */
+  LOCUS      *region;
+  bool        any_contig;
+  int32       beg;          /* 0-based, half-open */
+  int32       end;
+
+  /* where the scan is */
+  int         ref;          /* index of the contig being read */
+  TabixChunk *chunks;       /* its chunks */
+  int         nchunks;
+  int         chunk;        /* the chunk being read, or nchunks */
+  bool        in_chunk;
+  int64       lineno;       /* lines read, in a scan of the whole file */
+
+  /* records on contigs a locus cannot hold are passed over, and counted */
+  char       *contig;       /* the last contig checked */
+  bool        contig_valid;
+  int64       nskipped;     /* over every rescan */
+
+  /* columns */
+  int        *fieldmap;     /* for each column: a field, or LOCUS_FDW_REGION */
+  FmgrInfo   *in_functions;
+  Oid        *typioparams;
+} LocusFdwScanState;
+
+static void
+locus_fdw_rewind(LocusFdwScanState *state)
+{
+  state->ref = -1;
+  state->nchunks = state->chunk = 0;
+  state->in_chunk = false;
+  state->lineno = 0;
+  if (state->chunks != NULL)
+    pfree(state->chunks);
+  state->chunks = NULL;
+}
+
+static void
+locus_fdw_begin(ForeignScanState *node, int eflags)
+{
+  ForeignScan *plan = (ForeignScan *) node->ss.ps.plan;
+  Relation    rel = node->ss.ss_currentRelation;
+  TupleDesc   tupdesc = RelationGetDescr(rel);
+  Oid         locus_type = locus_fdw_locus_type();
+  LocusFdwScanState *state;
+  char       *indexname;
+  int         next = 0;
+  int         i;
+
+  state = (LocusFdwScanState *) palloc0(sizeof(LocusFdwScanState));
+  state->cxt = node->ss.ps.state->es_query_cxt;
+  node->fdw_state = state;
+
+  locus_fdw_files(RelationGetRelid(rel), &state->filename, &indexname);
+
+  if (plan->fdw_private != NIL)
+  {
+    Const      *region = (Const *) linitial(plan->fdw_private);
+
+    state->region = DatumGetLocusP(region->constvalue);
+    state->any_contig = boolVal(lsecond(plan->fdw_private));
+    state->beg = Max(state->region->lower - 1, 0);
+    state->end = state->region->upper;
+  }
+
+  if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+    return;
+
+  state->index = tabix_index(indexname);
+  state->file = bgzf_open(state->filename);
+  initStringInfo(&state->line);
+  state->maxfields = 16;
+  state->fields = (char **) palloc(state->maxfields * sizeof(char *));
+
+  state->fieldmap = (int *) palloc(tupdesc->natts * sizeof(int));
+  state->in_functions = (FmgrInfo *) palloc(tupdesc->natts * sizeof(FmgrInfo));
+  state->typioparams = (Oid *) palloc(tupdesc->natts * sizeof(Oid));
+
+  /* fields go to the columns in order, from the last one a column names */
+  for (i = 0; i < tupdesc->natts; i++)
+  {
+    Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+    int         field;
+    Oid         in_func;
+
+    if (att->attisdropped)
+    {
+      state->fieldmap[i] = LOCUS_FDW_NONE;
+      continue;
+    }
+
+    field = locus_fdw_column_field(RelationGetRelid(rel), att->attnum);
+    if (field < 0 && att->atttypid == locus_type)
+    {
+      state->fieldmap[i] = LOCUS_FDW_REGION;
+      continue;
+    }
+
+    state->fieldmap[i] = field >= 0 ? field : next;
+    next = state->fieldmap[i] + 1;
+
+    getTypeInputInfo(att->atttypid, &in_func, &state->typioparams[i]);
+    fmgr_info(in_func, &state->in_functions[i]);
+  }
+
+  locus_fdw_rewind(state);
+}
+
+static void
+locus_fdw_corrupt(LocusFdwScanState *state, const char *what, const char *value)
+{
+  ereport(ERROR,
+      (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+       errmsg("invalid %s \"%s\" in file \"%s\"", what, value, state->filename)));
+}
+
+/*
+ * Convert a position field: a number from 0 to INT_MAX
+ */
+static int32
+locus_fdw_position(LocusFdwScanState *state, const char *what, const char *value)
+{
+  const char *p = value;
+  int64       val = 0;
+
+  if (*p == '\0')
+    locus_fdw_corrupt(state, what, value);
+
+  for (; *p; p++)
+  {
+    if (*p < '0' || *p > '9')
+      locus_fdw_corrupt(state, what, value);
+    val = val * 10 + (*p - '0');
+    if (val > INT_MAX)
+      locus_fdw_corrupt(state, what, value);
+  }
+
+  return (int32) val;
+}
+
+/*
+ * Split a line at its tabs, in place, and return the number of fields
+ */
+static int
+locus_fdw_split(LocusFdwScanState *state, char *line)
+{
+  int         nfields = 0;
+
+  for (;;)
+  {
+    char       *tab = strchr(line, '\t');
+
+    if (nfields == state->maxfields)
+    {
+      state->maxfields *= 2;
+      state->fields = (char **) repalloc(state->fields, state->maxfields * sizeof(char *));
+    }
+
+    state->fields[nfields++] = line;
+    if (tab == NULL)
+      return nfields;
+    *tab = '\0';
+    line = tab + 1;
+  }
+}
+
+/*
+ * The contig and the 0-based, half-open region of a record, read the way
+ * tabix does
+ */
+static void
+locus_fdw_record(LocusFdwScanState *state, int nfields, const char **seq,
+                 int32 *beg, int32 *end)
+{
+  TabixIndex *index = state->index;
+  char      **f = state->fields;
+  int         format = index->format & 0xffff;
+  int         ncols = Max(index->col_seq, Max(index->col_beg, index->col_end));
+
+  if (format == TABIX_VCF)
+    ncols = Max(ncols, 8);
+  if (nfields < ncols)
+    ereport(ERROR,
+        (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+         errmsg("record with fewer than %d columns in file \"%s\"", ncols, state->filename)));
+
+  *seq = f[index->col_seq - 1];
+  *beg = locus_fdw_position(state, "start", f[index->col_beg - 1]);
+  if ((index->format & TABIX_UCSC) == 0)
+    *beg = Max(*beg - 1, 0);
+
+  if (format == TABIX_VCF)
+  {
+    /* the reference allele, or the bases up to END */
+    const char *p = f[7];
+
+    *end = *beg + strlen(f[3]);
+    while (p != NULL && *p)
+    {
+      if (strncmp(p, "END=", 4) == 0)
+      {
+        const char *value = p + 4;
+        const char *sep = strchr(value, ';');
+
+        *end = locus_fdw_position(state, "END",
+                                  sep ? pnstrdup(value, sep - value) : value);
+        break;
+      }
+      p = strchr(p, ';');
+      if (p != NULL)
+        p++;
+    }
+  }
+  else if (index->col_end > 0)
+    *end = locus_fdw_position(state, "end", f[index->col_end - 1]);
+  else
+    *end = *beg + 1;
+
+  /* a feature of no length, such as an insertion point, takes the base after it */
+  if (*end <= *beg)
+    *end = *beg + 1;
+}
+
+/*
+ * Whether a locus can hold the contig of a record.  Records come grouped by
+ * contig, so the answer for the last one is kept.
+ */
+static bool
+locus_fdw_contig_valid(LocusFdwScanState *state, const char *seq)
+{
+  if (state->contig == NULL || strcmp(state->contig, seq) != 0)
+  {
+    if (state->contig != NULL)
+      pfree(state->contig);
+    state->contig = MemoryContextStrdup(state->cxt, seq);
+    state->contig_valid = locus_name_valid(seq, strlen(seq));
+  }
+
+  return state->contig_valid;
+}
+
+/*
+ * Read the next record in the scan into state->fields; return the number of
+ * fields and set the region of the record, or return 0 at the end
+ */
+static int
+locus_fdw_next(LocusFdwScanState *state, const char **seq, int32 *beg, int32 *end)
+{
+  TabixIndex *index = state->index;
+  MemoryContext oldcontext;
+  uint64      voffset;
+  int         nfields;
+
+  for (;;)
+  {
+    if (state->region == NULL)
+    {
+      /* the whole file, from the start, past its header lines */
+      if (state->lineno == 0)
+        bgzf_seek(state->file, 0);
+      if (!bgzf_readline(state->file, &state->line, &voffset))
+        return 0;
+      if (state->lineno++ < index->skip ||
+          state->line.len == 0 || state->line.data[0] == index->meta)
+        continue;
+
+      nfields = locus_fdw_split(state, state->line.data);
+      locus_fdw_record(state, nfields, seq, beg, end);
+      return nfields;
+    }
+
+    if (!state->in_chunk)
+    {
+      /* the next chunk, or the chunks of the next contig of the region */
+      if (state->chunk < state->nchunks)
+      {
+        bgzf_seek(state->file, state->chunks[state->chunk].beg);
+        state->in_chunk = true;
+        continue;
+      }
+
+      if (state->chunks != NULL)
+        pfree(state->chunks);
+      state->chunks = NULL;
+      state->nchunks = state->chunk = 0;
+
+      do
+      {
+        if (++state->ref >= index->nrefs)
+          return 0;
+      } while (!tabix_ref_matches(&index->refs[state->ref], state->region, state->any_contig));
+
+      /* the scan is called in the per-tuple context, which every row resets */
+      oldcontext = MemoryContextSwitchTo(state->cxt);
+      state->nchunks = tabix_chunks(&index->refs[state->ref], state->beg, state->end,
+                                    &state->chunks);
+      MemoryContextSwitchTo(oldcontext);
+      continue;
+    }
+
+    if (!bgzf_readline(state->file, &state->line, &voffset) ||
+        voffset >= state->chunks[state->chunk].end)
+    {
+      state->in_chunk = false;
+      state->chunk++;
+      continue;
+    }
+    if (state->line.len == 0 || state->line.data[0] == index->meta)
+      continue;
+
+    nfields = locus_fdw_split(state, state->line.data);
+    locus_fdw_record(state, nfields, seq, beg, end);
+
+    if (strcmp(*seq, index->refs[state->ref].name) != 0 || *end <= state->beg)
+      continue;
+    if (*beg >= state->end)
+    {
+      /* records are sorted by start: the rest of the contig is past it */
+      state->in_chunk = false;
+      state->chunk = state->nchunks;
+      continue;
+    }
+
+    return nfields;
+  }
+}
+
+static TupleTableSlot *
+locus_fdw_iterate(ForeignScanState *node)
+{
+  LocusFdwScanState *state = (LocusFdwScanState *) node->fdw_state;
+  TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+  TupleDesc   tupdesc = slot->tts_tupleDescriptor;
+  bool        vcf = (state->index->format & 0xffff) == TABIX_VCF;
+  const char *seq;
+  int32       beg;
+  int32       end;
+  int         nfields;
+  LOCUS      *locus = NULL;
+  int         i;
+
+  ExecClearTuple(slot);
+
+  /* whatever the columns, so that every query sees the same rows */
+  for (;;)
+  {
+    nfields = locus_fdw_next(state, &seq, &beg, &end);
+    if (nfields == 0)
+      return slot;
+    if (locus_fdw_contig_valid(state, seq))
+      break;
+    state->nskipped++;
+  }
+
+  /* the values are allocated in the per-tuple context and live until the next row */
+  for (i = 0; i < tupdesc->natts; i++)
+  {
+    int         field = state->fieldmap[i];
+
+    slot->tts_values[i] = (Datum) 0;
+    slot->tts_isnull[i] = true;
+
+    if (field == LOCUS_FDW_REGION)
+    {
+      if (locus == NULL)
+      {
+        locus = (LOCUS *) palloc0(sizeof(LOCUS));
+        locus_parse_name(seq, strlen(seq), locus);
+        locus->lower = beg + 1;
+        locus->upper = end;
+        locus_set_natkey(locus);
+      }
+      slot->tts_values[i] = PointerGetDatum(locus);
+      slot->tts_isnull[i] = false;
+    }
+    else if (field >= 0 && field < nfields &&
+             !(vcf && strcmp(state->fields[field], ".") == 0))
+    {
+      slot->tts_values[i] = InputFunctionCall(&state->in_functions[i], state->fields[field],
+                                              state->typioparams[i],
+                                              TupleDescAttr(tupdesc, i)->atttypmod);
+      slot->tts_isnull[i] = false;
+    }
+  }
+
+  return ExecStoreVirtualTuple(slot);
+}
+
+static void
+locus_fdw_rescan(ForeignScanState *node)
+{
+  locus_fdw_rewind((LocusFdwScanState *) node->fdw_state);
+}
+
+static void
+locus_fdw_end(ForeignScanState *node)
+{
+  LocusFdwScanState *state = (LocusFdwScanState *) node->fdw_state;
+
+  if (state == NULL)
+    return;
+
+  if (state->file != NULL)
+    bgzf_close(state->file);
+
+  if (state->nskipped > 0)
+    ereport(NOTICE,
+        (errmsg("skipped %lld records of foreign table \"%s\" on contigs a locus cannot hold",
+                (long long) state->nskipped,
+                RelationGetRelationName(node->ss.ss_currentRelation)),
+         errdetail("A locus holds only the contig names that its text input accepts.")));
+}
+
+static void
+locus_fdw_explain(ForeignScanState *node, ExplainState *es)
+{
+  LocusFdwScanState *state = (LocusFdwScanState *) node->fdw_state;
+
+  if (state->region != NULL)
+  {
+    char       *region = DatumGetCString(DirectFunctionCall1(locus_out,
+                                                             PointerGetDatum(state->region)));
+
+    ExplainPropertyText("Tabix Region",
+                        state->any_contig ? psprintf("%s on every contig", region) : region,
+                        es);
+  }
+
+  if (es->verbose)
+    ExplainPropertyText("Foreign File", state->filename, es);
+
+  if (es->analyze && state->file != NULL)
+  {
+    ExplainPropertyInteger("Blocks Read", NULL, state->file->nblocks, es);
+    ExplainPropertyInteger("Records Skipped", NULL, state->nskipped, es);
+  }
+}
+
+Datum
+locus_fdw_handler(PG_FUNCTION_ARGS)
+{
+  FdwRoutine *routine = makeNode(FdwRoutine);
+
+  routine->GetForeignRelSize = locus_fdw_get_rel_size;
+  routine->GetForeignPaths = locus_fdw_get_paths;
+  routine->GetForeignPlan = locus_fdw_get_plan;
+  routine->ExplainForeignScan = locus_fdw_explain;
+  routine->BeginForeignScan = locus_fdw_begin;
+  routine->IterateForeignScan = locus_fdw_iterate;
+  routine->ReScanForeignScan = locus_fdw_rescan;
+  routine->EndForeignScan = locus_fdw_end;
+
+  PG_RETURN_POINTER(routine);
+}
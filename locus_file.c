@@ -0,0 +1,569 @@
+/*
+ * contrib/locus/locus_file.c
+ *
+ * Reading loci from BED and VCF files
+ *
+ * locus_read_bed() and locus_read_vcf() read a file on the server, plain or
+ * gzip-compressed (bgzip files are gzip files of many members), and return
+ * one row per record, with the coordinates converted straight into a locus
+ * and the other columns as text.  The file is read through a fixed buffer
+ * one line at a time, and the rows are returned one per call, so memory
+ * does not grow with the size of the file.
+ *
+ * Coordinates are converted to the 1-based, closed intervals of locus: a
+ * BED record covers bases start + 1 to end, and a VCF record covers its
+ * reference allele, or the bases up to its END, when its INFO has one.
+ */
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <limits.h>  /* for INT_MAX */
+#include <unistd.h>
+#include <zlib.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_authid.h"
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "storage/fd.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(locus_read_bed);
+PG_FUNCTION_INFO_V1(locus_read_vcf);
+
+
+/*****************************************************************************
+ * Line reader
+ *****************************************************************************/
+
+#define LOCUS_FILE_BUFSIZE  65536
+
+typedef struct LocusFile
+{
+  const char *path;
+  int         fd;
+  MemoryContext cxt;        /* where zlib allocates */
+  bool        gzip;         /* is the file compressed? */
+  z_stream    zs;
+  bool        member_end;   /* at the end of a gzip member */
+  bool        raw_eof;      /* no more bytes in the file */
+  char       *in;           /* bytes read from the file */
+  char       *out;          /* bytes inflated from them */
+  char       *pos;          /* the data not yet returned */
+  char       *end;
+  StringInfoData line;
+  int64       lineno;
+} LocusFile;
+
+static void *
+locus_file_zalloc(void *opaque, unsigned int items, unsigned int size)
+{
+  return MemoryContextAlloc((MemoryContext) opaque, (Size) items * size);
+}
+
+static void
+locus_file_zfree(void *opaque, void *address)
+{
+  pfree(address);
+}
+
+static int
+locus_file_read(LocusFile *file)
+{
+  int         n = read(file->fd, file->in, LOCUS_FILE_BUFSIZE);
+
+  if (n < 0)
+    ereport(ERROR,
+        (errcode_for_file_access(),
+         errmsg("could not read file \"%s\": %m", file->path)));
+
+  return n;
+}
+
+static void
+locus_file_zerror(LocusFile *file)
+{
+  ereport(ERROR,
+      (errcode(ERRCODE_DATA_CORRUPTED),
+       errmsg("could not decompress file \"%s\": %s", file->path,
+              file->zs.msg ? file->zs.msg : "unexpected end of data")));
+}
+
+/*
+ * Open a file for reading in the current memory context, which must last
+ * until it is closed.  The descriptor is closed at the end of the
+ * transaction if an error comes first.
+ */
+static LocusFile *
+locus_file_open(const char *path)
+{
+  LocusFile  *file = (LocusFile *) palloc0(sizeof(LocusFile));
+  int         n;
+
+  if (!has_privs_of_role(GetUserId(), ROLE_PG_READ_SERVER_FILES))
+    ereport(ERROR,
+        (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+         errmsg("permission denied to read from a file"),
+         errdetail("Only roles with privileges of the \"%s\" role may read files on the server.",
+                   "pg_read_server_files")));
+
+  file->path = pstrdup(path);
+  file->cxt = CurrentMemoryContext;
+  file->fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+  if (file->fd < 0)
+    ereport(ERROR,
+        (errcode_for_file_access(),
+         errmsg("could not open file \"%s\" for reading: %m", path)));
+
+  file->in = palloc(LOCUS_FILE_BUFSIZE);
+  initStringInfo(&file->line);
+
+  n = locus_file_read(file);
+  file->raw_eof = (n == 0);
+  file->gzip = n >= 2 && (uint8) file->in[0] == 0x1f && (uint8) file->in[1] == 0x8b;
+
+  if (file->gzip)
+  {
+    file->out = palloc(LOCUS_FILE_BUFSIZE);
+    file->zs.zalloc = locus_file_zalloc;
+    file->zs.zfree = locus_file_zfree;
+    file->zs.opaque = file->cxt;
+    file->zs.next_in = (Bytef *) file->in;
+    file->zs.avail_in = n;
+
+    /* 16 + MAX_WBITS: gzip header and trailer */
+    if (inflateInit2(&file->zs, 16 + MAX_WBITS) != Z_OK)
+      locus_file_zerror(file);
+    file->pos = file->end = file->out;
+  }
+  else
+  {
+    file->pos = file->in;
+    file->end = file->in + n;
+  }
+
+  return file;
+}
+
+static void
+locus_file_close(LocusFile *file)
+{
+  if (file->gzip)
+    inflateEnd(&file->zs);
+  CloseTransientFile(file->fd);
+}
+
+/*
+ * Refill the buffer; return false at the end of the file
+ */
+static bool
+locus_file_fill(LocusFile *file)
+{
+  int         n;
+  int         ret;
+
+  if (!file->gzip)
+  {
+    n = file->raw_eof ? 0 : locus_file_read(file);
+    file->raw_eof = (n == 0);
+    file->pos = file->in;
+    file->end = file->in + n;
+    return n > 0;
+  }
+
+  for (;;)
+  {
+    if (file->zs.avail_in == 0)
+    {
+      n = file->raw_eof ? 0 : locus_file_read(file);
+      if (n == 0)
+      {
+        file->raw_eof = true;
+        if (!file->member_end)
+          locus_file_zerror(file);
+        return false;
+      }
+      file->zs.next_in = (Bytef *) file->in;
+      file->zs.avail_in = n;
+    }
+
+    /* another member follows */
+    if (file->member_end)
+    {
+      if (inflateReset(&file->zs) != Z_OK)
+        locus_file_zerror(file);
+      file->member_end = false;
+    }
+
+    file->zs.next_out = (Bytef *) file->out;
+    file->zs.avail_out = LOCUS_FILE_BUFSIZE;
+
+    ret = inflate(&file->zs, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END)
+      file->member_end = true;
+    else if (ret != Z_OK && ret != Z_BUF_ERROR)
+      locus_file_zerror(file);
+
+    n = LOCUS_FILE_BUFSIZE - file->zs.avail_out;
+    if (n > 0)
+    {
+      file->pos = file->out;
+      file->end = file->out + n;
+      return true;
+    }
+  }
+}
+
+/*
+ * Return the next line, without its line ending, or NULL at the end of the
+ * file.  The line is good until the next call, and may be written to.
+ */
+static char *
+locus_file_readline(LocusFile *file)
+{
+  resetStringInfo(&file->line);
+
+  for (;;)
+  {
+    char       *nl;
+
+    if (file->pos == file->end && !locus_file_fill(file))
+    {
+      if (file->line.len == 0)
+        return NULL;
+      break;
+    }
+
+    nl = memchr(file->pos, '\n', file->end - file->pos);
+    if (nl != NULL)
+    {
+      appendBinaryStringInfo(&file->line, file->pos, nl - file->pos);
+      file->pos = nl + 1;
+      break;
+    }
+
+    appendBinaryStringInfo(&file->line, file->pos, file->end - file->pos);
+    file->pos = file->end;
+  }
+
+  if (file->line.len > 0 && file->line.data[file->line.len - 1] == '\r')
+    file->line.data[--file->line.len] = '\0';
+
+  file->lineno++;
+
+  return file->line.data;
+}
+
+
+/*****************************************************************************
+ * Records
+ *****************************************************************************/
+
+#define LOCUS_FILE_MAXFIELDS  4096
+
+typedef enum
+{
+  LOCUS_FILE_BED,
+  LOCUS_FILE_VCF
+} LocusFileFormat;
+
+typedef struct LocusReadState
+{
+  LocusFile  *file;
+  LocusFileFormat format;
+  char       *fields[LOCUS_FILE_MAXFIELDS];
+} LocusReadState;
+
+static void
+locus_read_error(LocusFile *file, const char *what, const char *value)
+{
+  ereport(ERROR,
+      (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+       errmsg("invalid %s \"%s\" in line %lld of file \"%s\"",
+              what, value, (long long) file->lineno, file->path)));
+}
+
+/*
+ * Split a line at its tabs, in place, and return the number of fields
+ */
+static int
+locus_read_split(LocusReadState *state, char *line)
+{
+  int         nfields = 0;
+
+  for (;;)
+  {
+    char       *tab = strchr(line, '\t');
+
+    if (nfields == LOCUS_FILE_MAXFIELDS)
+      ereport(ERROR,
+          (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+           errmsg("line %lld of file \"%s\" has more than %d columns",
+                  (long long) state->file->lineno, state->file->path, LOCUS_FILE_MAXFIELDS)));
+
+    state->fields[nfields++] = line;
+    if (tab == NULL)
+      return nfields;
+    *tab = '\0';
+    line = tab + 1;
+  }
+}
+
+/*
+ * Convert a position column: a number from 0 to INT_MAX
+ */
+static int32
+locus_read_position(LocusFile *file, const char *what, const char *value)
+{
+  const char *p = value;
+  int64       val = 0;
+
+  if (*p == '\0')
+    locus_read_error(file, what, value);
+
+  for (; *p; p++)
+  {
+    if (*p < '0' || *p > '9')
+      locus_read_error(file, what, value);
+    val = val * 10 + (*p - '0');
+    if (val > INT_MAX)
+      locus_read_error(file, what, value);
+  }
+
+  return (int32) val;
+}
+
+/*
+ * The END of a VCF record, if its INFO has one
+ */
+static bool
+locus_read_vcf_end(LocusFile *file, const char *info, int32 *end)
+{
+  const char *p = info;
+
+  while (p != NULL && *p)
+  {
+    if (strncmp(p, "END=", 4) == 0)
+    {
+      const char *value = p + 4;
+      const char *sep = strchr(value, ';');
+      char       *text = sep ? pnstrdup(value, sep - value) : pstrdup(value);
+
+      *end = locus_read_position(file, "END", text);
+      return true;
+    }
+
+    p = strchr(p, ';');
+    if (p != NULL)
+      p++;
+  }
+
+  return false;
+}
+
+static ArrayType *
+locus_read_fields(char **fields, int nfields)
+{
+  Datum      *elems = (Datum *) palloc(Max(nfields, 1) * sizeof(Datum));
+  int         i;
+
+  for (i = 0; i < nfields; i++)
+    elems[i] = CStringGetTextDatum(fields[i]);
+
+  return construct_array(elems, nfields, TEXTOID, -1, false, TYPALIGN_INT);
+}
+
+/* a text column, NULL for a VCF missing value */
+#define VCF_VALUE(i, f) \
+  do { \
+    if (strcmp((f), ".") == 0) \
+      nulls[i] = true; \
+    else \
+      values[i] = CStringGetTextDatum(f); \
+  } while (0)
+
+/*
+ * Read the next record of the file into values and nulls, skipping headers
+ * and blank lines; return false at the end of the file
+ */
+static bool
+locus_read_record(LocusReadState *state, Datum *values, bool *nulls)
+{
+  LocusFile  *file = state->file;
+  char       *line;
+  char      **f = state->fields;
+  int         nfields;
+  LOCUS      *locus;
+  int32       start;
+  int32       end;
+
+  for (;;)
+  {
+    line = locus_file_readline(file);
+    if (line == NULL)
+      return false;
+
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+    if (state->format == LOCUS_FILE_BED &&
+        ((strncmp(line, "track", 5) == 0 && (line[5] == '\0' || line[5] == ' ' || line[5] == '\t')) ||
+         (strncmp(line, "browser", 7) == 0 && (line[7] == '\0' || line[7] == ' ' || line[7] == '\t'))))
+      continue;
+    break;
+  }
+
+  nfields = locus_read_split(state, line);
+
+  locus = (LOCUS *) palloc0(sizeof(LOCUS));
+
+  if (state->format == LOCUS_FILE_BED)
+  {
+    /* chrom, chromStart, chromEnd, ... */
+    if (nfields < 3)
+      ereport(ERROR,
+          (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+           errmsg("line %lld of file \"%s\" has fewer than 3 columns",
+                  (long long) file->lineno, file->path)));
+
+    start = locus_read_position(file, "start", f[1]);
+    end = locus_read_position(file, "end", f[2]);
+    if (end < start || start == INT_MAX)
+      locus_read_error(file, "end", f[2]);
+
+    locus_parse_name(f[0], strlen(f[0]), locus);
+    /* a feature of no length, such as an insertion point, takes the base after it */
+    locus->lower = start + 1;
+    locus->upper = Max(end, start + 1);
+    locus_set_natkey(locus);
+
+    values[0] = PointerGetDatum(locus);
+    values[1] = PointerGetDatum(locus_read_fields(f + 3, nfields - 3));
+  }
+  else
+  {
+    /* CHROM, POS, ID, REF, ALT, QUAL, FILTER, INFO, ... */
+    if (nfields < 8)
+      ereport(ERROR,
+          (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+           errmsg("line %lld of file \"%s\" has fewer than 8 columns",
+                  (long long) file->lineno, file->path)));
+
+    start = locus_read_position(file, "position", f[1]);
+    if (f[3][0] == '\0' || (int64) start + strlen(f[3]) - 1 > INT_MAX)
+      locus_read_error(file, "reference allele", f[3]);
+    if (!locus_read_vcf_end(file, f[7], &end))
+      end = start + strlen(f[3]) - 1;
+    if (end < start)
+      locus_read_error(file, "END", f[7]);
+
+    locus_parse_name(f[0], strlen(f[0]), locus);
+    locus->lower = start;
+    locus->upper = end;
+    locus_set_natkey(locus);
+
+    values[0] = PointerGetDatum(locus);
+    VCF_VALUE(1, f[2]);
+    values[2] = CStringGetTextDatum(f[3]);
+    VCF_VALUE(3, f[4]);
+    VCF_VALUE(4, f[5]);
+    VCF_VALUE(5, f[6]);
+    VCF_VALUE(6, f[7]);
+    values[7] = PointerGetDatum(locus_read_fields(f + 8, nfields - 8));
+  }
+
+  return true;
+}
+
+/* Close the file when the scan ends before it does */
+static void
+locus_read_shutdown(Datum arg)
+{
+  LocusReadState *state = (LocusReadState *) DatumGetPointer(arg);
+
+  if (state->file != NULL)
+  {
+    locus_file_close(state->file);
+    state->file = NULL;
+  }
+}
+
+static Datum
+locus_read(FunctionCallInfo fcinfo, LocusFileFormat format)
+{
+  ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+  FuncCallContext *funcctx;
+  LocusReadState *state;
+  Datum       values[8];
+  bool        nulls[8];
+
+  if (SRF_IS_FIRSTCALL())
+  {
+    MemoryContext oldcontext;
+    TupleDesc   tupdesc;
+
+    funcctx = SRF_FIRSTCALL_INIT();
+    oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+      elog(ERROR, "return type must be a row type");
+    funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+    state = (LocusReadState *) palloc0(sizeof(LocusReadState));
+    state->format = format;
+    state->file = locus_file_open(text_to_cstring(PG_GETARG_TEXT_PP(0)));
+    funcctx->user_fctx = state;
+
+    if (rsinfo != NULL && IsA(rsinfo, ReturnSetInfo))
+      RegisterExprContextCallback(rsinfo->econtext, locus_read_shutdown,
+                                  PointerGetDatum(state));
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+
+  funcctx = SRF_PERCALL_SETUP();
+  state = (LocusReadState *) funcctx->user_fctx;
+
+  memset(nulls, 0, sizeof(nulls));
+
+  if (state->file != NULL && locus_read_record(state, values, nulls))
+  {
+    HeapTuple   tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+    SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+  }
+
+  /* the state goes away with the call context */
+  locus_read_shutdown(PointerGetDatum(state));
+  if (rsinfo != NULL && IsA(rsinfo, ReturnSetInfo))
+    UnregisterExprContextCallback(rsinfo->econtext, locus_read_shutdown,
+                                  PointerGetDatum(state));
+  SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * locus_read_bed(path) -- the records of a BED file, as (locus, fields),
+ * with the columns after chromEnd in fields
+ */
+Datum
+locus_read_bed(PG_FUNCTION_ARGS)
+{
+  return locus_read(fcinfo, LOCUS_FILE_BED);
+}
+
+/*
+ * locus_read_vcf(path) -- the records of a VCF file, as (locus, id, ref,
+ * alt, qual, filter, info, fields), with FORMAT and the sample columns in
+ * fields.  Missing values (".") are NULL.
+ */
+Datum
+locus_read_vcf(PG_FUNCTION_ARGS)
+{
+  return locus_read(fcinfo, LOCUS_FILE_VCF);
+}
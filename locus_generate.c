@@ -0,0 +1,285 @@
+/*
+ * contrib/locus/locus_generate.c
+ *
+ * Synthetic loci for benchmarks
+ *
+ * locus_generate(n, assembly_profile, length_distribution, seed) returns n
+ * loci shaped like the variant calls of a genome: their contigs are drawn
+ * in proportion to the lengths of the chromosomes of an assembly, their
+ * positions uniformly along them, and their lengths from a mix of single
+ * bases (SNVs), short indels and structural variants.  The loci come in the
+ * order they are drawn, not sorted.  The generator is splitmix64 seeded with
+ * seed, and only integer arithmetic is used, so a seed gives the same loci
+ * on every platform.
+ */
+
+#include "postgres.h"
+
+#include "fmgr.h"
+#include "funcapi.h"
+#include "utils/builtins.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(locus_generate);
+
+
+/*****************************************************************************
+ * Assemblies and length distributions
+ *****************************************************************************/
+
+typedef struct LocusGenerateContig
+{
+  const char *name;         /* without "chr" */
+  int32       length;
+} LocusGenerateContig;
+
+typedef struct LocusGenerateAssembly
+{
+  const char *name;
+  bool        chr;          /* are contigs spelled with "chr"? */
+  const LocusGenerateContig *contigs;
+  int         ncontigs;
+} LocusGenerateAssembly;
+
+static const LocusGenerateContig grch38_contigs[] = {
+  {"1", 248956422}, {"2", 242193529}, {"3", 198295559}, {"4", 190214555},
+  {"5", 181538259}, {"6", 170805979}, {"7", 159345973}, {"8", 145138636},
+  {"9", 138394717}, {"10", 133797422}, {"11", 135086622}, {"12", 133275309},
+  {"13", 114364328}, {"14", 107043718}, {"15", 101991189}, {"16", 90338345},
+  {"17", 83257441}, {"18", 80373285}, {"19", 58617616}, {"20", 64444167},
+  {"21", 46709983}, {"22", 50818468}, {"X", 156040895}, {"Y", 57227415},
+  {"M", 16569}
+};
+
+/* as in the b37 reference of the 1000 Genomes Project */
+static const LocusGenerateContig grch37_contigs[] = {
+  {"1", 249250621}, {"2", 243199373}, {"3", 198022430}, {"4", 191154276},
+  {"5", 180915260}, {"6", 171115067}, {"7", 159138663}, {"8", 146364022},
+  {"9", 141213431}, {"10", 135534747}, {"11", 135006516}, {"12", 133851895},
+  {"13", 115169878}, {"14", 107349540}, {"15", 102531392}, {"16", 90354753},
+  {"17", 81195210}, {"18", 78077248}, {"19", 59128983}, {"20", 63025520},
+  {"21", 48129895}, {"22", 51304566}, {"X", 155270560}, {"Y", 59373566},
+  {"MT", 16569}
+};
+
+/* T2T-CHM13v2.0 */
+static const LocusGenerateContig chm13_contigs[] = {
+  {"1", 248387328}, {"2", 242696752}, {"3", 201105948}, {"4", 193574945},
+  {"5", 182045439}, {"6", 172126628}, {"7", 160567428}, {"8", 146259331},
+  {"9", 150617247}, {"10", 134758134}, {"11", 135127769}, {"12", 133324548},
+  {"13", 113566686}, {"14", 101161492}, {"15", 99753195}, {"16", 96330374},
+  {"17", 84276897}, {"18", 80542538}, {"19", 61707364}, {"20", 66210255},
+  {"21", 45090682}, {"22", 51324926}, {"X", 154259566}, {"Y", 62460029},
+  {"M", 16569}
+};
+
+static const LocusGenerateAssembly locus_generate_assemblies[] = {
+  {"grch38", true, grch38_contigs, lengthof(grch38_contigs)},
+  {"grch37", false, grch37_contigs, lengthof(grch37_contigs)},
+  {"chm13", true, chm13_contigs, lengthof(chm13_contigs)},
+};
+
+/*
+ * Shares of SNVs and indels in thousandths; the rest are structural
+ * variants.  The germline mix is that of the calls of one genome, the
+ * somatic one that of a tumour with more structural variants.
+ */
+typedef struct LocusGenerateLengths
+{
+  const char *name;
+  int         snv;
+  int         indel;
+} LocusGenerateLengths;
+
+static const LocusGenerateLengths locus_generate_lengths[] = {
+  {"germline", 870, 125},
+  {"somatic", 900, 80},
+  {"snv", 1000, 0},
+  {"indel", 0, 1000},
+  {"sv", 0, 0},
+};
+
+/* indels span 2 to this many bases, structural variants from SV_MIN_LENGTH */
+#define INDEL_MAX_LENGTH  50
+#define SV_MIN_LENGTH     50
+#define SV_OCTAVES        15    /* up to SV_MIN_LENGTH << SV_OCTAVES bases */
+
+
+/*****************************************************************************
+ * Generator
+ *****************************************************************************/
+
+typedef struct LocusGenerateState
+{
+  uint64      rng;
+  int         ncontigs;
+  LOCUS      *contigs;      /* a locus on each contig, to copy */
+  int32      *lengths;
+  int64      *cumulative;   /* lengths of this and the preceding contigs */
+  const LocusGenerateLengths *mix;
+} LocusGenerateState;
+
+/* splitmix64 */
+static uint64
+locus_generate_next(LocusGenerateState *state)
+{
+  uint64      z = (state->rng += UINT64CONST(0x9e3779b97f4a7c15));
+
+  z = (z ^ (z >> 30)) * UINT64CONST(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64CONST(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+/* uniform in [0, n) */
+static int64
+locus_generate_below(LocusGenerateState *state, int64 n)
+{
+  return (int64) (locus_generate_next(state) % (uint64) n);
+}
+
+/*
+ * The number of bases a variant spans: one for an SNV; for an indel, 2 and
+ * more with halving odds (the anchor base and the bases deleted); for a
+ * structural variant, a length in an octave above SV_MIN_LENGTH drawn
+ * uniformly, so that the lengths spread evenly on a log scale.
+ */
+static int32
+locus_generate_length(LocusGenerateState *state)
+{
+  int64       kind = locus_generate_below(state, 1000);
+  uint64      bits;
+  int32       length;
+
+  if (kind < state->mix->snv)
+    return 1;
+
+  if (kind < state->mix->snv + state->mix->indel)
+  {
+    bits = locus_generate_next(state);
+    for (length = 2; (bits & 1) != 0 && length < INDEL_MAX_LENGTH; length++)
+      bits >>= 1;
+    return length;
+  }
+
+  length = SV_MIN_LENGTH << locus_generate_below(state, SV_OCTAVES);
+  return length + (int32) locus_generate_below(state, length);
+}
+
+static LocusGenerateState *
+locus_generate_start(const char *assembly_name, const char *lengths_name,
+                     int64 seed)
+{
+  const LocusGenerateAssembly *assembly = NULL;
+  LocusGenerateState *state;
+  int64       total = 0;
+  int         i;
+
+  for (i = 0; i < lengthof(locus_generate_assemblies); i++)
+    if (strcmp(locus_generate_assemblies[i].name, assembly_name) == 0)
+      assembly = &locus_generate_assemblies[i];
+  if (assembly == NULL)
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("unknown assembly profile \"%s\"", assembly_name),
+             errhint("Assembly profiles are grch38, grch37 and chm13.")));
+
+  state = (LocusGenerateState *) palloc0(sizeof(LocusGenerateState));
+  for (i = 0; i < lengthof(locus_generate_lengths); i++)
+    if (strcmp(locus_generate_lengths[i].name, lengths_name) == 0)
+      state->mix = &locus_generate_lengths[i];
+  if (state->mix == NULL)
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("unknown length distribution \"%s\"", lengths_name),
+             errhint("Length distributions are germline, somatic, snv, indel and sv.")));
+
+  state->rng = (uint64) seed;
+  state->ncontigs = assembly->ncontigs;
+  state->contigs = (LOCUS *) palloc0(assembly->ncontigs * sizeof(LOCUS));
+  state->lengths = (int32 *) palloc(assembly->ncontigs * sizeof(int32));
+  state->cumulative = (int64 *) palloc(assembly->ncontigs * sizeof(int64));
+
+  for (i = 0; i < assembly->ncontigs; i++)
+  {
+    LOCUS      *locus = &state->contigs[i];
+
+    strcpy(locus->contig, assembly->contigs[i].name);
+    locus->chr = assembly->chr;
+    locus_set_natkey(locus);
+
+    state->lengths[i] = assembly->contigs[i].length;
+    total += assembly->contigs[i].length;
+    state->cumulative[i] = total;
+  }
+
+  return state;
+}
+
+static LOCUS *
+locus_generate_one(LocusGenerateState *state)
+{
+  int64       pick = locus_generate_below(state,
+                                          state->cumulative[state->ncontigs - 1]);
+  int         lo = 0;
+  int         hi = state->ncontigs - 1;
+  int32       length;
+  LOCUS      *result;
+
+  /* the first contig whose cumulative length exceeds pick */
+  while (lo < hi)
+  {
+    int         mid = (lo + hi) / 2;
+
+    if (state->cumulative[mid] > pick)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  length = Min(locus_generate_length(state), state->lengths[lo]);
+
+  result = (LOCUS *) palloc(sizeof(LOCUS));
+  memcpy(result, &state->contigs[lo], sizeof(LOCUS));
+  result->lower = 1 + (int32) locus_generate_below(state,
+                                                   state->lengths[lo] - length + 1);
+  result->upper = result->lower + length - 1;
+
+  return result;
+}
+
+Datum
+locus_generate(PG_FUNCTION_ARGS)
+{
+  FuncCallContext *funcctx;
+
+  if (SRF_IS_FIRSTCALL())
+  {
+    int64       n = PG_GETARG_INT64(0);
+    MemoryContext oldcontext;
+
+    if (n < 0)
+      ereport(ERROR,
+              (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+               errmsg("number of loci must not be negative")));
+
+    funcctx = SRF_FIRSTCALL_INIT();
+    oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+    funcctx->user_fctx =
+      locus_generate_start(text_to_cstring(PG_GETARG_TEXT_PP(1)),
+                           text_to_cstring(PG_GETARG_TEXT_PP(2)),
+                           PG_GETARG_INT64(3));
+    funcctx->max_calls = (uint64) n;
+
+    MemoryContextSwitchTo(oldcontext);
+  }
+
+  funcctx = SRF_PERCALL_SETUP();
+
+  if (funcctx->call_cntr < funcctx->max_calls)
+    SRF_RETURN_NEXT(funcctx,
+                    PointerGetDatum(locus_generate_one((LocusGenerateState *) funcctx->user_fctx)));
+
+  SRF_RETURN_DONE(funcctx);
+}
@@ -0,0 +1,714 @@
+/*
+ * contrib/locus/locus_packed.c
+ *
+ * Genomic loci with interned contig names
+ *
+ * plocus is the packed variant of locus: the positions and the ID of the
+ * contig in the dictionary table locus_contigs, in 16 bytes instead of 32.
+ * A genome has a few dozen contigs, or a few thousand scaffolds, so the
+ * table stays small however many loci refer to it.  Names are entered by
+ * locus_contig_register() and never change or go away, so an ID means the
+ * same contig for the life of the database.  <all> has ID 0 and no row.
+ *
+ * The input functions and the cast from locus only look names up, and do
+ * so in entries that committed: a value never refers to an entry that may
+ * roll back, and every lookup, including those of comparisons between index
+ * keys of rows the snapshot of the query cannot see, finds its entry.  Each
+ * backend keeps the entries it has met in a cache of the table and reads a
+ * value with plocus_view(), which yields a LOCUS (with its contig copied or
+ * pointed to, as vlocus_view() does) and hands it to the function of locus
+ * that does the job.  Values on the same contig are compared without a
+ * lookup.
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
+#include "commands/extension.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "libpq/pqformat.h"
+#include "miscadmin.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/syscache.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(plocus_in);
+PG_FUNCTION_INFO_V1(plocus_out);
+PG_FUNCTION_INFO_V1(plocus_recv);
+PG_FUNCTION_INFO_V1(plocus_send);
+PG_FUNCTION_INFO_V1(plocus);
+PG_FUNCTION_INFO_V1(plocus_to_locus);
+PG_FUNCTION_INFO_V1(plocus_contig);
+PG_FUNCTION_INFO_V1(plocus_lower);
+PG_FUNCTION_INFO_V1(plocus_upper);
+PG_FUNCTION_INFO_V1(plocus_cmp);
+PG_FUNCTION_INFO_V1(plocus_lt);
+PG_FUNCTION_INFO_V1(plocus_le);
+PG_FUNCTION_INFO_V1(plocus_gt);
+PG_FUNCTION_INFO_V1(plocus_ge);
+PG_FUNCTION_INFO_V1(plocus_same);
+PG_FUNCTION_INFO_V1(plocus_different);
+PG_FUNCTION_INFO_V1(plocus_left);
+PG_FUNCTION_INFO_V1(plocus_right);
+PG_FUNCTION_INFO_V1(plocus_over_left);
+PG_FUNCTION_INFO_V1(plocus_over_right);
+PG_FUNCTION_INFO_V1(plocus_overlap);
+PG_FUNCTION_INFO_V1(plocus_contains);
+PG_FUNCTION_INFO_V1(plocus_contained);
+PG_FUNCTION_INFO_V1(locus_contig_register);
+
+
+/*****************************************************************************
+ * The contig dictionary
+ *****************************************************************************/
+
+/*
+ * A cached dictionary entry, keyed by name, with what the comparisons of
+ * locus need: the natural-order key and flags of the contig
+ */
+typedef struct LocusContig
+{
+  char        name[VLOCUS_MAX_CONTIG + 1];  /* hash key; must be first */
+  int32       id;
+  int         len;
+  uint8       flags;
+  uint8       natkey[LOCUS_NATKEY_LEN];
+} LocusContig;
+
+/* The same entries, keyed by ID */
+typedef struct LocusContigById
+{
+  int32       id;                           /* hash key; must be first */
+  LocusContig *contig;
+} LocusContigById;
+
+/* The ID of <all>, which matches any contig and is in no row of the table */
+#define LOCUS_CONTIG_ALL_ID  0
+
+static HTAB *contigs_by_name = NULL;
+static HTAB *contigs_by_id = NULL;
+static Oid  contigs_relid = InvalidOid;
+static Oid  contigs_id_index;
+static Oid  contigs_name_index;
+
+/* locus_contig_register() enters names as the owner of locus_contigs */
+static const char *const contigs_insert =
+  "INSERT INTO %s (name) VALUES ($1) ON CONFLICT (name) DO NOTHING RETURNING id";
+static const char *const contigs_select =
+  "SELECT id FROM %s WHERE name = $1";
+static SPIPlanPtr contigs_insert_plan = NULL;
+static SPIPlanPtr contigs_select_plan = NULL;
+static Oid  contigs_owner = InvalidOid;
+
+static LocusContig *locus_contigs_enter(int32 id, const char *name);
+
+/*
+ * Find locus_contigs and its indexes, and set up the cache, with the entry
+ * of <all>
+ */
+static void
+locus_contigs_init(void)
+{
+  Oid         nspid = get_extension_schema(get_extension_oid("locus", false));
+  HASHCTL     ctl;
+
+  contigs_relid = get_relname_relid("locus_contigs", nspid);
+  if (!OidIsValid(contigs_relid))
+    ereport(ERROR,
+        (errcode(ERRCODE_UNDEFINED_TABLE),
+         errmsg("contig dictionary \"locus_contigs\" does not exist")));
+  contigs_id_index = get_relname_relid("locus_contigs_pkey", nspid);
+  contigs_name_index = get_relname_relid("locus_contigs_name_key", nspid);
+  if (!OidIsValid(contigs_id_index) || !OidIsValid(contigs_name_index))
+    elog(ERROR, "indexes of locus_contigs not found");
+
+  ctl.keysize = VLOCUS_MAX_CONTIG + 1;
+  ctl.entrysize = sizeof(LocusContig);
+  contigs_by_name = hash_create("locus contigs by name", 64, &ctl,
+                                HASH_ELEM | HASH_STRINGS);
+
+  ctl.keysize = sizeof(int32);
+  ctl.entrysize = sizeof(LocusContigById);
+  contigs_by_id = hash_create("locus contigs by ID", 64, &ctl,
+                              HASH_ELEM | HASH_BLOBS);
+
+  locus_contigs_enter(LOCUS_CONTIG_ALL_ID, "<all>");
+}
+
+/*
+ * Read the entry of locus_contigs that key finds in the given index.  The
+ * scan uses SnapshotSelf, not the snapshot of the query, so that it sees
+ * every committed entry: the btree comparisons of an index insertion meet
+ * the keys of rows no snapshot of the inserting query can see.  Entries
+ * that the current transaction entered are passed over, and *uncommitted
+ * set, so that no value refers to an entry before it has committed.
+ */
+static bool
+locus_contigs_fetch(Oid indexid, ScanKey key, int32 *id, char *name,
+                    bool *uncommitted)
+{
+  Relation    rel = table_open(contigs_relid, AccessShareLock);
+  SysScanDesc scan;
+  HeapTuple   tuple;
+  bool        found = false;
+
+  *uncommitted = false;
+
+  scan = systable_beginscan(rel, indexid, true, SnapshotSelf, 1, key);
+  tuple = systable_getnext(scan);
+  if (HeapTupleIsValid(tuple))
+  {
+    if (TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(tuple->t_data)))
+      *uncommitted = true;
+    else
+    {
+      bool        isnull;
+
+      *id = DatumGetInt32(heap_getattr(tuple, 1, RelationGetDescr(rel), &isnull));
+      text_to_cstring_buffer((text *) DatumGetPointer(heap_getattr(tuple, 2, RelationGetDescr(rel), &isnull)),
+                             name, VLOCUS_MAX_CONTIG + 1);
+      found = true;
+    }
+  }
+  systable_endscan(scan);
+
+  table_close(rel, AccessShareLock);
+
+  return found;
+}
+
+/*
+ * Cache an entry of locus_contigs
+ */
+static LocusContig *
+locus_contigs_enter(int32 id, const char *name)
+{
+  LocusContig *contig;
+  LocusContigById *byid;
+  bool        found;
+
+  contig = (LocusContig *) hash_search(contigs_by_name, name, HASH_ENTER, &found);
+  contig->id = id;
+  contig->len = strlen(contig->name);
+  contig->flags = locus_contig_flags(contig->name, contig->natkey);
+
+  byid = (LocusContigById *) hash_search(contigs_by_id, &id, HASH_ENTER, &found);
+  byid->contig = contig;
+
+  return contig;
+}
+
+/*
+ * Look up a contig by ID
+ */
+static LocusContig *
+locus_contig_by_id(int32 id)
+{
+  LocusContigById *byid;
+  ScanKeyData key;
+  char        name[VLOCUS_MAX_CONTIG + 1];
+  bool        uncommitted;
+
+  if (contigs_by_id == NULL)
+    locus_contigs_init();
+
+  byid = (LocusContigById *) hash_search(contigs_by_id, &id, HASH_FIND, NULL);
+  if (byid != NULL)
+    return byid->contig;
+
+  ScanKeyInit(&key, 1, BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(id));
+  if (!locus_contigs_fetch(contigs_id_index, &key, &id, name, &uncommitted))
+    ereport(ERROR,
+        (errcode(ERRCODE_DATA_CORRUPTED),
+         errmsg("contig ID %d is not in locus_contigs", id)));
+
+  return locus_contigs_enter(id, name);
+}
+
+/*
+ * Look up a contig by name, which need not end in a NUL, and return NULL
+ * if it has no committed entry
+ */
+static LocusContig *
+locus_contig_lookup(const char *name, int len, bool *uncommitted)
+{
+  char        key[VLOCUS_MAX_CONTIG + 1];
+  LocusContig *contig;
+  ScanKeyData skey;
+  int32       id;
+
+  if (contigs_by_name == NULL)
+    locus_contigs_init();
+
+  memcpy(key, name, len);
+  key[len] = '\0';
+
+  *uncommitted = false;
+  contig = (LocusContig *) hash_search(contigs_by_name, key, HASH_FIND, NULL);
+  if (contig != NULL)
+    return contig;
+
+  ScanKeyInit(&skey, 2, BTEqualStrategyNumber, F_TEXTEQ,
+              PointerGetDatum(cstring_to_text_with_len(name, len)));
+  if (!locus_contigs_fetch(contigs_name_index, &skey, &id, key, uncommitted))
+    return NULL;
+
+  return locus_contigs_enter(id, key);
+}
+
+/*
+ * Look up a contig by name, which must be in locus_contigs
+ */
+static LocusContig *
+locus_contig_by_name(const char *name, int len)
+{
+  LocusContig *contig;
+  bool        uncommitted;
+
+  contig = locus_contig_lookup(name, len, &uncommitted);
+  if (contig != NULL)
+    return contig;
+
+  if (uncommitted)
+    ereport(ERROR,
+        (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+         errmsg("contig \"%.*s\" is not in locus_contigs yet", len, name),
+         errdetail("The current transaction registered it and has not committed."),
+         errhint("Register contig names in a transaction of their own.")));
+
+  ereport(ERROR,
+      (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+       errmsg("contig \"%.*s\" is not in locus_contigs", len, name),
+       errhint("Register it with locus_contig_register() and commit.")));
+}
+
+/*
+ * Enter a contig name into locus_contigs, if it is not there, and return
+ * its ID.  The name is taken as the text representation has it, with or
+ * without "chr".  Values can refer to the entry once the transaction that
+ * calls this commits.
+ */
+Datum
+locus_contig_register(PG_FUNCTION_ARGS)
+{
+  text       *arg = PG_GETARG_TEXT_PP(0);
+  const char *name = VARDATA_ANY(arg);
+  int         len = VARSIZE_ANY_EXHDR(arg);
+  bool        chr = len > 3 && strncmp(name, "chr", 3) == 0;
+  const char *contig = chr ? name + 3 : name;
+  int         contig_len = chr ? len - 3 : len;
+  LocusContig *cached;
+  bool        uncommitted;
+  Datum       value;
+  Datum       id;
+  Oid         save_userid;
+  int         save_sec_context;
+  bool        isnull;
+  int         ret;
+
+  if (contig_len > VLOCUS_MAX_CONTIG)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("contig name can't be longer than %d characters", VLOCUS_MAX_CONTIG)));
+  if (!locus_contig_valid(chr, contig, contig_len, VLOCUS_MAX_CONTIG))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("invalid contig name \"%.*s\"", len, name)));
+
+  /* names already there keep their ID, and need no insert */
+  cached = locus_contig_lookup(contig, contig_len, &uncommitted);
+  if (cached != NULL)
+    PG_RETURN_INT32(cached->id);
+
+  if (SPI_connect() != SPI_OK_CONNECT)
+    elog(ERROR, "SPI_connect failed");
+
+  if (contigs_insert_plan == NULL)
+  {
+    const char *table = quote_qualified_identifier(get_namespace_name(get_rel_namespace(contigs_relid)),
+                                                   "locus_contigs");
+    Oid         argtype = TEXTOID;
+    HeapTuple   tuple;
+
+    tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(contigs_relid));
+    if (!HeapTupleIsValid(tuple))
+      elog(ERROR, "cache lookup failed for relation %u", contigs_relid);
+    contigs_owner = ((Form_pg_class) GETSTRUCT(tuple))->relowner;
+    ReleaseSysCache(tuple);
+
+    contigs_select_plan = SPI_prepare(psprintf(contigs_select, table), 1, &argtype);
+    if (contigs_select_plan == NULL)
+      elog(ERROR, "SPI_prepare failed: %s", SPI_result_code_string(SPI_result));
+    SPI_keepplan(contigs_select_plan);
+
+    contigs_insert_plan = SPI_prepare(psprintf(contigs_insert, table), 1, &argtype);
+    if (contigs_insert_plan == NULL)
+      elog(ERROR, "SPI_prepare failed: %s", SPI_result_code_string(SPI_result));
+    SPI_keepplan(contigs_insert_plan);
+  }
+
+  /*
+   * Run as the owner of the table, so that users need no rights on it.
+   * Another backend may enter the same name at the same time: the insert
+   * then waits for it and does nothing, and the name is read again with a
+   * new snapshot.
+   */
+  value = PointerGetDatum(cstring_to_text_with_len(contig, contig_len));
+
+  GetUserIdAndSecContext(&save_userid, &save_sec_context);
+  SetUserIdAndSecContext(contigs_owner, save_sec_context |
+                         SECURITY_LOCAL_USERID_CHANGE | SECURITY_NOFORCE_RLS);
+
+  ret = SPI_execute_plan(contigs_insert_plan, &value, NULL, false, 1);
+  if (ret >= 0 && SPI_processed == 0)
+    ret = SPI_execute_plan(contigs_select_plan, &value, NULL, false, 1);
+
+  SetUserIdAndSecContext(save_userid, save_sec_context);
+
+  if (ret < 0)
+    elog(ERROR, "SPI_execute_plan failed: %s", SPI_result_code_string(ret));
+  if (SPI_processed == 0)
+    elog(ERROR, "could not enter contig \"%.*s\" into locus_contigs", contig_len, contig);
+
+  id = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull);
+
+  SPI_finish();
+
+  PG_RETURN_DATUM(id);
+}
+
+/*
+ * Read a plocus into a LOCUS: the contig is copied when it fits, and
+ * pointed to in the cache otherwise.
+ */
+void
+plocus_view(PLOCUS *value, LOCUS *locus)
+{
+  LocusContig *contig = locus_contig_by_id(value->contig_id);
+
+  locus->lower = value->lower;
+  locus->upper = value->upper;
+  locus->chr = value->chr;
+  locus->flags = contig->flags;
+  memcpy(locus->natkey, contig->natkey, LOCUS_NATKEY_LEN);
+
+  if (contig->len < sizeof(locus->contig))
+    memcpy(locus->contig, contig->name, contig->len + 1);
+  else
+  {
+    const char *name = contig->name;
+
+    memcpy(locus->contig, &name, sizeof(name));
+    locus->flags |= LOCUS_CONTIG_OUT;
+  }
+}
+
+static PLOCUS *
+plocus_build(bool chr, const char *contig, int len, int32 lower, int32 upper)
+{
+  PLOCUS     *result = (PLOCUS *) palloc0(sizeof(PLOCUS));
+
+  result->contig_id = locus_contig_by_name(contig, len)->id;
+  result->lower = lower;
+  result->upper = upper;
+  result->chr = chr;
+
+  return result;
+}
+
+
+/*****************************************************************************
+ * Input/Output functions
+ *****************************************************************************/
+
+Datum
+plocus_in(PG_FUNCTION_ARGS)
+{
+  char       *str = PG_GETARG_CSTRING(0);
+  LOCUS       locus;
+  const char *contig;
+  int         len;
+
+  locus_parse_contig(str, &locus, VLOCUS_MAX_CONTIG, &contig, &len);
+
+  PG_RETURN_POINTER(plocus_build(locus.chr, contig, len, locus.lower, locus.upper));
+}
+
+Datum
+plocus_out(PG_FUNCTION_ARGS)
+{
+  PLOCUS     *value = PG_GETARG_PLOCUS_P(0);
+  LocusContig *contig = locus_contig_by_id(value->contig_id);
+
+  PG_RETURN_CSTRING(locus_format(value->chr, contig->name, contig->len,
+                                 value->lower, value->upper));
+}
+
+/*
+ * Binary representation: that of vlocus, with the contig name rather than
+ * its ID, which only means something in this database
+ */
+#define PLOCUS_BINARY_VERSION  1
+#define PLOCUS_BINARY_CHR      0x01
+
+Datum
+plocus_recv(PG_FUNCTION_ARGS)
+{
+  StringInfo  buf = (StringInfo) PG_GETARG_POINTER(0);
+  int         version;
+  int         flags;
+  int32       lower;
+  int32       upper;
+  int         len;
+  const char *contig;
+
+  version = pq_getmsgbyte(buf);
+  if (version != PLOCUS_BINARY_VERSION)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("unsupported plocus binary format version %d", version)));
+
+  flags = pq_getmsgbyte(buf);
+  lower = pq_getmsgint(buf, 4);
+  upper = pq_getmsgint(buf, 4);
+  len = pq_getmsgbyte(buf);
+
+  if (lower > upper)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("swapped boundaries in external plocus value: %d is greater than %d",
+                lower, upper)));
+
+  if (len < 1)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig length %d in external plocus value", len)));
+
+  /* as plocus_in would produce, before the name is looked up */
+  contig = pq_getmsgbytes(buf, len);
+  if (!locus_contig_valid((flags & PLOCUS_BINARY_CHR) != 0, contig, len,
+                          VLOCUS_MAX_CONTIG))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig in external plocus value")));
+
+  PG_RETURN_POINTER(plocus_build((flags & PLOCUS_BINARY_CHR) != 0, contig, len, lower, upper));
+}
+
+Datum
+plocus_send(PG_FUNCTION_ARGS)
+{
+  PLOCUS     *value = PG_GETARG_PLOCUS_P(0);
+  LocusContig *contig = locus_contig_by_id(value->contig_id);
+  StringInfoData buf;
+
+  pq_begintypsend(&buf);
+  pq_sendbyte(&buf, PLOCUS_BINARY_VERSION);
+  pq_sendbyte(&buf, value->chr ? PLOCUS_BINARY_CHR : 0);
+  pq_sendint32(&buf, value->lower);
+  pq_sendint32(&buf, value->upper);
+  pq_sendbyte(&buf, contig->len);
+  pq_sendbytes(&buf, contig->name, contig->len);
+
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+
+/*****************************************************************************
+ * Casts and accessors
+ *****************************************************************************/
+
+Datum
+plocus(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+
+  PG_RETURN_POINTER(plocus_build(locus->chr, locus->contig, strlen(locus->contig),
+                                 locus->lower, locus->upper));
+}
+
+Datum
+plocus_to_locus(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+  LOCUS      *result;
+
+  plocus_view(PG_GETARG_PLOCUS_P(0), &view);
+
+  if (view.flags & LOCUS_CONTIG_OUT)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("contig \"%s\" is too long for type locus", locus_contig_name(&view))));
+
+  result = (LOCUS *) palloc0(sizeof(LOCUS));
+  result->lower = view.lower;
+  result->upper = view.upper;
+  strcpy(result->contig, view.contig);
+  result->chr = view.chr;
+  result->flags = view.flags;
+  memcpy(result->natkey, view.natkey, LOCUS_NATKEY_LEN);
+
+  PG_RETURN_POINTER(result);
+}
+
+Datum
+plocus_contig(PG_FUNCTION_ARGS)
+{
+  LocusContig *contig = locus_contig_by_id(PG_GETARG_PLOCUS_P(0)->contig_id);
+
+  PG_RETURN_TEXT_P(cstring_to_text_with_len(contig->name, contig->len));
+}
+
+Datum
+plocus_lower(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_INT32(PG_GETARG_PLOCUS_P(0)->lower);
+}
+
+Datum
+plocus_upper(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_INT32(PG_GETARG_PLOCUS_P(0)->upper);
+}
+
+
+/*****************************************************************************
+ * Operators
+ *****************************************************************************/
+
+/*
+ * Compare two plocus values as locus_cmp_internal() does, without looking
+ * their contigs up when the IDs are the same
+ */
+static int32
+plocus_cmp_internal(PLOCUS *a, PLOCUS *b)
+{
+  LOCUS       va;
+  LOCUS       vb;
+
+  if (a->contig_id != b->contig_id)
+  {
+    plocus_view(a, &va);
+    plocus_view(b, &vb);
+
+    return locus_cmp_internal(&va, &vb);
+  }
+
+  if (a->lower != b->lower)
+    return a->lower < b->lower ? -1 : 1;
+  if (a->upper != b->upper)
+    return a->upper < b->upper ? -1 : 1;
+
+  return 0;
+}
+
+/*
+ * Call the locus function op on the two plocus arguments
+ */
+static Datum
+plocus_call(PGFunction op, FunctionCallInfo fcinfo)
+{
+  LOCUS       va;
+  LOCUS       vb;
+
+  plocus_view(PG_GETARG_PLOCUS_P(0), &va);
+  plocus_view(PG_GETARG_PLOCUS_P(1), &vb);
+
+  return DirectFunctionCall2(op, PointerGetDatum(&va), PointerGetDatum(&vb));
+}
+
+Datum
+plocus_cmp(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_INT32(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)));
+}
+
+Datum
+plocus_lt(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) < 0);
+}
+
+Datum
+plocus_le(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) <= 0);
+}
+
+Datum
+plocus_gt(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) > 0);
+}
+
+Datum
+plocus_ge(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) >= 0);
+}
+
+Datum
+plocus_same(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) == 0);
+}
+
+Datum
+plocus_different(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_BOOL(plocus_cmp_internal(PG_GETARG_PLOCUS_P(0), PG_GETARG_PLOCUS_P(1)) != 0);
+}
+
+Datum
+plocus_left(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_left, fcinfo);
+}
+
+Datum
+plocus_right(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_right, fcinfo);
+}
+
+Datum
+plocus_over_left(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_over_left, fcinfo);
+}
+
+Datum
+plocus_over_right(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_over_right, fcinfo);
+}
+
+Datum
+plocus_overlap(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_overlap, fcinfo);
+}
+
+Datum
+plocus_contains(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_contains, fcinfo);
+}
+
+Datum
+plocus_contained(PG_FUNCTION_ARGS)
+{
+  return plocus_call(locus_contained, fcinfo);
+}
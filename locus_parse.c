@@ -0,0 +1,518 @@
+/*
+ * contrib/locus/locus_parse.c
+ *
+ * Parser for the text representation of genomic loci
+ *
+ *   contig
+ *   contig:position
+ *   contig:start-end
+ *   contig:start-
+ *   contig:-end
+ *
+ * This replaces the flex scanner and bison grammar (locus_scan.l,
+ * locus_parse.y) of earlier versions and accepts exactly the same language
+ * with the same error messages.  The scanner state lives on the stack, so
+ * the parser is reentrant and allocates nothing unless it reports an error.
+ *
+ * The scanner reproduces flex's rules: at each position every token pattern
+ * is tried, the longest match wins, and ties go to the pattern listed first:
+ *
+ *   dash                    -
+ *   colon                   :
+ *   position_with_commas    [0-9]{1,3},[0-9]{3}(,[0-9]{3})*
+ *   chr_contig              chr[^: \t\n]{1,11}
+ *   contig                  ^[ \t\n]*[^: \t\n]{1,14}
+ *   contig_long             ^[ \t\n]*[^: \t\n]{14,}
+ *   position                [0-9]+
+ *   [ \t\n]+                (discarded)
+ *   .                       (bad character)
+ *
+ * The two contig patterns are anchored: they only apply at the beginning of
+ * the input or right after a newline.
+ */
+
+#include "postgres.h"
+
+#include <limits.h>  /* for INT_MAX, LONG_MAX */
+
+#include "fmgr.h"
+
+#include "locus_data.h"
+
+
+typedef enum
+{
+  LOCUS_TOKEN_END,
+  LOCUS_TOKEN_DASH,
+  LOCUS_TOKEN_COLON,
+  LOCUS_TOKEN_POSITION_WITH_COMMAS,
+  LOCUS_TOKEN_CHR_CONTIG,
+  LOCUS_TOKEN_CONTIG,
+  LOCUS_TOKEN_CONTIG_LONG,
+  LOCUS_TOKEN_POSITION,
+  LOCUS_TOKEN_BLANK,
+  LOCUS_TOKEN_BAD
+} LocusToken;
+
+typedef struct
+{
+  const char *cur;      /* next character to scan */
+  bool        at_bol;   /* at the beginning of a line */
+  LocusToken  token;    /* last token returned */
+  const char *text;     /* its text */
+  int         len;      /* and length */
+} LocusScanner;
+
+#define is_blank(c)   ((c) == ' ' || (c) == '\t' || (c) == '\n')
+#define is_digit(c)   ((c) >= '0' && (c) <= '9')
+#define is_contig(c)  ((c) != '\0' && (c) != ':' && !is_blank(c))
+
+static void locus_syntax_error(LocusScanner *sc) pg_attribute_noreturn();
+static void locus_contig_too_long(int maxlen) pg_attribute_noreturn();
+
+
+static inline int
+span_digits(const char *p)
+{
+  const char *s = p;
+
+  while (is_digit(*s))
+    s++;
+  return s - p;
+}
+
+static inline int
+span_blanks(const char *p)
+{
+  const char *s = p;
+
+  while (is_blank(*s))
+    s++;
+  return s - p;
+}
+
+static inline int
+span_contig(const char *p)
+{
+  const char *s = p;
+
+  while (is_contig(*s))
+    s++;
+  return s - p;
+}
+
+/*
+ * Return the next token, skipping blanks.
+ */
+static LocusToken
+locus_scan(LocusScanner *sc)
+{
+  for (;;)
+  {
+    const char *p = sc->cur;
+    LocusToken  token = LOCUS_TOKEN_BAD;
+    int         best = 0;
+    int         digits;
+
+#define CANDIDATE(t, l) \
+    do { if ((l) > best) { best = (l); token = (t); } } while (0)
+
+    if (*p == '\0')
+    {
+      sc->token = LOCUS_TOKEN_END;
+      sc->text = p;
+      sc->len = 0;
+      return sc->token;
+    }
+
+    if (*p == '-')
+      CANDIDATE(LOCUS_TOKEN_DASH, 1);
+    else if (*p == ':')
+      CANDIDATE(LOCUS_TOKEN_COLON, 1);
+
+    digits = span_digits(p);
+    if (digits >= 1 && digits <= 3)
+    {
+      const char *s = p + digits;
+
+      while (s[0] == ',' && is_digit(s[1]) && is_digit(s[2]) && is_digit(s[3]))
+        s += 4;
+      if (s > p + digits)
+        CANDIDATE(LOCUS_TOKEN_POSITION_WITH_COMMAS, s - p);
+    }
+
+    if (p[0] == 'c' && p[1] == 'h' && p[2] == 'r')
+    {
+      int     run = span_contig(p + 3);
+
+      if (run >= 1)
+        CANDIDATE(LOCUS_TOKEN_CHR_CONTIG, 3 + Min(run, 11));
+    }
+
+    if (sc->at_bol)
+    {
+      int     blanks = span_blanks(p);
+      int     run = span_contig(p + blanks);
+
+      if (run >= 1)
+        CANDIDATE(LOCUS_TOKEN_CONTIG, blanks + Min(run, 14));
+      if (run >= 14)
+        CANDIDATE(LOCUS_TOKEN_CONTIG_LONG, blanks + run);
+    }
+
+    if (digits >= 1)
+      CANDIDATE(LOCUS_TOKEN_POSITION, digits);
+
+    CANDIDATE(LOCUS_TOKEN_BLANK, span_blanks(p));
+
+    if (*p != '\n')
+      CANDIDATE(LOCUS_TOKEN_BAD, 1);
+
+#undef CANDIDATE
+
+    sc->cur = p + best;
+    sc->at_bol = (p[best - 1] == '\n');
+
+    if (token == LOCUS_TOKEN_BLANK)
+      continue;
+
+    if (token == LOCUS_TOKEN_BAD)
+      ereport(ERROR,
+          (errcode(ERRCODE_SYNTAX_ERROR),
+           errmsg("locus syntax error"),
+           errdetail(" bad character %c", *p)));
+
+    sc->token = token;
+    sc->text = p;
+    sc->len = best;
+    return token;
+  }
+}
+
+static void
+locus_syntax_error(LocusScanner *sc)
+{
+  if (sc->token == LOCUS_TOKEN_END)
+  {
+    ereport(ERROR,
+        (errcode(ERRCODE_SYNTAX_ERROR),
+         errmsg("bad locus representation"),
+         /* translator: %s is typically "syntax error" */
+         errdetail("%s at end of input", "syntax error")));
+  }
+  else
+  {
+    ereport(ERROR,
+        (errcode(ERRCODE_SYNTAX_ERROR),
+         errmsg("bad locus representation"),
+         /* translator: first %s is typically "syntax error" */
+         errdetail("%s at or near \"%.*s\"", "syntax error", sc->len, sc->text)));
+  }
+}
+
+static void
+locus_contig_too_long(int maxlen)
+{
+  if (maxlen == sizeof(((LOCUS *) 0)->contig) - 1)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("Conting name can't be longer than 15 characters")));
+
+  ereport(ERROR,
+      (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+       errmsg("contig name can't be longer than %d characters", maxlen)));
+}
+
+/*
+ * Convert the current POSITION or POSITION_WITH_COMMAS token.  The checks
+ * follow the strtol() calls of the old grammar, including the platform's
+ * long range.
+ */
+static int32
+locus_scan_boundary(LocusScanner *sc)
+{
+  const char *p = sc->text;
+  const char *end = sc->text + sc->len;
+  long        val = 0;
+  bool        overflow = false;
+
+  for (; p < end; p++)
+  {
+    int     digit;
+
+    if (*p == ',')
+      continue;
+
+    digit = *p - '0';
+    if (val > (LONG_MAX - digit) / 10)
+    {
+      overflow = true;
+      break;
+    }
+    val = val * 10 + digit;
+  }
+
+  if (sc->token == LOCUS_TOKEN_POSITION)
+  {
+    if (overflow)
+      ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("invalid number %.*s (long overflow)", sc->len, sc->text)));
+    else if (val > INT_MAX)
+      ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("invalid number %.*s (int32 overflow)", sc->len, sc->text)));
+  }
+  else
+  {
+    if (overflow)
+      ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("invalid number %lu (overflow)", (unsigned long) LONG_MAX)));
+    else if (val > INT_MAX)
+    {
+      char     *digits = palloc(sc->len + 1);
+      char     *d = digits;
+
+      for (p = sc->text; p < end; p++)
+        if (*p != ',')
+          *d++ = *p;
+      *d = '\0';
+
+      ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("invalid number %s (int32 overflow)", digits)));
+    }
+  }
+
+  return (int32) val;
+}
+
+#define is_boundary(t) \
+  ((t) == LOCUS_TOKEN_POSITION || (t) == LOCUS_TOKEN_POSITION_WITH_COMMAS)
+
+#define is_contig_token(t) \
+  ((t) == LOCUS_TOKEN_CHR_CONTIG || (t) == LOCUS_TOKEN_CONTIG || \
+   (t) == LOCUS_TOKEN_CONTIG_LONG)
+
+/*
+ * Scan the contig at the beginning of the input: it starts at *contig and
+ * takes *len bytes, and the chr flag of result is set.  Return false if the
+ * input does not start with a contig of at most maxlen characters.
+ */
+static bool
+locus_scan_contig(LocusScanner *sc, LOCUS *result, int maxlen,
+                  const char **contig, int *len)
+{
+  switch (locus_scan(sc))
+  {
+    case LOCUS_TOKEN_CHR_CONTIG:
+      *contig = sc->text + 3;
+      *len = sc->len - 3;
+      result->chr = true;
+      break;
+
+    case LOCUS_TOKEN_CONTIG:
+      *contig = sc->text;
+      *len = sc->len;
+      result->chr = false;
+      break;
+
+    case LOCUS_TOKEN_CONTIG_LONG:
+      if (maxlen < sc->len - span_blanks(sc->text))
+        return false;
+      *contig = sc->text + span_blanks(sc->text);
+      *len = sc->len - (*contig - sc->text);
+      result->chr = *len > 3 && strncmp(*contig, "chr", 3) == 0;
+      if (result->chr)
+      {
+        *contig += 3;
+        *len -= 3;
+      }
+      break;
+
+    default:
+      return false;
+  }
+
+  /* leading blanks count towards the contig token but not towards the limit */
+  return *len <= maxlen;
+}
+
+/*
+ * Parse str into result, leaving the contig, of at most maxlen characters,
+ * in str: it starts at *contig and takes *len bytes.  Only the positions and
+ * the chr flag are set.  Contigs longer than the chr_contig and contig
+ * patterns allow come as a single contig_long token, which locus rejects;
+ * with a greater maxlen, it is taken like contig, dropping leading blanks
+ * and a "chr" prefix.
+ */
+void
+locus_parse_contig(const char *str, LOCUS *result, int maxlen,
+                   const char **contig, int *len)
+{
+  LocusScanner sc;
+
+  sc.cur = str;
+  sc.at_bol = true;
+
+  if (!locus_scan_contig(&sc, result, maxlen, contig, len))
+  {
+    if (is_contig_token(sc.token))
+      locus_contig_too_long(maxlen);
+    locus_syntax_error(&sc);
+  }
+
+  result->lower = 0;
+  result->upper = INT_MAX;
+
+  if (locus_scan(&sc) == LOCUS_TOKEN_COLON)
+  {
+    locus_scan(&sc);
+
+    if (is_boundary(sc.token))
+    {
+      /* contig:start, contig:start-, contig:start-end */
+      result->lower = locus_scan_boundary(&sc);
+      result->upper = result->lower;
+
+      if (locus_scan(&sc) == LOCUS_TOKEN_DASH)
+      {
+        result->upper = INT_MAX;
+        locus_scan(&sc);
+        if (is_boundary(sc.token))
+        {
+          result->upper = locus_scan_boundary(&sc);
+          locus_scan(&sc);
+        }
+      }
+    }
+    else if (sc.token == LOCUS_TOKEN_DASH)
+    {
+      /* contig:-end */
+      locus_scan(&sc);
+      if (!is_boundary(sc.token))
+        locus_syntax_error(&sc);
+      result->upper = locus_scan_boundary(&sc);
+      locus_scan(&sc);
+    }
+    else
+      locus_syntax_error(&sc);
+  }
+
+  if (sc.token != LOCUS_TOKEN_END)
+    locus_syntax_error(&sc);
+
+  if (result->lower > result->upper)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("swapped boundaries: %d is greater than %d",
+            result->lower, result->upper)));
+}
+
+/*
+ * Parse str into result.  Only the position and contig fields are set; the
+ * caller computes the natural-order key.
+ */
+void
+locus_parse(const char *str, LOCUS *result)
+{
+  const char *contig;
+  int         len;
+
+  locus_parse_contig(str, result, sizeof(result->contig) - 1, &contig, &len);
+
+  memcpy(result->contig, contig, len);
+  result->contig[len] = '\0';
+}
+
+/*
+ * Check that a contig of at most maxlen characters, with the given chr flag,
+ * is one that the text parser produces, so that the value prints back as
+ * itself: the name must make up a single contig token once the "chr" prefix
+ * is put back.  Values that do not come from the text representation, such
+ * as the binary one, are checked with this.
+ */
+bool
+locus_contig_valid(bool chr, const char *name, int len, int maxlen)
+{
+  char        text[3 + VLOCUS_MAX_CONTIG + 1];
+  LocusScanner sc;
+  LOCUS       parsed;
+  const char *contig;
+  int         contig_len;
+  int         i;
+
+  if (len < 1 || len > maxlen || len > VLOCUS_MAX_CONTIG)
+    return false;
+
+  /* this also keeps the scanner from reporting a bad character */
+  for (i = 0; i < len; i++)
+    if (!is_contig(name[i]) && !is_blank(name[i]))
+      return false;
+
+  if (chr)
+    memcpy(text, "chr", 3);
+  memcpy(text + (chr ? 3 : 0), name, len);
+  text[(chr ? 3 : 0) + len] = '\0';
+
+  sc.cur = text;
+  sc.at_bol = true;
+
+  return locus_scan_contig(&sc, &parsed, maxlen, &contig, &contig_len) &&
+    *sc.cur == '\0' && parsed.chr == chr &&
+    contig_len == len && memcmp(contig, name, len) == 0;
+}
+
+/*
+ * Set the contig of result from a name that does not come from the text
+ * representation, such as a column of a BED or VCF file.  A "chr" prefix is
+ * taken as the parser takes it, and the rest must be a contig that a locus
+ * can hold and print back.  The caller computes the natural-order key.
+ */
+void
+locus_parse_name(const char *name, int len, LOCUS *result)
+{
+  const char *contig = name;
+  int         i;
+
+  for (i = 0; i < len; i++)
+    if (!is_contig(name[i]))
+      ereport(ERROR,
+          (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+           errmsg("invalid contig name \"%.*s\"", len, name)));
+
+  result->chr = len > 3 && strncmp(name, "chr", 3) == 0;
+  if (result->chr)
+  {
+    contig += 3;
+    len -= 3;
+  }
+
+  if (len > sizeof(result->contig) - 1)
+    locus_contig_too_long(sizeof(result->contig) - 1);
+  if (!locus_contig_valid(result->chr, contig, len, sizeof(result->contig) - 1))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("invalid contig name \"%.*s\"", (int) (contig - name) + len, name)));
+
+  memcpy(result->contig, contig, len);
+  result->contig[len] = '\0';
+}
+
+/*
+ * Whether locus_parse_name takes a name without an error, for callers that
+ * would rather pass over the records a locus cannot hold
+ */
+bool
+locus_name_valid(const char *name, int len)
+{
+  const int   maxlen = sizeof(((LOCUS *) NULL)->contig) - 1;
+  bool        chr;
+  int         i;
+
+  for (i = 0; i < len; i++)
+    if (!is_contig(name[i]))
+      return false;
+
+  chr = len > 3 && strncmp(name, "chr", 3) == 0;
+  if (chr)
+  {
+    name += 3;
+    len -= 3;
+  }
+
+  return len <= maxlen && locus_contig_valid(chr, name, len, maxlen);
+}
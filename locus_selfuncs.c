@@ -0,0 +1,1256 @@
+/*
+ * contrib/locus/locus_selfuncs.c
+ *
+ * ANALYZE support and selectivity estimation for genomic loci
+ *
+ * locus_typanalyze keeps the standard statistics (null fraction, number of
+ * distinct values, most common values, histogram, correlation) and adds two
+ * slots of its own, with stakind codes from the range pg_statistic.h leaves
+ * for private use:
+ *
+ *   LOCUS_STATS_CONTIGS  values: one locus per contig, from the smallest
+ *                        lower to the largest upper boundary seen on it, for
+ *                        the most frequent contigs in natural contig order;
+ *                        numbers: the fraction of rows on each of them, the
+ *                        fraction of "<all>" rows, the average fraction of
+ *                        rows on a contig left off the list, and the mean
+ *                        length of the loci on each listed contig
+ *   LOCUS_STATS_BOUNDS   values: an equi-depth histogram of lower boundaries
+ *                        followed by one of upper boundaries, both ordered by
+ *                        (contig, position) like locus_cmp; each entry is a
+ *                        locus with lower = upper = the boundary;
+ *                        numbers: an equi-depth histogram of upper - lower
+ *
+ * Wildcard loci stay out of all three histograms.  The standard statistics
+ * of a scalar type take at most three of the five slots, so ours always fit
+ * next to them.
+ *
+ * The estimators look at one contig at a time.  On a contig, a boundary is
+ * taken to follow the piecewise linear distribution through the histogram
+ * entries on that contig, stretched to the contig's extent and scaled to its
+ * frequency; lengths follow the length histogram, scaled to the contig's mean
+ * length, independently of position.
+ * Overlap and containment then come down to the probability that
+ * lower + length lands on one side of a query boundary, which is integrated
+ * exactly over every pair of position segment and length bin.  Unlike the
+ * difference of two bound distributions that range types use, this stays
+ * accurate for queries much narrower than a histogram bin.
+ *
+ * Join estimates place the loci of both sides uniformly over the extent of
+ * each contig they share.
+ */
+
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
+#include "commands/vacuum.h"
+#include "fmgr.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+
+#include "locus_data.h"
+
+
+PG_FUNCTION_INFO_V1(locus_typanalyze);
+PG_FUNCTION_INFO_V1(locus_overlap_sel);
+PG_FUNCTION_INFO_V1(locus_contains_sel);
+PG_FUNCTION_INFO_V1(locus_contained_sel);
+PG_FUNCTION_INFO_V1(locus_left_sel);
+PG_FUNCTION_INFO_V1(locus_right_sel);
+PG_FUNCTION_INFO_V1(locus_overlap_joinsel);
+PG_FUNCTION_INFO_V1(locus_contains_joinsel);
+PG_FUNCTION_INFO_V1(locus_contained_joinsel);
+PG_FUNCTION_INFO_V1(locus_left_joinsel);
+PG_FUNCTION_INFO_V1(locus_right_joinsel);
+
+#define LOCUS_STATS_CONTIGS  10001
+#define LOCUS_STATS_BOUNDS   10002
+#define LOCUS_STATS_NSLOTS   2
+
+/* estimates without statistics, the same as contsel and positionsel */
+#define DEFAULT_LOCUS_CONT_SEL      0.001
+#define DEFAULT_LOCUS_POSITION_SEL  0.1
+
+typedef enum
+{
+  LOCUS_SEL_OVERLAP,     /* var && const */
+  LOCUS_SEL_OVERLAPPED,  /* const && var */
+  LOCUS_SEL_CONTAINS,    /* var @> const */
+  LOCUS_SEL_CONTAINED,   /* var <@ const */
+  LOCUS_SEL_LEFT,        /* var << const */
+  LOCUS_SEL_RIGHT        /* var >> const */
+} LocusSelOp;
+
+
+/*****************************************************************************
+ * ANALYZE
+ *****************************************************************************/
+
+typedef struct
+{
+  AnalyzeAttrComputeStatsFunc std_compute_stats;
+  void     *std_extra_data;
+} LocusAnalyzeExtraData;
+
+typedef struct
+{
+  LOCUS    *first;  /* a locus on the contig */
+  int       count;
+  int32     min;    /* smallest lower boundary */
+  int32     max;    /* largest upper boundary */
+  float8    length; /* sum of lengths */
+} LocusContigCount;
+
+static void compute_locus_stats(VacAttrStats *stats,
+                                AnalyzeAttrFetchFunc fetchfunc,
+                                int samplerows, double totalrows);
+
+Datum
+locus_typanalyze(PG_FUNCTION_ARGS)
+{
+  VacAttrStats *stats = (VacAttrStats *) PG_GETARG_POINTER(0);
+  LocusAnalyzeExtraData *extra;
+
+  if (!std_typanalyze(stats))
+    PG_RETURN_BOOL(false);
+
+  extra = (LocusAnalyzeExtraData *) palloc(sizeof(LocusAnalyzeExtraData));
+  extra->std_compute_stats = stats->compute_stats;
+  extra->std_extra_data = stats->extra_data;
+
+  stats->compute_stats = compute_locus_stats;
+  stats->extra_data = extra;
+
+  PG_RETURN_BOOL(true);
+}
+
+static int
+locus_lower_qsort_cmp(const void *a, const void *b)
+{
+  LOCUS    *la = *(LOCUS *const *) a;
+  LOCUS    *lb = *(LOCUS *const *) b;
+  int       cmp = locus_contig_cmp(la, lb);
+
+  if (cmp != 0)
+    return cmp;
+  if (la->lower != lb->lower)
+    return la->lower < lb->lower ? -1 : 1;
+  return 0;
+}
+
+static int
+locus_upper_qsort_cmp(const void *a, const void *b)
+{
+  LOCUS    *la = *(LOCUS *const *) a;
+  LOCUS    *lb = *(LOCUS *const *) b;
+  int       cmp = locus_contig_cmp(la, lb);
+
+  if (cmp != 0)
+    return cmp;
+  if (la->upper != lb->upper)
+    return la->upper < lb->upper ? -1 : 1;
+  return 0;
+}
+
+static int
+locus_contig_count_qsort_cmp(const void *a, const void *b)
+{
+  const LocusContigCount *ca = a;
+  const LocusContigCount *cb = b;
+
+  /* most frequent first */
+  if (ca->count != cb->count)
+    return ca->count > cb->count ? -1 : 1;
+  return locus_contig_cmp(ca->first, cb->first);
+}
+
+static int
+locus_contig_order_qsort_cmp(const void *a, const void *b)
+{
+  const LocusContigCount *ca = a;
+  const LocusContigCount *cb = b;
+
+  return locus_contig_cmp(ca->first, cb->first);
+}
+
+static int
+locus_float8_qsort_cmp(const void *a, const void *b)
+{
+  float8    fa = *(const float8 *) a;
+  float8    fb = *(const float8 *) b;
+
+  if (fa != fb)
+    return fa < fb ? -1 : 1;
+  return 0;
+}
+
+/*
+ * A copy of locus with the given boundaries
+ */
+static Datum
+locus_stats_value(LOCUS *locus, int32 lower, int32 upper)
+{
+  LOCUS    *value = (LOCUS *) palloc(sizeof(LOCUS));
+
+  memcpy(value, locus, sizeof(LOCUS));
+  value->lower = lower;
+  value->upper = upper;
+
+  return PointerGetDatum(value);
+}
+
+/*
+ * Find room for our slots after the standard ones.  Returns the first free
+ * slot, or -1.
+ */
+static int
+locus_stats_free_slots(VacAttrStats *stats)
+{
+  int       nused = 0;
+
+  while (nused < STATISTIC_NUM_SLOTS && stats->stakind[nused] != 0)
+    nused++;
+
+  return nused + LOCUS_STATS_NSLOTS <= STATISTIC_NUM_SLOTS ? nused : -1;
+}
+
+static void
+locus_stats_set_slot(VacAttrStats *stats, int slot, int16 kind,
+                     float4 *numbers, int nnumbers, Datum *values, int nvalues)
+{
+  stats->stakind[slot] = kind;
+  stats->staop[slot] = InvalidOid;
+  stats->stacoll[slot] = InvalidOid;
+  stats->stanumbers[slot] = numbers;
+  stats->numnumbers[slot] = nnumbers;
+  stats->stavalues[slot] = values;
+  stats->numvalues[slot] = nvalues;
+  stats->statypid[slot] = stats->attrtypid;
+  stats->statyplen[slot] = stats->attrtype->typlen;
+  stats->statypbyval[slot] = stats->attrtype->typbyval;
+  stats->statypalign[slot] = stats->attrtype->typalign;
+}
+
+/*
+ * Position of the i-th of num_hist evenly spaced entries among n sorted
+ * ones, the first and the last included
+ */
+static inline int
+histogram_pos(int i, int n, int num_hist)
+{
+  return (int) (((int64) i * (n - 1)) / (num_hist - 1));
+}
+
+static void
+compute_locus_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
+                    int samplerows, double totalrows)
+{
+  LocusAnalyzeExtraData *extra = (LocusAnalyzeExtraData *) stats->extra_data;
+  LOCUS   **loci;
+  float8   *lengths;
+  LocusContigCount *contigs;
+  int       nloci = 0;
+  int       nwildcards = 0;
+  int       ncontigs = 0;
+  int       nlisted;
+  int       nlisted_loci = 0;
+  int       num_hist;
+  int       slot;
+  int       i;
+  Datum    *values;
+  float4   *numbers;
+  MemoryContext old_cxt;
+
+  /* the standard statistics first */
+  stats->extra_data = extra->std_extra_data;
+  extra->std_compute_stats(stats, fetchfunc, samplerows, totalrows);
+  stats->extra_data = extra;
+
+  if (!stats->stats_valid)
+    return;
+
+  loci = (LOCUS **) palloc(sizeof(LOCUS *) * samplerows);
+  lengths = (float8 *) palloc(sizeof(float8) * samplerows);
+
+  for (i = 0; i < samplerows; i++)
+  {
+    Datum     value;
+    bool      isnull;
+    LOCUS    *locus;
+
+    vacuum_delay_point();
+
+    value = fetchfunc(stats, i, &isnull);
+    if (isnull)
+      continue;
+
+    locus = DatumGetLocusP(value);
+    if (LOCUS_IS_WILDCARD(locus))
+    {
+      nwildcards++;
+      continue;
+    }
+
+    loci[nloci] = locus;
+    lengths[nloci] = (float8) ((int64) locus->upper - locus->lower);
+    nloci++;
+  }
+
+  if (nloci < 2)
+    return;
+
+  slot = locus_stats_free_slots(stats);
+  if (slot < 0)
+    return;
+
+  /* count the loci on each contig, walking them in (contig, lower) order */
+  qsort(loci, nloci, sizeof(LOCUS *), locus_lower_qsort_cmp);
+
+  contigs = (LocusContigCount *) palloc(sizeof(LocusContigCount) * nloci);
+  for (i = 0; i < nloci; i++)
+  {
+    LocusContigCount *contig;
+
+    if (ncontigs == 0 || locus_contig_cmp(loci[i], contigs[ncontigs - 1].first) != 0)
+    {
+      contig = &contigs[ncontigs++];
+      contig->first = loci[i];
+      contig->count = 0;
+      contig->min = loci[i]->lower;
+      contig->max = loci[i]->upper;
+      contig->length = 0.0;
+    }
+    else
+      contig = &contigs[ncontigs - 1];
+
+    contig->count++;
+    contig->max = Max(contig->max, loci[i]->upper);
+    contig->length += (float8) ((int64) loci[i]->upper - loci[i]->lower);
+  }
+
+  /* keep the most frequent contigs, back in natural order */
+  nlisted = Min(ncontigs, stats->attstattarget);
+  if (nlisted < ncontigs)
+  {
+    qsort(contigs, ncontigs, sizeof(LocusContigCount), locus_contig_count_qsort_cmp);
+    qsort(contigs, nlisted, sizeof(LocusContigCount), locus_contig_order_qsort_cmp);
+  }
+
+  old_cxt = MemoryContextSwitchTo(stats->anl_context);
+
+  values = (Datum *) palloc(sizeof(Datum) * nlisted);
+  numbers = (float4 *) palloc(sizeof(float4) * (nlisted * 2 + 2));
+  for (i = 0; i < nlisted; i++)
+  {
+    values[i] = locus_stats_value(contigs[i].first, contigs[i].min, contigs[i].max);
+    numbers[i] = (double) contigs[i].count / samplerows;
+    numbers[nlisted + 2 + i] = contigs[i].length / contigs[i].count;
+    nlisted_loci += contigs[i].count;
+  }
+  numbers[nlisted] = (double) nwildcards / samplerows;
+  numbers[nlisted + 1] = nlisted < ncontigs ?
+    (double) (nloci - nlisted_loci) / samplerows / (ncontigs - nlisted) : 0.0;
+
+  locus_stats_set_slot(stats, slot, LOCUS_STATS_CONTIGS,
+                       numbers, nlisted * 2 + 2, values, nlisted);
+
+  /* bound histograms: lower boundaries first, then upper */
+  num_hist = Min(nloci, stats->attstattarget + 1);
+
+  values = (Datum *) palloc(sizeof(Datum) * num_hist * 2);
+  for (i = 0; i < num_hist; i++)
+  {
+    LOCUS    *locus = loci[histogram_pos(i, nloci, num_hist)];
+
+    values[i] = locus_stats_value(locus, locus->lower, locus->lower);
+  }
+
+  qsort(loci, nloci, sizeof(LOCUS *), locus_upper_qsort_cmp);
+  for (i = 0; i < num_hist; i++)
+  {
+    LOCUS    *locus = loci[histogram_pos(i, nloci, num_hist)];
+
+    values[num_hist + i] = locus_stats_value(locus, locus->upper, locus->upper);
+  }
+
+  /* and the length histogram, in the numbers of the same slot */
+  qsort(lengths, nloci, sizeof(float8), locus_float8_qsort_cmp);
+
+  numbers = (float4 *) palloc(sizeof(float4) * num_hist);
+  for (i = 0; i < num_hist; i++)
+    numbers[i] = (float4) lengths[histogram_pos(i, nloci, num_hist)];
+
+  locus_stats_set_slot(stats, slot + 1, LOCUS_STATS_BOUNDS,
+                       numbers, num_hist, values, num_hist * 2);
+
+  MemoryContextSwitchTo(old_cxt);
+}
+
+
+/*****************************************************************************
+ * Statistics as seen by the estimators
+ *****************************************************************************/
+
+typedef struct
+{
+  AttStatsSlot contigs_slot;
+  AttStatsSlot bounds_slot;
+
+  int       ncontigs;
+  Datum    *contigs;        /* LOCUS spanning each listed contig */
+  float4   *freqs;          /* fraction of rows on each listed contig */
+  float4   *mean_lengths;   /* mean length on each listed contig */
+  double    wildcard_frac;  /* fraction of "<all>" rows */
+  double    unlisted_frac;  /* fraction of rows on one unlisted contig */
+  double    real_frac;      /* fraction of rows with a real contig */
+
+  int       nbounds;        /* entries in each bound histogram */
+  Datum    *lower;
+  Datum    *upper;
+  double    bin_frac;       /* fraction of rows per bound histogram bin */
+
+  int       nlengths;
+  float8   *lengths;
+  float8    mean_length;    /* of the length histogram */
+} LocusStats;
+
+/*
+ * Length histogram bins, each taken at its midpoint for the means.  Lengths
+ * on one contig are modelled by the whole histogram times the ratio of the
+ * contig's mean length to the histogram's.
+ */
+#define LENGTH_BINS(ls)  Max((ls)->nlengths - 1, 1)
+
+static inline float8
+locus_length_bin_mid(LocusStats *ls, int i)
+{
+  if (ls->nlengths == 1)
+    return ls->lengths[0];
+  return (ls->lengths[i] + ls->lengths[i + 1]) / 2.0;
+}
+
+static float8
+locus_mean_length(LocusStats *ls)
+{
+  float8    sum = 0.0;
+  int       i;
+
+  for (i = 0; i < LENGTH_BINS(ls); i++)
+    sum += locus_length_bin_mid(ls, i);
+
+  return sum / LENGTH_BINS(ls);
+}
+
+static float8
+locus_length_scale(LocusStats *ls, int contig)
+{
+  if (contig < 0 || ls->mean_length <= 0.0)
+    return 1.0;
+  return ls->mean_lengths[contig] / ls->mean_length;
+}
+
+/*
+ * Mean of (a - b + 1)+ for lengths a and b from two scaled length histograms
+ */
+static float8
+locus_mean_length_excess(LocusStats *a, float8 scale_a, LocusStats *b, float8 scale_b)
+{
+  float8    sum = 0.0;
+  int       i;
+  int       j;
+
+  for (i = 0; i < LENGTH_BINS(a); i++)
+    for (j = 0; j < LENGTH_BINS(b); j++)
+      sum += Max(locus_length_bin_mid(a, i) * scale_a -
+                 locus_length_bin_mid(b, j) * scale_b + 1.0, 0.0);
+
+  return sum / LENGTH_BINS(a) / LENGTH_BINS(b);
+}
+
+static void
+locus_stats_release(LocusStats *ls)
+{
+  free_attstatsslot(&ls->contigs_slot);
+  free_attstatsslot(&ls->bounds_slot);
+  if (ls->lengths)
+    pfree(ls->lengths);
+}
+
+/*
+ * Load the statistics of vardata.  Returns false if there are none, e.g.
+ * because the column was last analyzed by an older version.
+ */
+static bool
+locus_stats_fetch(VariableStatData *vardata, LocusStats *ls)
+{
+  int       i;
+
+  memset(ls, 0, sizeof(LocusStats));
+
+  if (!HeapTupleIsValid(vardata->statsTuple))
+    return false;
+
+  if (!get_attstatsslot(&ls->contigs_slot, vardata->statsTuple,
+                        LOCUS_STATS_CONTIGS, InvalidOid,
+                        ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS) ||
+      !get_attstatsslot(&ls->bounds_slot, vardata->statsTuple,
+                        LOCUS_STATS_BOUNDS, InvalidOid,
+                        ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS) ||
+      ls->contigs_slot.nnumbers != ls->contigs_slot.nvalues * 2 + 2 ||
+      ls->bounds_slot.nvalues < 4 || ls->bounds_slot.nvalues % 2 != 0 ||
+      ls->bounds_slot.nnumbers < 1)
+  {
+    locus_stats_release(ls);
+    return false;
+  }
+
+  ls->ncontigs = ls->contigs_slot.nvalues;
+  ls->contigs = ls->contigs_slot.values;
+  ls->freqs = ls->contigs_slot.numbers;
+  ls->wildcard_frac = ls->freqs[ls->ncontigs];
+  ls->unlisted_frac = ls->freqs[ls->ncontigs + 1];
+  ls->mean_lengths = ls->freqs + ls->ncontigs + 2;
+  ls->real_frac = 1.0 - ((Form_pg_statistic) GETSTRUCT(vardata->statsTuple))->stanullfrac -
+    ls->wildcard_frac;
+  ls->real_frac = Max(ls->real_frac, 0.0);
+
+  ls->nbounds = ls->bounds_slot.nvalues / 2;
+  ls->lower = ls->bounds_slot.values;
+  ls->upper = ls->bounds_slot.values + ls->nbounds;
+  ls->bin_frac = ls->real_frac / (ls->nbounds - 1);
+
+  ls->nlengths = ls->bounds_slot.nnumbers;
+  ls->lengths = (float8 *) palloc(sizeof(float8) * ls->nlengths);
+  for (i = 0; i < ls->nlengths; i++)
+    ls->lengths[i] = ls->bounds_slot.numbers[i];
+  ls->mean_length = locus_mean_length(ls);
+
+  return true;
+}
+
+/*
+ * Index of the listed contig of locus, or -1
+ */
+static int
+locus_stats_find_contig(LocusStats *ls, LOCUS *locus)
+{
+  int       lo = 0;
+  int       hi = ls->ncontigs - 1;
+
+  while (lo <= hi)
+  {
+    int       mid = (lo + hi) / 2;
+    int       cmp = locus_contig_cmp(locus, DatumGetLocusP(ls->contigs[mid]));
+
+    if (cmp == 0)
+      return mid;
+    if (cmp < 0)
+      hi = mid - 1;
+    else
+      lo = mid + 1;
+  }
+
+  return -1;
+}
+
+/*****************************************************************************
+ * Boundary distributions
+ *****************************************************************************/
+
+/*
+ * The distribution of one kind of boundary over one contig: cum[i] is the
+ * fraction of all rows whose boundary lies on this contig at or below x[i],
+ * with linear interpolation in between.  Equal neighbouring knots carry a
+ * point mass.
+ */
+typedef struct
+{
+  int       nknots;
+  float8   *x;
+  float8   *cum;
+  float8    length_scale;  /* for the lengths of loci on the contig */
+  float8    max_length;
+} LocusDist;
+
+/*
+ * Build the distribution of the lower (or upper) boundaries of loci on the
+ * contig of locus.  The histogram entries on the contig are evenly spaced in
+ * rank; whatever the contig's frequency leaves over is spread evenly over
+ * the stretches from its first entry down to the contig's smallest boundary
+ * and from its last entry up to the largest.  Returns false if nothing is
+ * known about the contig.
+ */
+static bool
+locus_dist_build(LocusStats *ls, LOCUS *locus, bool upper, LocusDist *dist)
+{
+  Datum    *bounds = upper ? ls->upper : ls->lower;
+  int       idx = locus_stats_find_contig(ls, locus);
+  float8    freq;
+  float8    ext_min;
+  float8    ext_max;
+  float8    interior;
+  float8    head;
+  float8    tail;
+  float8    end;
+  int       first = -1;
+  int       k = 0;
+  int       i;
+
+  for (i = 0; i < ls->nbounds; i++)
+  {
+    if (locus_contig_cmp(DatumGetLocusP(bounds[i]), locus) == 0)
+    {
+      if (first < 0)
+        first = i;
+      k++;
+    }
+  }
+
+  if (idx >= 0)
+  {
+    LOCUS    *contig = DatumGetLocusP(ls->contigs[idx]);
+
+    freq = ls->freqs[idx];
+    ext_min = contig->lower;
+    ext_max = contig->upper;
+  }
+  else if (k > 0)
+  {
+    freq = Max(ls->unlisted_frac, (k - 1) * ls->bin_frac);
+    ext_min = DatumGetLocusP(bounds[first])->lower;
+    ext_max = DatumGetLocusP(bounds[first + k - 1])->lower;
+  }
+  else
+    return false;
+
+  dist->nknots = k + 2;
+  dist->x = (float8 *) palloc(sizeof(float8) * dist->nknots);
+  dist->cum = (float8 *) palloc(sizeof(float8) * dist->nknots);
+
+  interior = k > 1 ? Min((k - 1) * ls->bin_frac, freq) : 0.0;
+  end = (freq - interior) / 2.0;
+  if (k > 0)
+  {
+    head = Max(DatumGetLocusP(bounds[first])->lower - ext_min, 0.0);
+    tail = Max(ext_max - DatumGetLocusP(bounds[first + k - 1])->lower, 0.0);
+    if (head + tail > 0.0)
+      end = (freq - interior) * head / (head + tail);
+  }
+
+  dist->x[0] = ext_min;
+  dist->cum[0] = 0.0;
+  for (i = 0; i < k; i++)
+  {
+    dist->x[i + 1] = Max(DatumGetLocusP(bounds[first + i])->lower, dist->x[i]);
+    dist->cum[i + 1] = end + (k > 1 ? interior * i / (k - 1) : 0.0);
+  }
+  dist->x[k + 1] = Max(ext_max, dist->x[k]);
+  dist->cum[k + 1] = freq;
+
+  dist->length_scale = locus_length_scale(ls, idx);
+  dist->max_length = ls->lengths[ls->nlengths - 1] * dist->length_scale;
+
+  return true;
+}
+
+static void
+locus_dist_free(LocusDist *dist)
+{
+  pfree(dist->x);
+  pfree(dist->cum);
+}
+
+/*
+ * Fraction of rows with the boundary on the contig at or below x
+ */
+static float8
+locus_dist_cdf(LocusDist *dist, float8 x)
+{
+  float8    sel = 0.0;
+  int       i;
+
+  for (i = 0; i < dist->nknots - 1; i++)
+  {
+    float8    a = dist->x[i];
+    float8    b = dist->x[i + 1];
+    float8    mass = dist->cum[i + 1] - dist->cum[i];
+
+    if (b <= x)
+      sel += mass;
+    else
+    {
+      if (a <= x)
+        sel += mass * (x - a) / (b - a);
+      break;
+    }
+  }
+
+  return sel;
+}
+
+/*
+ * P(X + Y <= t) for independent X, Y distributed uniformly over [a1, b1] and
+ * [a2, b2].  Either interval may be a single point.
+ */
+static float8
+uniform_sum_le(float8 a1, float8 b1, float8 a2, float8 b2, float8 t)
+{
+  float8    w1 = b1 - a1;
+  float8    w2 = b2 - a2;
+  float8    s = t - a1 - a2;
+  float8    area;
+
+  if (s < 0.0)
+    return 0.0;
+  if (s >= w1 + w2)
+    return 1.0;
+  if (w1 == 0.0 || w2 == 0.0)
+    return s / Max(w1, w2);
+
+  /* the part of the w1 x w2 rectangle below the line x + y = s */
+#define TRIANGLE(u)  ((u) > 0.0 ? (u) * (u) / 2.0 : 0.0)
+  area = TRIANGLE(s) - TRIANGLE(s - w1) - TRIANGLE(s - w2) + TRIANGLE(s - w1 - w2);
+#undef TRIANGLE
+
+  return Min(Max(area / (w1 * w2), 0.0), 1.0);
+}
+
+static float8
+uniform_sum_ge(float8 a1, float8 b1, float8 a2, float8 b2, float8 t)
+{
+  if (a1 == b1 && a2 == b2)
+    return a1 + a2 >= t ? 1.0 : 0.0;
+  return 1.0 - uniform_sum_le(a1, b1, a2, b2, t);
+}
+
+/*
+ * Fraction of loci starting uniformly in [a, b], with lengths from the length
+ * histogram times scale, whose lower + length is >= t (or <= t)
+ */
+static float8
+locus_length_frac(LocusStats *ls, float8 scale, float8 a, float8 b, float8 t, bool ge)
+{
+  float8    sum = 0.0;
+  int       i;
+
+  for (i = 0; i < LENGTH_BINS(ls); i++)
+  {
+    float8    lo = ls->lengths[Min(i, ls->nlengths - 1)] * scale;
+    float8    hi = ls->lengths[Min(i + 1, ls->nlengths - 1)] * scale;
+
+    sum += ge ? uniform_sum_ge(a, b, lo, hi, t) : uniform_sum_le(a, b, lo, hi, t);
+  }
+
+  return sum / LENGTH_BINS(ls);
+}
+
+/*
+ * Fraction of rows on the contig whose lower boundary is at or below upto
+ * and whose upper boundary is at or above ref
+ *
+ * With upto = query upper and ref = query lower these are the loci that
+ * overlap the query; with upto = query lower and ref = query upper, the loci
+ * that contain it.
+ */
+static float8
+locus_dist_reach(LocusStats *ls, LocusDist *dist, float8 upto, float8 ref)
+{
+  float8    sel = 0.0;
+  int       i;
+
+  for (i = 0; i < dist->nknots - 1; i++)
+  {
+    float8    a = dist->x[i];
+    float8    b = dist->x[i + 1];
+    float8    mass = dist->cum[i + 1] - dist->cum[i];
+
+    if (a > upto)
+      break;
+    if (mass <= 0.0)
+      continue;
+    if (b > upto)
+    {
+      mass *= (upto - a) / (b - a);
+      b = upto;
+    }
+
+    if (a >= ref)
+      sel += mass;
+    else if (b + dist->max_length >= ref)
+      sel += mass * locus_length_frac(ls, dist->length_scale, a, b, ref, true);
+  }
+
+  return sel;
+}
+
+/*
+ * Fraction of rows on the contig that lie within [lo, hi]
+ */
+static float8
+locus_dist_within(LocusStats *ls, LocusDist *dist, float8 lo, float8 hi)
+{
+  float8    sel = 0.0;
+  int       i;
+
+  for (i = 0; i < dist->nknots - 1; i++)
+  {
+    float8    a = dist->x[i];
+    float8    b = dist->x[i + 1];
+    float8    mass = dist->cum[i + 1] - dist->cum[i];
+
+    if (a > hi)
+      break;
+    if (b < lo || mass <= 0.0)
+      continue;
+    if (b > a)
+    {
+      float8    clip_a = Max(a, lo);
+      float8    clip_b = Min(b, hi);
+
+      mass *= (clip_b - clip_a) / (b - a);
+      a = clip_a;
+      b = clip_b;
+    }
+
+    if (b + dist->max_length <= hi)
+      sel += mass;
+    else
+      sel += mass * locus_length_frac(ls, dist->length_scale, a, b, hi, false);
+  }
+
+  return sel;
+}
+
+
+/*****************************************************************************
+ * Restriction selectivity
+ *****************************************************************************/
+
+/*
+ * Fraction of rows on the contig of query that overlap, contain (op =
+ * LOCUS_SEL_CONTAINS) or lie within (LOCUS_SEL_CONTAINED) the positions of
+ * query.  Returns a negative number if the contig is unknown.
+ */
+static float8
+locus_contig_sel(LocusStats *ls, LocusSelOp op, LOCUS *contig, LOCUS *query)
+{
+  LocusDist dist;
+  float8    sel;
+
+  if (!locus_dist_build(ls, contig, false, &dist))
+    return -1.0;
+
+  switch (op)
+  {
+    case LOCUS_SEL_CONTAINS:
+      sel = locus_dist_reach(ls, &dist, query->lower, query->upper);
+      break;
+    case LOCUS_SEL_CONTAINED:
+      sel = locus_dist_within(ls, &dist, query->lower, query->upper);
+      break;
+    default:
+      sel = locus_dist_reach(ls, &dist, query->upper, query->lower);
+      break;
+  }
+
+  locus_dist_free(&dist);
+  return sel;
+}
+
+/*
+ * The same over every contig, for queries with the wildcard contig.  *cond
+ * is set to the fraction of real-contig rows that qualify, which also stands
+ * in for wildcard rows and for rows on contigs we know nothing about.
+ */
+static float8
+locus_any_contig_sel(LocusStats *ls, LocusSelOp op, LOCUS *query, float8 *cond)
+{
+  float8    sel = 0.0;
+  float8    listed_frac = 0.0;
+  int       i;
+
+  for (i = 0; i < ls->ncontigs; i++)
+  {
+    float8    contig_sel = locus_contig_sel(ls, op, DatumGetLocusP(ls->contigs[i]), query);
+
+    if (contig_sel >= 0.0)
+    {
+      sel += contig_sel;
+      listed_frac += ls->freqs[i];
+    }
+  }
+
+  *cond = listed_frac > 0.0 ? Min(sel / listed_frac, 1.0) : DEFAULT_LOCUS_CONT_SEL;
+
+  /* the rest of the rows with a real contig */
+  return sel + Max(ls->real_frac - listed_frac, 0.0) * *cond;
+}
+
+/*
+ * Fraction of rows entirely to the left (or right) of query
+ */
+static float8
+locus_side_sel(LocusStats *ls, LOCUS *query, bool left)
+{
+  float8    sel = 0.0;
+  LocusDist dist;
+  int       i;
+
+  /* wildcards are never to the left or right of anything */
+  if (LOCUS_IS_WILDCARD(query))
+    return 0.0;
+
+  for (i = 0; i < ls->ncontigs; i++)
+  {
+    int       cmp = locus_contig_cmp(DatumGetLocusP(ls->contigs[i]), query);
+
+    if (left ? cmp < 0 : cmp > 0)
+      sel += ls->freqs[i];
+  }
+
+  if (locus_dist_build(ls, query, left, &dist))
+  {
+    float8    freq = dist.cum[dist.nknots - 1];
+
+    if (left)
+      sel += locus_dist_cdf(&dist, (float8) query->lower - 1.0);
+    else
+      sel += freq - locus_dist_cdf(&dist, query->upper);
+    locus_dist_free(&dist);
+  }
+  else
+    sel += ls->unlisted_frac / 2.0;
+
+  return sel;
+}
+
+/*
+ * Selectivity of "var op query"
+ *
+ * For && and @>, the left operand decides whether a wildcard matches, so
+ * wildcard rows match on position alone and a wildcard query only matches
+ * them.  For "query && var" and <@, it is the other way around.
+ */
+static float8
+locus_restrict_sel(LocusStats *ls, LocusSelOp op, LOCUS *query)
+{
+  LocusSelOp  pos_op;
+  float8      any_sel;
+  float8      cond;
+  float8      sel;
+
+  switch (op)
+  {
+    case LOCUS_SEL_LEFT:
+      return locus_side_sel(ls, query, true);
+    case LOCUS_SEL_RIGHT:
+      return locus_side_sel(ls, query, false);
+    case LOCUS_SEL_OVERLAPPED:
+      pos_op = LOCUS_SEL_OVERLAP;
+      break;
+    default:
+      pos_op = op;
+      break;
+  }
+
+  if (op == LOCUS_SEL_OVERLAPPED || op == LOCUS_SEL_CONTAINED)
+  {
+    if (LOCUS_IS_WILDCARD(query))
+    {
+      any_sel = locus_any_contig_sel(ls, pos_op, query, &cond);
+      return any_sel + ls->wildcard_frac * cond;
+    }
+
+    sel = locus_contig_sel(ls, pos_op, query, query);
+    if (sel < 0.0)
+    {
+      locus_any_contig_sel(ls, pos_op, query, &cond);
+      sel = ls->unlisted_frac * cond;
+    }
+    return sel;
+  }
+
+  /* the wildcard rows; skip the work if there are none */
+  sel = 0.0;
+  cond = DEFAULT_LOCUS_CONT_SEL;
+  if (ls->wildcard_frac > 0.0)
+  {
+    locus_any_contig_sel(ls, pos_op, query, &cond);
+    sel += ls->wildcard_frac * cond;
+  }
+
+  if (!LOCUS_IS_WILDCARD(query))
+  {
+    float8    contig_sel = locus_contig_sel(ls, pos_op, query, query);
+
+    if (contig_sel < 0.0)
+    {
+      if (ls->wildcard_frac <= 0.0)
+        locus_any_contig_sel(ls, pos_op, query, &cond);
+      contig_sel = ls->unlisted_frac * cond;
+    }
+    sel += contig_sel;
+  }
+
+  return sel;
+}
+
+static LocusSelOp
+locus_sel_commute(LocusSelOp op)
+{
+  switch (op)
+  {
+    case LOCUS_SEL_OVERLAP:
+      return LOCUS_SEL_OVERLAPPED;
+    case LOCUS_SEL_OVERLAPPED:
+      return LOCUS_SEL_OVERLAP;
+    case LOCUS_SEL_CONTAINS:
+      return LOCUS_SEL_CONTAINED;
+    case LOCUS_SEL_CONTAINED:
+      return LOCUS_SEL_CONTAINS;
+    case LOCUS_SEL_LEFT:
+      return LOCUS_SEL_RIGHT;
+    case LOCUS_SEL_RIGHT:
+      return LOCUS_SEL_LEFT;
+  }
+  return op;  /* keep compiler quiet */
+}
+
+static Selectivity
+locus_restrict(FunctionCallInfo fcinfo, LocusSelOp op, Selectivity default_sel)
+{
+  PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+  /* Oid      operator = PG_GETARG_OID(1); */
+  List       *args = (List *) PG_GETARG_POINTER(2);
+  int         varRelid = PG_GETARG_INT32(3);
+  VariableStatData vardata;
+  Node       *other;
+  bool        varonleft;
+  LocusStats  ls;
+  Selectivity sel;
+
+  if (!get_restriction_variable(root, args, varRelid, &vardata, &other, &varonleft))
+    return default_sel;
+
+  if (!IsA(other, Const))
+  {
+    ReleaseVariableStats(vardata);
+    return default_sel;
+  }
+
+  /* the operators are strict */
+  if (((Const *) other)->constisnull)
+  {
+    ReleaseVariableStats(vardata);
+    return 0.0;
+  }
+
+  if (!varonleft)
+    op = locus_sel_commute(op);
+
+  if (locus_stats_fetch(&vardata, &ls))
+  {
+    sel = locus_restrict_sel(&ls, op, DatumGetLocusP(((Const *) other)->constvalue));
+    locus_stats_release(&ls);
+  }
+  else
+    sel = default_sel;
+
+  ReleaseVariableStats(vardata);
+
+  CLAMP_PROBABILITY(sel);
+  return sel;
+}
+
+Datum
+locus_overlap_sel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_restrict(fcinfo, LOCUS_SEL_OVERLAP, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_contains_sel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_restrict(fcinfo, LOCUS_SEL_CONTAINS, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_contained_sel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_restrict(fcinfo, LOCUS_SEL_CONTAINED, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_left_sel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_restrict(fcinfo, LOCUS_SEL_LEFT, DEFAULT_LOCUS_POSITION_SEL));
+}
+
+Datum
+locus_right_sel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_restrict(fcinfo, LOCUS_SEL_RIGHT, DEFAULT_LOCUS_POSITION_SEL));
+}
+
+
+/*****************************************************************************
+ * Join selectivity
+ *****************************************************************************/
+
+/*
+ * Probability that a locus from s1 (the i-th contig, or a wildcard if i < 0)
+ * and one from s2 (the j-th contig), placed uniformly over span bases,
+ * satisfy the operator
+ */
+static float8
+locus_pair_prob(LocusSelOp op, float8 span,
+                LocusStats *s1, int i, LocusStats *s2, int j)
+{
+  float8    len1 = i >= 0 ? s1->mean_lengths[i] : s1->mean_length;
+  float8    len2 = s2->mean_lengths[j];
+
+  span = Max(span, 1.0);
+
+  switch (op)
+  {
+    case LOCUS_SEL_CONTAINS:
+      return Min(locus_mean_length_excess(s1, locus_length_scale(s1, i),
+                                          s2, locus_length_scale(s2, j)) / span, 1.0);
+    case LOCUS_SEL_LEFT:
+      return Max(1.0 - (len1 + len2 + 1.0) / span, 0.0) / 2.0;
+    default:
+      return Min((len1 + len2 + 1.0) / span, 1.0);
+  }
+}
+
+/*
+ * Selectivity of "a op b" for a from the rows of s1 and b from those of s2,
+ * op being &&, @> or <<
+ */
+static float8
+locus_join_sel(LocusStats *s1, LocusStats *s2, LocusSelOp op)
+{
+  float8    sel = 0.0;
+  float8    before = 0.0;  /* rows of s1 on contigs before the current one */
+  int       i = 0;
+  int       j = 0;
+
+  /* walk the contigs of both sides in natural order */
+  while (i < s1->ncontigs || j < s2->ncontigs)
+  {
+    LOCUS    *c1 = i < s1->ncontigs ? DatumGetLocusP(s1->contigs[i]) : NULL;
+    LOCUS    *c2 = j < s2->ncontigs ? DatumGetLocusP(s2->contigs[j]) : NULL;
+    int       cmp = c1 == NULL ? 1 : c2 == NULL ? -1 : locus_contig_cmp(c1, c2);
+
+    if (cmp == 0)
+    {
+      float8    span = (float8) Max(c1->upper, c2->upper) - Min(c1->lower, c2->lower) + 1.0;
+
+      sel += s1->freqs[i] * s2->freqs[j] * locus_pair_prob(op, span, s1, i, s2, j);
+    }
+    if (cmp >= 0)
+    {
+      if (op == LOCUS_SEL_LEFT)
+        sel += before * s2->freqs[j];
+      j++;
+    }
+    if (cmp <= 0)
+      before += s1->freqs[i++];
+  }
+
+  /* wildcards on the left match loci of any contig */
+  if (op != LOCUS_SEL_LEFT && s1->wildcard_frac > 0.0)
+  {
+    for (j = 0; j < s2->ncontigs; j++)
+    {
+      LOCUS    *c2 = DatumGetLocusP(s2->contigs[j]);
+
+      sel += s1->wildcard_frac * s2->freqs[j] *
+        locus_pair_prob(op, (float8) c2->upper - c2->lower + 1.0, s1, -1, s2, j);
+    }
+  }
+
+  return sel;
+}
+
+static Selectivity
+locus_join(FunctionCallInfo fcinfo, LocusSelOp op, Selectivity default_sel)
+{
+  PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+  /* Oid      operator = PG_GETARG_OID(1); */
+  List       *args = (List *) PG_GETARG_POINTER(2);
+  JoinType    jointype = (JoinType) PG_GETARG_INT16(3);
+  SpecialJoinInfo *sjinfo = (SpecialJoinInfo *) PG_GETARG_POINTER(4);
+  VariableStatData vardata1;
+  VariableStatData vardata2;
+  bool        join_is_reversed;
+  LocusStats  ls1;
+  LocusStats  ls2;
+  Selectivity sel = default_sel;
+
+  get_join_variables(root, args, sjinfo, &vardata1, &vardata2, &join_is_reversed);
+
+  if (locus_stats_fetch(&vardata1, &ls1))
+  {
+    if (locus_stats_fetch(&vardata2, &ls2))
+    {
+      /* "a <@ b" is "b @> a", and "a >> b" is "b << a" */
+      if (op == LOCUS_SEL_CONTAINED || op == LOCUS_SEL_RIGHT)
+        sel = locus_join_sel(&ls2, &ls1, op == LOCUS_SEL_RIGHT ? LOCUS_SEL_LEFT : LOCUS_SEL_CONTAINS);
+      else
+        sel = locus_join_sel(&ls1, &ls2, op);
+
+      /* semi- and antijoins want the fraction of outer rows with a match */
+      if (jointype == JOIN_SEMI || jointype == JOIN_ANTI)
+      {
+        RelOptInfo *inner = join_is_reversed ? vardata1.rel : vardata2.rel;
+
+        if (inner != NULL)
+          sel = 1.0 - exp(-sel * Max(inner->rows, 1.0));
+      }
+
+      locus_stats_release(&ls2);
+    }
+    locus_stats_release(&ls1);
+  }
+
+  ReleaseVariableStats(vardata1);
+  ReleaseVariableStats(vardata2);
+
+  CLAMP_PROBABILITY(sel);
+  return sel;
+}
+
+Datum
+locus_overlap_joinsel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_join(fcinfo, LOCUS_SEL_OVERLAP, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_contains_joinsel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_join(fcinfo, LOCUS_SEL_CONTAINS, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_contained_joinsel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_join(fcinfo, LOCUS_SEL_CONTAINED, DEFAULT_LOCUS_CONT_SEL));
+}
+
+Datum
+locus_left_joinsel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_join(fcinfo, LOCUS_SEL_LEFT, DEFAULT_LOCUS_POSITION_SEL));
+}
+
+Datum
+locus_right_joinsel(PG_FUNCTION_ARGS)
+{
+  PG_RETURN_FLOAT8(locus_join(fcinfo, LOCUS_SEL_RIGHT, DEFAULT_LOCUS_POSITION_SEL));
+}
@@ -0,0 +1,511 @@
+/*
+ * contrib/locus/locus_set.c
+ *
+ * Sets of genomic intervals
+ *
+ * A locus_set holds the union of a collection of loci, such as the exons of
+ * a gene panel or the targets of a capture kit, in a canonical form: sorted
+ * by contig and position, with overlapping and adjacent loci merged (see
+ * LOCUS_SET in locus_data.h).  Since the intervals of a contig are disjoint,
+ * their upper boundaries ascend with the lower ones, and
+ *
+ *   locus && set    is a binary search for the first interval that ends at
+ *                   or after the start of the locus, which overlaps it if it
+ *                   begins at or before its end;
+ *   locus <@ set    is the same search, which must find an interval holding
+ *                   the whole locus.
+ *
+ * The operators follow && and <@ on two loci: an "<all>" locus overlaps the
+ * intervals of every contig, and "<all>" intervals in a set contain loci on
+ * any contig.  Set union, intersection and difference work contig by contig
+ * on the intervals as sets of positions.
+ */
+
+#include "postgres.h"
+
+#include <ctype.h>
+
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(locus_set_in);
+PG_FUNCTION_INFO_V1(locus_set_out);
+PG_FUNCTION_INFO_V1(locus_set);
+PG_FUNCTION_INFO_V1(locus_set_to_array);
+PG_FUNCTION_INFO_V1(locus_overlap_set);
+PG_FUNCTION_INFO_V1(locus_contained_set);
+PG_FUNCTION_INFO_V1(locus_set_union);
+PG_FUNCTION_INFO_V1(locus_set_intersect);
+PG_FUNCTION_INFO_V1(locus_set_minus);
+
+static int
+locus_set_item_cmp(const void *a, const void *b)
+{
+  return locus_cmp_internal((LOCUS *) a, (LOCUS *) b);
+}
+
+/*
+ * Build a set from loci, which are sorted in place.  Loci on the same contig
+ * that overlap or touch are merged; each contig keeps the spelling of its
+ * first locus.
+ */
+LOCUS_SET *
+locus_set_build(LOCUS *items, int nitems)
+{
+  LOCUS_SET  *set;
+  LocusSetInterval *intervals;
+  LocusSetContig *contig = NULL;
+  int         ncontigs = 0;
+  int         n = 0;
+  int         i;
+
+  qsort(items, nitems, sizeof(LOCUS), locus_set_item_cmp);
+
+  /* merge in place, counting the contigs */
+  for (i = 0; i < nitems; i++)
+  {
+    if (n > 0 && locus_contig_cmp(&items[n - 1], &items[i]) == 0)
+    {
+      if ((int64) items[i].lower <= (int64) items[n - 1].upper + 1)
+      {
+        if (items[i].upper > items[n - 1].upper)
+          items[n - 1].upper = items[i].upper;
+        continue;
+      }
+    }
+    else
+      ncontigs++;
+    items[n++] = items[i];
+  }
+
+  set = (LOCUS_SET *) palloc0(LOCUS_SET_SIZE(ncontigs, n));
+  SET_VARSIZE(set, LOCUS_SET_SIZE(ncontigs, n));
+  set->ncontigs = ncontigs;
+  set->nintervals = n;
+  intervals = LOCUS_SET_INTERVALS(set);
+
+  for (i = 0; i < n; i++)
+  {
+    if (contig == NULL || locus_contig_cmp(&contig->extent, &items[i]) != 0)
+    {
+      contig = contig == NULL ? set->contigs : contig + 1;
+      contig->extent = items[i];
+      contig->first = i;
+    }
+    contig->extent.upper = items[i].upper;
+    contig->count++;
+    intervals[i].lower = items[i].lower;
+    intervals[i].upper = items[i].upper;
+  }
+
+  return set;
+}
+
+/* The loci of a set, in order, with room for extra more */
+static LOCUS *
+locus_set_items(LOCUS_SET *set, int extra)
+{
+  LOCUS      *items = (LOCUS *) palloc((set->nintervals + extra + 1) * sizeof(LOCUS));
+  LocusSetInterval *intervals = LOCUS_SET_INTERVALS(set);
+  int         c,
+              i;
+
+  for (c = 0; c < set->ncontigs; c++)
+  {
+    LocusSetContig *contig = &set->contigs[c];
+
+    for (i = contig->first; i < contig->first + contig->count; i++)
+    {
+      items[i] = contig->extent;
+      items[i].lower = intervals[i].lower;
+      items[i].upper = intervals[i].upper;
+    }
+  }
+  return items;
+}
+
+/* The contig of a set that a locus is on, or NULL */
+static LocusSetContig *
+locus_set_find_contig(LOCUS_SET *set, LOCUS *locus)
+{
+  int         lo = 0,
+              hi = set->ncontigs;
+
+  while (lo < hi)
+  {
+    int         mid = lo + (hi - lo) / 2;
+    int         cmp = locus_contig_cmp(&set->contigs[mid].extent, locus);
+
+    if (cmp == 0)
+      return &set->contigs[mid];
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return NULL;
+}
+
+/*
+ * The first interval of a contig that ends at or after pos, or NULL if none
+ * does
+ */
+static LocusSetInterval *
+locus_set_search(LOCUS_SET *set, LocusSetContig *contig, int32 pos)
+{
+  LocusSetInterval *intervals = LOCUS_SET_INTERVALS(set) + contig->first;
+  int         lo = 0,
+              hi = contig->count;
+
+  if (contig->extent.upper < pos)
+    return NULL;
+
+  while (lo < hi)
+  {
+    int         mid = lo + (hi - lo) / 2;
+
+    if (intervals[mid].upper < pos)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return &intervals[lo];
+}
+
+static bool
+locus_set_contig_overlaps(LOCUS_SET *set, LocusSetContig *contig, LOCUS *locus)
+{
+  LocusSetInterval *interval;
+
+  if (contig == NULL || contig->extent.lower > locus->upper)
+    return false;
+  interval = locus_set_search(set, contig, locus->lower);
+  return interval != NULL && interval->lower <= locus->upper;
+}
+
+static bool
+locus_set_contig_contains(LOCUS_SET *set, LocusSetContig *contig, LOCUS *locus)
+{
+  LocusSetInterval *interval;
+
+  if (contig == NULL)
+    return false;
+  interval = locus_set_search(set, contig, locus->upper);
+  return interval != NULL && interval->lower <= locus->lower;
+}
+
+/*****************************************************************************
+ * Input/Output functions
+ *****************************************************************************/
+
+/*
+ * The text form is a list of loci in braces, like a locus[], for example
+ * '{chr1:100-200, chr2:5}'.  Input may be in any order and overlap.
+ */
+Datum
+locus_set_in(PG_FUNCTION_ARGS)
+{
+  char       *str = PG_GETARG_CSTRING(0);
+  char       *buf = pstrdup(str);
+  char       *p = buf;
+  int         nitems = 0;
+  int         maxitems = 16;
+  LOCUS      *items = (LOCUS *) palloc(maxitems * sizeof(LOCUS));
+
+  while (isspace((unsigned char) *p))
+    p++;
+  if (*p++ != '{')
+    goto malformed;
+
+  for (;;)
+  {
+    char       *item;
+    char       *end;
+    char        delim;
+
+    while (isspace((unsigned char) *p))
+      p++;
+    if (*p == '}' && nitems == 0)
+    {
+      p++;
+      break;
+    }
+
+    item = p;
+    while (*p != '\0' && *p != ',' && *p != '}')
+      p++;
+    delim = *p;
+    if (delim == '\0')
+      goto malformed;
+
+    for (end = p; end > item && isspace((unsigned char) end[-1]); end--)
+      ;
+    if (end == item)
+      goto malformed;
+    *end = '\0';
+
+    if (nitems == maxitems)
+    {
+      maxitems *= 2;
+      items = (LOCUS *) repalloc_huge(items, maxitems * sizeof(LOCUS));
+    }
+    memset(&items[nitems], 0, sizeof(LOCUS));
+    locus_parse(item, &items[nitems]);
+    locus_set_natkey(&items[nitems]);
+    nitems++;
+
+    p++;
+    if (delim == '}')
+      break;
+  }
+
+  while (isspace((unsigned char) *p))
+    p++;
+  if (*p != '\0')
+    goto malformed;
+
+  PG_RETURN_POINTER(locus_set_build(items, nitems));
+
+malformed:
+  ereport(ERROR,
+          (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+           errmsg("malformed locus_set literal: \"%s\"", str)));
+  PG_RETURN_NULL();
+}
+
+Datum
+locus_set_out(PG_FUNCTION_ARGS)
+{
+  LOCUS_SET  *set = PG_GETARG_LOCUS_SET_P(0);
+  LOCUS      *items = locus_set_items(set, 0);
+  StringInfoData buf;
+  int         i;
+
+  initStringInfo(&buf);
+  appendStringInfoChar(&buf, '{');
+  for (i = 0; i < set->nintervals; i++)
+  {
+    if (i > 0)
+      appendStringInfoChar(&buf, ',');
+    appendStringInfoString(&buf,
+                           DatumGetCString(DirectFunctionCall1(locus_out,
+                                                               PointerGetDatum(&items[i]))));
+  }
+  appendStringInfoChar(&buf, '}');
+
+  PG_RETURN_CSTRING(buf.data);
+}
+
+/*
+ * locus_set(locus[]), also the cast: NULL elements are skipped
+ */
+Datum
+locus_set(PG_FUNCTION_ARGS)
+{
+  ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+  int16       typlen;
+  bool        typbyval;
+  char        typalign;
+  Datum      *elems;
+  bool       *nulls;
+  int         nelems;
+  LOCUS      *items;
+  int         nitems = 0;
+  int         i;
+
+  get_typlenbyvalalign(ARR_ELEMTYPE(array), &typlen, &typbyval, &typalign);
+  deconstruct_array(array, ARR_ELEMTYPE(array), typlen, typbyval, typalign,
+                    &elems, &nulls, &nelems);
+
+  items = (LOCUS *) palloc((nelems + 1) * sizeof(LOCUS));
+  for (i = 0; i < nelems; i++)
+  {
+    if (!nulls[i])
+      items[nitems++] = *DatumGetLocusP(elems[i]);
+  }
+
+  PG_RETURN_POINTER(locus_set_build(items, nitems));
+}
+
+/*
+ * The intervals of a set as a locus[]
+ */
+Datum
+locus_set_to_array(PG_FUNCTION_ARGS)
+{
+  LOCUS_SET  *set = PG_GETARG_LOCUS_SET_P(0);
+  LOCUS      *items = locus_set_items(set, 0);
+  Oid         elemtype = get_element_type(get_fn_expr_rettype(fcinfo->flinfo));
+  int16       typlen;
+  bool        typbyval;
+  char        typalign;
+  Datum      *elems;
+  int         i;
+
+  get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+
+  elems = (Datum *) palloc((set->nintervals + 1) * sizeof(Datum));
+  for (i = 0; i < set->nintervals; i++)
+    elems[i] = PointerGetDatum(&items[i]);
+
+  PG_RETURN_ARRAYTYPE_P(construct_array(elems, set->nintervals, elemtype,
+                                        typlen, typbyval, typalign));
+}
+
+/*****************************************************************************
+ * Probes
+ *****************************************************************************/
+
+/*  locus_overlap_set -- locus && set
+ */
+Datum
+locus_overlap_set(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  LOCUS_SET  *set = PG_GETARG_LOCUS_SET_P(1);
+  int         c;
+
+  if (!LOCUS_IS_WILDCARD(locus))
+    PG_RETURN_BOOL(locus_set_contig_overlaps(set, locus_set_find_contig(set, locus), locus));
+
+  for (c = 0; c < set->ncontigs; c++)
+  {
+    if (locus_set_contig_overlaps(set, &set->contigs[c], locus))
+      PG_RETURN_BOOL(true);
+  }
+  PG_RETURN_BOOL(false);
+}
+
+/*  locus_contained_set -- locus <@ set
+ */
+Datum
+locus_contained_set(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+  LOCUS_SET  *set = PG_GETARG_LOCUS_SET_P(1);
+  LOCUS       wildcard;
+
+  if (locus_set_contig_contains(set, locus_set_find_contig(set, locus), locus))
+    PG_RETURN_BOOL(true);
+  if (LOCUS_IS_WILDCARD(locus))
+    PG_RETURN_BOOL(false);
+
+  memset(&wildcard, 0, sizeof(wildcard));
+  locus_set_wildcard(&wildcard);
+  PG_RETURN_BOOL(locus_set_contig_contains(set, locus_set_find_contig(set, &wildcard), locus));
+}
+
+/*****************************************************************************
+ * Set operations
+ *****************************************************************************/
+
+/* Append an interval on a contig to a list of loci */
+#define locus_set_emit(items, n, contig, lo, hi) \
+  do { \
+    (items)[n] = (contig)->extent; \
+    (items)[n].lower = (lo); \
+    (items)[n].upper = (hi); \
+    (n)++; \
+  } while (0)
+
+Datum
+locus_set_union(PG_FUNCTION_ARGS)
+{
+  LOCUS_SET  *a = PG_GETARG_LOCUS_SET_P(0);
+  LOCUS_SET  *b = PG_GETARG_LOCUS_SET_P(1);
+  LOCUS      *items = locus_set_items(a, b->nintervals);
+  LOCUS      *bitems = locus_set_items(b, 0);
+
+  memcpy(items + a->nintervals, bitems, b->nintervals * sizeof(LOCUS));
+
+  PG_RETURN_POINTER(locus_set_build(items, a->nintervals + b->nintervals));
+}
+
+Datum
+locus_set_intersect(PG_FUNCTION_ARGS)
+{
+  LOCUS_SET  *a = PG_GETARG_LOCUS_SET_P(0);
+  LOCUS_SET  *b = PG_GETARG_LOCUS_SET_P(1);
+  LocusSetInterval *aintervals = LOCUS_SET_INTERVALS(a);
+  LocusSetInterval *bintervals = LOCUS_SET_INTERVALS(b);
+  LOCUS      *items = (LOCUS *) palloc((a->nintervals + b->nintervals + 1) * sizeof(LOCUS));
+  int         n = 0;
+  int         c;
+
+  for (c = 0; c < a->ncontigs; c++)
+  {
+    LocusSetContig *acontig = &a->contigs[c];
+    LocusSetContig *bcontig = locus_set_find_contig(b, &acontig->extent);
+    int         i,
+                j;
+
+    if (bcontig == NULL)
+      continue;
+
+    i = acontig->first;
+    j = bcontig->first;
+    while (i < acontig->first + acontig->count && j < bcontig->first + bcontig->count)
+    {
+      int32       lo = Max(aintervals[i].lower, bintervals[j].lower);
+      int32       hi = Min(aintervals[i].upper, bintervals[j].upper);
+
+      if (lo <= hi)
+        locus_set_emit(items, n, acontig, lo, hi);
+      if (aintervals[i].upper < bintervals[j].upper)
+        i++;
+      else
+        j++;
+    }
+  }
+
+  PG_RETURN_POINTER(locus_set_build(items, n));
+}
+
+Datum
+locus_set_minus(PG_FUNCTION_ARGS)
+{
+  LOCUS_SET  *a = PG_GETARG_LOCUS_SET_P(0);
+  LOCUS_SET  *b = PG_GETARG_LOCUS_SET_P(1);
+  LocusSetInterval *aintervals = LOCUS_SET_INTERVALS(a);
+  LocusSetInterval *bintervals = LOCUS_SET_INTERVALS(b);
+  LOCUS      *items = (LOCUS *) palloc((a->nintervals + b->nintervals + 1) * sizeof(LOCUS));
+  int         n = 0;
+  int         c;
+
+  for (c = 0; c < a->ncontigs; c++)
+  {
+    LocusSetContig *acontig = &a->contigs[c];
+    LocusSetContig *bcontig = locus_set_find_contig(b, &acontig->extent);
+    int         bend = bcontig ? bcontig->first + bcontig->count : 0;
+    int         j = bcontig ? bcontig->first : 0;
+    int         i;
+
+    for (i = acontig->first; i < acontig->first + acontig->count; i++)
+    {
+      int64       pos = aintervals[i].lower;
+      int32       upper = aintervals[i].upper;
+
+      /* cut the intervals of b out of [pos, upper] */
+      while (j < bend && bintervals[j].upper < pos)
+        j++;
+      while (j < bend && bintervals[j].lower <= upper)
+      {
+        if (bintervals[j].lower > pos)
+          locus_set_emit(items, n, acontig, (int32) pos, bintervals[j].lower - 1);
+        pos = (int64) bintervals[j].upper + 1;
+        if (pos > upper)
+          break;
+        j++;
+      }
+      if (pos <= upper)
+        locus_set_emit(items, n, acontig, (int32) pos, upper);
+    }
+  }
+
+  PG_RETURN_POINTER(locus_set_build(items, n));
+}
@@ -0,0 +1,476 @@
+/*
+ * contrib/locus/locus_spgist.c
+ *
+ * SP-GiST quad tree for genomic loci
+ *
+ * Following the quad tree for range types, every locus is mapped to a point
+ * (L, U) in two dimensions, where L = (contig, lower) and U = (contig, upper)
+ * are ordered by contig first (natural order, as in locus_cmp) and then by
+ * position.  Inner tuples store a centroid locus and split their points into
+ * four quadrants around it:
+ *
+ *             U
+ *             ^
+ *        4    |    1
+ *             |
+ *   ----------+--------->  L
+ *             |
+ *        3    |    2
+ *
+ * Because contig is the major key, the top levels of the tree separate
+ * contigs, and the levels below partition the loci of one contig by lower
+ * and upper position.  Each query is translated into a box in the same
+ * space, and inner_consistent descends into the quadrants the box reaches.
+ *
+ * A locus with the wildcard contig "<all>" sits where "<all>" falls in the
+ * contig order, but it overlaps or contains loci of any contig.  For those
+ * strategies inner_consistent also descends towards the wildcard contig.
+ */
+
+#include "postgres.h"
+
+#include <limits.h>  /* for INT_MAX */
+
+#include "access/spgist.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+
+#include "locus_data.h"
+
+
+PG_FUNCTION_INFO_V1(spg_locus_quad_config);
+PG_FUNCTION_INFO_V1(spg_locus_quad_choose);
+PG_FUNCTION_INFO_V1(spg_locus_quad_picksplit);
+PG_FUNCTION_INFO_V1(spg_locus_quad_inner_consistent);
+PG_FUNCTION_INFO_V1(spg_locus_quad_leaf_consistent);
+
+/*
+ * A bound in the (contig, position) order.  Positions one past the int32
+ * range stand for the start and the end of a contig; inf != 0 makes the
+ * bound lie before (-1) or after (+1) every contig.
+ */
+typedef struct
+{
+  int       inf;
+  LOCUS    *locus;  /* supplies the contig */
+  int64     pos;
+} LocusBound;
+
+#define CONTIG_START  ((int64) PG_INT32_MIN - 1)
+#define CONTIG_END    ((int64) PG_INT32_MAX + 1)
+
+/* A query, as a box of (L, U) points */
+typedef struct
+{
+  LocusBound  lower_min;
+  LocusBound  lower_max;
+  LocusBound  upper_min;
+  LocusBound  upper_max;
+} LocusBox;
+
+
+/*
+ * The quadrant of the centroid that tst falls into
+ */
+static int16
+locus_quadrant(LOCUS *centroid, LOCUS *tst)
+{
+  int       cmp = locus_contig_cmp(tst, centroid);
+  bool      lower_high;
+  bool      upper_high;
+
+  if (cmp != 0)
+    lower_high = upper_high = (cmp > 0);
+  else
+  {
+    lower_high = tst->lower >= centroid->lower;
+    upper_high = tst->upper >= centroid->upper;
+  }
+
+  if (lower_high)
+    return upper_high ? 1 : 2;
+  else
+    return upper_high ? 4 : 3;
+}
+
+static inline void
+locus_bound_set(LocusBound *bound, LOCUS *locus, int64 pos)
+{
+  bound->inf = 0;
+  bound->locus = locus;
+  bound->pos = pos;
+}
+
+static inline void
+locus_bound_set_inf(LocusBound *bound, int inf)
+{
+  bound->inf = inf;
+  bound->locus = NULL;
+  bound->pos = 0;
+}
+
+/*
+ * Compare a bound with the centroid bound (centroid contig, pos)
+ */
+static int
+locus_bound_cmp(const LocusBound *bound, LOCUS *centroid, int32 pos)
+{
+  int       cmp;
+
+  if (bound->inf != 0)
+    return bound->inf;
+
+  cmp = locus_contig_cmp(bound->locus, centroid);
+  if (cmp != 0)
+    return cmp;
+
+  if (bound->pos < pos)
+    return -1;
+  return bound->pos > pos ? 1 : 0;
+}
+
+/*
+ * Build the box of points satisfying "leaf <strategy> query", with the leaf
+ * contig taken to be that of query.  Returns false if no point can satisfy
+ * it, true if the box is unbounded along both axes (*box is unset then).
+ */
+static bool
+locus_query_box(StrategyNumber strategy, LOCUS *query, LocusBox *box, bool *unbounded)
+{
+  *unbounded = false;
+
+  switch (strategy)
+  {
+    case RTOverlapStrategyNumber:
+      locus_bound_set(&box->lower_min, query, CONTIG_START);
+      locus_bound_set(&box->lower_max, query, query->upper);
+      locus_bound_set(&box->upper_min, query, query->lower);
+      locus_bound_set(&box->upper_max, query, CONTIG_END);
+      break;
+
+    case RTContainsStrategyNumber:
+      locus_bound_set(&box->lower_min, query, CONTIG_START);
+      locus_bound_set(&box->lower_max, query, query->lower);
+      locus_bound_set(&box->upper_min, query, query->upper);
+      locus_bound_set(&box->upper_max, query, CONTIG_END);
+      break;
+
+    case RTContainedByStrategyNumber:
+      /* a wildcard query contains loci of any contig */
+      if (LOCUS_IS_WILDCARD(query))
+      {
+        *unbounded = true;
+        break;
+      }
+      locus_bound_set(&box->lower_min, query, query->lower);
+      locus_bound_set(&box->lower_max, query, CONTIG_END);
+      locus_bound_set(&box->upper_min, query, CONTIG_START);
+      locus_bound_set(&box->upper_max, query, query->upper);
+      break;
+
+    case RTLeftStrategyNumber:
+      if (LOCUS_IS_WILDCARD(query))
+        return false;
+      locus_bound_set_inf(&box->lower_min, -1);
+      locus_bound_set_inf(&box->lower_max, 1);
+      locus_bound_set_inf(&box->upper_min, -1);
+      locus_bound_set(&box->upper_max, query, (int64) query->lower - 1);
+      break;
+
+    case RTRightStrategyNumber:
+      if (LOCUS_IS_WILDCARD(query))
+        return false;
+      locus_bound_set(&box->lower_min, query, (int64) query->upper + 1);
+      locus_bound_set_inf(&box->lower_max, 1);
+      locus_bound_set_inf(&box->upper_min, -1);
+      locus_bound_set_inf(&box->upper_max, 1);
+      break;
+
+    default:
+      elog(ERROR, "unrecognized strategy: %d", strategy);
+  }
+
+  return true;
+}
+
+/*
+ * Bitmask of the quadrants of centroid that box reaches (bit n - 1 stands
+ * for quadrant n)
+ */
+static int
+locus_box_quadrants(LOCUS *centroid, const LocusBox *box)
+{
+  bool      lower_high = locus_bound_cmp(&box->lower_max, centroid, centroid->lower) >= 0;
+  bool      lower_low = locus_bound_cmp(&box->lower_min, centroid, centroid->lower) < 0;
+  bool      upper_high = locus_bound_cmp(&box->upper_max, centroid, centroid->upper) >= 0;
+  bool      upper_low = locus_bound_cmp(&box->upper_min, centroid, centroid->upper) < 0;
+  int       which = 0;
+
+  if (lower_high && upper_high)
+    which |= 1 << 0;
+  if (lower_high && upper_low)
+    which |= 1 << 1;
+  if (lower_low && upper_low)
+    which |= 1 << 2;
+  if (lower_low && upper_high)
+    which |= 1 << 3;
+
+  return which;
+}
+
+/*
+ * SP-GiST config function
+ */
+Datum
+spg_locus_quad_config(PG_FUNCTION_ARGS)
+{
+  spgConfigIn *cfgin = (spgConfigIn *) PG_GETARG_POINTER(0);
+  spgConfigOut *cfg = (spgConfigOut *) PG_GETARG_POINTER(1);
+
+  cfg->prefixType = cfgin->attType;  /* the centroid is a locus */
+  cfg->labelType = VOIDOID;          /* we don't need node labels */
+  cfg->canReturnData = true;
+  cfg->longValuesOK = false;
+  PG_RETURN_VOID();
+}
+
+/*
+ * SP-GiST choose function
+ */
+Datum
+spg_locus_quad_choose(PG_FUNCTION_ARGS)
+{
+  spgChooseIn *in = (spgChooseIn *) PG_GETARG_POINTER(0);
+  spgChooseOut *out = (spgChooseOut *) PG_GETARG_POINTER(1);
+
+  out->resultType = spgMatchNode;
+  out->result.matchNode.levelAdd = 0;
+  out->result.matchNode.restDatum = in->datum;
+
+  /* nodeN will be set by core when all the nodes are the same */
+  if (!in->allTheSame)
+  {
+    Assert(in->hasPrefix && in->nNodes == 4);
+    out->result.matchNode.nodeN =
+      locus_quadrant(DatumGetLocusP(in->prefixDatum), DatumGetLocusP(in->datum)) - 1;
+  }
+
+  PG_RETURN_VOID();
+}
+
+static int
+locus_bound_lower_cmp(const void *a, const void *b)
+{
+  LOCUS    *la = *(LOCUS *const *) a;
+  LOCUS    *lb = *(LOCUS *const *) b;
+  int       cmp = locus_contig_cmp(la, lb);
+
+  if (cmp != 0)
+    return cmp;
+  return (la->lower > lb->lower) - (la->lower < lb->lower);
+}
+
+static int
+locus_bound_upper_cmp(const void *a, const void *b)
+{
+  LOCUS    *la = *(LOCUS *const *) a;
+  LOCUS    *lb = *(LOCUS *const *) b;
+  int       cmp = locus_contig_cmp(la, lb);
+
+  if (cmp != 0)
+    return cmp;
+  return (la->upper > lb->upper) - (la->upper < lb->upper);
+}
+
+/*
+ * SP-GiST picksplit function
+ *
+ * The centroid is the median lower bound and the median upper bound.  Both
+ * must share one contig; since the median upper bound can never precede the
+ * median lower bound, when it falls on a later contig the centroid's upper
+ * bound becomes the end of the median lower bound's contig.
+ */
+Datum
+spg_locus_quad_picksplit(PG_FUNCTION_ARGS)
+{
+  spgPickSplitIn *in = (spgPickSplitIn *) PG_GETARG_POINTER(0);
+  spgPickSplitOut *out = (spgPickSplitOut *) PG_GETARG_POINTER(1);
+  LOCUS   **sorted;
+  LOCUS    *median_lower;
+  LOCUS    *median_upper;
+  LOCUS    *centroid;
+  int       i;
+
+  sorted = (LOCUS **) palloc(sizeof(LOCUS *) * in->nTuples);
+  for (i = 0; i < in->nTuples; i++)
+    sorted[i] = DatumGetLocusP(in->datums[i]);
+
+  qsort(sorted, in->nTuples, sizeof(LOCUS *), locus_bound_lower_cmp);
+  median_lower = sorted[in->nTuples / 2];
+
+  qsort(sorted, in->nTuples, sizeof(LOCUS *), locus_bound_upper_cmp);
+  median_upper = sorted[in->nTuples / 2];
+
+  centroid = (LOCUS *) palloc(sizeof(LOCUS));
+  memcpy(centroid, median_lower, sizeof(LOCUS));
+  if (locus_contig_cmp(median_upper, median_lower) == 0)
+    centroid->upper = median_upper->upper;
+  else
+    centroid->upper = INT_MAX;
+
+  out->hasPrefix = true;
+  out->prefixDatum = PointerGetDatum(centroid);
+
+  out->nNodes = 4;
+  out->nodeLabels = NULL;     /* we don't need node labels */
+
+  out->mapTuplesToNodes = palloc(sizeof(int) * in->nTuples);
+  out->leafTupleDatums = palloc(sizeof(Datum) * in->nTuples);
+
+  for (i = 0; i < in->nTuples; i++)
+  {
+    out->leafTupleDatums[i] = in->datums[i];
+    out->mapTuplesToNodes[i] =
+      locus_quadrant(centroid, DatumGetLocusP(in->datums[i])) - 1;
+  }
+
+  pfree(sorted);
+
+  PG_RETURN_VOID();
+}
+
+/*
+ * SP-GiST inner_consistent function
+ */
+Datum
+spg_locus_quad_inner_consistent(PG_FUNCTION_ARGS)
+{
+  spgInnerConsistentIn *in = (spgInnerConsistentIn *) PG_GETARG_POINTER(0);
+  spgInnerConsistentOut *out = (spgInnerConsistentOut *) PG_GETARG_POINTER(1);
+  LOCUS    *centroid;
+  LOCUS     wildcard;
+  bool      have_wildcard = false;
+  int       which;
+  int       i;
+
+  if (in->allTheSame)
+  {
+    /* Report that all nodes should be visited */
+    out->nNodes = in->nNodes;
+    out->nodeNumbers = (int *) palloc(sizeof(int) * in->nNodes);
+    for (i = 0; i < in->nNodes; i++)
+      out->nodeNumbers[i] = i;
+    PG_RETURN_VOID();
+  }
+
+  Assert(in->hasPrefix && in->nNodes == 4);
+  centroid = DatumGetLocusP(in->prefixDatum);
+
+  /* "which" is a bitmask of quadrants that satisfy all constraints */
+  which = (1 << 4) - 1;
+
+  for (i = 0; i < in->nkeys; i++)
+  {
+    StrategyNumber strategy = in->scankeys[i].sk_strategy;
+    LOCUS    *query = DatumGetLocusP(in->scankeys[i].sk_argument);
+    LocusBox  box;
+    bool      unbounded;
+    int       reach;
+
+    if (!locus_query_box(strategy, query, &box, &unbounded))
+      reach = 0;
+    else if (unbounded)
+      continue;
+    else
+      reach = locus_box_quadrants(centroid, &box);
+
+    /* wildcard loci overlap and contain loci of any contig */
+    if (strategy == RTOverlapStrategyNumber || strategy == RTContainsStrategyNumber)
+    {
+      LOCUS     wildcard_query;
+
+      if (!have_wildcard)
+      {
+        memset(&wildcard, 0, sizeof(LOCUS));
+        locus_set_wildcard(&wildcard);
+        have_wildcard = true;
+      }
+
+      memcpy(&wildcard_query, &wildcard, sizeof(LOCUS));
+      wildcard_query.lower = query->lower;
+      wildcard_query.upper = query->upper;
+
+      locus_query_box(strategy, &wildcard_query, &box, &unbounded);
+      reach |= locus_box_quadrants(centroid, &box);
+    }
+
+    which &= reach;
+    if (which == 0)
+      break;
+  }
+
+  out->nodeNumbers = (int *) palloc(sizeof(int) * 4);
+  out->nNodes = 0;
+  for (i = 1; i <= 4; i++)
+  {
+    if (which & (1 << (i - 1)))
+      out->nodeNumbers[out->nNodes++] = i - 1;
+  }
+
+  PG_RETURN_VOID();
+}
+
+/*
+ * SP-GiST leaf_consistent function
+ */
+Datum
+spg_locus_quad_leaf_consistent(PG_FUNCTION_ARGS)
+{
+  spgLeafConsistentIn *in = (spgLeafConsistentIn *) PG_GETARG_POINTER(0);
+  spgLeafConsistentOut *out = (spgLeafConsistentOut *) PG_GETARG_POINTER(1);
+  Datum     leaf = in->leafDatum;
+  bool      res = true;
+  int       i;
+
+  /* all tests are exact */
+  out->recheck = false;
+
+  /* leafDatum is what it is... */
+  out->leafValue = leaf;
+
+  /* Perform the required comparison(s) */
+  for (i = 0; i < in->nkeys; i++)
+  {
+    Datum     query = in->scankeys[i].sk_argument;
+
+    switch (in->scankeys[i].sk_strategy)
+    {
+      case RTLeftStrategyNumber:
+        res = DatumGetBool(DirectFunctionCall2(locus_left, leaf, query));
+        break;
+      case RTOverlapStrategyNumber:
+        res = DatumGetBool(DirectFunctionCall2(locus_overlap, leaf, query));
+        break;
+      case RTRightStrategyNumber:
+        res = DatumGetBool(DirectFunctionCall2(locus_right, leaf, query));
+        break;
+      case RTContainsStrategyNumber:
+        res = DatumGetBool(DirectFunctionCall2(locus_contains, leaf, query));
+        break;
+      case RTContainedByStrategyNumber:
+        res = DatumGetBool(DirectFunctionCall2(locus_contained, leaf, query));
+        break;
+      default:
+        elog(ERROR, "unrecognized strategy number: %d",
+           in->scankeys[i].sk_strategy);
+        break;
+    }
+
+    if (!res)
+      break;
+  }
+
+  PG_RETURN_BOOL(res);
+}
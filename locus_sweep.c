@@ -0,0 +1,772 @@
+/*
+ * contrib/locus/locus_sweep.c
+ *
+ * Sweep-line joins on overlap
+ *
+ * An inner join on a && b can only run as a nested loop, with an index probe
+ * or a full scan of one input for each row of the other.  This module adds a
+ * custom join path that sorts both inputs by locus_ops instead and sweeps
+ * along the genome: the rows of both inputs are taken in (contig, lower)
+ * order, and each is paired with the rows of the other input still active,
+ * that is, those on the same contig that end at or after its start.  Rows
+ * leave the active sets as soon as the sweep passes their end, so they only
+ * hold the loci that overlap the current position.  This is how bedtools
+ * and similar tools intersect sorted interval files.
+ *
+ * Sorting can't place "<all>" loci, which overlap loci on every contig when
+ * they are the left operand of &&.  Such rows are set aside in a tuplestore
+ * during the sweep, and paired with all the rows of the other input in a
+ * second pass over it.  The join clauses, && included, are evaluated on
+ * every pair the sweep yields.
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "commands/explain.h"
+#include "executor/executor.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "nodes/extensible.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/cost.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "optimizer/restrictinfo.h"
+#include "optimizer/tlist.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/ruleutils.h"
+#include "utils/tuplestore.h"
+#include "utils/typcache.h"
+
+#include "locus_data.h"
+
+#define LOCUS_SWEEP_OUTER  0
+#define LOCUS_SWEEP_INNER  1
+
+/* A row of one input in the active set */
+typedef struct LocusSweepEntry
+{
+  dlist_node  node;
+  LOCUS       key;
+  MinimalTuple tuple;
+} LocusSweepEntry;
+
+/* One input of the join */
+typedef struct LocusSweepInput
+{
+  PlanState  *plan;
+  AttrNumber  keyno;          /* column of the join key */
+  TupleTableSlot *head;       /* next row, not swept yet */
+  LOCUS       head_key;
+  bool        done;
+  dlist_head  active;
+  TupleTableSlot *slot;       /* row of this input in the current pair */
+} LocusSweepInput;
+
+typedef struct LocusSweepState
+{
+  CustomScanState css;
+  LocusSweepInput input[2];
+  int         left;           /* input of the left operand of && */
+  int        *map;            /* scan tuple columns: outer > 0, inner < 0 */
+  int         nmap;
+  MemoryContext active_cxt;
+  int         current;        /* input of the row being paired, or -1 */
+  dlist_node *partner;        /* its next partner in the other input */
+  Tuplestorestate *wildcards; /* "<all>" rows of the left input */
+  bool        sweep_done;
+  bool        rescanned;      /* second pass over the other input begun */
+  TupleTableSlot *other_row;  /* its row being paired with the wildcards */
+  int64       nactive;
+  int64       peak_active;
+  int64       nwildcards;
+} LocusSweepState;
+
+static bool locus_enable_sweep_join = true;
+static set_join_pathlist_hook_type prev_set_join_pathlist_hook = NULL;
+
+static Plan *locus_sweep_plan_path(PlannerInfo *root, RelOptInfo *rel,
+                                   CustomPath *best_path, List *tlist,
+                                   List *clauses, List *custom_plans);
+static Node *locus_sweep_create_state(CustomScan *cscan);
+static void locus_sweep_begin(CustomScanState *node, EState *estate, int eflags);
+static TupleTableSlot *locus_sweep_exec(CustomScanState *node);
+static void locus_sweep_end(CustomScanState *node);
+static void locus_sweep_rescan(CustomScanState *node);
+static void locus_sweep_explain(CustomScanState *node, List *ancestors,
+                                ExplainState *es);
+
+static const CustomPathMethods locus_sweep_path_methods = {
+  .CustomName = "LocusSweepJoin",
+  .PlanCustomPath = locus_sweep_plan_path,
+};
+
+static const CustomScanMethods locus_sweep_scan_methods = {
+  .CustomName = "LocusSweepJoin",
+  .CreateCustomScanState = locus_sweep_create_state,
+};
+
+static const CustomExecMethods locus_sweep_exec_methods = {
+  .CustomName = "LocusSweepJoin",
+  .BeginCustomScan = locus_sweep_begin,
+  .ExecCustomScan = locus_sweep_exec,
+  .EndCustomScan = locus_sweep_end,
+  .ReScanCustomScan = locus_sweep_rescan,
+  .ExplainCustomScan = locus_sweep_explain,
+};
+
+/*****************************************************************************
+ * Planning
+ *****************************************************************************/
+
+/*
+ * Whether an operator is locus overlap.  It is recognized by the C function
+ * behind it, which doesn't depend on the schema of the extension.
+ */
+static bool
+locus_sweep_is_overlap(OpExpr *op)
+{
+  static Oid  overlap_opno = InvalidOid;
+  FmgrInfo    finfo;
+
+  if (op->opno == overlap_opno)
+    return true;
+  if (list_length(op->args) != 2 ||
+      exprType(linitial(op->args)) != exprType(lsecond(op->args)) ||
+      get_typlen(exprType(linitial(op->args))) != sizeof(LOCUS))
+    return false;
+
+  fmgr_info(get_opcode(op->opno), &finfo);
+  if (finfo.fn_addr != locus_overlap)
+    return false;
+
+  overlap_opno = op->opno;
+  return true;
+}
+
+/*
+ * The cheapest path of rel sorted on key, either one that is already sorted
+ * or the cheapest path with a sort on top.
+ */
+static Path *
+locus_sweep_sorted_path(PlannerInfo *root, RelOptInfo *rel, Var *key)
+{
+  Oid         ltopr = lookup_type_cache(key->vartype, TYPECACHE_LT_OPR)->lt_opr;
+  List       *pathkeys;
+  Path       *cheapest = rel->cheapest_total_path;
+  Path       *sorted;
+  Path       *sort;
+
+  if (!OidIsValid(ltopr) || cheapest == NULL || cheapest->param_info != NULL)
+    return NULL;
+
+  pathkeys = build_expression_pathkey(root, (Expr *) key, ltopr, rel->relids, true);
+  if (pathkeys == NIL)
+    return NULL;
+  if (pathkeys_contained_in(pathkeys, cheapest->pathkeys))
+    return cheapest;
+
+  sorted = get_cheapest_path_for_pathkeys(rel->pathlist, pathkeys, NULL,
+                                          TOTAL_COST, false);
+  sort = (Path *) create_sort_path(root, rel, cheapest, pathkeys, -1.0);
+  if (sorted == NULL || sort->total_cost < sorted->total_cost)
+    sorted = sort;
+
+  return sorted;
+}
+
+static void
+locus_sweep_join_pathlist(PlannerInfo *root, RelOptInfo *joinrel,
+                          RelOptInfo *outerrel, RelOptInfo *innerrel,
+                          JoinType jointype, JoinPathExtraData *extra)
+{
+  OpExpr     *clause = NULL;
+  bool        left_is_outer = false;
+  Var        *outer_key,
+             *inner_key;
+  Path       *outer_path,
+             *inner_path;
+  List       *quals;
+  QualCost    qual_cost;
+  double      active_rows;
+  CustomPath *cpath;
+  ListCell   *lc;
+
+  if (prev_set_join_pathlist_hook)
+    prev_set_join_pathlist_hook(root, joinrel, outerrel, innerrel, jointype, extra);
+
+  /*
+   * Only inner joins, and none under row locks: an EvalPlanQual recheck
+   * would have to rebuild the joined row.
+   */
+  if (!locus_enable_sweep_join || jointype != JOIN_INNER ||
+      !bms_is_empty(joinrel->lateral_relids) || root->rowMarks != NIL)
+    return;
+
+  /* the scan tuple is made of plain columns of the inputs */
+  foreach(lc, joinrel->reltarget->exprs)
+  {
+    if (!IsA(lfirst(lc), Var))
+      return;
+  }
+
+  foreach(lc, extra->restrictlist)
+  {
+    RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+    OpExpr     *op;
+
+    if (rinfo->pseudoconstant)
+      return;
+    if (clause != NULL || !is_opclause(rinfo->clause))
+      continue;
+
+    op = (OpExpr *) rinfo->clause;
+    if (!locus_sweep_is_overlap(op) ||
+        !IsA(linitial(op->args), Var) || !IsA(lsecond(op->args), Var))
+      continue;
+
+    if (bms_is_subset(rinfo->left_relids, outerrel->relids) &&
+        bms_is_subset(rinfo->right_relids, innerrel->relids))
+    {
+      clause = op;
+      left_is_outer = true;
+    }
+    else if (bms_is_subset(rinfo->left_relids, innerrel->relids) &&
+             bms_is_subset(rinfo->right_relids, outerrel->relids))
+    {
+      clause = op;
+      left_is_outer = false;
+    }
+  }
+  if (clause == NULL)
+    return;
+
+  quals = extract_actual_clauses(extra->restrictlist, false);
+  foreach(lc, pull_var_clause((Node *) quals, PVC_INCLUDE_PLACEHOLDERS))
+  {
+    if (!IsA(lfirst(lc), Var))
+      return;
+  }
+
+  outer_key = (Var *) (left_is_outer ? linitial(clause->args) : lsecond(clause->args));
+  inner_key = (Var *) (left_is_outer ? lsecond(clause->args) : linitial(clause->args));
+  outer_path = locus_sweep_sorted_path(root, outerrel, outer_key);
+  inner_path = locus_sweep_sorted_path(root, innerrel, inner_key);
+  if (outer_path == NULL || inner_path == NULL)
+    return;
+
+  /*
+   * The active sets hold the rows that overlap the sweep position, about as
+   * many as the partners of a row.  Leave joins whose active sets wouldn't
+   * fit in work_mem to the other join methods.
+   */
+  active_rows = joinrel->rows / Max(outer_path->rows, 1.0) +
+    joinrel->rows / Max(inner_path->rows, 1.0);
+  if (active_rows * (Max(outerrel->reltarget->width, innerrel->reltarget->width) +
+                     MAXALIGN(SizeofMinimalTupleHeader) +
+                     sizeof(LocusSweepEntry)) > work_mem * 1024.0)
+    return;
+
+  cpath = makeNode(CustomPath);
+  cpath->path.pathtype = T_CustomScan;
+  cpath->path.parent = joinrel;
+  cpath->path.pathtarget = joinrel->reltarget;
+  cpath->path.param_info = NULL;
+  cpath->path.parallel_aware = false;
+  cpath->path.parallel_safe = false;
+  cpath->path.parallel_workers = 0;
+  cpath->path.rows = joinrel->rows;
+  cpath->path.pathkeys = NIL;
+
+  /*
+   * Both inputs are read once, and every row is compared with the head of
+   * the other input and with the active rows it evicts.  The join clauses
+   * are evaluated on the pairs, about as many as the join returns.
+   */
+  cost_qual_eval(&qual_cost, quals, root);
+  cpath->path.startup_cost = outer_path->startup_cost + inner_path->startup_cost +
+    qual_cost.startup + joinrel->reltarget->cost.startup;
+  cpath->path.total_cost = cpath->path.startup_cost +
+    (outer_path->total_cost - outer_path->startup_cost) +
+    (inner_path->total_cost - inner_path->startup_cost) +
+    2 * cpu_operator_cost * (outer_path->rows + inner_path->rows) +
+    (cpu_tuple_cost + qual_cost.per_tuple + joinrel->reltarget->cost.per_tuple) *
+    joinrel->rows;
+
+  cpath->custom_paths = list_make2(outer_path, inner_path);
+  cpath->custom_private = list_make2(extra->restrictlist, clause);
+  cpath->methods = &locus_sweep_path_methods;
+
+  add_path(joinrel, &cpath->path);
+}
+
+/* Position of a column in the target list of an input plan, or 0 */
+static int
+locus_sweep_find_var(List *tlist, Var *var)
+{
+  ListCell   *lc;
+
+  foreach(lc, tlist)
+  {
+    TargetEntry *tle = lfirst_node(TargetEntry, lc);
+    Var        *tvar = (Var *) tle->expr;
+
+    if (IsA(tvar, Var) && tvar->varno == var->varno &&
+        tvar->varattno == var->varattno && tvar->varlevelsup == var->varlevelsup)
+      return tle->resno;
+  }
+
+  return 0;
+}
+
+static Plan *
+locus_sweep_plan_path(PlannerInfo *root, RelOptInfo *rel,
+                      CustomPath *best_path, List *tlist,
+                      List *clauses, List *custom_plans)
+{
+  CustomScan *cscan = makeNode(CustomScan);
+  List       *restrictlist = (List *) linitial(best_path->custom_private);
+  OpExpr     *clause = (OpExpr *) lsecond(best_path->custom_private);
+  Plan       *outer_plan = (Plan *) linitial(custom_plans);
+  Plan       *inner_plan = (Plan *) lsecond(custom_plans);
+  List       *quals = extract_actual_clauses(restrictlist, false);
+  List       *scan_tlist;
+  List       *map = NIL;
+  Var        *left = (Var *) linitial(clause->args);
+  Var        *right = (Var *) lsecond(clause->args);
+  bool        left_is_outer;
+  ListCell   *lc;
+
+  /*
+   * The scan tuple holds the columns of both inputs that the target list
+   * and the join clauses need; map says where each comes from.
+   */
+  scan_tlist = add_to_flat_tlist(NIL, pull_var_clause((Node *) tlist, 0));
+  scan_tlist = add_to_flat_tlist(scan_tlist, pull_var_clause((Node *) quals, 0));
+  foreach(lc, scan_tlist)
+  {
+    Var        *var = (Var *) lfirst_node(TargetEntry, lc)->expr;
+    int         resno;
+
+    if ((resno = locus_sweep_find_var(outer_plan->targetlist, var)) > 0)
+      map = lappend_int(map, resno);
+    else if ((resno = locus_sweep_find_var(inner_plan->targetlist, var)) > 0)
+      map = lappend_int(map, -resno);
+    else
+      elog(ERROR, "variable not found in the inputs of a sweep join");
+  }
+
+  left_is_outer = locus_sweep_find_var(outer_plan->targetlist, left) > 0;
+
+  cscan->scan.plan.targetlist = tlist;
+  cscan->scan.plan.qual = quals;
+  cscan->scan.scanrelid = 0;
+  cscan->flags = best_path->flags;
+  cscan->custom_plans = custom_plans;
+  cscan->custom_exprs = list_make1(clause);
+  cscan->custom_private =
+    list_make2(map,
+               list_make3_int(locus_sweep_find_var(outer_plan->targetlist,
+                                                   left_is_outer ? left : right),
+                              locus_sweep_find_var(inner_plan->targetlist,
+                                                   left_is_outer ? right : left),
+                              left_is_outer ? LOCUS_SWEEP_OUTER : LOCUS_SWEEP_INNER));
+  cscan->custom_scan_tlist = scan_tlist;
+  cscan->methods = &locus_sweep_scan_methods;
+
+  return &cscan->scan.plan;
+}
+
+/*****************************************************************************
+ * Execution
+ *****************************************************************************/
+
+static Node *
+locus_sweep_create_state(CustomScan *cscan)
+{
+  LocusSweepState *state;
+
+  state = (LocusSweepState *) newNode(sizeof(LocusSweepState), T_CustomScanState);
+  state->css.methods = &locus_sweep_exec_methods;
+
+  return (Node *) state;
+}
+
+static void
+locus_sweep_begin(CustomScanState *node, EState *estate, int eflags)
+{
+  LocusSweepState *state = (LocusSweepState *) node;
+  CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+  List       *map = (List *) linitial(cscan->custom_private);
+  List       *keys = (List *) lsecond(cscan->custom_private);
+  ListCell   *lc;
+  int         i;
+
+  for (i = 0; i < 2; i++)
+  {
+    LocusSweepInput *input = &state->input[i];
+
+    input->plan = ExecInitNode((Plan *) list_nth(cscan->custom_plans, i), estate, eflags);
+    input->keyno = list_nth_int(keys, i);
+    input->slot = ExecInitExtraTupleSlot(estate, ExecGetResultType(input->plan),
+                                         &TTSOpsMinimalTuple);
+    dlist_init(&input->active);
+    node->custom_ps = lappend(node->custom_ps, input->plan);
+  }
+  state->left = list_nth_int(keys, 2);
+
+  state->nmap = list_length(map);
+  state->map = (int *) palloc(state->nmap * sizeof(int));
+  i = 0;
+  foreach(lc, map)
+    state->map[i++] = lfirst_int(lc);
+
+  state->active_cxt = AllocSetContextCreate(estate->es_query_cxt,
+                                            "locus sweep join",
+                                            ALLOCSET_DEFAULT_SIZES);
+  state->wildcards = tuplestore_begin_heap(false, false, work_mem);
+  state->current = -1;
+}
+
+/*
+ * Make sure the head of an input holds its next row, unless it is done.
+ * Rows with a null key match nothing, and "<all>" rows of the left input go
+ * to the wildcard store.
+ */
+static bool
+locus_sweep_fetch(LocusSweepState *state, int i)
+{
+  LocusSweepInput *input = &state->input[i];
+
+  while (input->head == NULL && !input->done)
+  {
+    TupleTableSlot *slot = ExecProcNode(input->plan);
+    Datum       key;
+    bool        isnull;
+
+    if (TupIsNull(slot))
+    {
+      input->done = true;
+      break;
+    }
+
+    key = slot_getattr(slot, input->keyno, &isnull);
+    if (isnull)
+      continue;
+    if (i == state->left && LOCUS_IS_WILDCARD(DatumGetLocusP(key)))
+    {
+      tuplestore_puttupleslot(state->wildcards, slot);
+      state->nwildcards++;
+      continue;
+    }
+
+    input->head = slot;
+    memcpy(&input->head_key, DatumGetLocusP(key), sizeof(LOCUS));
+  }
+
+  return input->head != NULL;
+}
+
+/*
+ * Drop the active rows of an input that no row from key on can overlap:
+ * those on an earlier contig, or ending before it starts.
+ */
+static void
+locus_sweep_evict(LocusSweepState *state, LocusSweepInput *input, LOCUS *key)
+{
+  dlist_mutable_iter iter;
+
+  dlist_foreach_modify(iter, &input->active)
+  {
+    LocusSweepEntry *entry = dlist_container(LocusSweepEntry, node, iter.cur);
+
+    if (entry->key.upper < key->lower || locus_contig_cmp(&entry->key, key) != 0)
+    {
+      dlist_delete(iter.cur);
+      pfree(entry->tuple);
+      pfree(entry);
+      state->nactive--;
+    }
+  }
+}
+
+/* Fill the scan tuple from a pair of rows */
+static TupleTableSlot *
+locus_sweep_pair(LocusSweepState *state, TupleTableSlot *outer, TupleTableSlot *inner)
+{
+  TupleTableSlot *slot = state->css.ss.ss_ScanTupleSlot;
+  int         i;
+
+  ExecClearTuple(slot);
+  for (i = 0; i < state->nmap; i++)
+  {
+    if (state->map[i] > 0)
+      slot->tts_values[i] = slot_getattr(outer, state->map[i], &slot->tts_isnull[i]);
+    else
+      slot->tts_values[i] = slot_getattr(inner, -state->map[i], &slot->tts_isnull[i]);
+  }
+
+  return ExecStoreVirtualTuple(slot);
+}
+
+/*
+ * Take the next row in sweep order into the active set of its input, after
+ * evicting the rows it has passed, and start pairing it with the active rows
+ * of the other input.  Returns false when the sweep is over.
+ */
+static bool
+locus_sweep_advance(LocusSweepState *state)
+{
+  bool        has_outer = locus_sweep_fetch(state, LOCUS_SWEEP_OUTER);
+  bool        has_inner = locus_sweep_fetch(state, LOCUS_SWEEP_INNER);
+  LocusSweepInput *input;
+  LocusSweepInput *other;
+  LocusSweepEntry *entry;
+  MemoryContext oldcontext;
+  int         i;
+
+  if (!has_outer && !has_inner)
+    return false;
+
+  if (!has_inner)
+    i = LOCUS_SWEEP_OUTER;
+  else if (!has_outer)
+    i = LOCUS_SWEEP_INNER;
+  else
+  {
+    LOCUS      *a = &state->input[LOCUS_SWEEP_OUTER].head_key;
+    LOCUS      *b = &state->input[LOCUS_SWEEP_INNER].head_key;
+    int         cmp = locus_contig_cmp(a, b);
+
+    i = (cmp < 0 || (cmp == 0 && a->lower <= b->lower)) ?
+      LOCUS_SWEEP_OUTER : LOCUS_SWEEP_INNER;
+  }
+  input = &state->input[i];
+  other = &state->input[1 - i];
+
+  /*
+   * Once the other input is done and nothing of it is active, the rest of
+   * this one has nothing to pair with.  The left input still has to be read
+   * to the end for its "<all>" rows.
+   */
+  if (other->done && dlist_is_empty(&other->active) && i != state->left)
+    return false;
+
+  locus_sweep_evict(state, &state->input[LOCUS_SWEEP_OUTER], &input->head_key);
+  locus_sweep_evict(state, &state->input[LOCUS_SWEEP_INNER], &input->head_key);
+
+  oldcontext = MemoryContextSwitchTo(state->active_cxt);
+  entry = (LocusSweepEntry *) palloc(sizeof(LocusSweepEntry));
+  entry->key = input->head_key;
+  entry->tuple = ExecCopySlotMinimalTuple(input->head);
+  MemoryContextSwitchTo(oldcontext);
+
+  dlist_push_tail(&input->active, &entry->node);
+  input->head = NULL;
+  if (++state->nactive > state->peak_active)
+    state->peak_active = state->nactive;
+
+  if (!dlist_is_empty(&other->active))
+  {
+    ExecStoreMinimalTuple(entry->tuple, input->slot, false);
+    state->current = i;
+    state->partner = dlist_head_node(&other->active);
+  }
+
+  return true;
+}
+
+/*
+ * The second pass: pair every row of the other input with every "<all>" row
+ * of the left one.
+ */
+static TupleTableSlot *
+locus_sweep_wildcards(LocusSweepState *state)
+{
+  int         other = 1 - state->left;
+  LocusSweepInput *input = &state->input[other];
+
+  if (tuplestore_tuple_count(state->wildcards) == 0)
+    return NULL;
+
+  if (!state->rescanned)
+  {
+    ExecReScan(input->plan);
+    state->rescanned = true;
+  }
+
+  for (;;)
+  {
+    if (state->other_row == NULL)
+    {
+      TupleTableSlot *slot = ExecProcNode(input->plan);
+      bool        isnull;
+
+      if (TupIsNull(slot))
+        return NULL;
+      (void) slot_getattr(slot, input->keyno, &isnull);
+      if (isnull)
+        continue;
+
+      state->other_row = slot;
+      tuplestore_rescan(state->wildcards);
+    }
+
+    if (tuplestore_gettupleslot(state->wildcards, true, false,
+                                state->input[state->left].slot))
+    {
+      if (other == LOCUS_SWEEP_OUTER)
+        return locus_sweep_pair(state, state->other_row,
+                                state->input[LOCUS_SWEEP_INNER].slot);
+      return locus_sweep_pair(state, state->input[LOCUS_SWEEP_OUTER].slot,
+                              state->other_row);
+    }
+    state->other_row = NULL;
+  }
+}
+
+static TupleTableSlot *
+locus_sweep_next(ScanState *node)
+{
+  LocusSweepState *state = (LocusSweepState *) node;
+
+  for (;;)
+  {
+    if (state->current >= 0)
+    {
+      int         i = state->current;
+      LocusSweepInput *other = &state->input[1 - i];
+      dlist_node *partner = state->partner;
+
+      if (partner != NULL)
+      {
+        LocusSweepEntry *entry = dlist_container(LocusSweepEntry, node, partner);
+
+        state->partner = dlist_has_next(&other->active, partner) ?
+          dlist_next_node(&other->active, partner) : NULL;
+        ExecStoreMinimalTuple(entry->tuple, other->slot, false);
+        return locus_sweep_pair(state, state->input[LOCUS_SWEEP_OUTER].slot,
+                                state->input[LOCUS_SWEEP_INNER].slot);
+      }
+      state->current = -1;
+    }
+
+    if (state->sweep_done)
+    {
+      TupleTableSlot *slot = locus_sweep_wildcards(state);
+
+      if (slot == NULL)
+        return ExecClearTuple(node->ss_ScanTupleSlot);
+      return slot;
+    }
+
+    if (!locus_sweep_advance(state))
+      state->sweep_done = true;
+  }
+}
+
+static bool
+locus_sweep_recheck(ScanState *node, TupleTableSlot *slot)
+{
+  return true;
+}
+
+static TupleTableSlot *
+locus_sweep_exec(CustomScanState *node)
+{
+  return ExecScan(&node->ss,
+                  (ExecScanAccessMtd) locus_sweep_next,
+                  (ExecScanRecheckMtd) locus_sweep_recheck);
+}
+
+static void
+locus_sweep_reset(LocusSweepState *state)
+{
+  int         i;
+
+  for (i = 0; i < 2; i++)
+  {
+    state->input[i].head = NULL;
+    state->input[i].done = false;
+    dlist_init(&state->input[i].active);
+  }
+  MemoryContextReset(state->active_cxt);
+  tuplestore_clear(state->wildcards);
+  state->nactive = 0;
+  state->current = -1;
+  state->partner = NULL;
+  state->sweep_done = false;
+  state->rescanned = false;
+  state->other_row = NULL;
+}
+
+static void
+locus_sweep_rescan(CustomScanState *node)
+{
+  LocusSweepState *state = (LocusSweepState *) node;
+  int         i;
+
+  for (i = 0; i < 2; i++)
+  {
+    if (state->input[i].plan->chgParam == NULL)
+      ExecReScan(state->input[i].plan);
+  }
+  locus_sweep_reset(state);
+}
+
+static void
+locus_sweep_end(CustomScanState *node)
+{
+  LocusSweepState *state = (LocusSweepState *) node;
+
+  ExecEndNode(state->input[LOCUS_SWEEP_OUTER].plan);
+  ExecEndNode(state->input[LOCUS_SWEEP_INNER].plan);
+  tuplestore_end(state->wildcards);
+  MemoryContextDelete(state->active_cxt);
+}
+
+static void
+locus_sweep_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+  LocusSweepState *state = (LocusSweepState *) node;
+  CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+  List       *context;
+
+  context = set_deparse_context_plan(es->deparse_cxt, &cscan->scan.plan, ancestors);
+  ExplainPropertyText("Sweep Key",
+                      deparse_expression(linitial(cscan->custom_exprs), context,
+                                         true, false),
+                      es);
+
+  if (es->analyze)
+  {
+    ExplainPropertyInteger("Peak Active Rows", NULL, state->peak_active, es);
+    ExplainPropertyInteger("Wildcard Rows", NULL, state->nwildcards, es);
+  }
+}
+
+/*****************************************************************************
+ * Registration
+ *****************************************************************************/
+
+void
+locus_sweep_init(void)
+{
+  DefineCustomBoolVariable("locus.enable_sweep_join",
+                           "Enables the planner's use of sweep-line joins on locus overlap.",
+                           NULL,
+                           &locus_enable_sweep_join,
+                           true,
+                           PGC_USERSET,
+                           0,
+                           NULL, NULL, NULL);
+
+  RegisterCustomScanMethods(&locus_sweep_scan_methods);
+
+  prev_set_join_pathlist_hook = set_join_pathlist_hook;
+  set_join_pathlist_hook = locus_sweep_join_pathlist;
+}
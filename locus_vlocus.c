@@ -0,0 +1,353 @@
+/*
+ * contrib/locus/locus_vlocus.c
+ *
+ * Genomic loci with contig names of any length
+ *
+ * vlocus is the variable-length variant of locus for assemblies whose contig
+ * names do not fit in 14 characters, such as chr1_KI270706v1_random or the
+ * scaffolds of non-model organisms.  It reads and writes the same text, sorts
+ * and compares the same way, and takes the contig names that locus rejects.
+ * A value is the fields of a LOCUS followed by its contig (see VLOCUS in
+ * locus_data.h); with the one-byte varlena header of short values on disk,
+ * chr1:100-200 takes 20 bytes rather than 32.
+ *
+ * The functions read a value in place with vlocus_view(), which yields a
+ * LOCUS whose contig is a copy, or a pointer for names that do not fit, and
+ * hand it to the function of locus that does the job.
+ */
+
+#include "postgres.h"
+
+#include <limits.h>  /* for INT_MAX */
+
+#include "fmgr.h"
+#include "libpq/pqformat.h"
+#include "utils/builtins.h"
+
+#include "locus_data.h"
+
+PG_FUNCTION_INFO_V1(vlocus_in);
+PG_FUNCTION_INFO_V1(vlocus_out);
+PG_FUNCTION_INFO_V1(vlocus_recv);
+PG_FUNCTION_INFO_V1(vlocus_send);
+PG_FUNCTION_INFO_V1(vlocus);
+PG_FUNCTION_INFO_V1(vlocus_to_locus);
+PG_FUNCTION_INFO_V1(vlocus_contig);
+PG_FUNCTION_INFO_V1(vlocus_lower);
+PG_FUNCTION_INFO_V1(vlocus_upper);
+PG_FUNCTION_INFO_V1(vlocus_cmp);
+PG_FUNCTION_INFO_V1(vlocus_lt);
+PG_FUNCTION_INFO_V1(vlocus_le);
+PG_FUNCTION_INFO_V1(vlocus_gt);
+PG_FUNCTION_INFO_V1(vlocus_ge);
+PG_FUNCTION_INFO_V1(vlocus_same);
+PG_FUNCTION_INFO_V1(vlocus_different);
+PG_FUNCTION_INFO_V1(vlocus_left);
+PG_FUNCTION_INFO_V1(vlocus_right);
+PG_FUNCTION_INFO_V1(vlocus_over_left);
+PG_FUNCTION_INFO_V1(vlocus_over_right);
+PG_FUNCTION_INFO_V1(vlocus_overlap);
+PG_FUNCTION_INFO_V1(vlocus_contains);
+PG_FUNCTION_INFO_V1(vlocus_contained);
+
+/*
+ * Build a vlocus.  The contig need not end in a NUL.
+ */
+static VLOCUS *
+vlocus_build(bool chr, const char *contig, int len, int32 lower, int32 upper)
+{
+  VLOCUS     *result = (VLOCUS *) palloc0(VLOCUS_HDRSZ + len + 1);
+
+  SET_VARSIZE(result, VLOCUS_HDRSZ + len + 1);
+  result->lower = lower;
+  result->upper = upper;
+  result->chr = chr;
+  memcpy(result->contig, contig, len);
+  result->flags = locus_contig_flags(result->contig, result->natkey);
+
+  return result;
+}
+
+
+/*****************************************************************************
+ * Input/Output functions
+ *****************************************************************************/
+
+Datum
+vlocus_in(PG_FUNCTION_ARGS)
+{
+  char       *str = PG_GETARG_CSTRING(0);
+  LOCUS       locus;
+  const char *contig;
+  int         len;
+
+  locus_parse_contig(str, &locus, VLOCUS_MAX_CONTIG, &contig, &len);
+
+  PG_RETURN_POINTER(vlocus_build(locus.chr, contig, len, locus.lower, locus.upper));
+}
+
+Datum
+vlocus_out(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+  const char *contig;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+  contig = locus_contig_name(&view);
+
+  PG_RETURN_CSTRING(locus_format(view.chr, contig, strlen(contig), view.lower, view.upper));
+}
+
+/*
+ * Binary representation: that of locus (see locus_send()), with contigs of
+ * up to VLOCUS_MAX_CONTIG bytes
+ */
+#define VLOCUS_BINARY_VERSION  1
+#define VLOCUS_BINARY_CHR      0x01
+
+Datum
+vlocus_recv(PG_FUNCTION_ARGS)
+{
+  StringInfo  buf = (StringInfo) PG_GETARG_POINTER(0);
+  int         version;
+  int         flags;
+  int32       lower;
+  int32       upper;
+  int         len;
+  const char *contig;
+
+  version = pq_getmsgbyte(buf);
+  if (version != VLOCUS_BINARY_VERSION)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("unsupported vlocus binary format version %d", version)));
+
+  flags = pq_getmsgbyte(buf);
+  lower = pq_getmsgint(buf, 4);
+  upper = pq_getmsgint(buf, 4);
+  len = pq_getmsgbyte(buf);
+
+  if (lower > upper)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("swapped boundaries in external vlocus value: %d is greater than %d",
+                lower, upper)));
+
+  if (len < 1)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig length %d in external vlocus value", len)));
+
+  /* as vlocus_in would produce, so that the value prints back as itself */
+  contig = pq_getmsgbytes(buf, len);
+  if (!locus_contig_valid((flags & VLOCUS_BINARY_CHR) != 0, contig, len,
+                          VLOCUS_MAX_CONTIG))
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+         errmsg("invalid contig in external vlocus value")));
+
+  PG_RETURN_POINTER(vlocus_build((flags & VLOCUS_BINARY_CHR) != 0, contig, len, lower, upper));
+}
+
+Datum
+vlocus_send(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+  const char *contig;
+  int         len;
+  StringInfoData buf;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+  contig = locus_contig_name(&view);
+  len = strlen(contig);
+
+  pq_begintypsend(&buf);
+  pq_sendbyte(&buf, VLOCUS_BINARY_VERSION);
+  pq_sendbyte(&buf, view.chr ? VLOCUS_BINARY_CHR : 0);
+  pq_sendint32(&buf, view.lower);
+  pq_sendint32(&buf, view.upper);
+  pq_sendbyte(&buf, len);
+  pq_sendbytes(&buf, contig, len);
+
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+
+/*****************************************************************************
+ * Casts and accessors
+ *****************************************************************************/
+
+Datum
+vlocus(PG_FUNCTION_ARGS)
+{
+  LOCUS      *locus = PG_GETARG_LOCUS_P(0);
+
+  PG_RETURN_POINTER(vlocus_build(locus->chr, locus->contig, strlen(locus->contig),
+                                 locus->lower, locus->upper));
+}
+
+Datum
+vlocus_to_locus(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+  LOCUS      *result;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+
+  if (view.flags & LOCUS_CONTIG_OUT)
+    ereport(ERROR,
+        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+         errmsg("contig \"%s\" is too long for type locus", locus_contig_name(&view))));
+
+  result = (LOCUS *) palloc0(sizeof(LOCUS));
+  result->lower = view.lower;
+  result->upper = view.upper;
+  strcpy(result->contig, view.contig);
+  result->chr = view.chr;
+  result->flags = view.flags;
+  memcpy(result->natkey, view.natkey, LOCUS_NATKEY_LEN);
+
+  PG_RETURN_POINTER(result);
+}
+
+Datum
+vlocus_contig(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+
+  PG_RETURN_TEXT_P(cstring_to_text(locus_contig_name(&view)));
+}
+
+Datum
+vlocus_lower(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+
+  PG_RETURN_INT32(view.lower);
+}
+
+Datum
+vlocus_upper(PG_FUNCTION_ARGS)
+{
+  LOCUS       view;
+
+  vlocus_view(PG_GETARG_VLOCUS_P(0), &view);
+
+  PG_RETURN_INT32(view.upper);
+}
+
+
+/*****************************************************************************
+ * Operators
+ *****************************************************************************/
+
+/*
+ * Call the locus function op on the two vlocus arguments
+ */
+static Datum
+vlocus_call(PGFunction op, FunctionCallInfo fcinfo)
+{
+  VLOCUS     *a = PG_GETARG_VLOCUS_P(0);
+  VLOCUS     *b = PG_GETARG_VLOCUS_P(1);
+  LOCUS       va;
+  LOCUS       vb;
+  Datum       result;
+
+  vlocus_view(a, &va);
+  vlocus_view(b, &vb);
+
+  result = DirectFunctionCall2(op, PointerGetDatum(&va), PointerGetDatum(&vb));
+
+  PG_FREE_IF_COPY(a, 0);
+  PG_FREE_IF_COPY(b, 1);
+
+  return result;
+}
+
+Datum
+vlocus_cmp(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_cmp, fcinfo);
+}
+
+Datum
+vlocus_lt(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_lt, fcinfo);
+}
+
+Datum
+vlocus_le(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_le, fcinfo);
+}
+
+Datum
+vlocus_gt(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_gt, fcinfo);
+}
+
+Datum
+vlocus_ge(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_ge, fcinfo);
+}
+
+Datum
+vlocus_same(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_same, fcinfo);
+}
+
+Datum
+vlocus_different(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_different, fcinfo);
+}
+
+Datum
+vlocus_left(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_left, fcinfo);
+}
+
+Datum
+vlocus_right(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_right, fcinfo);
+}
+
+Datum
+vlocus_over_left(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_over_left, fcinfo);
+}
+
+Datum
+vlocus_over_right(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_over_right, fcinfo);
+}
+
+Datum
+vlocus_overlap(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_overlap, fcinfo);
+}
+
+Datum
+vlocus_contains(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_contains, fcinfo);
+}
+
+Datum
+vlocus_contained(PG_FUNCTION_ARGS)
+{
+  return vlocus_call(locus_contained, fcinfo);
+}
@@ -0,0 +1,92 @@
+--
+--  Locus datatype test
+--
+-- locus_merge: overlapping loci on the same contig become their union
+SELECT locus_merge(p) FROM (VALUES
+  ('chr1:100-200'::locus), ('chr1:150-300'), ('1:300-400'), ('chr1:402-500'),
+  ('chr2:100-200'), ('chr10:50-60'), ('chr1:1000'), (NULL),
+  ('<all>:1-10'), ('<all>:5-20')) AS t (p);
+
+-- with a gap, loci at most that many bases apart are merged as well
+SELECT locus_merge(p, 2) FROM (VALUES
+  ('chr1:100-200'::locus), ('chr1:202-300'), ('chr1:303-400'), ('chrX:5-')) AS t (p);
+SELECT locus_merge(p, -1) FROM (VALUES ('chr1:100-200'::locus)) AS t (p);
+
+-- no loci, no result
+SELECT locus_merge(p) IS NULL AS empty FROM (VALUES (NULL::locus)) AS t (p);
+SELECT contig(p), locus_merge(p) FROM (VALUES
+  ('chr1:100-200'::locus), ('chr1:150-300'), ('chr2:1-5'), ('chr2:7-9')) AS t (p)
+GROUP BY 1 ORDER BY 1;
+
+-- states that outgrow the initial array, and parallel partial aggregation
+CREATE TABLE test_merge AS
+  SELECT ('chr' || (1 + i % 5) || ':' || s || '-' || (s + (i % 10) * 100))::locus AS p
+  FROM generate_series(1, 20000) AS i, LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g;
+ANALYZE test_merge;
+SELECT cardinality(m), m[1] AS first, m[cardinality(m)] AS last
+FROM (SELECT locus_merge(p) AS m FROM test_merge) AS t;
+SELECT cardinality(m), m[1] AS first, m[cardinality(m)] AS last
+FROM (SELECT locus_merge(p, 100) AS m FROM test_merge) AS t;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT locus_merge(p) FROM test_merge;
+SELECT cardinality(m), m[1] AS first, m[cardinality(m)] AS last
+FROM (SELECT locus_merge(p) AS m FROM test_merge) AS t;
+SELECT cardinality(m), m[1] AS first, m[cardinality(m)] AS last
+FROM (SELECT locus_merge(p, 100) AS m FROM test_merge) AS t;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE test_merge;
+
+-- locus_coverage: runs of equal depth, from lower to upper inclusive
+SELECT * FROM unnest((SELECT locus_coverage(p) FROM (VALUES
+  ('chr1:100-200'::locus), ('chr1:150-300'), ('chr1:150-160'), ('chr2:10-20'),
+  ('chr1:400-'), (NULL)) AS t (p)));
+
+-- with bins, the depth is the number of loci that touch each bin
+SELECT * FROM unnest((SELECT locus_coverage(p, 100) FROM (VALUES
+  ('chr1:100-200'::locus), ('chr1:150-300'), ('chr1:150-160'), ('chr2:10-20'),
+  ('chr1:400-'), (NULL)) AS t (p)));
+SELECT locus_coverage(p, 0) FROM (VALUES ('chr1:100-200'::locus)) AS t (p);
+SELECT locus_coverage(p) IS NULL AS empty FROM (VALUES (NULL::locus)) AS t (p);
+
+-- the runs agree with the depth counted base by base
+CREATE TABLE test_coverage AS
+  SELECT ('chr' || (1 + i % 3) || ':' || s || '-' || (s + i % 50))::locus AS p
+  FROM generate_series(1, 20000) AS i, LATERAL (SELECT (i * 7919) % 100000 AS s) AS g;
+ANALYZE test_coverage;
+WITH bases AS (
+  SELECT contig(p) AS contig, pos, count(*) AS depth
+  FROM test_coverage, generate_series(lower(p), upper(p)) AS pos
+  GROUP BY 1, 2
+),
+runs AS (
+  SELECT contig(locus) AS contig, pos, depth
+  FROM unnest((SELECT locus_coverage(p) FROM test_coverage)),
+       generate_series(lower(locus), upper(locus)) AS pos
+)
+SELECT (SELECT count(*) FROM bases) AS bases,
+       (SELECT count(*) FROM (TABLE bases EXCEPT TABLE runs) AS d) AS missing,
+       (SELECT count(*) FROM (TABLE runs EXCEPT TABLE bases) AS d) AS extra;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT locus_coverage(p) FROM test_coverage;
+SELECT count(*) AS runs, sum(depth * (upper(locus) - lower(locus) + 1)) AS bases, max(depth)
+FROM unnest((SELECT locus_coverage(p) FROM test_coverage));
+SELECT count(*) AS runs, sum(depth) AS depth, max(depth)
+FROM unnest((SELECT locus_coverage(p, 1000) FROM test_coverage));
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE test_coverage;
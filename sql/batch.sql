@@ -0,0 +1,59 @@
+--
+--  Locus datatype test
+--
+-- locus && locus[] and locus <@ locus[] agree with && ANY and <@ ANY
+SELECT p, p && a AS overlap, p && ANY (a) AS overlap_any,
+       p <@ a AS contained, p <@ ANY (a) AS contained_any
+FROM (VALUES ('chr1:150'::locus), ('chr1:190-310'), ('chr1:1500'), ('<all>:55'),
+             ('chr3:1500-1600'), ('chr2:60-70')) AS t(p),
+     (SELECT '{chr1:100-200,chr1:300-400,chr2:50-60,<all>:1000-2000,NULL}'::locus[] AS a) AS u;
+SELECT 'chr1:150'::locus && '{}'::locus[] AS overlap, 'chr1:150'::locus <@ '{}'::locus[] AS contained;
+
+-- one index scan probes the whole array
+CREATE TABLE test_batch AS
+  SELECT ('chr' || (1 + i % 5) || ':' || s || '-' || (s + (i % 10) * 100))::locus AS p
+  FROM generate_series(1, 20000) AS i, LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g;
+INSERT INTO test_batch VALUES ('<all>:500000-500100'), (NULL);
+CREATE INDEX test_batch_ix ON test_batch USING gist (p);
+CREATE TABLE test_batch_probe AS
+  SELECT ('chr' || (1 + j % 6) || ':' || s || '-' || (s + (j % 20) * 200))::locus AS p
+  FROM generate_series(1, 300) AS j, LATERAL (SELECT (j * 104729) % 1000000 AS s) AS g;
+INSERT INTO test_batch_probe VALUES ('<all>:10-20'), (NULL);
+ANALYZE test_batch;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM test_batch WHERE p && '{chr1:100-200,chr2:5000-6000}'::locus[];
+SELECT count(*) FROM test_batch WHERE p && '{chr1:100-2000,chr2:5000-6000}'::locus[];
+SELECT count(*) FROM test_batch WHERE p <@ '{chr1:100-2000,chr2:5000-6000}'::locus[];
+SELECT count(*) FROM test_batch WHERE p && (SELECT array_agg(p) FROM test_batch_probe);
+SELECT count(*) FROM test_batch WHERE p <@ (SELECT array_agg(p) FROM test_batch_probe);
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM test_batch WHERE p && ANY ((SELECT array_agg(p) FROM test_batch_probe));
+SELECT count(*) FROM test_batch WHERE p <@ ANY ((SELECT array_agg(p) FROM test_batch_probe));
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+
+-- an index scan rescanned with the array of each outer row, built where the
+-- last one was, probes that array
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT i, (SELECT count(*) FROM test_batch WHERE p && a) AS overlap,
+          (SELECT count(*) FROM test_batch WHERE p <@ a) AS contained
+FROM generate_series(1, 6) AS i,
+     LATERAL (SELECT ARRAY[('chr' || i || ':100-20000')::locus,
+                           ('chr' || i || ':600000-610000')::locus] AS a) AS g;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+-- an array that is not constant is probed one element at a time
+SELECT count(*) FILTER (WHERE b.p && a.a) AS overlap,
+       count(*) FILTER (WHERE b.p <@ a.a) AS contained
+FROM test_batch AS b,
+     (SELECT array_agg(p) AS a FROM test_batch_probe) AS a;
+DROP TABLE test_batch, test_batch_probe;
@@ -0,0 +1,33 @@
+--
+--  Locus datatype test
+--
+-- Testing binary send
+--
+SELECT locus_send('chr16:89831249-89831439');
+SELECT locus_send('GL383557.1:100');
+SELECT locus_send('X');
+
+-- binary COPY reads back what it writes
+\getenv abs_builddir PG_ABS_BUILDDIR
+\set binary_file :abs_builddir '/results/binary.data'
+CREATE TABLE test_binary (p locus);
+INSERT INTO test_binary VALUES ('chr16:89831249-89831439'), ('GL383557.1:100'), ('X'),
+  ('chrX:1-'), ('chr2:-99');
+COPY test_binary TO :'binary_file' WITH (FORMAT binary);
+CREATE TABLE test_binary_in (p locus);
+COPY test_binary_in FROM :'binary_file' WITH (FORMAT binary);
+SELECT (SELECT array_agg(locus_send(p)) FROM test_binary)
+     = (SELECT array_agg(locus_send(p)) FROM test_binary_in) AS same,
+       (SELECT count(*) FROM test_binary_in) AS rows;
+
+-- and rejects swapped boundaries, as locus_in does
+COPY (SELECT '\x0101000000c8000000640131'::bytea) TO :'binary_file' WITH (FORMAT binary);
+COPY test_binary_in FROM :'binary_file' WITH (FORMAT binary);
+
+-- and contigs that locus_in would not produce: "1:2", or "chrX" without
+-- the chr flag, which would print as chrX and read back with it
+COPY (SELECT '\x0100000000010000000203313a32'::bytea) TO :'binary_file' WITH (FORMAT binary);
+COPY test_binary_in FROM :'binary_file' WITH (FORMAT binary);
+COPY (SELECT '\x010000000001000000020463687258'::bytea) TO :'binary_file' WITH (FORMAT binary);
+COPY test_binary_in FROM :'binary_file' WITH (FORMAT binary);
+DROP TABLE test_binary, test_binary_in;
@@ -0,0 +1,23 @@
+--
+--  Locus datatype test
+--
+-- BRIN summaries on a table in genome order
+CREATE TABLE test_brin AS
+  SELECT ('chr' || c || ':' || pos || '-' || pos + 99)::locus AS p
+  FROM generate_series(1, 3) AS c, generate_series(1, 1000000, 100) AS pos
+  ORDER BY c, pos;
+INSERT INTO test_brin VALUES ('<all>:5000-5100');
+CREATE INDEX test_brin_ix ON test_brin USING brin (p) WITH (pages_per_range = 4);
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM test_brin WHERE p && 'chr2:500000-500999';
+SELECT count(*) FROM test_brin WHERE p && 'chr2:500000-500999';
+SELECT count(*) FROM test_brin WHERE p @> 'chr3:250050';
+SELECT count(*) FROM test_brin WHERE p <@ 'chr1:1-1000';
+SELECT count(*) FROM test_brin WHERE p = 'chr1:101-200';
+SELECT count(*) FROM test_brin WHERE p << 'chr1:1000';
+SELECT count(*) FROM test_brin WHERE p >> 'chr2:999000';
+
+-- the wildcard locus matches queries on any contig
+SELECT count(*) FROM test_brin WHERE p && 'chr3:5050';
+SELECT count(*) FROM test_brin WHERE p && '<all>:1-1000000';
+RESET enable_seqscan;
@@ -6,3 +6,12 @@
 select locus_cmp('chr6', 'chr21');
 select locus_cmp('chr6:29474946-29475446'::locus, 'chr21:29474869-29475900');
 select locus_cmp('chr6:29474946-29475446'::locus, 'chr6:28474869-29475900');
+
+-- contigs whose natural-order keys don't fit into the stored prefix
+select locus_cmp('GL000220.1:100', 'GL000219.1:100');
+select locus_cmp('KI270742.1', 'KI270743.1');
+
+-- 'chr' is not part of the contig
+select locus_cmp('chr1:100', '1:100');
+select locus_cmp('chr01:100', '1:100');
+select 'GL000220.1:5'::locus = 'GL000220.1:5'::locus AS bool;
@@ -0,0 +1,72 @@
+--
+--  Locus datatype test
+--
+\getenv abs_srcdir PG_ABS_SRCDIR
+\set tabix_file :abs_srcdir '/data/sample.bed.gz'
+\set alt_file :abs_srcdir '/data/alt_contigs.bed.gz'
+
+-- a BED file compressed with bgzip and indexed with tabix -p bed
+CREATE SERVER locus_files FOREIGN DATA WRAPPER locus_fdw;
+CREATE FOREIGN TABLE test_fdw (
+  locus locus,
+  chrom text,
+  chrom_start int,
+  chrom_end int,
+  name text,
+  score int
+) SERVER locus_files OPTIONS (filename :'tabix_file');
+
+-- the whole file
+SELECT count(*) FROM test_fdw;
+SELECT * FROM test_fdw LIMIT 3;
+
+-- a region: the scan reads its blocks only, and checks the qual again
+EXPLAIN (COSTS OFF) SELECT * FROM test_fdw WHERE locus && 'chr1:100000-200000';
+SELECT count(*) FROM test_fdw WHERE locus && 'chr1:100000-200000';
+SELECT count(*) FROM (SELECT * FROM test_fdw OFFSET 0) t WHERE locus && 'chr1:100000-200000';
+SELECT locus, name, score FROM test_fdw WHERE 'chrX:500000-500100' && locus;
+SELECT count(*) FROM test_fdw WHERE locus <@ 'chr2:1-1000000';
+SELECT count(*) FROM test_fdw WHERE 'chr2:1-1000000' @> locus;
+SELECT count(*) FROM test_fdw WHERE locus @> 'chr1:1000000';
+SELECT count(*) FROM test_fdw WHERE locus && 'chr3:1-1000000';
+
+-- a wildcard reads the region on every contig
+EXPLAIN (COSTS OFF) SELECT count(*) FROM test_fdw WHERE '<all>:100000-200000' && locus;
+SELECT count(*) FROM test_fdw WHERE '<all>:100000-200000' && locus;
+SELECT count(*) FROM test_fdw WHERE locus && '<all>:100000-200000';
+
+-- other quals are checked on the rows of the region
+EXPLAIN (COSTS OFF) SELECT name FROM test_fdw WHERE locus && 'chr10:1-100000' AND score > 900;
+SELECT locus, name, score FROM test_fdw WHERE locus && 'chr10:1-100000' AND score > 900 ORDER BY locus;
+
+-- columns can pick their fields
+CREATE FOREIGN TABLE test_fdw_names (
+  name text OPTIONS (field '4'),
+  score int,
+  locus locus
+) SERVER locus_files OPTIONS (filename :'tabix_file');
+SELECT * FROM test_fdw_names WHERE locus && 'chr2:1-5000';
+
+-- records on contigs a locus cannot hold, such as chr1_KI270706v1_random, are
+-- skipped and counted
+CREATE FOREIGN TABLE test_fdw_alt (
+  locus locus,
+  chrom text,
+  chrom_start int,
+  chrom_end int,
+  name text,
+  score int
+) SERVER locus_files OPTIONS (filename :'alt_file');
+SELECT * FROM test_fdw_alt;
+SELECT name FROM test_fdw_alt WHERE locus && '<all>:1-1000';
+SELECT name FROM test_fdw_alt WHERE locus && 'chr2:1-1000';
+
+-- errors
+CREATE FOREIGN TABLE test_fdw_bad (locus locus) SERVER locus_files;
+CREATE FOREIGN TABLE test_fdw_bad (locus locus) SERVER locus_files OPTIONS (filename 'x.gz', format 'bed');
+CREATE FOREIGN TABLE test_fdw_bad (locus locus OPTIONS (field '0')) SERVER locus_files OPTIONS (filename 'x.gz');
+CREATE FOREIGN TABLE test_fdw_bad (locus locus) SERVER locus_files OPTIONS (filename 'missing.bed.gz');
+SELECT * FROM test_fdw_bad;
+
+DROP FOREIGN TABLE test_fdw, test_fdw_names, test_fdw_alt, test_fdw_bad;
+DROP SERVER locus_files;
@@ -0,0 +1,34 @@
+--
+--  Locus datatype test
+--
+
+-- synthetic variant loci, the same for the same seed
+SELECT * FROM locus_generate(5, 'grch38', 'germline', 0);
+SELECT * FROM locus_generate(3, 'grch37', 'sv', 1);
+SELECT l FROM locus_generate(4, 'chm13', 'indel', 7) AS l;
+SELECT count(*) FROM locus_generate(1000);
+SELECT (SELECT array_agg(l) FROM locus_generate(1000, 'grch38', 'germline', 42) AS l)
+     = (SELECT array_agg(l) FROM locus_generate(1000, 'grch38', 'germline', 42) AS l) AS same_seed,
+       (SELECT array_agg(l) FROM locus_generate(1000, 'grch38', 'germline', 42) AS l)
+     = (SELECT array_agg(l) FROM locus_generate(1000, 'grch38', 'germline', 43) AS l) AS other_seed;
+
+-- the mix of lengths
+SELECT count(*) FILTER (WHERE length(l) = 0) AS snv,
+       count(*) FILTER (WHERE length(l) BETWEEN 1 AND 49) AS indel,
+       count(*) FILTER (WHERE length(l) > 49) AS sv
+FROM locus_generate(10000, 'grch38', 'germline', 1) AS l;
+SELECT min(length(l)), max(length(l)) FROM locus_generate(10000, 'grch38', 'indel', 1) AS l;
+SELECT min(length(l)), max(length(l)) FROM locus_generate(10000, 'grch38', 'sv', 1) AS l;
+
+-- contigs in proportion to their lengths, and loci within them
+SELECT contig(l), count(*) FROM locus_generate(10000, 'grch37', 'snv', 1) AS l
+GROUP BY 1 ORDER BY 2 DESC, 1 LIMIT 5;
+SELECT count(*), max(upper(l)) FROM locus_generate(100000, 'grch38', 'sv', 2) AS l
+WHERE contig(l) = 'M';
+SELECT count(*) FROM locus_generate(10000, 'chm13', 'sv', 3) AS l
+WHERE lower(l) < 1 OR l && 'chr1:248387329-2147483647';
+
+-- errors
+SELECT * FROM locus_generate(-1);
+SELECT * FROM locus_generate(1, 'hg19');
+SELECT * FROM locus_generate(1, 'grch38', 'cnv');
@@ -0,0 +1,46 @@
+--
+--  Locus datatype test
+--
+-- Hash support: equal loci hash alike however they are spelled
+SELECT locus_hash('chr1:100') = locus_hash('1:100') AS chr,
+       locus_hash(' 1:100') = locus_hash('1:100') AS blank,
+       locus_hash('GL000220.1:5') = locus_hash('GL000220.1:5') AS long_contig,
+       locus_hash_extended('chr1:100', 42) = locus_hash_extended('1:100', 42) AS extended;
+
+CREATE TABLE test_hash (p locus);
+INSERT INTO test_hash VALUES
+  ('chr1:100'),
+  ('1:100'),
+  (' 1:100'),
+  ('chr1:100-200'),
+  ('GL000220.1:5'),
+  ('chrX:1-'),
+  ('<all>:5');
+
+-- hash join
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM test_hash a JOIN test_hash b ON a.p = b.p;
+SELECT count(*) FROM test_hash a JOIN test_hash b ON a.p = b.p;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+
+-- hash aggregation
+SET enable_sort = off;
+EXPLAIN (COSTS OFF) SELECT DISTINCT p FROM test_hash;
+SELECT count(*) FROM (SELECT DISTINCT p FROM test_hash) s;
+RESET enable_sort;
+
+-- hash index
+CREATE INDEX test_hash_ix ON test_hash USING hash (p);
+SET enable_seqscan = off;
+SELECT count(*) FROM test_hash WHERE p = '1:100';
+SELECT count(*) FROM test_hash WHERE p = 'GL000220.1:5';
+RESET enable_seqscan;
+
+-- hash partitioning
+CREATE TABLE test_hash_part (p locus) PARTITION BY HASH (p);
+CREATE TABLE test_hash_part_0 PARTITION OF test_hash_part FOR VALUES WITH (MODULUS 2, REMAINDER 0);
+CREATE TABLE test_hash_part_1 PARTITION OF test_hash_part FOR VALUES WITH (MODULUS 2, REMAINDER 1);
+INSERT INTO test_hash_part SELECT p FROM test_hash;
+SELECT count(*), count(DISTINCT tableoid) AS partitions FROM test_hash_part WHERE p = '1:100';
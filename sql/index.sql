@@ -2,3 +2,28 @@
 --  Locus datatype test
 --
 CREATE INDEX test_locus_ix ON test_locus USING gist (p);
+
+-- The index is built by sorting; scans through it must find every match
+SET enable_seqscan = off;
+SELECT count(*) FROM test_locus WHERE p && '21';
+SELECT count(*) FROM test_locus WHERE p && 'chr21:10600000-12608058';
+SELECT count(*) FROM test_locus WHERE p <& 'chr21:28800000-30000000';
+RESET enable_seqscan;
+
+-- Keys above the leaves span several contigs and "<all>" loci
+CREATE TABLE test_gist_keys AS
+  SELECT ('chr' || (1 + i % 24) || ':' || i * 10 || '-' || i * 10 + i % 50)::locus AS p
+  FROM generate_series(1, 20000) AS i;
+INSERT INTO test_gist_keys
+  SELECT ('<all>:' || i * 1000 || '-' || i * 1000 + 10)::locus
+  FROM generate_series(1, 50) AS i;
+CREATE INDEX test_gist_keys_ix ON test_gist_keys USING gist (p) WITH (buffering = on);
+SET enable_seqscan = off;
+SELECT count(*) FROM test_gist_keys WHERE p && 'chr7:50000-60000';
+SELECT count(*) FROM test_gist_keys WHERE p << 'chr3:100000';
+SELECT count(*) FROM test_gist_keys WHERE p >> 'chr22:150000';
+SELECT count(*) FROM test_gist_keys WHERE p <@ '<all>:50000-60000';
+SELECT count(*) FROM test_gist_keys WHERE p @> 'chr5:1000-1005';
+SELECT count(*) FROM test_gist_keys WHERE p && '<all>:1000-1005';
+SELECT p, p <-> 'chr9:100000' AS distance FROM test_gist_keys ORDER BY p <-> 'chr9:100000' LIMIT 4;
+RESET enable_seqscan;
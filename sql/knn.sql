@@ -0,0 +1,20 @@
+--
+--  Locus datatype test
+--
+-- Nearest-neighbor search through the GiST index
+CREATE TABLE test_knn (p locus);
+INSERT INTO test_knn VALUES
+  ('chr7:55019017-55211628'),
+  ('chr7:55086725'),
+  ('chr7:55200000-55300000'),
+  ('chr7:100000'),
+  ('chr1:55191822'),
+  ('chr17:7661779-7687538'),
+  ('7:55191822'),
+  ('chr7:55191900-55192000');
+CREATE INDEX test_knn_ix ON test_knn USING gist (p);
+
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT p FROM test_knn ORDER BY p <-> 'chr7:55191822' LIMIT 3;
+SELECT p, p <-> 'chr7:55191822' AS distance FROM test_knn ORDER BY p <-> 'chr7:55191822', p;
+RESET enable_seqscan;
@@ -101,3 +101,13 @@ SELECT 'chr7:100-900'::locus @> 'chr1:200-500'::locus AS bool;
 SELECT '<all>:100-900'::locus @> 'chr1:200-500'::locus AS bool;
 SELECT '<all>:200-500'::locus @> 'chr1:100-900'::locus AS bool;
 SELECT 'chr1:100-900'::locus @> '<all>:200-500'::locus AS bool;
+
+-- distance in bases (zero for overlapping loci, infinite across contigs):
+--
+SELECT 'chr1:100-200'::locus <-> 'chr1:150'::locus AS distance;
+SELECT 'chr1:100-200'::locus <-> 'chr1:200-300'::locus AS distance;
+SELECT 'chr1:100-200'::locus <-> 'chr1:250-300'::locus AS distance;
+SELECT 'chr1:250-300'::locus <-> '1:100-200'::locus AS distance;
+SELECT 'chr1:100-200'::locus <-> 'chr2:100-200'::locus AS distance;
+SELECT '<all>:1000'::locus <-> 'chr2:100-200'::locus AS distance;
+SELECT 'chr2:100-200'::locus <-> '<all>:1000'::locus AS distance;
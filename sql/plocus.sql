@@ -0,0 +1,126 @@
+--
+--  Locus datatype test
+--
+-- contig names are entered into the dictionary by locus_contig_register(),
+-- with or without "chr", before values refer to them
+SELECT 'chr1:100-200'::plocus;
+SELECT locus_contig_register(name) AS id, name
+FROM unnest(ARRAY['chr1', 'chrX', 'chr2', 'chr1_KI270706v1_random', 'scaffold_0000123_pilon',
+                  'chrUn_KI270742v1', 'chr10', 'chr3', 'chr1_KI270707v1_random',
+                  'chrUn_GL000195v1_decoy_long']) AS name;
+SELECT locus_contig_register('1') AS "1", locus_contig_register('chr1') AS chr1,
+       locus_contig_register('<all>') AS "<all>";
+SELECT locus_contig_register('1:2');
+SELECT id, name FROM locus_contigs ORDER BY id;
+
+-- plocus reads and writes what vlocus does
+SELECT 'chr1:100-200'::plocus, '1:100'::plocus, 'chrX:400-'::plocus,
+       'chr2:-99'::plocus, '<all>'::plocus;
+SELECT 'chr1:200-100'::plocus;
+SELECT 'chr1_KI270706v1_random:100-200'::plocus, 'scaffold_0000123_pilon:1,000-2,000'::plocus;
+SELECT contig(p), lower(p), upper(p)
+FROM (SELECT 'chr1_KI270706v1_random:100-200'::plocus AS p) AS t;
+SELECT (repeat('x', 256) || ':5')::plocus;
+
+-- values refer only to entries that committed, so that every lookup finds
+-- its entry whatever the snapshot
+BEGIN;
+SELECT locus_contig_register('chrM');
+SELECT 'chrM:1-100'::plocus;
+ROLLBACK;
+SELECT 'chrM:1-100'::plocus;
+
+-- a read-only transaction, or a hot standby, reads the names there are
+BEGIN TRANSACTION READ ONLY;
+SELECT 'chr1:1-10'::plocus;
+ROLLBACK;
+
+-- so the functions that read values are stable and parallel safe; only
+-- registering names is not
+SELECT proname, provolatile, proparallel FROM pg_proc
+WHERE proname IN ('plocus_in', 'plocus_recv', 'plocus', 'locus_contig_register')
+ORDER BY proname;
+
+-- casts
+SELECT 'chr1:1-10'::locus::plocus, 'chrUn_KI270742v1:1-10'::plocus::locus;
+SELECT 'chr1_KI270706v1_random:1-10'::plocus::locus;
+
+-- binary send carries the name, not the ID
+SELECT plocus_send('chr1_KI270706v1_random:5-10');
+
+-- and binary input takes only contigs that plocus_in produces
+\getenv abs_builddir PG_ABS_BUILDDIR
+\set binary_file :abs_builddir '/results/plocus.data'
+CREATE TABLE test_plocus_in (p plocus);
+COPY (SELECT '\x0100000000010000000203313a32'::bytea) TO :'binary_file' WITH (FORMAT binary);
+COPY test_plocus_in FROM :'binary_file' WITH (FORMAT binary);
+DROP TABLE test_plocus_in;
+
+-- natural order, with contigs of either length
+SELECT p FROM (VALUES ('chrUn_KI270742v1:1'::plocus), ('chr10:1'), ('chr1_KI270706v1_random:5'),
+                      ('chr1:100'), ('<all>:1'), ('chr2:1'), ('chr1:5'),
+                      ('chr1_KI270706v1_random:1-4')) AS t(p)
+ORDER BY p;
+
+-- values take 16 bytes
+CREATE TABLE test_plocus_size (l locus, p plocus);
+INSERT INTO test_plocus_size VALUES ('chr1:100-200', 'chr1:100-200'),
+  ('chr1:100-200', 'chr1_KI270706v1_random:100-200');
+SELECT pg_column_size(l) AS locus, pg_column_size(p) AS plocus FROM test_plocus_size;
+DROP TABLE test_plocus_size;
+
+-- the operators of plocus agree with those of locus
+CREATE TABLE test_plocus_pairs AS
+  SELECT l, l::plocus AS p
+  FROM (SELECT ('chr' || (1 + i % 3) || ':' || s || '-' || (s + (i % 10) * 100))::locus AS l
+        FROM generate_series(1, 150) AS i, LATERAL (SELECT (i * 7919) % 10000 AS s) AS g
+        UNION ALL
+        SELECT '<all>:500-600') AS t;
+SELECT count(*) AS pairs,
+       count(*) FILTER (WHERE (a.l < b.l) <> (a.p < b.p) OR (a.l <= b.l) <> (a.p <= b.p) OR
+                              (a.l = b.l) <> (a.p = b.p) OR (a.l <> b.l) <> (a.p <> b.p) OR
+                              (a.l >= b.l) <> (a.p >= b.p) OR (a.l > b.l) <> (a.p > b.p)) AS cmp,
+       count(*) FILTER (WHERE (a.l << b.l) <> (a.p << b.p) OR (a.l >> b.l) <> (a.p >> b.p) OR
+                              (a.l <& b.l) <> (a.p <& b.p) OR (a.l &> b.l) <> (a.p &> b.p)) AS position,
+       count(*) FILTER (WHERE (a.l && b.l) <> (a.p && b.p) OR (a.l @> b.l) <> (a.p @> b.p) OR
+                              (a.l <@ b.l) <> (a.p <@ b.p)) AS overlap
+FROM test_plocus_pairs AS a, test_plocus_pairs AS b;
+DROP TABLE test_plocus_pairs;
+
+-- GiST and btree indexes, on short and long contigs alike
+CREATE TABLE test_plocus AS
+  SELECT (c[1 + i % 6] || ':' || s || '-' || (s + (i % 10) * 100))::plocus AS p
+  FROM generate_series(1, 20000) AS i,
+       LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g,
+       (SELECT ARRAY['chr1', 'chr2', 'chr1_KI270706v1_random', 'chr1_KI270707v1_random',
+                     'chrUn_KI270742v1', 'chrUn_GL000195v1_decoy_long'] AS c) AS n;
+INSERT INTO test_plocus VALUES ('<all>:150000-150100'), (NULL);
+CREATE INDEX test_plocus_ix ON test_plocus USING gist (p);
+CREATE INDEX test_plocus_btree_ix ON test_plocus (p);
+ANALYZE test_plocus;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM test_plocus WHERE p && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p <@ 'chr1_KI270707v1_random:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p @> 'chrUn_GL000195v1_decoy_long:500000';
+SELECT count(*) FROM test_plocus WHERE p && 'chr1:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p && '<all>:150050';
+SELECT count(*) FROM test_plocus WHERE p = 'chrUn_KI270742v1:31676-32076';
+SELECT p FROM test_plocus WHERE p > 'chr1_KI270707v1_random:999000' ORDER BY p LIMIT 3;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM test_plocus WHERE p && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p <@ 'chr1_KI270707v1_random:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p @> 'chrUn_GL000195v1_decoy_long:500000';
+SELECT count(*) FROM test_plocus WHERE p && 'chr1:100000-200000';
+SELECT count(*) FROM test_plocus WHERE p && '<all>:150050';
+SELECT count(*) FROM test_plocus WHERE p = 'chrUn_KI270742v1:31676-32076';
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE test_plocus;
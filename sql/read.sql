@@ -0,0 +1,27 @@
+--
+--  Locus datatype test
+--
+\getenv abs_srcdir PG_ABS_SRCDIR
+\set bed_file :abs_srcdir '/data/sample.bed'
+\set vcf_file :abs_srcdir '/data/sample.vcf.gz'
+
+-- BED records are 0-based and half-open; they come back as 1-based loci
+SELECT * FROM locus_read_bed(:'bed_file');
+
+-- loading a table
+CREATE TABLE test_read_bed AS
+  SELECT locus, fields[1] AS name FROM locus_read_bed(:'bed_file');
+SELECT count(*) FROM test_read_bed WHERE locus && 'chr1:1000-2000';
+DROP TABLE test_read_bed;
+
+-- gzip-compressed VCF; a symbolic allele ends at the END in its INFO
+SELECT * FROM locus_read_vcf(:'vcf_file');
+SELECT locus, ref FROM locus_read_vcf(:'vcf_file') LIMIT 1;
+
+-- errors
+SELECT * FROM locus_read_bed('missing.bed');
+CREATE ROLE regress_locus_reader;
+SET ROLE regress_locus_reader;
+SELECT * FROM locus_read_bed(:'bed_file');
+RESET ROLE;
+DROP ROLE regress_locus_reader;
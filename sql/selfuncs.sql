@@ -0,0 +1,67 @@
+--
+--  Locus datatype test
+--
+-- ANALYZE statistics and selectivity estimates
+CREATE TABLE test_stats AS
+  SELECT ('chr1:' || i * 100 || '-' || i * 100 + i % 10)::locus AS p
+    FROM generate_series(1, 10000) AS i
+  UNION ALL
+  SELECT ('chr2:' || i * 2000 || '-' || i * 2000 + 500)::locus
+    FROM generate_series(1, 5000) AS i
+  UNION ALL
+  SELECT ('chr10:' || i * 50000 || '-' || i * 50000 + 10000)::locus
+    FROM generate_series(1, 2000) AS i
+  UNION ALL
+  SELECT '<all>:1000-2000'::locus FROM generate_series(1, 20)
+  UNION ALL
+  SELECT NULL FROM generate_series(1, 100);
+ANALYZE test_stats;
+
+-- the contig and boundary slots are in place, the latter with the lengths
+-- in its numbers
+SELECT 10001 = ANY (ARRAY[stakind1, stakind2, stakind3, stakind4, stakind5]) AS contigs,
+       10002 = ANY (ARRAY[stakind1, stakind2, stakind3, stakind4, stakind5]) AS bounds,
+       CASE 10002 WHEN stakind1 THEN stanumbers1 WHEN stakind2 THEN stanumbers2
+                  WHEN stakind3 THEN stanumbers3 WHEN stakind4 THEN stanumbers4
+                  WHEN stakind5 THEN stanumbers5 END IS NOT NULL AS lengths
+  FROM pg_statistic
+  WHERE starelid = 'test_stats'::regclass;
+
+-- and the standard histogram stays next to them
+SELECT histogram_bounds IS NOT NULL AS histogram, correlation IS NOT NULL AS correlation
+  FROM pg_stats
+  WHERE tablename = 'test_stats' AND attname = 'p';
+
+-- whether the planner's row estimate is within a factor of two of the count
+CREATE FUNCTION estimate_ok(query text) RETURNS bool AS $$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE 'EXPLAIN (ANALYZE, FORMAT JSON, TIMING OFF, SUMMARY OFF) ' || query INTO plan;
+  RETURN (plan->0->'Plan'->>'Plan Rows')::float8
+         BETWEEN (plan->0->'Plan'->>'Actual Rows')::float8 / 2
+             AND (plan->0->'Plan'->>'Actual Rows')::float8 * 2;
+END
+$$ LANGUAGE plpgsql;
+
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE p && 'chr1:500000-510000'$$);
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE p && 'chr2'$$);
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE p <@ 'chr1:1-100000'$$);
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE 'chr10:1000000-1500000' @> p$$);
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE p << 'chr2:1000000-2000000'$$);
+SELECT estimate_ok($$SELECT * FROM test_stats WHERE p >> 'chr1:500000-510000'$$);
+
+-- joins
+CREATE TABLE test_regions AS
+  SELECT ('chr1:' || i * 20000 || '-' || i * 20000 + 5000)::locus AS r
+    FROM generate_series(1, 50) AS i
+  UNION ALL
+  SELECT ('chr2:' || i * 300000 || '-' || i * 300000 + 100000)::locus
+    FROM generate_series(1, 30) AS i;
+ANALYZE test_regions;
+SELECT estimate_ok($$SELECT * FROM test_stats t JOIN test_regions g ON t.p && g.r$$);
+SELECT estimate_ok($$SELECT * FROM test_stats t JOIN test_regions g ON g.r @> t.p$$);
+SELECT estimate_ok($$SELECT * FROM test_stats t JOIN test_regions g ON t.p << g.r$$);
+
+DROP FUNCTION estimate_ok(text);
+DROP TABLE test_stats, test_regions;
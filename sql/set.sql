@@ -0,0 +1,47 @@
+--
+--  Locus datatype test
+--
+-- locus_set: sorted, with overlapping and adjacent loci merged
+SELECT '{chr1:300-400, chr1:100-200, 1:150-250, chr2:5, chr1:401-500, chr10:1-10}'::locus_set;
+SELECT '{}'::locus_set;
+SELECT '{chr1:1-5,}'::locus_set;
+SELECT 'chr1:1-5'::locus_set;
+SELECT ARRAY['chr2:1-5', NULL, 'chr1:3-4']::locus[]::locus_set;
+SELECT '{chr1:1-5,chr2:3}'::locus_set::locus[];
+
+-- probes agree with && ANY and <@ ANY of the same loci
+CREATE TABLE test_set_probe (p locus);
+INSERT INTO test_set_probe VALUES
+  ('chr1:150'), ('chr1:190-310'), ('chr1:201-299'), ('chr1:400-450'),
+  ('chr1:1500'), ('chr3:55'), ('<all>:55'), ('chr2:60-70');
+SELECT p,
+       p && s AS overlap, p && ANY (a) AS overlap_any,
+       p <@ s AS contained, p <@ ANY (a) AS contained_any
+FROM test_set_probe,
+     (SELECT '{chr1:100-200,chr1:300-400,chr2:50-60,<all>:1000-2000}'::locus[] AS a) AS t,
+     LATERAL (SELECT a::locus_set AS s) AS u;
+DROP TABLE test_set_probe;
+
+-- set operations
+SELECT a + b AS union, a * b AS intersect, a - b AS minus, b - a AS minus_reverse
+FROM (SELECT '{chr1:100-200,chr1:300-400,chr2:1-50}'::locus_set AS a,
+             '{chr1:150-350,chr3:1-5,chr2:50-60}'::locus_set AS b) AS t;
+
+-- a panel built by the aggregate; <@ tests the union of the panel, not
+-- each locus in it
+CREATE TABLE test_set AS
+  SELECT ('chr' || (1 + i % 5) || ':' || s || '-' || (s + (i % 10) * 100))::locus AS p
+  FROM generate_series(1, 20000) AS i, LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g;
+CREATE TABLE test_set_panel AS
+  SELECT ('chr' || (1 + i % 5) || ':' || s || '-' || (s + (i % 20) * 200))::locus AS p
+  FROM generate_series(1, 500) AS i, LATERAL (SELECT (i * 104729) % 1000000 AS s) AS g;
+SELECT cardinality(locus_set_agg(p)::locus[]) AS intervals,
+       locus_set_agg(p)::text = locus_set(array_agg(p))::text AS same
+FROM test_set_panel;
+SELECT count(*) FILTER (WHERE p && s) AS overlap,
+       count(*) FILTER (WHERE p && ANY (a)) AS overlap_any,
+       count(*) FILTER (WHERE p <@ s) AS contained,
+       count(*) FILTER (WHERE p <@ ANY (a)) AS contained_any
+FROM test_set,
+     (SELECT locus_set_agg(p) AS s, array_agg(p) AS a FROM test_set_panel) AS t;
+DROP TABLE test_set, test_set_panel;
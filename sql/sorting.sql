@@ -0,0 +1,34 @@
+--
+--  Locus datatype test
+--
+-- Testing sort support
+--
+SELECT p FROM (VALUES
+  ('chr10:500-600'::locus),
+  ('chr2:100-200'::locus),
+  ('X:5'::locus),
+  ('chr1:300-400'::locus),
+  ('1:300-350'::locus),
+  ('GL000220.1:100-200'::locus),
+  ('GL000219.1:50'::locus),
+  ('chrUn_gl000220'::locus),
+  ('chr1'::locus),
+  ('22:1000-'::locus),
+  ('chr22:-500'::locus),
+  ('MT:16000'::locus),
+  ('chr01:5'::locus),
+  ('chr001:5'::locus),
+  ('chrY:10-20'::locus),
+  ('chr9:1-2'::locus),
+  ('3:7'::locus)
+) AS v(p) ORDER BY p;
+
+-- Abbreviated keys must agree with locus_cmp() on a sort large enough to
+-- exercise the cardinality check
+SELECT count(*) AS misordered
+  FROM (SELECT p, lag(p) OVER (ORDER BY p) AS prev
+          FROM (SELECT (CASE i % 3 WHEN 0 THEN 'chr' ELSE '' END ||
+                        (ARRAY['1', '2', '10', 'X', 'GL000220.1', 'GL000219.1', '01', 'MT'])[i % 8 + 1] ||
+                        ':' || (i * 7919 % 100000) || '-' || (i * 7919 % 100000 + i % 500))::locus AS p
+                  FROM generate_series(1, 50000) AS i) AS s) AS t
+ WHERE prev > p;
@@ -0,0 +1,32 @@
+--
+--  Locus datatype test
+--
+-- SP-GiST quad tree, in place of the GiST index on test_locus
+BEGIN;
+DROP INDEX test_locus_ix;
+CREATE INDEX test_locus_spgist_ix ON test_locus USING spgist (p spgist_locus_ops);
+SET LOCAL enable_seqscan = off;
+SELECT count(*) FROM test_locus WHERE p && '21';
+SELECT count(*) FROM test_locus WHERE p && 'chr21:10600000-12608058';
+SELECT count(*) FROM test_locus WHERE p << 'chr21:28800000-30000000';
+SELECT count(*) FROM test_locus WHERE p >> 'chr21:28800000-30000000';
+SELECT count(*) FROM test_locus WHERE p <@ 'chr21:28800000-30000000';
+SELECT count(*) FROM test_locus WHERE p <@ '<all>:28800000-30000000';
+ROLLBACK;
+
+-- Wildcard loci match queries on any contig
+CREATE TABLE test_spgist (p locus);
+INSERT INTO test_spgist
+  SELECT ('chr' || (i % 3 + 1) || ':' || i * 10 || '-' || i * 10 + 5)::locus
+  FROM generate_series(1, 1000) AS i;
+INSERT INTO test_spgist VALUES ('<all>:500-600'), ('<all>');
+CREATE INDEX test_spgist_ix ON test_spgist USING spgist (p spgist_locus_ops);
+SET enable_seqscan = off;
+SELECT count(*) FROM test_spgist WHERE p && 'chr2:1000-2000';
+SELECT count(*) FROM test_spgist WHERE p && '<all>:1000-1010';
+SELECT count(*) FROM test_spgist WHERE p @> 'chr1:10';
+SELECT count(*) FROM test_spgist WHERE p <@ 'chr3:0-100';
+SELECT count(*) FROM test_spgist WHERE p <@ '<all>:500-600';
+SELECT count(*) FROM test_spgist WHERE p << 'chr2:100';
+SELECT count(*) FROM test_spgist WHERE p >> 'chr2:100';
+RESET enable_seqscan;
@@ -0,0 +1,30 @@
+--
+--  Locus datatype test
+--
+-- Sweep-line joins on &&: the same rows as the nested loop, "<all>" included
+CREATE TABLE test_sweep_a (id int, p locus);
+INSERT INTO test_sweep_a
+  SELECT i, ('chr' || (1 + i % 3) || ':' || s || '-' || (s + (i % 5) * 1000))::locus
+  FROM generate_series(1, 2000) AS i, LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g;
+INSERT INTO test_sweep_a VALUES (0, '<all>:500000-501000'), (-1, NULL);
+CREATE TABLE test_sweep_b (id int, p locus);
+INSERT INTO test_sweep_b
+  SELECT i, ('chr' || (1 + i % 4) || ':' || s || '-' || (s + (i % 7) * 500))::locus
+  FROM generate_series(1, 1000) AS i, LATERAL (SELECT (i * 104729) % 1000000 AS s) AS g;
+INSERT INTO test_sweep_b VALUES (0, '<all>:1-100000'), (-1, NULL);
+ANALYZE test_sweep_a, test_sweep_b;
+
+SET locus.enable_sweep_join = off;
+SELECT count(*), sum(a.id) AS a, sum(b.id) AS b FROM test_sweep_a a JOIN test_sweep_b b ON a.p && b.p;
+SELECT count(*), sum(a.id) AS a, sum(b.id) AS b FROM test_sweep_a a JOIN test_sweep_b b ON b.p && a.p;
+RESET locus.enable_sweep_join;
+
+SET enable_nestloop = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM test_sweep_a a JOIN test_sweep_b b ON a.p && b.p;
+SELECT count(*), sum(a.id) AS a, sum(b.id) AS b FROM test_sweep_a a JOIN test_sweep_b b ON a.p && b.p;
+SELECT count(*), sum(a.id) AS a, sum(b.id) AS b FROM test_sweep_a a JOIN test_sweep_b b ON b.p && a.p;
+SELECT count(*), sum(a.id) AS a, sum(b.id) AS b FROM test_sweep_a a JOIN test_sweep_b b ON a.p && b.p AND a.id < b.id;
+SELECT count(*) FROM test_sweep_a a JOIN test_sweep_b b ON a.p && b.p WHERE a.id = 0;
+RESET enable_nestloop;
+
+DROP TABLE test_sweep_a, test_sweep_b;
@@ -18,3 +18,56 @@ SELECT locus_tile_id('1:50-100'::locus, 10);
 -- Test error on zero tile size
 SELECT locus_tile_id('1:50-100'::locus, 0);
 -- Expected: ERROR: tile width must be positive
+
+-- Test integer tile keys: the tile number is in the lower 32 bits
+SELECT locus_tile_key('12:112847287-112944263'::locus) & 4294967295 AS tile;
+-- Expected: 112
+
+-- Spellings of one contig share keys, different contigs do not
+SELECT locus_tile_key('1:50-100'::locus, 10) = locus_tile_key('chr1:59'::locus, 10) AS same_contig,
+       locus_tile_key('1:50'::locus) = locus_tile_key('2:50'::locus) AS other_contig;
+-- Expected: t, f
+
+-- Test all tiles that a locus touches
+SELECT t & 4294967295 AS tile FROM locus_tiles('chr1:995000-3000000'::locus) AS t;
+-- Expected: 0 to 3
+
+SELECT count(*) FROM locus_tiles('chr1:1000000-1999999'::locus);
+-- Expected: 1
+
+SELECT count(*) FROM locus_tiles('chr1:1-2'::locus, 0);
+-- Expected: ERROR: tile width must be positive
+
+SELECT locus_tile_key('<all>:1-2'::locus);
+-- Expected: ERROR: a locus on all contigs has no tiles or bins
+
+-- Test UCSC bins: 128 kb, 1 Mb and extended bins
+SELECT locus_bin(l) & 4294967295 AS bin
+FROM (VALUES ('chr1:1-1000'::locus), ('chr1:200001-200100'),
+             ('chr1:131000-132000'), ('chr1:600000000-600000100')) AS v(l);
+-- Expected: 585, 586, 73, 13939
+
+SELECT count(*) FROM locus_bins('chr1:1000'::locus);
+-- Expected: 11, one bin on each level of both schemes
+
+-- Binned joins find the same pairs as the overlap join
+CREATE TEMP TABLE tiles_test AS
+  SELECT ('chr' || (1 + i % 3) || ':' || s || '-' ||
+          (s + CASE WHEN i % 50 = 0 THEN 200000000 ELSE (i % 7) * 150000 END))::locus AS l
+  FROM generate_series(1::bigint, 300) AS i,
+       LATERAL (SELECT (i * 7919 * 104729) % 700000000 AS s) AS g;
+
+SELECT count(*) FROM tiles_test a JOIN tiles_test b ON a.l && b.l;
+-- Expected: 612
+
+SELECT count(*)
+FROM tiles_test a, locus_tiles(a.l, 100000) AS ta,
+     tiles_test b, locus_tiles(b.l, 100000) AS tb
+WHERE ta = tb AND a.l && b.l
+  AND ta = greatest(locus_tile_key(a.l, 100000), locus_tile_key(b.l, 100000));
+-- Expected: 612
+
+SELECT count(*)
+FROM tiles_test a, locus_bins(a.l) AS k, tiles_test b
+WHERE locus_bin(b.l) = k AND a.l && b.l;
+-- Expected: 612
@@ -0,0 +1,24 @@
+--
+--  Locus datatype test
+--
+-- the 0.0.2 -> 0.0.3 upgrade rewrites every column that holds loci, in
+-- arrays too, and goes down an inheritance tree through its parent
+SET client_min_messages = warning;
+DROP EXTENSION locus CASCADE;
+CREATE EXTENSION locus VERSION '0.0.2';
+RESET client_min_messages;
+CREATE TABLE test_upgrade_parent (p locus, ps locus[]);
+CREATE TABLE test_upgrade_child (q locus) INHERITS (test_upgrade_parent);
+INSERT INTO test_upgrade_parent VALUES ('chr2:100-200', ARRAY['chr2:1', 'chr10:5']::locus[]);
+INSERT INTO test_upgrade_child VALUES ('chr10:100-200', ARRAY['chrX:7']::locus[], 'chr1:1-5');
+CREATE INDEX test_upgrade_parent_ix ON test_upgrade_parent (p);
+CREATE INDEX test_upgrade_child_ix ON test_upgrade_child (p);
+CREATE TEMPORARY TABLE upgrade_files AS
+  SELECT oid, relname, relfilenode FROM pg_class WHERE relname LIKE 'test_upgrade%';
+ALTER EXTENSION locus UPDATE TO '0.0.3';
+SELECT f.relname, c.relfilenode <> f.relfilenode AS rewritten
+FROM upgrade_files AS f JOIN pg_class AS c ON c.oid = f.oid
+ORDER BY f.relname;
+SELECT * FROM test_upgrade_parent ORDER BY p;
+SELECT * FROM test_upgrade_child;
+DROP TABLE test_upgrade_child, test_upgrade_parent, upgrade_files;
@@ -0,0 +1,98 @@
+--
+--  Locus datatype test
+--
+-- vlocus reads and writes what locus does
+SELECT 'chr1:100-200'::vlocus, '1:100'::vlocus, 'chrX:400-'::vlocus,
+       'chr2:-99'::vlocus, '<all>'::vlocus;
+SELECT 'chr1:200-100'::vlocus;
+
+-- and contig names of any length up to 255 characters
+SELECT 'chr1_KI270706v1_random:100-200'::vlocus, 'scaffold_0000123_pilon:1,000-2,000'::vlocus;
+SELECT contig(v), lower(v), upper(v)
+FROM (SELECT 'chr1_KI270706v1_random:100-200'::vlocus AS v) AS t;
+SELECT length(contig((repeat('x', 255) || ':5')::vlocus));
+SELECT (repeat('x', 256) || ':5')::vlocus;
+
+-- casts
+SELECT 'chr1:1-10'::locus::vlocus, 'chrUn_KI270742v1:1-10'::vlocus::locus;
+SELECT 'chr1_KI270706v1_random:1-10'::vlocus::locus;
+
+-- binary send
+SELECT vlocus_send('chr1_KI270706v1_random:5-10');
+
+-- and binary input takes only contigs that vlocus_in produces
+\getenv abs_builddir PG_ABS_BUILDDIR
+\set binary_file :abs_builddir '/results/vlocus.data'
+CREATE TABLE test_vlocus_in (v vlocus);
+COPY (SELECT '\x0100000000010000000203313a32'::bytea) TO :'binary_file' WITH (FORMAT binary);
+COPY test_vlocus_in FROM :'binary_file' WITH (FORMAT binary);
+DROP TABLE test_vlocus_in;
+
+-- natural order, with contigs of either length
+SELECT v FROM (VALUES ('chrUn_KI270742v1:1'::vlocus), ('chr10:1'), ('chr1_KI270706v1_random:5'),
+                      ('chr1:100'), ('<all>:1'), ('chr2:1'), ('chr1:5'),
+                      ('chr1_KI270706v1_random:1-4')) AS t(v)
+ORDER BY v;
+
+-- short values are stored with a one-byte header
+CREATE TABLE test_vlocus_size (p locus, v vlocus);
+INSERT INTO test_vlocus_size VALUES ('chr1:100-200', 'chr1:100-200'),
+  ('chr1:100-200', 'chr1_KI270706v1_random:100-200');
+SELECT pg_column_size(p) AS locus, pg_column_size(v) AS vlocus FROM test_vlocus_size;
+DROP TABLE test_vlocus_size;
+
+-- the operators of vlocus agree with those of locus
+CREATE TABLE test_vlocus_pairs AS
+  SELECT p, p::vlocus AS v
+  FROM (SELECT ('chr' || (1 + i % 3) || ':' || s || '-' || (s + (i % 10) * 100))::locus AS p
+        FROM generate_series(1, 150) AS i, LATERAL (SELECT (i * 7919) % 10000 AS s) AS g
+        UNION ALL
+        SELECT '<all>:500-600') AS t;
+SELECT count(*) AS pairs,
+       count(*) FILTER (WHERE (a.p < b.p) <> (a.v < b.v) OR (a.p <= b.p) <> (a.v <= b.v) OR
+                              (a.p = b.p) <> (a.v = b.v) OR (a.p <> b.p) <> (a.v <> b.v) OR
+                              (a.p >= b.p) <> (a.v >= b.v) OR (a.p > b.p) <> (a.v > b.v)) AS cmp,
+       count(*) FILTER (WHERE (a.p << b.p) <> (a.v << b.v) OR (a.p >> b.p) <> (a.v >> b.v) OR
+                              (a.p <& b.p) <> (a.v <& b.v) OR (a.p &> b.p) <> (a.v &> b.v)) AS position,
+       count(*) FILTER (WHERE (a.p && b.p) <> (a.v && b.v) OR (a.p @> b.p) <> (a.v @> b.v) OR
+                              (a.p <@ b.p) <> (a.v <@ b.v)) AS overlap
+FROM test_vlocus_pairs AS a, test_vlocus_pairs AS b;
+DROP TABLE test_vlocus_pairs;
+
+-- GiST and btree indexes, on short and long contigs alike
+CREATE TABLE test_vlocus AS
+  SELECT (c[1 + i % 6] || ':' || s || '-' || (s + (i % 10) * 100))::vlocus AS v
+  FROM generate_series(1, 20000) AS i,
+       LATERAL (SELECT (i * 7919) % 1000000 AS s) AS g,
+       (SELECT ARRAY['chr1', 'chr2', 'chr1_KI270706v1_random', 'chr1_KI270707v1_random',
+                     'chrUn_KI270742v1', 'chrUn_GL000195v1_decoy_long'] AS c) AS n;
+INSERT INTO test_vlocus VALUES ('<all>:150000-150100'), (NULL);
+CREATE INDEX test_vlocus_ix ON test_vlocus USING gist (v);
+CREATE INDEX test_vlocus_btree_ix ON test_vlocus (v);
+ANALYZE test_vlocus;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM test_vlocus WHERE v && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v <@ 'chr1_KI270707v1_random:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v @> 'chrUn_GL000195v1_decoy_long:500000';
+SELECT count(*) FROM test_vlocus WHERE v && 'chr1:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v && '<all>:150050';
+SELECT count(*) FROM test_vlocus WHERE v = 'chrUn_KI270742v1:31676-32076';
+SELECT v FROM test_vlocus WHERE v > 'chr1_KI270707v1_random:999000' ORDER BY v LIMIT 3;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM test_vlocus WHERE v && 'chr1_KI270706v1_random:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v <@ 'chr1_KI270707v1_random:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v @> 'chrUn_GL000195v1_decoy_long:500000';
+SELECT count(*) FROM test_vlocus WHERE v && 'chr1:100000-200000';
+SELECT count(*) FROM test_vlocus WHERE v && '<all>:150050';
+SELECT count(*) FROM test_vlocus WHERE v = 'chrUn_KI270742v1:31676-32076';
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE test_vlocus;